@@ -0,0 +1,26 @@
+/*
+    Host clock of the FreeRTOS and ESP-IDF shims.
+    In real time mode the tick counter, esp_timer and the log timestamps follow the monotonic clock of the host, and
+    vTaskDelay and the queue timeouts sleep for real.
+    In virtual mode the clock only moves when every task waits: the shim then jumps to the earliest deadline of a
+    vTaskDelay, a queue timeout or a timer and wakes the tasks due at that time, so an hour of firmware time runs as fast
+    as the tasks compute. The I2S channels block for the duration of the audio already written, as the DMA does.
+    The mode is set once, before the first task or timer is created, the calling thread takes part in the scheduling and
+    should only wait through the FreeRTOS API.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define HOST_CLOCK_FOREVER              (INT64_MAX)
+
+typedef enum {
+    HOST_CLOCK_REAL = 0,
+    HOST_CLOCK_VIRTUAL,
+} HostClockMode_t;
+
+void HostClockSetMode(HostClockMode_t mode);
+HostClockMode_t HostClockGetMode();
+int64_t HostClockNowUs();
+void HostClockSleepUntilUs(int64_t deadline_us);
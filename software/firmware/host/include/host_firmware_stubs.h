@@ -0,0 +1,67 @@
+/*
+    Host replacements of the firmware modules that are not built on the host: GUI, bluetooth, NVS backed configuration
+    and the embedded BMI270 config file. The replacements record what the pipeline asked them to do, so the host
+    programs can print or check it.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+#include "bluethroat_gui.h"
+
+typedef struct {
+    char clock[32];
+    uint16_t battery_voltage;
+    bool is_charging;
+    bool is_activiting;
+    bool is_undercurrent;
+    GuiBluetoothState_t bluetooth_state;
+    GuiGnssStatus_t gnss_status;
+    float speed;
+    float altitude;
+    float agl;
+    float vertical_speed;
+    float netto_vertical_speed;
+    float relative_vertical_speed;
+    float wind_speed;
+    float wind_direction;
+    uint32_t wind_count;
+    bool circling;
+    bool thermal_core_valid;
+    float thermal_core_east;                /* m from the glider */
+    float thermal_core_north;
+    float thermal_climb;
+    uint32_t thermal_count;
+    float short_average;                    /* m/s */
+    float long_average;
+    float thermal_average;
+    float thermal_gain;                     /* m */
+    uint32_t climb_count;
+    float speed_to_fly;                     /* m/s */
+    float final_glide_speed;
+    float waypoint_distance;                /* m */
+    float required_glide;
+    float glide;
+    float arrival_altitude;                 /* m above the waypoint and the margin */
+    uint32_t glide_count;
+    FlightState_t flight_state;
+    uint32_t airtime;                       /* ms */
+    float distance;                         /* m */
+    uint32_t task_stats_count;
+    uint32_t update_count;
+} HostGuiState_t;
+
+typedef struct {
+    uint32_t pressure_notify_count;
+    uint32_t nmea_notify_count;
+    float last_pressure;
+    uint32_t climb_notify_count;
+    ClimbRecord_t last_climb;
+} HostBluetoothState_t;
+
+extern HostGuiState_t g_HostGuiState;
+extern HostBluetoothState_t g_HostBluetoothState;
+
+void HostResetFirmwareStubs();
@@ -0,0 +1,257 @@
+/*
+    Synthetic atmosphere and flight generator.
+    A flight is scripted as a list of segments, straight glides and circles in a thermal core, flown through an ISA
+    troposphere with turbulence. The generator integrates the flight at the sample period and turns the true state into
+    the raw DPS3xx temperature and pressure registers, by inverting the compensation formula of the calibration
+    coefficients Dps3xxBarometer::get_coefs() loads, with the noise and drift of the sensor, and into $GNGGA, $GNRMC and
+    $GNVTG sentences. The true state of every step is kept, it is the ground truth for the output of the firmware.
+    With an IMU, the specific force and the rotation of the glider are turned into BMI270 FIFO frames: the glider banks
+    into the circles of a thermal with a first order lag, and the vertical acceleration of a step is the change of the
+    vertical speed over it. The sensor frame is x forward, y left, z up.
+    With an anemometer, the total pressure of a pitot tube, the static pressure and the dynamic pressure of the
+    airspeed in the density of the air, is turned into the raw registers of a second DPS3xx. A pull up trades airspeed for
+    altitude at a constant total energy: the vertical speed of the glider is the one of the energy, less the rate of
+    V^2 / 2g, which is the truth of a total energy compensated vario.
+    With a static port, the second DPS3xx reads the static pressure as well, with its own noise and a calibration
+    offset, and the barometer can be made to stick at a time, it then repeats its last sample.
+    With a polar, the sink of the glider follows its airspeed, the polar of the firmware (utilities/glider_polar.h) at
+    the indicated airspeed and scaled to the density, instead of the glider sink; the air mass is the truth of netto.
+    With a wind, the air mass drifts, the glider and the circles of a thermal with it, and the ground velocity of the
+    $GNRMC and $GNVTG sentences is the velocity in the air plus the wind.
+    On the ground the glider stands still where it is, it takes off at the airspeed of the script, before a takeoff and
+    after a landing.
+
+    Script, one statement per line, # starts a comment:
+        qnh <pa>                                    sea level pressure, 101325 by default
+        temperature <c>                             sea level air temperature, 15 by default
+        altitude <m>                                start altitude, 1000 by default
+        position <latitude> <longitude>             start position in degrees, north and east positive
+        time <hhmmss> <ddmmyy>                      UTC time and date of the start
+        speed <mps>                                 airspeed, 10 by default
+        wind <mps> <degrees>                        wind speed and the direction it blows from, none by default
+        heading <degrees>                           start heading, 0 by default
+        glider_sink <mps>                           sink of the glider in still air, 0 by default
+        polar <kmh> <mps> <kmh> <mps> <kmh> <mps>   sink of the glider in still air at three indicated airspeeds,
+                                                    in place of the glider sink
+        turbulence <rms mps> <correlation s>        vertical gusts, a first order Gauss-Markov process
+        pressure_noise <rms pa>                     white noise of the pressure sensor
+        pressure_drift <pa per hour>                linear drift of the pressure sensor
+        temperature_noise <rms c>                   white noise of the temperature sensor
+        temperature_drift <c per hour>              self heating of the temperature sensor
+        sensor_warming <c> <time constant s> <pa per c>
+                                                    the sensor warms by that much in the sun with a first order lag,
+                                                    and its pressure drifts with its temperature since the start
+        gnss_noise <rms m>                          white noise of the GNSS altitude
+        gnss_speed_noise <rms mps>                  white noise of each component of the GNSS ground velocity
+        imu <rms m/s^2> <rms dps>                   BMI270 frames, with the white noise of the accelerometer and
+                                                    gyroscope, none by default
+        anemometer <rms pa>                         DPS3xx frames of the total pressure, with the white noise of the
+                                                    sensor, none by default
+        static_port <rms pa> <offset pa>            DPS3xx frames of a second static pressure, with the white noise
+                                                    and the offset of the sensor, in place of the anemometer
+        barometer_stuck <time s>                    the barometer repeats its last sample from that time on
+        waypoint <latitude> <longitude> <altitude m>
+                                                    waypoint of the final glide, in degrees, given to the firmware
+        maccready <mps>                             MacCready setting given to the firmware, 0 by default
+        seed <n>                                    seed of the noise generators
+        glide <duration s> <air mass mps>           straight flight, the glider sinks in the air mass
+        thermal <duration s> <core lift mps> <core radius m> <circle radius m> <core offset m>
+                                                    right hand circles, the lift falls off as a gaussian of the
+                                                    distance to the core
+        pullup <duration s> <end speed mps> <air mass mps>
+                                                    straight flight, the airspeed changes linearly to the end speed
+                                                    and the glider climbs or dives the energy it trades
+        ground <duration s>                         the glider stands on the ground
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <random>
+#include <vector>
+
+#include <esp_err.h>
+
+#include "drivers/bmi270_imu.h"
+#include "drivers/dps3xx_barometer.h"
+#include "utilities/glider_polar.h"
+
+#define HOST_FLIGHT_NMEA_MAX_SIZE       (0x80)
+
+typedef enum {
+    HOST_DPS3XX_C0 = 0,
+    HOST_DPS3XX_C1,
+    HOST_DPS3XX_C00,
+    HOST_DPS3XX_C10,
+    HOST_DPS3XX_C01,
+    HOST_DPS3XX_C11,
+    HOST_DPS3XX_C20,
+    HOST_DPS3XX_C21,
+    HOST_DPS3XX_C30,
+    HOST_DPS3XX_COEF_MAX,
+} HostDps3xxCoef_t;
+
+typedef enum {
+    HOST_SEGMENT_GLIDE = 0,
+    HOST_SEGMENT_THERMAL,
+    HOST_SEGMENT_PULLUP,
+    HOST_SEGMENT_GROUND,
+} HostSegmentType_t;
+
+typedef struct {
+    HostSegmentType_t type;
+    double duration_s;
+    double lift_mps;                        /* glide and pullup: air mass vertical speed, thermal: lift at the core */
+    double core_radius_m;                   /* thermal: distance where the lift falls to 1/e of the core lift */
+    double circle_radius_m;                 /* thermal: radius of the circles flown */
+    double core_offset_m;                   /* thermal: distance from the circle center to the core, east of it */
+    double speed_mps;                       /* pullup: airspeed at the end of the segment */
+} HostFlightSegment_t;
+
+typedef struct {
+    double qnh_pa;
+    double sea_level_temperature_c;
+    double start_altitude_m;
+    double start_latitude_deg;
+    double start_longitude_deg;
+    uint32_t start_time_s;                  /* UTC seconds of the day */
+    uint32_t start_date;                    /* ddmmyy */
+    double speed_mps;
+    double heading_deg;
+    double wind_speed_mps;
+    double wind_direction_deg;              /* it blows from */
+    double glider_sink_mps;
+    bool polar_enabled;
+    double polar_speeds_kmh[GLIDER_POLAR_POINTS];
+    double polar_sinks_mps[GLIDER_POLAR_POINTS];
+    double turbulence_mps;
+    double turbulence_time_s;
+    double pressure_noise_pa;
+    double pressure_drift_pa_per_h;
+    double temperature_noise_c;
+    double temperature_drift_c_per_h;
+    double warming_c;
+    double warming_time_s;
+    double warming_pa_per_c;                /* drift of the sensor pressure with the sensor temperature */
+    double gnss_noise_m;
+    double gnss_speed_noise_mps;
+    double geoid_separation_m;
+    bool imu_enabled;
+    double imu_acceleration_noise_mps2;
+    double imu_rotation_noise_dps;
+    bool anemometer_enabled;
+    double anemometer_noise_pa;
+    bool static_port_enabled;
+    double static_port_noise_pa;
+    double static_port_offset_pa;
+    double barometer_stuck_s;               /* 0 for never */
+    bool waypoint_enabled;
+    double waypoint_latitude_deg;
+    double waypoint_longitude_deg;
+    double waypoint_altitude_m;
+    double maccready_mps;
+    uint32_t seed;
+} HostFlightConfig_t;
+
+typedef struct {
+    double time_s;
+    uint32_t segment;
+    double altitude_m;
+    double vertical_speed_mps;              /* true vertical speed, turbulence included */
+    double pressure_pa;                     /* true static pressure */
+    double temperature_c;                   /* true air temperature */
+    double sensor_pressure_pa;              /* pressure seen by the sensor, noise and drift included */
+    double sensor_temperature_c;
+    double east_m;
+    double north_m;
+    double heading_deg;
+    double vertical_acceleration_mps2;      /* mean over the last step */
+    double turn_rate_dps;                   /* positive to the right */
+    double bank_deg;                        /* positive right wing down */
+    double roll_rate_dps;
+    double airspeed_mps;
+    double total_energy_speed_mps;          /* vertical speed plus the rate of the energy height V^2 / 2g */
+    double air_mass_speed_mps;              /* vertical speed of the air, lift and turbulence */
+    double dynamic_pressure_pa;             /* true dynamic pressure of the airspeed */
+    double sensor_total_pressure_pa;        /* total pressure seen by the anemometer, noise included */
+    double sensor_static_pressure_pa;       /* pressure seen by the second static port, noise and offset included */
+    double ground_speed_mps;                /* true ground velocity, the airspeed on the heading plus the wind */
+    double track_deg;
+    double sensor_ground_speed_mps;         /* ground velocity of the GNSS, noise included */
+    double sensor_track_deg;
+} HostFlightState_t;
+
+/* Accuracy and lag of an estimate of the vertical speed against the true one, sampled at the same instants. */
+typedef struct {
+    uint32_t samples;
+    double rms_error_mps;                   /* at the same instant */
+    double lag_s;                           /* shift of the estimate giving the smallest error */
+    double lagged_rms_error_mps;            /* at that shift */
+    double max_error_mps;
+} HostVarioScore_t;
+
+class HostFlightGenerator {
+public:
+    /* Construction member variables */
+    HostFlightConfig_t m_config;
+    std::vector<HostFlightSegment_t> m_segments;
+    GliderPolar m_polar;
+    int32_t m_coefs[HOST_DPS3XX_COEF_MAX];
+    double m_pressure_scale_factor;         /* kP and kT of the oversampling rates set by Dps3xxBarometer::init_device */
+    double m_temperature_scale_factor;
+
+    /* Runtime member variables */
+    HostFlightState_t m_state;
+    double m_segment_time_s;
+    double m_turbulence_mps;
+    double m_circle_center_east_m;
+    double m_circle_center_north_m;
+    double m_segment_start_speed_mps;       /* airspeed at the start of the segment */
+    std::mt19937 m_random;
+    std::normal_distribution<double> m_normal;
+    std::mt19937 m_imu_random;              /* apart, the IMU leaves the other noise of a seed as it is */
+    std::normal_distribution<double> m_imu_normal;
+    std::mt19937 m_anemometer_random;       /* apart as well */
+    std::normal_distribution<double> m_anemometer_normal;
+    std::mt19937 m_gnss_random;             /* apart as well */
+    std::normal_distribution<double> m_gnss_normal;
+
+public:
+    HostFlightGenerator();
+
+public:
+    static void GetDefaultConfig(HostFlightConfig_t *p_config);
+    static double StandardPressure(double altitude_m, double qnh_pa, double sea_level_temperature_c);
+
+public:
+    esp_err_t LoadScript(const char *file_name);
+    void AddSegment(const HostFlightSegment_t *p_segment);
+    double Duration() const;
+    void GetWind(double *p_east_mps, double *p_north_mps) const;
+    void GetWaypoint(double *p_east_m, double *p_north_m) const;
+    void Reset();
+    bool Step(double period_s);
+
+    void EncodeCoefs(uint8_t *p_bytes, size_t size) const;
+    void EncodeDps3xx(uint8_t *p_bytes, size_t size) const;
+    void EncodeDps3xxTotal(uint8_t *p_bytes, size_t size) const;
+    void EncodeDps3xxStatic(uint8_t *p_bytes, size_t size) const;
+    double CompensatePressure(int32_t raw_pressure, int32_t raw_temperature) const;
+    double CompensateTemperature(int32_t raw_temperature) const;
+    void EncodeBmi270Frame(Bmi270FifoFrame_t *p_frame);
+
+    void EncodeGga(char *sentence, size_t size);
+    void EncodeRmc(char *sentence, size_t size) const;
+    void EncodeVtg(char *sentence, size_t size) const;
+
+private:
+    esp_err_t parse_statement(char *line);
+    void enter_segment();
+    void encode_dps3xx(double pressure_pa, double temperature_c, uint8_t *p_bytes, size_t size) const;
+    void format_time(char *buffer, size_t size) const;
+    void format_position(char *latitude, size_t latitude_size, char *longitude, size_t longitude_size, char *p_north, char *p_east) const;
+    void finish_sentence(char *sentence, size_t size) const;
+};
+
+void HostScoreVario(const std::vector<double> &truth, const std::vector<double> &estimate, double period_s, double max_lag_s, HostVarioScore_t *p_score);
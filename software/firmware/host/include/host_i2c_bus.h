@@ -0,0 +1,128 @@
+/*
+    Host side I2C bus.
+    I2cMaster is reimplemented on the host on top of this bus. Each port owns a HostI2cBus, devices are attached to it by
+    their 7-bit (or flagged 10-bit) address and receive the register address exactly as the firmware passed it to
+    I2cMaster, including the I2C_REG_16_BIT_FLAG and I2C_NO_REG_FLAG bits.
+
+    Every transaction is timed as the ESP-IDF command link would put it on the wire: start, address, register address,
+    repeated start and address for a read, data and stop, nine clocks a byte at the SCL frequency of the I2cMaster, plus
+    a configurable driver overhead. A NACK ends the transaction after the first address byte, a timeout holds the bus
+    for the whole timeout of the I2cMaster. The time is accounted per device, and with blocking timing the calling task
+    also sleeps for it on the host clock (host_clock.h), so bus time shows in the loop timing of the tasks on the
+    virtual clock. Faults are injected per device address, for a number of transactions or at random.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <random>
+
+#include <esp_err.h>
+#include <driver/i2c.h>
+#include <freertos/FreeRTOS.h>
+
+#define HOST_I2C_REG_ADDR_MASK          ((uint32_t)(0x0000ffff))
+
+/* Same values as in utilities/i2c_master.cpp */
+#define HOST_I2C_ADDR_10_BIT_FLAG       ((uint16_t)(0x8000))
+#define HOST_I2C_REG_16_BIT_FLAG        ((uint32_t)(0x80000000))
+#define HOST_I2C_NO_REG_FLAG            ((uint32_t)(0x40000000))
+
+#define HOST_I2C_CLOCKS_PER_BYTE        (9)
+#define HOST_I2C_DEFAULT_SEED           (1)
+
+class HostI2cDevice {
+public:
+    virtual ~HostI2cDevice() {}
+
+public:
+    virtual esp_err_t Read(uint32_t reg_addr, uint8_t *buffer, uint16_t size) = 0;
+    virtual esp_err_t Write(uint32_t reg_addr, const uint8_t *buffer, uint16_t size) = 0;
+};
+
+/*
+    Plain 256 bytes register file with auto increment addressing.
+    Bits cleared in the write mask of a register are read-only, they keep the value set by SetRegister() whatever the
+    firmware writes, e.g. the ready flags in the high nibble of the DPS3xx MEAS_CFG register.
+*/
+class HostI2cRegisterFile : public HostI2cDevice {
+public:
+    uint8_t m_registers[256];
+    uint8_t m_write_masks[256];
+
+public:
+    HostI2cRegisterFile();
+    virtual ~HostI2cRegisterFile() {}
+
+public:
+    void SetRegister(uint8_t reg_addr, uint8_t value, uint8_t write_mask = 0xff);
+    void SetRegisters(uint8_t reg_addr, const uint8_t *values, uint16_t size, uint8_t write_mask = 0xff);
+
+public:
+    virtual esp_err_t Read(uint32_t reg_addr, uint8_t *buffer, uint16_t size);
+    virtual esp_err_t Write(uint32_t reg_addr, const uint8_t *buffer, uint16_t size);
+};
+
+typedef struct {
+    uint32_t clock_hz;                      /* SCL frequency, set by the I2cMaster of the port */
+    uint32_t overhead_us;                   /* command link setup and interrupt latency of every transaction */
+    bool blocking;                          /* the calling task sleeps for the duration of the transaction */
+} HostI2cTiming_t;
+
+typedef struct {
+    uint32_t after_count;                   /* transactions acknowledged before any fault is injected */
+    uint32_t nack_count;                    /* then the next transactions are not acknowledged */
+    uint32_t timeout_count;                 /* the next transactions hold SCL low until the timeout */
+    double nack_probability;                /* then every transaction is not acknowledged with this probability */
+    double timeout_probability;
+} HostI2cFault_t;
+
+typedef struct {
+    uint32_t transactions;                  /* probes included */
+    uint32_t probes;
+    uint32_t read_bytes;
+    uint32_t write_bytes;
+    uint32_t nacks;                         /* injected, and transactions to an address no device answers */
+    uint32_t timeouts;
+    uint64_t busy_us;
+} HostI2cStats_t;
+
+class HostI2cBus {
+public:
+    static HostI2cBus m_bus[I2C_NUM_MAX];
+    std::map<uint16_t, HostI2cDevice *> m_devices;
+    std::map<uint16_t, HostI2cFault_t> m_faults;
+    std::map<uint16_t, HostI2cStats_t> m_device_stats;
+    HostI2cStats_t m_stats;
+    HostI2cTiming_t m_timing;
+    std::mt19937 m_random;
+
+public:
+    HostI2cBus();
+
+public:
+    static HostI2cBus *GetBus(i2c_port_t port);
+
+public:
+    void Attach(uint16_t device_addr, HostI2cDevice *p_device);
+    void Detach(uint16_t device_addr);
+    HostI2cDevice *Find(uint16_t device_addr);
+
+    void SetTiming(const HostI2cTiming_t *p_timing);
+    void SetFault(uint16_t device_addr, const HostI2cFault_t *p_fault);
+    void ClearFaults(uint32_t seed = HOST_I2C_DEFAULT_SEED);
+    void ResetStats();
+    void GetStats(uint16_t device_addr, HostI2cStats_t *p_stats);
+
+    esp_err_t Probe(uint16_t device_addr, TickType_t timeout);
+    esp_err_t Read(uint16_t device_addr, uint32_t reg_addr, uint8_t *buffer, uint16_t size, TickType_t timeout);
+    esp_err_t Write(uint16_t device_addr, uint32_t reg_addr, const uint8_t *buffer, uint16_t size, TickType_t timeout);
+
+private:
+    esp_err_t inject_fault(uint16_t device_addr);
+    uint32_t address_bytes(uint16_t device_addr) const;
+    uint32_t register_bytes(uint32_t reg_addr) const;
+    uint64_t duration_us(esp_err_t result, uint32_t clocks, TickType_t timeout) const;
+    void account(uint16_t device_addr, const HostI2cStats_t *p_delta);
+};
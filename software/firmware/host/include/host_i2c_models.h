@@ -0,0 +1,164 @@
+/*
+    Register models of the I2C devices of the Core2, attached to the host bus (host_i2c_bus.h).
+    Unlike the plain register files of the host rig, they follow the host clock: the DPS3xx is ready after its reset and
+    measurement times, the BM8563 counts seconds, so the poll and retry loops of the drivers run as on the device.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include <deque>
+
+#include "host_i2c_bus.h"
+
+/* Datasheet timing of the DPS3xx: a measurement takes 3.6ms plus 1.6ms per oversampled conversion after the first. */
+#define HOST_DPS3XX_MEASUREMENT_BASE_US     (3600)
+#define HOST_DPS3XX_MEASUREMENT_STEP_US     (1600)
+#define HOST_DPS3XX_COEF_SRC_EXTERNAL       (0x80)
+
+/* The BMI270 reports its initialization 20ms after it was started, its FIFO holds 6KB. */
+#define HOST_BMI270_INIT_US                 (20000)
+#define HOST_BMI270_FIFO_SIZE               (6144)
+
+#define HOST_FT6X36U_REG_ADDR_CHIP_ID       (0xa3)
+#define HOST_FT6X36U_REG_ADDR_VENDOR_ID     (0xa8)
+#define HOST_FT6X36U_CHIP_ID                (0x64)
+#define HOST_FT6X36U_VENDOR_ID              (0x11)
+
+#define HOST_BM8563_REG_ADDR_DATETIME       (0x02)
+#define HOST_BM8563_DATETIME_SIZE           (7)
+
+/*
+    DPS3xx in command and background mode. A write of a temperature or pressure command to MEAS_CFG starts a
+    measurement, its ready flag is set once the measurement time of the oversampling rate in TMP_CFG or PRS_CFG has
+    passed, and the result is latched in the result registers. In background mode a temperature ends a temperature
+    period of the rate in TMP_CFG after the previous one, the first its measurement time after the start, a pressure a
+    pressure period after the previous one, the first after the temperature and its own measurement time, and with
+    fifo_en set the results are queued in the FIFO of 32 instead. A read at PSR_B2 pops a single entry, the empty marker
+    once it's empty, the bytes past the first 3 are the registers after PSR_B0, and a result is lost on a full FIFO. The
+    time scale stretches the datasheet timing, and the periods, to model a slow part. The pressure slope ramps the
+    background pressures from the time it is set, by the end of each, to model a climb or a sink.
+*/
+class HostDps3xxModel : public HostI2cRegisterFile {
+public:
+    /* Construction member variables */
+    double m_time_scale;
+
+    /* Runtime member variables */
+    int64_t m_reset_us;
+    int64_t m_measurement_end_us;
+    uint8_t m_measurement;
+    int32_t m_raw_pressure;
+    int32_t m_raw_temperature;
+    double m_raw_pressure_slope;            /* raw pressure per second of the background pressures */
+    int64_t m_slope_start_us;
+    uint32_t m_measurements;
+    uint32_t m_status_reads;                /* reads of MEAS_CFG, the ready flag polls of the driver */
+    int64_t m_temperature_end_us;           /* of the next background result */
+    int64_t m_pressure_end_us;
+    int64_t m_background_start_us;          /* write of the last background measurement start */
+    int64_t m_last_pressure_us;             /* end of the last background pressure */
+    uint32_t m_background_temperatures;     /* results of the background measurement, queued or lost */
+    uint32_t m_background_pressures;
+    std::deque<uint32_t> m_fifo;
+    uint32_t m_fifo_lost;
+
+public:
+    HostDps3xxModel();
+    virtual ~HostDps3xxModel() {}
+
+public:
+    void SetCoefs(const uint8_t *p_coefs, uint16_t size);
+    void SetSample(int32_t raw_pressure, int32_t raw_temperature);
+    void SetPressureSlope(double raw_per_s, int64_t start_us);
+    int64_t MeasurementTimeUs(uint8_t cfg) const;
+
+public:
+    virtual esp_err_t Read(uint32_t reg_addr, uint8_t *buffer, uint16_t size);
+    virtual esp_err_t Write(uint32_t reg_addr, const uint8_t *buffer, uint16_t size);
+
+private:
+    void reset();
+    void update();
+    void update_background(int64_t now_us);
+    void put_result(bool pressure);
+    void update_fifo_status();
+};
+
+/*
+    BMI270 with its config file upload. INTERNAL_STATUS reads not initialized after a reset, and initialized once
+    INIT_CTRL was set to 1 after the whole config file was written to INIT_DATA, in order from the word offset of
+    INIT_ADDR_0 and INIT_ADDR_1, which a write moves on. It reads an initialization error after a partial upload or with
+    the init failure set. Until it is initialized, and while the accelerometer or the gyroscope is off in PWR_CTRL, the
+    frames pushed are refused and FIFO_LENGTH reads 0. A read of FIFO_DATA pops as many bytes as it reads, a FIFO flush
+    command empties it and a full FIFO drops its oldest frames.
+*/
+class HostBmi270Model : public HostI2cRegisterFile {
+public:
+    /* Runtime member variables */
+    bool m_init_failure;                    /* the initialization reports an error whatever was uploaded */
+    int64_t m_init_end_us;                  /* of the initialization started, 0 when none is pending */
+    uint32_t m_config_bytes;                /* end of the last config file write since INIT_CTRL was cleared */
+    bool m_config_in_order;
+    uint32_t m_refused_bytes;               /* pushed before the initialization or with the sensors off */
+    std::deque<uint8_t> m_fifo;
+
+public:
+    HostBmi270Model();
+    virtual ~HostBmi270Model() {}
+
+public:
+    void SetInitFailure(bool failure) { m_init_failure = failure; }
+    bool IsInitialized();
+    void PushFrames(const uint8_t *p_frames, uint16_t size);
+
+public:
+    virtual esp_err_t Read(uint32_t reg_addr, uint8_t *buffer, uint16_t size);
+    virtual esp_err_t Write(uint32_t reg_addr, const uint8_t *buffer, uint16_t size);
+
+private:
+    void reset();
+    void update();
+};
+
+/* AXP192 with a battery attached and no USB power, the ADC registers hold the battery voltage and charging current. */
+class HostAxp192Model : public HostI2cRegisterFile {
+public:
+    HostAxp192Model();
+    virtual ~HostAxp192Model() {}
+
+public:
+    void SetBattery(uint32_t voltage_mv, uint32_t charging_current_ma, bool vbus_present);
+};
+
+/* BM8563 real time clock, the date and time registers count from the last write on the host clock. */
+class HostBm8563Model : public HostI2cRegisterFile {
+public:
+    /* Runtime member variables */
+    time_t m_base_time;
+    int64_t m_base_us;
+
+public:
+    HostBm8563Model();
+    virtual ~HostBm8563Model() {}
+
+public:
+    void SetTime(time_t time);
+    time_t GetTime() const;
+
+public:
+    virtual esp_err_t Read(uint32_t reg_addr, uint8_t *buffer, uint16_t size);
+    virtual esp_err_t Write(uint32_t reg_addr, const uint8_t *buffer, uint16_t size);
+};
+
+/* FT6336U touch controller with a single touch point. */
+class HostFt6x36uModel : public HostI2cRegisterFile {
+public:
+    HostFt6x36uModel();
+    virtual ~HostFt6x36uModel() {}
+
+public:
+    void Touch(uint16_t x, uint16_t y);
+    void Release();
+};
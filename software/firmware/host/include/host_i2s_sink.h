@@ -0,0 +1,40 @@
+/*
+    Host side I2S sink.
+    Everything written to the transmit channel of an I2sMaster ends up here. The sink counts the bytes, keeps a FNV-1a
+    hash of the whole stream so two runs can be compared sample for sample, and optionally copies the raw stream into a
+    file which can be imported as signed 8-bit PCM.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <esp_err.h>
+#include <driver/i2s_std.h>
+
+#define HOST_I2S_FNV1A_OFFSET_BASIS     (0xcbf29ce484222325ULL)
+#define HOST_I2S_FNV1A_PRIME            (0x00000100000001b3ULL)
+
+/* The NS4168 stream repeats every signed 8-bit sample in 4 bytes, whatever the configured bits and channels. */
+#define HOST_I2S_BYTES_PER_SAMPLE       (4)
+
+class HostI2sSink {
+public:
+    static HostI2sSink m_sink[SOC_I2S_NUM];
+    uint64_t m_bytes_written;
+    uint64_t m_hash;
+    FILE *m_p_capture_file;
+
+public:
+    HostI2sSink();
+
+public:
+    static HostI2sSink *GetSink(i2s_port_t port);
+
+public:
+    void Reset();
+    void Capture(FILE *p_file);
+    esp_err_t Write(const void *src, size_t size);
+};
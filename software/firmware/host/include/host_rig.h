@@ -0,0 +1,113 @@
+/*
+    Host rig: the firmware data path assembled on the host bus, driven one raw frame at a time.
+    A frame is handled exactly as on the device: DPS3xx, BMI270 and AXP192 frames go through the driver process_data(), NMEA
+    sentences through NeoM9nGnss::process_gnss_sentence(), the resulting messages through
+    BluethroatMsgProc::process_message(). Before a frame is handled, the NS4168 tone generator and the AXP192 polling
+    loop are run until they catch up with the frame timestamp, so the output only depends on the frame sequence and the
+    host programs feeding the same frames get the same output, whatever their pace.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include "utilities/frame_recorder.h"
+#include "drivers/axp192_pmu.h"
+#include "drivers/bmi270_imu.h"
+#include "drivers/dps3xx_anemometer.h"
+#include "drivers/dps3xx_barometer.h"
+#include "drivers/neo_m9n_gnss.h"
+#include "drivers/ns4168_sound.h"
+#include "bluethroat_msg_proc.h"
+#include "host_i2c_bus.h"
+#include "host_i2c_models.h"
+#include "host_i2s_sink.h"
+
+typedef enum {
+    HOST_STAGE_BAROMETER = 0,
+    HOST_STAGE_ANEMOMETER,
+    HOST_STAGE_IMU,
+    HOST_STAGE_PMU,
+    HOST_STAGE_GNSS,
+    HOST_STAGE_MSG_PROC,
+    HOST_STAGE_SOUND,
+    HOST_STAGE_MAX,
+} HostStage_t;
+
+typedef struct {
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} HostStageStats_t;
+
+class HostRig {
+public:
+    /* Simulated devices */
+    HostI2cRegisterFile m_barometer_registers;
+    HostI2cRegisterFile m_anemometer_registers;
+    HostBmi270Model m_imu_model;            /* refuses the FIFO reads until the config file is uploaded */
+    HostI2cRegisterFile m_pmu_registers;
+
+    /* Firmware objects */
+    I2cMaster *m_p_i2c_master;
+    Dps3xxBarometer *m_p_barometer;
+    Dps3xxAnemometer *m_p_anemometer;
+    Bmi270Imu *m_p_imu;
+    Axp192Pmu *m_p_pmu;
+    NeoM9nGnss *m_p_gnss;
+    QueueHandle_t m_gnss_queue;
+    BluethroatMsgProc *m_p_msg_proc;
+    I2sMaster *m_p_i2s_master;
+    Ns4168Sound *m_p_sound;
+    HostI2sSink *m_p_sink;
+
+    /* Configuration member variables */
+    bool m_second_static;                   /* the second DPS3xx is a static port, not a pitot anemometer */
+
+    /* Runtime member variables */
+    uint32_t m_now_ms;
+    Axp192PmuStatus_t m_pmu_status;
+    bool m_pmu_status_valid;
+    uint32_t m_pmu_next_ms;
+    uint32_t m_frame_counts[FRAME_TYPE_MAX];
+    uint32_t m_skipped_frames;
+    HostStageStats_t m_stats[HOST_STAGE_MAX];
+
+    /* Output trace, one line per barometer sample */
+    FILE *m_p_trace_file;
+    FILE *m_p_expected_trace_file;
+    uint32_t m_trace_lines;
+    uint32_t m_trace_mismatches;
+
+    /* Barometer, anemometer and acceleration messages handed to the message processor, in order, when set */
+    std::vector<BluethroatMsg_t> *m_p_message_log;
+
+public:
+    HostRig();
+    ~HostRig();
+
+public:
+    esp_err_t Init(int32_t volume);
+    esp_err_t ProcessFrame(const FrameHeader_t *p_header, const uint8_t *p_payload);
+    void Finish();
+    void SetTrace(FILE *p_trace_file, FILE *p_expected_trace_file);
+    void SetMessageLog(std::vector<BluethroatMsg_t> *p_message_log);
+    void SetSecondStatic(bool second_static);
+    void PrintSummary(FILE *p_file);
+
+private:
+    void advance(uint32_t timestamp);
+    esp_err_t process_coef(uint8_t source, const uint8_t *p_payload, uint8_t size);
+    esp_err_t process_dps3xx(uint8_t source, uint32_t timestamp, const uint8_t *p_payload, uint8_t size);
+    esp_err_t process_mode(uint8_t source, const uint8_t *p_payload, uint8_t size);
+    esp_err_t process_bmi270(uint8_t source, uint32_t timestamp, const uint8_t *p_payload, uint8_t size);
+    esp_err_t process_pmu(uint32_t timestamp, const uint8_t *p_payload, uint8_t size);
+    esp_err_t process_nmea(const uint8_t *p_payload, uint8_t size);
+    void process_message(BluethroatMsg_t *p_message);
+    void trace(uint32_t timestamp);
+};
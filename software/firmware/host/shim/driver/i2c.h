@@ -0,0 +1,23 @@
+/*
+    Host shim of ESP-IDF driver/i2c.h.
+    The I2C transactions are not emulated at command link level, I2cMaster is reimplemented on the host on top of 
+    HostI2cBus (see host_i2c_bus.h), so only the types used in the class declarations are provided.
+*/
+
+#pragma once
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+typedef int i2c_port_t;
+
+#define I2C_NUM_0           (0)
+#define I2C_NUM_1           (1)
+#define I2C_NUM_MAX         (2)
+
+typedef enum {
+    I2C_MASTER_WRITE = 0,
+    I2C_MASTER_READ,
+} i2c_rw_t;
+
+typedef void *i2c_cmd_handle_t;
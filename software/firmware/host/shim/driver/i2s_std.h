@@ -0,0 +1,38 @@
+/*
+    Host shim of ESP-IDF driver/i2s_std.h.
+    I2sMaster is reimplemented on the host, the channel read and write functions feed HostI2sSink (see host_i2s_sink.h).
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+typedef int i2s_port_t;
+
+#define I2S_NUM_0           (0)
+#define I2S_NUM_1           (1)
+#define SOC_I2S_NUM         (2)
+
+typedef enum {
+    I2S_DATA_BIT_WIDTH_8BIT  = 8,
+    I2S_DATA_BIT_WIDTH_16BIT = 16,
+    I2S_DATA_BIT_WIDTH_24BIT = 24,
+    I2S_DATA_BIT_WIDTH_32BIT = 32,
+} i2s_data_bit_width_t;
+
+typedef struct HostI2sChannel *i2s_chan_handle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t i2s_channel_write(i2s_chan_handle_t handle, const void *src, size_t size, size_t *bytes_written, uint32_t timeout_ms);
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void *dest, size_t size, size_t *bytes_read, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,12 @@
+/*
+    Host shim of ESP-IDF esp_compiler.h, included by FreeRTOS.h as on the device.
+*/
+
+#pragma once
+
+#ifndef likely
+#define likely(x)                       __builtin_expect(!!(x), 1)
+#endif
+#ifndef unlikely
+#define unlikely(x)                     __builtin_expect(!!(x), 0)
+#endif
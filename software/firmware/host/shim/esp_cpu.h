@@ -0,0 +1,28 @@
+/*
+    Host shim of ESP-IDF esp_cpu.h.
+    The cycle counter is the x86 time stamp counter, which counts at a constant reference rate rather than core cycles,
+    or nanoseconds of the monotonic clock on other hosts. Like CCOUNT on the ESP32 it is 32 bits wide, differences must
+    be taken in esp_cpu_cycle_count_t.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+static inline esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return (esp_cpu_cycle_count_t)__rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (esp_cpu_cycle_count_t)((uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec);
+#endif
+}
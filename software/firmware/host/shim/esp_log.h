@@ -0,0 +1,55 @@
+/*
+    Host shim of ESP-IDF esp_log.h.
+    Log lines are written to stderr in the same "L (timestamp) TAG: message" layout as on the device. The level check is 
+    done before the arguments are evaluated, so disabled log lines cost nothing on the hot path.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+esp_log_level_t esp_log_level_get(const char *tag);
+uint32_t esp_log_timestamp(void);
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) __attribute__ ((format (printf, 3, 4)));
+void esp_log_buffer_hex_internal(const char *tag, const void *buffer, uint16_t buff_len, esp_log_level_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ESP_LOG_LEVEL(level, tag, letter, format, ...)                                                      \
+    do {                                                                                                    \
+        if (esp_log_level_get(tag) >= (level)) {                                                            \
+            esp_log_write((level), (tag), letter " (%u) %s: " format "\n", (unsigned int)esp_log_timestamp(), (tag), ##__VA_ARGS__); \
+        }                                                                                                   \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_ERROR,   tag, "E", format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_WARN,    tag, "W", format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_INFO,    tag, "I", format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_DEBUG,   tag, "D", format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_VERBOSE, tag, "V", format, ##__VA_ARGS__)
+
+#define ESP_LOG_BUFFER_HEX_LEVEL(tag, buffer, buff_len, level)                                              \
+    do {                                                                                                    \
+        if (esp_log_level_get(tag) >= (level)) {                                                            \
+            esp_log_buffer_hex_internal((tag), (buffer), (buff_len), (level));                              \
+        }                                                                                                   \
+    } while (0)
+
+#define ESP_LOG_BUFFER_HEX(tag, buffer, buff_len) ESP_LOG_BUFFER_HEX_LEVEL(tag, buffer, buff_len, ESP_LOG_INFO)
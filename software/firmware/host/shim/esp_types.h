@@ -0,0 +1,9 @@
+/*
+    Host shim of ESP-IDF esp_types.h.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
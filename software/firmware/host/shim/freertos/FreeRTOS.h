@@ -0,0 +1,54 @@
+/*
+    Host shim of FreeRTOS.h.
+    Tasks are mapped to POSIX threads, queues and semaphores to buffers guarded by one kernel mutex, and the tick counter
+    to the host clock at CONFIG_FREERTOS_HZ, real or virtual (host_clock.h). Only the API used by the firmware sources is
+    provided.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "sdkconfig.h"
+#include "esp_compiler.h"
+#include "esp_err.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                         ((BaseType_t)0)
+#define pdTRUE                          ((BaseType_t)1)
+#define pdFAIL                          (pdFALSE)
+#define pdPASS                          (pdTRUE)
+#define errQUEUE_EMPTY                  ((BaseType_t)0)
+#define errQUEUE_FULL                   ((BaseType_t)0)
+
+#define configTICK_RATE_HZ              (CONFIG_FREERTOS_HZ)
+#define configMAX_PRIORITIES            (25)
+#define configMINIMAL_STACK_SIZE        (768)
+
+#define portMAX_DELAY                   ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS              ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portPRIVILEGE_BIT               ((UBaseType_t)0x00)
+#define portNUM_PROCESSORS              (2)
+
+#define pdMS_TO_TICKS(xTimeInMs)        ((TickType_t)(((uint64_t)(xTimeInMs) * (uint64_t)configTICK_RATE_HZ) / (uint64_t)1000U))
+#define pdTICKS_TO_MS(xTicks)           ((uint32_t)(((uint64_t)(xTicks) * (uint64_t)1000U) / (uint64_t)configTICK_RATE_HZ))
+
+#define tskIDLE_PRIORITY                ((UBaseType_t)0U)
+#define tskNO_AFFINITY                  (0x7FFFFFFF)
+
+#define IRAM_ATTR
+
+/* Spinlocks of the dual core port, on host all critical sections share one recursive mutex. */
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    {0, 0}
+#define SPINLOCK_INITIALIZER            portMUX_INITIALIZER_UNLOCKED
+#define portMUX_INITIALIZE(mux)         do { (mux)->owner = 0; (mux)->count = 0; } while (0)
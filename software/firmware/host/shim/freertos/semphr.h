@@ -0,0 +1,27 @@
+/*
+    Host shim of FreeRTOS semphr.h.
+    As in FreeRTOS, a semaphore is a queue of zero sized items, a mutex is a semaphore created in the given state.
+*/
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define xSemaphoreTake(xSemaphore, xBlockTime)  xQueueReceive((xSemaphore), NULL, (xBlockTime))
+#define xSemaphoreGive(xSemaphore)              xQueueSend((xSemaphore), NULL, 0)
+#define vSemaphoreDelete(xSemaphore)            vQueueDelete(xSemaphore)
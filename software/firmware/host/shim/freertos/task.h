@@ -0,0 +1,34 @@
+/*
+    Host shim of FreeRTOS task.h.
+*/
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HostTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth, void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask, BaseType_t xCoreID);
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth, void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask);
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+void vTaskDelay(const TickType_t xTicksToDelay);
+void vTaskDelayUntil(TickType_t *pxPreviousWakeTime, const TickType_t xTimeIncrement);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+void vTaskYield(void);
+void vTaskEnterCritical(portMUX_TYPE *mux);
+void vTaskExitCritical(portMUX_TYPE *mux);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define taskYIELD()                 vTaskYield()
+#define taskENTER_CRITICAL(mux)     vTaskEnterCritical(mux)
+#define taskEXIT_CRITICAL(mux)      vTaskExitCritical(mux)
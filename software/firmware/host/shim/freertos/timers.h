@@ -0,0 +1,25 @@
+/*
+    Host shim of FreeRTOS timers.h.
+    Every timer runs on its own thread, callbacks are called from that thread instead of the timer service task.
+*/
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HostTimer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t xTimer);
+
+TimerHandle_t xTimerCreate(const char *pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void *pvTimerID, TimerCallbackFunction_t pxCallbackFunction);
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait);
+void *pvTimerGetTimerID(TimerHandle_t xTimer);
+
+#ifdef __cplusplus
+}
+#endif
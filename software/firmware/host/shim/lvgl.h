@@ -0,0 +1,30 @@
+/*
+    Host shim of lvgl.h.
+    The GUI is not built on the host, only the types used in the declarations of bluethroat_gui.h are provided so that 
+    message procedure sources can include it.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+typedef int16_t lv_coord_t;
+typedef uint8_t lv_opa_t;
+typedef uint8_t lv_align_t;
+typedef uint8_t lv_text_align_t;
+typedef uint32_t lv_style_selector_t;
+
+typedef union {
+    uint16_t full;
+} lv_color_t;
+
+typedef struct {
+    lv_coord_t x;
+    lv_coord_t y;
+} lv_point_t;
+
+typedef struct _lv_obj_t lv_obj_t;
+typedef struct _lv_font_t lv_font_t;
+typedef struct _lv_meter_indicator_t lv_meter_indicator_t;
+
+#define LV_FONT_DECLARE(font_name) extern const lv_font_t font_name;
@@ -0,0 +1,5 @@
+/*
+    Host shim of lvgl_helpers.h, nothing is needed on the host.
+*/
+
+#pragma once
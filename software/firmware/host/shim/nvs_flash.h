@@ -0,0 +1,17 @@
+/*
+    Host shim of ESP-IDF nvs_flash.h.
+    BluethroatConfig is replaced by an in-memory store on the host, only the handle type is needed here.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE,
+} nvs_open_mode_t;
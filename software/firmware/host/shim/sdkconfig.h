@@ -0,0 +1,96 @@
+/*
+    Host shim of the generated sdkconfig.h.
+    Mirrors the options of sdkconfig.m5stack-core2aws that the host-built sources depend on, so the host binary runs the 
+    same code paths as the default PlatformIO environment.
+*/
+
+#pragma once
+
+#define CONFIG_BLUETHROAD_TARGET_DEVICE_M5CORE2AWS      1
+
+#define CONFIG_FREERTOS_HZ                              100
+#define CONFIG_LOG_DEFAULT_LEVEL                        2
+
+#define CONFIG_I2C_PORT_0_ENABLED                       1
+#define CONFIG_I2C_PORT_0_SDA                           21
+#define CONFIG_I2C_PORT_0_SCL                           22
+#define CONFIG_I2C_PORT_0_FREQ_HZ                       400000
+#define CONFIG_I2C_PORT_0_TIMEOUT                       20
+#define CONFIG_I2C_PORT_0_LOCK_TIMEOUT                  50
+#define CONFIG_I2C_PORT_1_ENABLED                       1
+#define CONFIG_I2C_PORT_1_SDA                           32
+#define CONFIG_I2C_PORT_1_SCL                           33
+#define CONFIG_I2C_PORT_1_FREQ_HZ                       1000000
+#define CONFIG_I2C_PORT_1_TIMEOUT                       20
+#define CONFIG_I2C_PORT_1_LOCK_TIMEOUT                  50
+
+#define CONFIG_I2S_PORT_0_ENABLED                       1
+#define CONFIG_I2S_PORT_0_MCLK                          -1
+#define CONFIG_I2S_PORT_0_BCLK                          12
+#define CONFIG_I2S_PORT_0_WS                            0
+#define CONFIG_I2S_PORT_0_DIN                           2
+#define CONFIG_I2S_PORT_0_DOUT                          2
+#define CONFIG_I2S_PORT_0_SAMPLE_RATE                   44100
+#define CONFIG_I2S_PORT_0_SAMPLE_BITS                   8
+#define CONFIG_I2S_PORT_0_CHANNEL_NUM                   2
+
+#define CONFIG_I2C_DEVICE_AXP192                        1
+#define CONFIG_I2C_DEVICE_AXP192_BATTERY_CAPACITY_MAH   500
+#define CONFIG_I2C_DEVICE_AXP192_CHARGING_CURRENT_05C   1
+#define CONFIG_I2C_DEVICE_AXP192_SOFTWARE_LED           1
+#define CONFIG_I2C_DEVICE_AXP192_SOFTWARE_LED_PWM       1
+#define CONFIG_I2C_DEVICE_BM8563                        1
+#define CONFIG_I2C_DEVICE_FT6X36U                       1
+#define CONFIG_I2C_DEVICE_DPS3XX                        1
+#define CONFIG_I2C_DEVICE_DPS3XX_FIFO_BURST_SAMPLES     2
+#define CONFIG_I2C_DEVICE_DPS3XX_TEMPERATURE_RATIO      8
+#define CONFIG_I2C_DEVICE_DPS3XX_LOW_POWER_ON_GROUND    1
+#define CONFIG_I2C_DEVICE_BMI270                        1
+#define CONFIG_I2C_DEVICE_BMI270_ATTITUDE_TIME          5
+#define CONFIG_I2C_DEVICE_BMI270_ATTITUDE_GATE          15
+#define CONFIG_I2S_DEVICE_NS4168                        1
+
+#define CONFIG_GNSS_MODULE_ENABLED                      1
+#define CONFIG_GNSS_UART_PORT                           2
+#define CONFIG_GNSS_UART_PORT_TX_PIN                    14
+#define CONFIG_GNSS_UART_PORT_RX_PIN                    13
+#define CONFIG_GNSS_UART_PORT_BAUDRATE                  38400
+
+#define CONFIG_FRAME_RECORDER_ENABLED                   1
+#define CONFIG_FRAME_RECORDER_PATH                      "frames.btr"
+#define CONFIG_FRAME_RECORDER_BUFFER_SIZE               4096
+#define CONFIG_FRAME_RECORDER_MAX_FILE_SIZE             1572864
+
+#define CONFIG_LATENCY_TRACE_ENABLED                    1
+#define CONFIG_LATENCY_TRACE_REPORT_INTERVAL_S          60
+
+#define CONFIG_VARIO_ENGINE_KALMAN                      1
+#define CONFIG_VARIO_KALMAN_PROCESS_NOISE               100
+#define CONFIG_VARIO_KALMAN_MEASUREMENT_NOISE           20
+#define CONFIG_VARIO_INERTIAL_ACCELERATION_NOISE        30
+#define CONFIG_VARIO_INERTIAL_BIAS_NOISE                2
+#define CONFIG_VARIO_TOTAL_ENERGY                       1
+#define CONFIG_VARIO_SECOND_DPS3XX_ANEMOMETER           1
+#define CONFIG_VARIO_REDUNDANT_STATIC_AVERAGE           1
+#define CONFIG_VARIO_REDUNDANT_STATIC_MAX_DIFFERENCE    50
+#define CONFIG_VARIO_TEMPERATURE_COMPENSATION           1
+#define CONFIG_VARIO_TEMPERATURE_MIN_SPAN               20
+#define CONFIG_VARIO_TEMPERATURE_GNSS_CORRECTION        1
+#define CONFIG_VARIO_POLAR_SPEED_1                      26
+#define CONFIG_VARIO_POLAR_SINK_1                       115
+#define CONFIG_VARIO_POLAR_SPEED_2                      37
+#define CONFIG_VARIO_POLAR_SINK_2                       110
+#define CONFIG_VARIO_POLAR_SPEED_3                      52
+#define CONFIG_VARIO_POLAR_SINK_3                       200
+#define CONFIG_VARIO_QNH                                101325
+#define CONFIG_VARIO_BAROMETRIC_ALTITUDE                1
+#define CONFIG_VARIO_WIND_WINDOW                        32
+#define CONFIG_VARIO_WIND_MIN_TURN                      300
+#define CONFIG_VARIO_AVERAGE_SHORT_WINDOW               5
+#define CONFIG_VARIO_AVERAGE_LONG_WINDOW                30
+#define CONFIG_VARIO_TAKEOFF_SPEED                      15
+#define CONFIG_VARIO_TAKEOFF_TIME                       10
+#define CONFIG_VARIO_LANDING_SPEED                      5
+#define CONFIG_VARIO_LANDING_TIME                       30
+#define CONFIG_VARIO_MACCREADY                          0
+#define CONFIG_VARIO_FINAL_GLIDE_MARGIN                 100
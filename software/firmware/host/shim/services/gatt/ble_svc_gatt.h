@@ -0,0 +1,5 @@
+/*
+    Host shim of NimBLE ble_svc_gatt.h, nothing is needed on the host.
+*/
+
+#pragma once
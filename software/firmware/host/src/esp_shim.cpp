@@ -0,0 +1,110 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <esp_log.h>
+#include <driver/uart.h>
+
+static std::mutex s_log_mutex;
+static esp_log_level_t s_log_default_level = (esp_log_level_t)CONFIG_LOG_DEFAULT_LEVEL;
+static std::map<std::string, esp_log_level_t> s_log_tag_levels;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    std::lock_guard<std::mutex> lock(s_log_mutex);
+    if (strcmp(tag, "*") == 0) {
+        s_log_default_level = level;
+        s_log_tag_levels.clear();
+    } else {
+        s_log_tag_levels[tag] = level;
+    }
+}
+
+esp_log_level_t esp_log_level_get(const char *tag) {
+    std::lock_guard<std::mutex> lock(s_log_mutex);
+    if (!s_log_tag_levels.empty()) {
+        std::map<std::string, esp_log_level_t>::const_iterator it = s_log_tag_levels.find(tag);
+        if (it != s_log_tag_levels.end()) {
+            return it->second;
+        }
+    }
+    return s_log_default_level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    (void)level;
+    (void)tag;
+
+    va_list args;
+    va_start(args, format);
+    {
+        std::lock_guard<std::mutex> lock(s_log_mutex);
+        vfprintf(stderr, format, args);
+    }
+    va_end(args);
+}
+
+void esp_log_buffer_hex_internal(const char *tag, const void *buffer, uint16_t buff_len, esp_log_level_t level) {
+    (void)level;
+
+    const uint8_t *bytes = (const uint8_t *)buffer;
+    std::lock_guard<std::mutex> lock(s_log_mutex);
+    for (uint16_t offset = 0; offset < buff_len; offset += 16) {
+        fprintf(stderr, "  (%u) %s: ", (unsigned int)esp_log_timestamp(), tag);
+        for (uint16_t i = offset; i < buff_len && i < offset + 16; i++) {
+            fprintf(stderr, "%02x ", bytes[i]);
+        }
+        fprintf(stderr, "\n");
+    }
+}
+
+/*
+    There is no UART on the host, NMEA sentences are fed to the GNSS parser directly.
+*/
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config) {
+    (void)uart_num; (void)uart_config;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num) {
+    (void)uart_num; (void)tx_io_num; (void)rx_io_num; (void)rts_io_num; (void)cts_io_num;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size, QueueHandle_t *uart_queue, int intr_alloc_flags) {
+    (void)uart_num; (void)rx_buffer_size; (void)tx_buffer_size; (void)queue_size; (void)uart_queue; (void)intr_alloc_flags;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t uart_enable_pattern_det_baud_intr(uart_port_t uart_num, char pattern_chr, uint8_t chr_num, int chr_tout, int post_idle, int pre_idle) {
+    (void)uart_num; (void)pattern_chr; (void)chr_num; (void)chr_tout; (void)post_idle; (void)pre_idle;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t uart_pattern_queue_reset(uart_port_t uart_num, int queue_length) {
+    (void)uart_num; (void)queue_length;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num) {
+    (void)uart_num;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t *size) {
+    (void)uart_num;
+    *size = 0;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+int uart_pattern_pop_pos(uart_port_t uart_num) {
+    (void)uart_num;
+    return -1;
+}
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait) {
+    (void)uart_num; (void)buf; (void)length; (void)ticks_to_wait;
+    return -1;
+}
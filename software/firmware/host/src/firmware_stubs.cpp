@@ -0,0 +1,201 @@
+#include <string.h>
+#include <map>
+#include <string>
+
+#include "drivers/bm8563_rtc.h"
+#include "drivers/bmi270_imu.h"
+#include "bluethroat_bluetooth.h"
+#include "bluethroat_config.h"
+#include "bluethroat_gui.h"
+#include "host_firmware_stubs.h"
+
+HostGuiState_t g_HostGuiState;
+HostBluetoothState_t g_HostBluetoothState;
+
+void HostResetFirmwareStubs() {
+    memset(&g_HostGuiState, 0, sizeof(g_HostGuiState));
+    memset(&g_HostBluetoothState, 0, sizeof(g_HostBluetoothState));
+}
+
+/***********************************************************************************************************************
+ * GUI
+***********************************************************************************************************************/
+BluethroatGui *g_p_BluethroatGui = NULL;
+
+void GuiSetClock(const char *clock_string) {
+    strncpy(g_HostGuiState.clock, clock_string, sizeof(g_HostGuiState.clock) - 1);
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetBatteryState(uint16_t battery_voltage, bool is_charging, bool is_activiting, bool is_undercurrent) {
+    g_HostGuiState.battery_voltage = battery_voltage;
+    g_HostGuiState.is_charging = is_charging;
+    g_HostGuiState.is_activiting = is_activiting;
+    g_HostGuiState.is_undercurrent = is_undercurrent;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetBluetoothState(GuiBluetoothState_t state) {
+    g_HostGuiState.bluetooth_state = state;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetGnssStatus(GuiGnssStatus_t status) {
+    g_HostGuiState.gnss_status = status;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetSpeed(float speed) {
+    g_HostGuiState.speed = speed;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetAltitude(float altitude) {
+    g_HostGuiState.altitude = altitude;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetAgl(float agl) {
+    g_HostGuiState.agl = agl;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetVerticalSpeed(float vertical_speed) {
+    g_HostGuiState.vertical_speed = vertical_speed;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetNettoVerticalSpeed(float netto_vertical_speed, float relative_vertical_speed) {
+    g_HostGuiState.netto_vertical_speed = netto_vertical_speed;
+    g_HostGuiState.relative_vertical_speed = relative_vertical_speed;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetWind(float speed, float direction) {
+    g_HostGuiState.wind_speed = speed;
+    g_HostGuiState.wind_direction = direction;
+    g_HostGuiState.wind_count++;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetClimbAverages(const ClimbAverager *p_averager) {
+    g_HostGuiState.short_average = p_averager->GetAverage(CLIMB_WINDOW_SHORT);
+    g_HostGuiState.long_average = p_averager->GetAverage(CLIMB_WINDOW_LONG);
+    g_HostGuiState.thermal_average = p_averager->GetThermalAverage();
+    g_HostGuiState.thermal_gain = p_averager->GetThermalGain();
+    g_HostGuiState.climb_count++;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetGlide(const GlideComputer *p_glide) {
+    g_HostGuiState.speed_to_fly = p_glide->GetSpeedToFly();
+    g_HostGuiState.final_glide_speed = p_glide->GetFinalGlideSpeed();
+    g_HostGuiState.waypoint_distance = p_glide->GetDistance();
+    g_HostGuiState.required_glide = p_glide->GetRequiredGlide();
+    g_HostGuiState.glide = p_glide->GetGlide();
+    g_HostGuiState.arrival_altitude = p_glide->GetArrivalAltitude();
+    g_HostGuiState.glide_count++;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetThermal(const ThermalAssistant *p_thermal) {
+    g_HostGuiState.circling = p_thermal->IsCircling();
+    g_HostGuiState.thermal_core_valid = p_thermal->IsCoreValid();
+    g_HostGuiState.thermal_core_east = p_thermal->GetCoreEast();
+    g_HostGuiState.thermal_core_north = p_thermal->GetCoreNorth();
+    g_HostGuiState.thermal_climb = p_thermal->GetThermalClimb();
+    g_HostGuiState.thermal_count++;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetFlightStats(FlightState_t state, uint32_t airtime, float distance) {
+    g_HostGuiState.flight_state = state;
+    g_HostGuiState.airtime = airtime;
+    g_HostGuiState.distance = distance;
+    g_HostGuiState.update_count++;
+}
+
+void GuiSetTaskStats(const TaskStats_t *p_stats, uint32_t count) {
+    (void)p_stats;
+    g_HostGuiState.task_stats_count = count;
+}
+
+/***********************************************************************************************************************
+ * BMI270 config file, embedded from the binary of the Bosch SensorAPI on the device. The stand-in only has its size,
+ * the BMI270 model checks that all of it is uploaded, not what it holds.
+***********************************************************************************************************************/
+const uint8_t g_bmi270_config_file[BMI270_CONFIG_FILE_SIZE] = {0};
+
+/***********************************************************************************************************************
+ * Bluetooth
+***********************************************************************************************************************/
+int BluetoothSendPressure(float pressure) {
+    g_HostBluetoothState.pressure_notify_count++;
+    g_HostBluetoothState.last_pressure = pressure;
+    return 0;
+}
+
+int BluetoothSendGnssNmea(const char *nmea) {
+    (void)nmea;
+    g_HostBluetoothState.nmea_notify_count++;
+    return 0;
+}
+
+int BluetoothSendClimb(const ClimbRecord_t *p_record) {
+    g_HostBluetoothState.climb_notify_count++;
+    g_HostBluetoothState.last_climb = *p_record;
+    return 0;
+}
+
+/***********************************************************************************************************************
+ * Configuration, kept in memory instead of NVS.
+***********************************************************************************************************************/
+static std::map<std::string, std::string> s_config_strings;
+static std::map<std::string, int32_t> s_config_integers;
+
+BluethroatConfig *g_pBluethroatConfig = NULL;
+
+BluethroatConfig::BluethroatConfig() {
+}
+
+BluethroatConfig::~BluethroatConfig() {
+}
+
+esp_err_t BluethroatConfig::SetString(const char *name_space, const char *key, const char *value) {
+    s_config_strings[std::string(name_space) + "/" + key] = value;
+    return ESP_OK;
+}
+
+esp_err_t BluethroatConfig::GetString(const char *name_space, const char *key, char *value, size_t *length) {
+    std::map<std::string, std::string>::const_iterator it = s_config_strings.find(std::string(name_space) + "/" + key);
+    if (it == s_config_strings.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    size_t required = it->second.size() + 1;
+    if (value == NULL) {
+        *length = required;
+        return ESP_OK;
+    } else if (*length < required) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memcpy(value, it->second.c_str(), required);
+    *length = required;
+    return ESP_OK;
+}
+
+esp_err_t BluethroatConfig::SetInteger(const char *name_space, const char *key, int32_t value) {
+    s_config_integers[std::string(name_space) + "/" + key] = value;
+    return ESP_OK;
+}
+
+esp_err_t BluethroatConfig::GetInteger(const char *name_space, const char *key, int32_t *value) {
+    std::map<std::string, int32_t>::const_iterator it = s_config_integers.find(std::string(name_space) + "/" + key);
+    if (it == s_config_integers.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    *value = it->second;
+    return ESP_OK;
+}
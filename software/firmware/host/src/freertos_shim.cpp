@@ -0,0 +1,631 @@
+#include <pthread.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+
+#include "host_clock.h"
+
+static const char *TAG = "HOST_FREERTOS";
+
+struct HostQueue {
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    std::vector<uint8_t> storage;
+};
+
+struct HostTask {
+    std::string name;
+    TaskFunction_t entry;
+    void *param;
+    UBaseType_t priority;
+    BaseType_t core_id;
+};
+
+struct HostTimer {
+    std::string name;
+    TickType_t period;
+    bool auto_reload;
+    void *id;
+    TimerCallbackFunction_t callback;
+    uint32_t generation;
+    bool deleted;
+};
+
+struct HostEspTimer {
+    std::string name;
+    esp_timer_cb_t callback;
+    void *arg;
+    uint32_t generation;
+    bool active;
+    bool deleted;
+};
+
+typedef std::function<bool()> HostPredicate_t;
+
+/* A task blocked in virtual mode, woken by a state change making its predicate true or by the clock reaching the deadline. */
+struct HostWaiter {
+    std::condition_variable condition;
+    const HostPredicate_t *p_predicate;
+    int64_t deadline_us;
+    bool woken;
+};
+
+/*
+    All queues and timers share the kernel mutex, every change of their state is followed by kernel_changed() which
+    wakes the waiters. In virtual mode the kernel counts the runnable tasks, the threads of tasks and timers and the
+    thread which set the mode, when the last of them blocks the clock jumps to the earliest deadline.
+*/
+struct HostKernel {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::atomic<HostClockMode_t> mode;
+    std::atomic<int64_t> now_us;
+    std::list<HostWaiter *> waiters;
+    uint32_t runnable;
+    bool deadlock_reported;
+
+    HostKernel() : mode(HOST_CLOCK_REAL), now_us(0), runnable(0), deadlock_reported(false) {}
+};
+
+static thread_local HostTask *s_p_current_task = NULL;
+static std::recursive_mutex s_critical_mutex;
+
+static HostKernel *host_kernel() {
+    // Never destroyed, detached tasks may still wait on it while the process exits.
+    static HostKernel *p_kernel = new HostKernel();
+    return p_kernel;
+}
+
+static std::chrono::steady_clock::time_point host_clock_origin() {
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return origin;
+}
+
+static int64_t real_clock_us() {
+    return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - host_clock_origin()).count();
+}
+
+/* FreeRTOS wakes up tasks on the tick interrupt, a timeout of n ticks ends n ticks after the start of the current one. */
+static int64_t tick_deadline_us(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        return HOST_CLOCK_FOREVER;
+    }
+
+    int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+    return (HostClockNowUs() / tick_us + ticks) * tick_us;
+}
+
+static void kernel_wake(HostKernel *p_kernel, HostWaiter *p_waiter) {
+    p_waiter->woken = true;
+    p_kernel->runnable++;
+    p_waiter->condition.notify_one();
+}
+
+/* Called with the kernel lock held after a queue or timer changed. */
+static void kernel_changed(HostKernel *p_kernel) {
+    if (p_kernel->mode == HOST_CLOCK_REAL) {
+        p_kernel->changed.notify_all();
+        return;
+    }
+
+    for (HostWaiter *p_waiter : p_kernel->waiters) {
+        if (!p_waiter->woken && p_waiter->p_predicate != NULL && (*p_waiter->p_predicate)()) {
+            kernel_wake(p_kernel, p_waiter);
+        }
+    }
+}
+
+/* Called with the kernel lock held when a task blocks or exits in virtual mode, once no task can run the clock moves on. */
+static void kernel_idle(HostKernel *p_kernel) {
+    if (p_kernel->runnable > 0) {
+        return;
+    }
+
+    int64_t next_us = HOST_CLOCK_FOREVER;
+    for (HostWaiter *p_waiter : p_kernel->waiters) {
+        if (!p_waiter->woken && p_waiter->deadline_us < next_us) {
+            next_us = p_waiter->deadline_us;
+        }
+    }
+
+    if (next_us == HOST_CLOCK_FOREVER) {
+        if (!p_kernel->deadlock_reported) {
+            ESP_LOGE(TAG, "All tasks wait forever at %lld us.", (long long)p_kernel->now_us.load());
+            p_kernel->deadlock_reported = true;
+        }
+        return;
+    }
+
+    if (next_us > p_kernel->now_us) {
+        p_kernel->now_us = next_us;
+    }
+    for (HostWaiter *p_waiter : p_kernel->waiters) {
+        if (!p_waiter->woken && p_waiter->deadline_us <= next_us) {
+            kernel_wake(p_kernel, p_waiter);
+        }
+    }
+}
+
+/* A thread of a task or timer counts as runnable from its creation, before the host schedules it. */
+static void kernel_enter(HostKernel *p_kernel) {
+    std::lock_guard<std::mutex> lock(p_kernel->mutex);
+    if (p_kernel->mode == HOST_CLOCK_VIRTUAL) {
+        p_kernel->runnable++;
+    }
+}
+
+static void kernel_exit(HostKernel *p_kernel) {
+    std::lock_guard<std::mutex> lock(p_kernel->mutex);
+    if (p_kernel->mode == HOST_CLOCK_VIRTUAL) {
+        p_kernel->runnable--;
+        kernel_idle(p_kernel);
+    }
+}
+
+/*
+    Block with the kernel lock held until the predicate holds or the clock reaches the deadline, a NULL predicate waits
+    for the deadline only. Returns the predicate, a task woken for a predicate which another task made false again before
+    it ran goes back to wait.
+*/
+static bool kernel_wait_until(HostKernel *p_kernel, std::unique_lock<std::mutex> &lock, int64_t deadline_us, const HostPredicate_t *p_predicate) {
+    if (p_kernel->mode == HOST_CLOCK_REAL) {
+        auto predicate = [p_predicate]() { return p_predicate != NULL && (*p_predicate)(); };
+        if (deadline_us == HOST_CLOCK_FOREVER) {
+            p_kernel->changed.wait(lock, predicate);
+            return true;
+        } else {
+            return p_kernel->changed.wait_until(lock, host_clock_origin() + std::chrono::microseconds(deadline_us), predicate);
+        }
+    }
+
+    HostWaiter waiter;
+    waiter.p_predicate = p_predicate;
+    waiter.deadline_us = deadline_us;
+    for ( ; ; ) {
+        if (p_predicate != NULL && (*p_predicate)()) {
+            return true;
+        } else if (deadline_us <= p_kernel->now_us) {
+            return false;
+        }
+
+        waiter.woken = false;
+        p_kernel->waiters.push_back(&waiter);
+        p_kernel->runnable--;
+        kernel_idle(p_kernel);
+        waiter.condition.wait(lock, [&waiter]() { return waiter.woken; });
+        p_kernel->waiters.remove(&waiter);
+    }
+}
+
+/* portMAX_DELAY blocks forever, 0 just checks the predicate once. */
+static bool kernel_wait_ticks(HostKernel *p_kernel, std::unique_lock<std::mutex> &lock, TickType_t ticks, const HostPredicate_t *p_predicate) {
+    if (ticks == 0) {
+        return (*p_predicate)();
+    }
+    return kernel_wait_until(p_kernel, lock, tick_deadline_us(ticks), p_predicate);
+}
+
+void HostClockSetMode(HostClockMode_t mode) {
+    HostKernel *p_kernel = host_kernel();
+    std::lock_guard<std::mutex> lock(p_kernel->mutex);
+    if (mode == HOST_CLOCK_VIRTUAL && p_kernel->mode != HOST_CLOCK_VIRTUAL) {
+        // The virtual clock starts at boot, the calling thread is the only runnable one.
+        p_kernel->now_us = 0;
+        p_kernel->runnable = 1;
+    }
+    p_kernel->mode = mode;
+}
+
+HostClockMode_t HostClockGetMode() {
+    return host_kernel()->mode;
+}
+
+int64_t HostClockNowUs() {
+    HostKernel *p_kernel = host_kernel();
+    return (p_kernel->mode == HOST_CLOCK_VIRTUAL) ? p_kernel->now_us.load() : real_clock_us();
+}
+
+void HostClockSleepUntilUs(int64_t deadline_us) {
+    HostKernel *p_kernel = host_kernel();
+    if (p_kernel->mode == HOST_CLOCK_VIRTUAL) {
+        std::unique_lock<std::mutex> lock(p_kernel->mutex);
+        (void)kernel_wait_until(p_kernel, lock, deadline_us, NULL);
+    } else {
+        std::this_thread::sleep_until(host_clock_origin() + std::chrono::microseconds(deadline_us));
+    }
+}
+
+extern "C" uint32_t esp_log_timestamp(void) {
+    return (uint32_t)(HostClockNowUs() / 1000);
+}
+
+extern "C" int64_t esp_timer_get_time(void) {
+    return HostClockNowUs();
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(HostClockNowUs() / 1000 / portTICK_PERIOD_MS);
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay) {
+    if (host_kernel()->mode == HOST_CLOCK_VIRTUAL) {
+        HostClockSleepUntilUs(tick_deadline_us(xTicksToDelay));
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(pdTICKS_TO_MS(xTicksToDelay)));
+    }
+}
+
+/* As FreeRTOS, a wake time already passed doesn't delay, and the next one still follows it. */
+void vTaskDelayUntil(TickType_t *pxPreviousWakeTime, const TickType_t xTimeIncrement) {
+    *pxPreviousWakeTime += xTimeIncrement;
+    TickType_t ticks = *pxPreviousWakeTime - xTaskGetTickCount();
+    if ((int32_t)ticks > 0) {
+        vTaskDelay(ticks);
+    }
+}
+
+void vTaskYield(void) {
+    std::this_thread::yield();
+}
+
+void vTaskEnterCritical(portMUX_TYPE *mux) {
+    s_critical_mutex.lock();
+    mux->count++;
+}
+
+void vTaskExitCritical(portMUX_TYPE *mux) {
+    mux->count--;
+    s_critical_mutex.unlock();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return s_p_current_task;
+}
+
+/* Host threads have no stack fill pattern to scan, the high-water mark is not measured. */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask) {
+    (void)xTask;
+    return 0;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth, void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask, BaseType_t xCoreID) {
+    (void)usStackDepth;
+
+    HostTask *p_task = new HostTask{(pcName != NULL) ? pcName : "", pvTaskCode, pvParameters, uxPriority, xCoreID};
+    if (pvCreatedTask != NULL) {
+        *pvCreatedTask = p_task;
+    }
+
+    kernel_enter(host_kernel());
+    std::thread([p_task]() {
+        s_p_current_task = p_task;
+        p_task->entry(p_task->param);
+        ESP_LOGE(TAG, "Task %s returned from its entry.", p_task->name.c_str());
+        kernel_exit(host_kernel());
+    }).detach();
+
+    ESP_LOGD(TAG, "Create task %s, priority %u, core %d.", p_task->name.c_str(), uxPriority, xCoreID);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth, void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask) {
+    return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+    if (xTaskToDelete == NULL || xTaskToDelete == s_p_current_task) {
+        kernel_exit(host_kernel());
+        pthread_exit(NULL);
+    } else {
+        // A POSIX thread can not be killed safely from outside, the task keeps running until the process exits.
+        ESP_LOGW(TAG, "Task %s can not be deleted by another task on host.", xTaskToDelete->name.c_str());
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+    if (uxQueueLength == 0) {
+        return NULL;
+    }
+
+    HostQueue *p_queue = new HostQueue();
+    p_queue->length = uxQueueLength;
+    p_queue->item_size = uxItemSize;
+    p_queue->count = 0;
+    p_queue->head = 0;
+    p_queue->storage.resize((size_t)uxQueueLength * uxItemSize);
+    return p_queue;
+}
+
+void vQueueDelete(QueueHandle_t xQueue) {
+    delete xQueue;
+}
+
+static BaseType_t queue_send(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait, bool to_front) {
+    if (xQueue == NULL) {
+        return errQUEUE_FULL;
+    }
+
+    HostKernel *p_kernel = host_kernel();
+    std::unique_lock<std::mutex> lock(p_kernel->mutex);
+    const HostPredicate_t not_full = [xQueue]() { return xQueue->count < xQueue->length; };
+    if (!kernel_wait_ticks(p_kernel, lock, xTicksToWait, &not_full)) {
+        return errQUEUE_FULL;
+    }
+
+    UBaseType_t index;
+    if (to_front) {
+        xQueue->head = (xQueue->head + xQueue->length - 1) % xQueue->length;
+        index = xQueue->head;
+    } else {
+        index = (xQueue->head + xQueue->count) % xQueue->length;
+    }
+
+    if (xQueue->item_size != 0 && pvItemToQueue != NULL) {
+        memcpy(&(xQueue->storage[(size_t)index * xQueue->item_size]), pvItemToQueue, xQueue->item_size);
+    }
+    xQueue->count++;
+
+    kernel_changed(p_kernel);
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait) {
+    return queue_send(xQueue, pvItemToQueue, xTicksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait) {
+    return queue_send(xQueue, pvItemToQueue, xTicksToWait, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait) {
+    if (xQueue == NULL) {
+        return errQUEUE_EMPTY;
+    }
+
+    HostKernel *p_kernel = host_kernel();
+    std::unique_lock<std::mutex> lock(p_kernel->mutex);
+    const HostPredicate_t not_empty = [xQueue]() { return xQueue->count > 0; };
+    if (!kernel_wait_ticks(p_kernel, lock, xTicksToWait, &not_empty)) {
+        return errQUEUE_EMPTY;
+    }
+
+    if (xQueue->item_size != 0 && pvBuffer != NULL) {
+        memcpy(pvBuffer, &(xQueue->storage[(size_t)xQueue->head * xQueue->item_size]), xQueue->item_size);
+    }
+    xQueue->head = (xQueue->head + 1) % xQueue->length;
+    xQueue->count--;
+
+    kernel_changed(p_kernel);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue) {
+    if (xQueue != NULL) {
+        HostKernel *p_kernel = host_kernel();
+        std::lock_guard<std::mutex> lock(p_kernel->mutex);
+        xQueue->count = 0;
+        xQueue->head = 0;
+        kernel_changed(p_kernel);
+    }
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+    std::lock_guard<std::mutex> lock(host_kernel()->mutex);
+    return xQueue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t xQueue) {
+    std::lock_guard<std::mutex> lock(host_kernel()->mutex);
+    return xQueue->length - xQueue->count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount) {
+    SemaphoreHandle_t semaphore = xQueueCreate(uxMaxCount, 0);
+    if (semaphore != NULL) {
+        semaphore->count = uxInitialCount;
+    }
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+/*
+    A started timer owns a thread which waits for the period, a restart, stop or delete bumps the generation so the
+    waiting thread of the previous start gives up. Deleted timers are leaked, their thread may still hold them.
+*/
+TimerHandle_t xTimerCreate(const char *pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void *pvTimerID, TimerCallbackFunction_t pxCallbackFunction) {
+    HostTimer *p_timer = new HostTimer();
+    p_timer->name = (pcTimerName != NULL) ? pcTimerName : "";
+    p_timer->period = xTimerPeriodInTicks;
+    p_timer->auto_reload = (uxAutoReload != pdFALSE);
+    p_timer->id = pvTimerID;
+    p_timer->callback = pxCallbackFunction;
+    p_timer->generation = 0;
+    p_timer->deleted = false;
+    return p_timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    (void)xTicksToWait;
+
+    HostKernel *p_kernel = host_kernel();
+    uint32_t generation;
+    {
+        std::lock_guard<std::mutex> lock(p_kernel->mutex);
+        if (xTimer->deleted) {
+            return pdFAIL;
+        }
+        generation = ++xTimer->generation;
+        kernel_changed(p_kernel);
+    }
+
+    kernel_enter(p_kernel);
+    std::thread([p_kernel, xTimer, generation]() {
+        const HostPredicate_t cancelled = [xTimer, generation]() { return xTimer->deleted || xTimer->generation != generation; };
+        for ( ; ; ) {
+            {
+                std::unique_lock<std::mutex> lock(p_kernel->mutex);
+                if (kernel_wait_ticks(p_kernel, lock, xTimer->period, &cancelled)) {
+                    break;
+                }
+            }
+            xTimer->callback(xTimer);
+            if (!xTimer->auto_reload) {
+                break;
+            }
+        }
+        kernel_exit(p_kernel);
+    }).detach();
+
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    (void)xTicksToWait;
+
+    HostKernel *p_kernel = host_kernel();
+    std::lock_guard<std::mutex> lock(p_kernel->mutex);
+    xTimer->generation++;
+    kernel_changed(p_kernel);
+    return pdPASS;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    (void)xTicksToWait;
+
+    HostKernel *p_kernel = host_kernel();
+    std::lock_guard<std::mutex> lock(p_kernel->mutex);
+    xTimer->deleted = true;
+    kernel_changed(p_kernel);
+    return pdPASS;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t xTimer) {
+    return xTimer->id;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle) {
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    HostEspTimer *p_timer = new HostEspTimer();
+    p_timer->name = (create_args->name != NULL) ? create_args->name : "";
+    p_timer->callback = create_args->callback;
+    p_timer->arg = create_args->arg;
+    p_timer->generation = 0;
+    p_timer->active = false;
+    p_timer->deleted = false;
+    *out_handle = p_timer;
+    return ESP_OK;
+}
+
+/*
+    As the FreeRTOS timers, a started esp_timer owns a thread which waits for the deadline on the microsecond clock, a
+    stop or delete bumps the generation so it gives up. A period of 0 fires once.
+*/
+static esp_err_t esp_timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us) {
+    HostKernel *p_kernel = host_kernel();
+    uint32_t generation;
+    int64_t deadline_us;
+    {
+        std::lock_guard<std::mutex> lock(p_kernel->mutex);
+        if (timer == NULL || timer->deleted) {
+            return ESP_ERR_INVALID_ARG;
+        } else if (timer->active) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        generation = ++timer->generation;
+        timer->active = true;
+        deadline_us = HostClockNowUs() + (int64_t)timeout_us;
+        kernel_changed(p_kernel);
+    }
+
+    kernel_enter(p_kernel);
+    std::thread([p_kernel, timer, generation, deadline_us, period_us]() mutable {
+        const HostPredicate_t cancelled = [timer, generation]() { return timer->deleted || timer->generation != generation; };
+        for ( ; ; ) {
+            {
+                std::unique_lock<std::mutex> lock(p_kernel->mutex);
+                if (kernel_wait_until(p_kernel, lock, deadline_us, &cancelled)) {
+                    break;
+                }
+                if (period_us == 0) {
+                    timer->active = false;
+                }
+            }
+            timer->callback(timer->arg);
+            if (period_us == 0) {
+                break;
+            }
+            deadline_us += (int64_t)period_us;
+        }
+        kernel_exit(p_kernel);
+    }).detach();
+
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return esp_timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    return (period == 0) ? ESP_ERR_INVALID_ARG : esp_timer_start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    HostKernel *p_kernel = host_kernel();
+    std::lock_guard<std::mutex> lock(p_kernel->mutex);
+    if (timer == NULL || !timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->generation++;
+    timer->active = false;
+    kernel_changed(p_kernel);
+    return ESP_OK;
+}
+
+/* Deleted timers are leaked, their thread may still hold them. */
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    HostKernel *p_kernel = host_kernel();
+    std::lock_guard<std::mutex> lock(p_kernel->mutex);
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    } else if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->deleted = true;
+    kernel_changed(p_kernel);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    HostKernel *p_kernel = host_kernel();
+    std::lock_guard<std::mutex> lock(p_kernel->mutex);
+    return timer->active;
+}
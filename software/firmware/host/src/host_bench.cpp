@@ -0,0 +1,60 @@
+/*
+    Host benchmark: runs the float32_t benchmark of the firmware (utilities/sme_float_bench.h) natively, the cycle
+    counter is the one of host/shim/esp_cpu.h. The altitude table of utilities/baro_altitude.h is then checked against
+    the double precision formula at every Pa of its range, and must stay within BARO_ALTITUDE_MAX_ERROR_M.
+
+    Usage: bluethroat_host_bench [-n rounds]
+        -n  rounds per case, 1000 by default
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <esp_log.h>
+
+#include "utilities/baro_altitude.h"
+#include "utilities/sme_float_bench.h"
+
+#define HOST_DEFAULT_ROUNDS             (1000)
+
+static bool check_altitude_table() {
+    double max_error = 0;
+    int32_t max_error_pressure = 0;
+
+    for (int32_t pressure = BARO_ALTITUDE_MIN_PRESSURE; pressure <= BARO_ALTITUDE_MAX_PRESSURE; pressure++) {
+        double expected = BARO_ALTITUDE_SCALE_M * (1.0 - pow(pressure / (double)BARO_ALTITUDE_STANDARD_PRESSURE, BARO_ALTITUDE_EXPONENT));
+        double error = fmax(fabs(PressureToAltitude((float)pressure) - expected), fabs((float)PressureToAltitude(float32_t(pressure)) - expected));
+        if (error > max_error) {
+            max_error = error;
+            max_error_pressure = pressure;
+        }
+    }
+
+    bool passed = max_error <= BARO_ALTITUDE_MAX_ERROR_M;
+    printf("altitude table %d~%dPa, max error %.4f m at %d Pa: %s\n", BARO_ALTITUDE_MIN_PRESSURE, BARO_ALTITUDE_MAX_PRESSURE, max_error, max_error_pressure, passed ? "pass" : "FAIL");
+    return passed;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t rounds = HOST_DEFAULT_ROUNDS;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:")) != -1) {
+        switch (option) {
+        case 'n': rounds = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "Usage: %s [-n rounds]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    esp_log_level_set("SME_FLOAT_BENCH", ESP_LOG_INFO);
+
+    bool passed = (SmeFloatBenchmark(rounds > 0 ? rounds : 1) == ESP_OK);
+    passed &= check_altitude_table();
+
+    return passed ? 0 : 1;
+}
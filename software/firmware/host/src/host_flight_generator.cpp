@@ -0,0 +1,602 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_log.h>
+
+#include "host_flight_generator.h"
+
+#define HOST_ISA_LAPSE_RATE_K_PER_M     (0.0065)
+#define HOST_ISA_PRESSURE_EXPONENT      (5.25588)
+#define HOST_CELSIUS_TO_KELVIN          (273.15)
+#define HOST_METERS_PER_DEGREE          (111194.93)
+#define HOST_METERS_PER_SECOND_TO_KNOTS (3600.0 / 1852.0)
+#define HOST_RAW_MIN                    (-(1 << 23))
+#define HOST_RAW_MAX                    ((1 << 23) - 1)
+#define HOST_TIME_EPSILON_S             (1e-9)
+#define HOST_BANK_TIME_S                (1.5)
+#define HOST_GAS_CONSTANT               (287.05)
+#define HOST_SEA_LEVEL_DENSITY          (1.225)
+
+static const char *TAG = "HOST_FLIGHT";
+
+/* Coefficients of a DPS310 sample, c0..c30 as read from registers 0x10~0x21. */
+static const int32_t s_default_coefs[HOST_DPS3XX_COEF_MAX] = {204, -261, 80469, -54417, -2224, 1299, -10784, 196, -1470};
+
+static double normalize_heading(double heading_deg) {
+    heading_deg = fmod(heading_deg, 360.0);
+    return (heading_deg < 0) ? heading_deg + 360.0 : heading_deg;
+}
+
+HostFlightGenerator::HostFlightGenerator() : m_pressure_scale_factor(DPS3XX_SCALE_FACTOR_PRC_64), m_temperature_scale_factor(DPS3XX_SCALE_FACTOR_PRC_32) {
+    GetDefaultConfig(&m_config);
+    memcpy(m_coefs, s_default_coefs, sizeof(m_coefs));
+    Reset();
+}
+
+void HostFlightGenerator::GetDefaultConfig(HostFlightConfig_t *p_config) {
+    memset(p_config, 0, sizeof(HostFlightConfig_t));
+    p_config->qnh_pa = 101325.0;
+    p_config->sea_level_temperature_c = 15.0;
+    p_config->start_altitude_m = 1000.0;
+    p_config->start_latitude_deg = 22.600256;
+    p_config->start_longitude_deg = 114.007972;
+    p_config->start_time_s = 8 * 3600;
+    p_config->start_date = 70724;
+    p_config->speed_mps = 10.0;
+    p_config->turbulence_time_s = 1.0;
+    p_config->geoid_separation_m = -2.5;
+    p_config->seed = 1;
+}
+
+/* Pressure of the ISA troposphere, with the sea level pressure and temperature of the day. */
+double HostFlightGenerator::StandardPressure(double altitude_m, double qnh_pa, double sea_level_temperature_c) {
+    double sea_level_temperature_k = sea_level_temperature_c + HOST_CELSIUS_TO_KELVIN;
+    return qnh_pa * pow(1.0 - HOST_ISA_LAPSE_RATE_K_PER_M * altitude_m / sea_level_temperature_k, HOST_ISA_PRESSURE_EXPONENT);
+}
+
+esp_err_t HostFlightGenerator::LoadScript(const char *file_name) {
+    FILE *p_file = fopen(file_name, "r");
+    if (p_file == NULL) {
+        ESP_LOGE(TAG, "Failed to open flight script %s.", file_name);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    char line[256];
+    uint32_t line_number = 0;
+    esp_err_t result = ESP_OK;
+    while (result == ESP_OK && fgets(line, sizeof(line), p_file) != NULL) {
+        line_number++;
+        char *p_comment = strchr(line, '#');
+        if (p_comment != NULL) {
+            *p_comment = '\0';
+        }
+        if ((result = parse_statement(line)) != ESP_OK) {
+            ESP_LOGE(TAG, "%s:%u: invalid statement.", file_name, line_number);
+        }
+    }
+    fclose(p_file);
+
+    if (result == ESP_OK && m_segments.empty()) {
+        ESP_LOGE(TAG, "Flight script %s has no segment.", file_name);
+        result = ESP_ERR_INVALID_SIZE;
+    }
+
+    Reset();
+    return result;
+}
+
+esp_err_t HostFlightGenerator::parse_statement(char *line) {
+    char keyword[32];
+    double values[6];
+    int length = 0;
+
+    if (sscanf(line, " %31s%n", keyword, &length) != 1) {
+        return ESP_OK;
+    }
+
+    int count = sscanf(line + length, "%lf %lf %lf %lf %lf %lf", &values[0], &values[1], &values[2], &values[3], &values[4], &values[5]);
+    count = (count < 0) ? 0 : count;
+
+    if (strcmp(keyword, "qnh") == 0 && count == 1) {
+        m_config.qnh_pa = values[0];
+    } else if (strcmp(keyword, "temperature") == 0 && count == 1) {
+        m_config.sea_level_temperature_c = values[0];
+    } else if (strcmp(keyword, "altitude") == 0 && count == 1) {
+        m_config.start_altitude_m = values[0];
+    } else if (strcmp(keyword, "position") == 0 && count == 2) {
+        m_config.start_latitude_deg = values[0];
+        m_config.start_longitude_deg = values[1];
+    } else if (strcmp(keyword, "time") == 0 && count == 2) {
+        uint32_t hhmmss = (uint32_t)values[0];
+        m_config.start_time_s = (hhmmss / 10000) * 3600 + (hhmmss / 100 % 100) * 60 + hhmmss % 100;
+        m_config.start_date = (uint32_t)values[1];
+    } else if (strcmp(keyword, "speed") == 0 && count == 1) {
+        m_config.speed_mps = values[0];
+    } else if (strcmp(keyword, "wind") == 0 && count == 2 && values[0] >= 0) {
+        m_config.wind_speed_mps = values[0];
+        m_config.wind_direction_deg = values[1];
+    } else if (strcmp(keyword, "heading") == 0 && count == 1) {
+        m_config.heading_deg = values[0];
+    } else if (strcmp(keyword, "glider_sink") == 0 && count == 1) {
+        m_config.glider_sink_mps = values[0];
+    } else if (strcmp(keyword, "polar") == 0 && count == 6) {
+        float speeds[GLIDER_POLAR_POINTS], sinks[GLIDER_POLAR_POINTS];
+        for (int i = 0; i < GLIDER_POLAR_POINTS; i++) {
+            m_config.polar_speeds_kmh[i] = values[2 * i];
+            m_config.polar_sinks_mps[i] = values[2 * i + 1];
+            speeds[i] = (float)(values[2 * i] / 3.6);
+            sinks[i] = (float)values[2 * i + 1];
+        }
+        if (m_polar.SetPoints(speeds, sinks) != ESP_OK) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        m_config.polar_enabled = true;
+    } else if (strcmp(keyword, "turbulence") == 0 && count == 2 && values[1] > 0) {
+        m_config.turbulence_mps = values[0];
+        m_config.turbulence_time_s = values[1];
+    } else if (strcmp(keyword, "pressure_noise") == 0 && count == 1) {
+        m_config.pressure_noise_pa = values[0];
+    } else if (strcmp(keyword, "pressure_drift") == 0 && count == 1) {
+        m_config.pressure_drift_pa_per_h = values[0];
+    } else if (strcmp(keyword, "temperature_noise") == 0 && count == 1) {
+        m_config.temperature_noise_c = values[0];
+    } else if (strcmp(keyword, "temperature_drift") == 0 && count == 1) {
+        m_config.temperature_drift_c_per_h = values[0];
+    } else if (strcmp(keyword, "sensor_warming") == 0 && count == 3 && values[1] > 0) {
+        m_config.warming_c = values[0];
+        m_config.warming_time_s = values[1];
+        m_config.warming_pa_per_c = values[2];
+    } else if (strcmp(keyword, "gnss_noise") == 0 && count == 1) {
+        m_config.gnss_noise_m = values[0];
+    } else if (strcmp(keyword, "gnss_speed_noise") == 0 && count == 1) {
+        m_config.gnss_speed_noise_mps = values[0];
+    } else if (strcmp(keyword, "imu") == 0 && count == 2) {
+        m_config.imu_enabled = true;
+        m_config.imu_acceleration_noise_mps2 = values[0];
+        m_config.imu_rotation_noise_dps = values[1];
+    } else if (strcmp(keyword, "anemometer") == 0 && count == 1) {
+        m_config.anemometer_enabled = true;
+        m_config.anemometer_noise_pa = values[0];
+    } else if (strcmp(keyword, "static_port") == 0 && count == 2) {
+        m_config.static_port_enabled = true;
+        m_config.static_port_noise_pa = values[0];
+        m_config.static_port_offset_pa = values[1];
+    } else if (strcmp(keyword, "barometer_stuck") == 0 && count == 1 && values[0] > 0) {
+        m_config.barometer_stuck_s = values[0];
+    } else if (strcmp(keyword, "waypoint") == 0 && count == 3 && fabs(values[0]) <= 90 && fabs(values[1]) <= 180) {
+        m_config.waypoint_enabled = true;
+        m_config.waypoint_latitude_deg = values[0];
+        m_config.waypoint_longitude_deg = values[1];
+        m_config.waypoint_altitude_m = values[2];
+    } else if (strcmp(keyword, "maccready") == 0 && count == 1 && values[0] >= 0) {
+        m_config.maccready_mps = values[0];
+    } else if (strcmp(keyword, "seed") == 0 && count == 1) {
+        m_config.seed = (uint32_t)values[0];
+    } else if (strcmp(keyword, "glide") == 0 && count == 2 && values[0] > 0) {
+        HostFlightSegment_t segment = {.type = HOST_SEGMENT_GLIDE, .duration_s = values[0], .lift_mps = values[1]};
+        AddSegment(&segment);
+    } else if (strcmp(keyword, "thermal") == 0 && count == 5 && values[0] > 0 && values[2] > 0 && values[3] > 0) {
+        HostFlightSegment_t segment = {.type = HOST_SEGMENT_THERMAL, .duration_s = values[0], .lift_mps = values[1], .core_radius_m = values[2], .circle_radius_m = values[3], .core_offset_m = values[4]};
+        AddSegment(&segment);
+    } else if (strcmp(keyword, "pullup") == 0 && count == 3 && values[0] > 0 && values[1] > 0) {
+        HostFlightSegment_t segment = {.type = HOST_SEGMENT_PULLUP, .duration_s = values[0], .lift_mps = values[2], .speed_mps = values[1]};
+        AddSegment(&segment);
+    } else if (strcmp(keyword, "ground") == 0 && count == 1 && values[0] > 0) {
+        HostFlightSegment_t segment = {.type = HOST_SEGMENT_GROUND, .duration_s = values[0]};
+        AddSegment(&segment);
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return ESP_OK;
+}
+
+void HostFlightGenerator::AddSegment(const HostFlightSegment_t *p_segment) {
+    m_segments.push_back(*p_segment);
+}
+
+double HostFlightGenerator::Duration() const {
+    double duration_s = 0;
+    for (const HostFlightSegment_t &segment : m_segments) {
+        duration_s += segment.duration_s;
+    }
+    return duration_s;
+}
+
+/* Velocity of the air mass, the wind blows from its direction. */
+void HostFlightGenerator::GetWind(double *p_east_mps, double *p_north_mps) const {
+    double direction_rad = m_config.wind_direction_deg * M_PI / 180.0;
+    *p_east_mps = -m_config.wind_speed_mps * sin(direction_rad);
+    *p_north_mps = -m_config.wind_speed_mps * cos(direction_rad);
+}
+
+/* True distance from the glider to the waypoint, at the scale of the positions of the sentences. */
+void HostFlightGenerator::GetWaypoint(double *p_east_m, double *p_north_m) const {
+    *p_north_m = (m_config.waypoint_latitude_deg - m_config.start_latitude_deg) * HOST_METERS_PER_DEGREE - m_state.north_m;
+    *p_east_m = (m_config.waypoint_longitude_deg - m_config.start_longitude_deg) * HOST_METERS_PER_DEGREE * cos(m_config.start_latitude_deg * M_PI / 180.0) - m_state.east_m;
+}
+
+/* Back to the start of the script, the noise generators restart from the seed so every run is the same. */
+void HostFlightGenerator::Reset() {
+    m_random.seed(m_config.seed);
+    m_normal.reset();
+    m_imu_random.seed(m_config.seed + 1);
+    m_imu_normal.reset();
+    m_anemometer_random.seed(m_config.seed + 2);
+    m_anemometer_normal.reset();
+    m_gnss_random.seed(m_config.seed + 3);
+    m_gnss_normal.reset();
+
+    memset(&m_state, 0, sizeof(m_state));
+    m_state.altitude_m = m_config.start_altitude_m;
+    m_state.heading_deg = normalize_heading(m_config.heading_deg);
+    m_state.airspeed_mps = m_config.speed_mps;
+    m_segment_time_s = 0;
+    m_turbulence_mps = 0;
+    enter_segment();
+    Step(0);
+}
+
+/*
+    A thermal is circled to the right, the glider enters the circle where it is, on its current heading. A pull up starts
+    from the airspeed the glider has.
+*/
+void HostFlightGenerator::enter_segment() {
+    m_segment_start_speed_mps = m_state.airspeed_mps;
+    if (m_state.segment < m_segments.size() && m_segments[m_state.segment].type == HOST_SEGMENT_THERMAL) {
+        double radius_m = m_segments[m_state.segment].circle_radius_m;
+        double heading_rad = (m_state.heading_deg + 90.0) * M_PI / 180.0;
+        m_circle_center_east_m = m_state.east_m + radius_m * sin(heading_rad);
+        m_circle_center_north_m = m_state.north_m + radius_m * cos(heading_rad);
+    }
+}
+
+/*
+    Advance the flight by one period and draw the sensor noise of the new state. Returns false once the script is over,
+    the state then stays at the end of the last segment.
+*/
+bool HostFlightGenerator::Step(double period_s) {
+    if (m_state.segment >= m_segments.size()) {
+        return false;
+    }
+
+    const HostFlightSegment_t *p_segment = &(m_segments[m_state.segment]);
+    double lift_mps = p_segment->lift_mps;
+    double last_vertical_speed_mps = m_state.vertical_speed_mps;
+    double last_airspeed_mps = m_state.airspeed_mps;
+    if (p_segment->type == HOST_SEGMENT_GROUND) {
+        m_state.airspeed_mps = 0;
+        last_airspeed_mps = 0;
+    } else if (m_state.airspeed_mps <= 0) {
+        // The launch, the glider flies at its airspeed at once and the run up to it is not energy it trades.
+        m_state.airspeed_mps = m_config.speed_mps;
+        last_airspeed_mps = m_state.airspeed_mps;
+    }
+    if (p_segment->type == HOST_SEGMENT_PULLUP) {
+        double progress = fmin((m_segment_time_s + period_s) / p_segment->duration_s, 1.0);
+        m_state.airspeed_mps = m_segment_start_speed_mps + (p_segment->speed_mps - m_segment_start_speed_mps) * progress;
+    }
+    m_state.turn_rate_dps = (p_segment->type == HOST_SEGMENT_THERMAL) ? m_state.airspeed_mps / p_segment->circle_radius_m * 180.0 / M_PI : 0.0;
+    double wind_east_mps, wind_north_mps;
+    GetWind(&wind_east_mps, &wind_north_mps);
+    if (p_segment->type == HOST_SEGMENT_GROUND) {
+        wind_east_mps = 0;
+        wind_north_mps = 0;
+    } else if (p_segment->type != HOST_SEGMENT_THERMAL) {
+        double heading_rad = m_state.heading_deg * M_PI / 180.0;
+        m_state.east_m += (m_state.airspeed_mps * sin(heading_rad) + wind_east_mps) * period_s;
+        m_state.north_m += (m_state.airspeed_mps * cos(heading_rad) + wind_north_mps) * period_s;
+    } else {
+        // On the circle the glider is on the left of the center, seen along its heading. The circles and the core drift
+        // with the air mass.
+        m_circle_center_east_m += wind_east_mps * period_s;
+        m_circle_center_north_m += wind_north_mps * period_s;
+        m_state.heading_deg = normalize_heading(m_state.heading_deg + m_state.airspeed_mps * period_s / p_segment->circle_radius_m * 180.0 / M_PI);
+        double bearing_rad = (m_state.heading_deg - 90.0) * M_PI / 180.0;
+        m_state.east_m = m_circle_center_east_m + p_segment->circle_radius_m * sin(bearing_rad);
+        m_state.north_m = m_circle_center_north_m + p_segment->circle_radius_m * cos(bearing_rad);
+
+        double core_distance_m = hypot(m_state.east_m - (m_circle_center_east_m + p_segment->core_offset_m), m_state.north_m - m_circle_center_north_m);
+        lift_mps = p_segment->lift_mps * exp(-(core_distance_m * core_distance_m) / (p_segment->core_radius_m * p_segment->core_radius_m));
+    }
+
+    // Exact discretization of the Gauss-Markov process, the variance doesn't depend on the period.
+    if (m_config.turbulence_mps > 0 && period_s > 0) {
+        double decay = exp(-period_s / m_config.turbulence_time_s);
+        m_turbulence_mps = decay * m_turbulence_mps + m_config.turbulence_mps * sqrt(1.0 - decay * decay) * m_normal(m_random);
+    }
+
+    // The energy of the glider only changes with the air mass and its sink, the airspeed it loses is height it gains.
+    double glider_sink_mps = m_config.glider_sink_mps;
+    if (m_config.polar_enabled) {
+        double pressure_pa = StandardPressure(m_state.altitude_m, m_config.qnh_pa, m_config.sea_level_temperature_c);
+        double temperature_c = m_config.sea_level_temperature_c - HOST_ISA_LAPSE_RATE_K_PER_M * m_state.altitude_m;
+        double density_ratio = sqrt(pressure_pa / (HOST_GAS_CONSTANT * (temperature_c + HOST_CELSIUS_TO_KELVIN)) / HOST_SEA_LEVEL_DENSITY);
+        glider_sink_mps = m_polar.GetSink((float)(m_state.airspeed_mps * density_ratio)) / density_ratio;
+    }
+    m_state.air_mass_speed_mps = lift_mps + m_turbulence_mps;
+    if (p_segment->type == HOST_SEGMENT_GROUND) {
+        // The air mass still moves, the glider doesn't.
+        glider_sink_mps = m_state.air_mass_speed_mps;
+    }
+    m_state.total_energy_speed_mps = m_state.air_mass_speed_mps - glider_sink_mps;
+    m_state.vertical_speed_mps = m_state.total_energy_speed_mps;
+    if (period_s > 0) {
+        m_state.vertical_speed_mps -= (m_state.airspeed_mps * m_state.airspeed_mps - last_airspeed_mps * last_airspeed_mps) / (2.0 * BMI270_STANDARD_GRAVITY * period_s);
+    }
+    m_state.altitude_m += m_state.vertical_speed_mps * period_s;
+
+    // The bank of a coordinated turn, approached with a lag, the turn itself starts at once.
+    if (period_s > 0) {
+        double target_bank_deg = atan(m_state.airspeed_mps * m_state.turn_rate_dps * M_PI / 180.0 / BMI270_STANDARD_GRAVITY) * 180.0 / M_PI;
+        double bank_deg = m_state.bank_deg + (target_bank_deg - m_state.bank_deg) * (1.0 - exp(-period_s / HOST_BANK_TIME_S));
+        m_state.roll_rate_dps = (bank_deg - m_state.bank_deg) / period_s;
+        m_state.bank_deg = bank_deg;
+        m_state.vertical_acceleration_mps2 = (m_state.vertical_speed_mps - last_vertical_speed_mps) / period_s;
+    }
+    m_state.time_s += period_s;
+    m_segment_time_s += period_s;
+
+    m_state.temperature_c = m_config.sea_level_temperature_c - HOST_ISA_LAPSE_RATE_K_PER_M * m_state.altitude_m;
+    m_state.pressure_pa = StandardPressure(m_state.altitude_m, m_config.qnh_pa, m_config.sea_level_temperature_c);
+    // A stuck barometer keeps the sensor pressure and temperature of its last sample.
+    // The sensor warms in the sun and its pressure drifts with its temperature since the start.
+    if (m_config.barometer_stuck_s <= 0 || m_state.time_s < m_config.barometer_stuck_s) {
+        m_state.sensor_temperature_c = m_state.temperature_c + m_config.temperature_drift_c_per_h * m_state.time_s / 3600.0;
+        if (m_config.warming_c != 0) {
+            m_state.sensor_temperature_c += m_config.warming_c * (1.0 - exp(-m_state.time_s / m_config.warming_time_s));
+        }
+        double start_temperature_c = m_config.sea_level_temperature_c - HOST_ISA_LAPSE_RATE_K_PER_M * m_config.start_altitude_m;
+        m_state.sensor_pressure_pa = m_state.pressure_pa + m_config.pressure_drift_pa_per_h * m_state.time_s / 3600.0 + m_config.warming_pa_per_c * (m_state.sensor_temperature_c - start_temperature_c);
+        if (m_config.pressure_noise_pa > 0) {
+            m_state.sensor_pressure_pa += m_config.pressure_noise_pa * m_normal(m_random);
+        }
+        if (m_config.temperature_noise_c > 0) {
+            m_state.sensor_temperature_c += m_config.temperature_noise_c * m_normal(m_random);
+        }
+    }
+
+    double heading_rad = m_state.heading_deg * M_PI / 180.0;
+    double ground_east_mps = m_state.airspeed_mps * sin(heading_rad) + wind_east_mps;
+    double ground_north_mps = m_state.airspeed_mps * cos(heading_rad) + wind_north_mps;
+    m_state.ground_speed_mps = hypot(ground_east_mps, ground_north_mps);
+    m_state.track_deg = normalize_heading(atan2(ground_east_mps, ground_north_mps) * 180.0 / M_PI);
+    if (m_config.gnss_speed_noise_mps > 0) {
+        ground_east_mps += m_config.gnss_speed_noise_mps * m_gnss_normal(m_gnss_random);
+        ground_north_mps += m_config.gnss_speed_noise_mps * m_gnss_normal(m_gnss_random);
+    }
+    m_state.sensor_ground_speed_mps = hypot(ground_east_mps, ground_north_mps);
+    m_state.sensor_track_deg = normalize_heading(atan2(ground_east_mps, ground_north_mps) * 180.0 / M_PI);
+
+    double density = m_state.pressure_pa / (HOST_GAS_CONSTANT * (m_state.temperature_c + HOST_CELSIUS_TO_KELVIN));
+    m_state.dynamic_pressure_pa = 0.5 * density * m_state.airspeed_mps * m_state.airspeed_mps;
+    m_state.sensor_total_pressure_pa = m_state.pressure_pa + m_state.dynamic_pressure_pa;
+    if (m_config.anemometer_enabled && m_config.anemometer_noise_pa > 0) {
+        m_state.sensor_total_pressure_pa += m_config.anemometer_noise_pa * m_anemometer_normal(m_anemometer_random);
+    }
+    // The second static port has the noise generator of the anemometer it replaces.
+    m_state.sensor_static_pressure_pa = m_state.pressure_pa + m_config.static_port_offset_pa;
+    if (m_config.static_port_enabled && m_config.static_port_noise_pa > 0) {
+        m_state.sensor_static_pressure_pa += m_config.static_port_noise_pa * m_anemometer_normal(m_anemometer_random);
+    }
+
+    if (m_segment_time_s >= p_segment->duration_s - HOST_TIME_EPSILON_S) {
+        m_state.segment++;
+        m_segment_time_s = 0;
+        enter_segment();
+    }
+
+    return true;
+}
+
+void HostFlightGenerator::EncodeCoefs(uint8_t *p_bytes, size_t size) const {
+    if (size < sizeof(Dps3xxCoefRegs_t)) {
+        return;
+    }
+
+    memset(p_bytes, 0, size);
+    p_bytes[0]  = (uint8_t)(m_coefs[HOST_DPS3XX_C0] >> 4);
+    p_bytes[1]  = (uint8_t)(((m_coefs[HOST_DPS3XX_C0] & 0x0f) << 4) | ((m_coefs[HOST_DPS3XX_C1] >> 8) & 0x0f));
+    p_bytes[2]  = (uint8_t)(m_coefs[HOST_DPS3XX_C1]);
+    p_bytes[3]  = (uint8_t)(m_coefs[HOST_DPS3XX_C00] >> 12);
+    p_bytes[4]  = (uint8_t)(m_coefs[HOST_DPS3XX_C00] >> 4);
+    p_bytes[5]  = (uint8_t)(((m_coefs[HOST_DPS3XX_C00] & 0x0f) << 4) | ((m_coefs[HOST_DPS3XX_C10] >> 16) & 0x0f));
+    p_bytes[6]  = (uint8_t)(m_coefs[HOST_DPS3XX_C10] >> 8);
+    p_bytes[7]  = (uint8_t)(m_coefs[HOST_DPS3XX_C10]);
+    for (int i = 0; i < 5; i++) {
+        p_bytes[8 + 2 * i] = (uint8_t)(m_coefs[HOST_DPS3XX_C01 + i] >> 8);
+        p_bytes[9 + 2 * i] = (uint8_t)(m_coefs[HOST_DPS3XX_C01 + i]);
+    }
+}
+
+/* Compensated pressure and temperature of the datasheet formulas, in double precision. */
+double HostFlightGenerator::CompensatePressure(int32_t raw_pressure, int32_t raw_temperature) const {
+    double p = (double)raw_pressure / m_pressure_scale_factor;
+    double t = (double)raw_temperature / m_temperature_scale_factor;
+    return m_coefs[HOST_DPS3XX_C00] + p * (m_coefs[HOST_DPS3XX_C10] + p * (m_coefs[HOST_DPS3XX_C20] + p * m_coefs[HOST_DPS3XX_C30])) +
+           t * m_coefs[HOST_DPS3XX_C01] + t * p * (m_coefs[HOST_DPS3XX_C11] + p * m_coefs[HOST_DPS3XX_C21]);
+}
+
+double HostFlightGenerator::CompensateTemperature(int32_t raw_temperature) const {
+    return m_coefs[HOST_DPS3XX_C0] / 2.0 + m_coefs[HOST_DPS3XX_C1] * (double)raw_temperature / m_temperature_scale_factor;
+}
+
+void HostFlightGenerator::EncodeDps3xx(uint8_t *p_bytes, size_t size) const {
+    encode_dps3xx(m_state.sensor_pressure_pa, m_state.sensor_temperature_c, p_bytes, size);
+}
+
+/* The anemometer has the calibration of the barometer and sits in the same air. */
+void HostFlightGenerator::EncodeDps3xxTotal(uint8_t *p_bytes, size_t size) const {
+    encode_dps3xx(m_state.sensor_total_pressure_pa, m_state.sensor_temperature_c, p_bytes, size);
+}
+
+/* The second static port sits in the air of the barometer. */
+void HostFlightGenerator::EncodeDps3xxStatic(uint8_t *p_bytes, size_t size) const {
+    encode_dps3xx(m_state.sensor_static_pressure_pa, m_state.temperature_c, p_bytes, size);
+}
+
+/*
+    The temperature formula is linear and inverted directly. The pressure formula is monotonic over the range of the
+    sensor, the 24-bit raw value closest to the sensor pressure is searched by bisection.
+*/
+void HostFlightGenerator::encode_dps3xx(double pressure_pa, double temperature_c, uint8_t *p_bytes, size_t size) const {
+    if (size < sizeof(Dps3xxData_t)) {
+        return;
+    }
+
+    double raw = (temperature_c - m_coefs[HOST_DPS3XX_C0] / 2.0) / m_coefs[HOST_DPS3XX_C1] * m_temperature_scale_factor;
+    int32_t raw_temperature = (int32_t)fmax(HOST_RAW_MIN, fmin(HOST_RAW_MAX, round(raw)));
+
+    double t = (double)raw_temperature / m_temperature_scale_factor;
+    bool decreasing = (m_coefs[HOST_DPS3XX_C10] + t * m_coefs[HOST_DPS3XX_C11]) < 0;
+    int32_t low = HOST_RAW_MIN, high = HOST_RAW_MAX;
+    while (low < high) {
+        int32_t middle = low + (high - low) / 2;
+        if ((CompensatePressure(middle, raw_temperature) > pressure_pa) == decreasing) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low > HOST_RAW_MIN && fabs(CompensatePressure(low - 1, raw_temperature) - pressure_pa) < fabs(CompensatePressure(low, raw_temperature) - pressure_pa)) {
+        low--;
+    }
+
+    Dps3xxData_t *p_regs = (Dps3xxData_t *)p_bytes;
+    p_regs->prs_b2 = (uint8_t)(low >> 16);
+    p_regs->prs_b1 = (uint8_t)(low >> 8);
+    p_regs->prs_b0 = (uint8_t)(low);
+    p_regs->tmp_b2 = (uint8_t)(raw_temperature >> 16);
+    p_regs->tmp_b1 = (uint8_t)(raw_temperature >> 8);
+    p_regs->tmp_b0 = (uint8_t)(raw_temperature);
+}
+
+/*
+    Specific force and rotation of the last step in the sensor frame, rolled by the bank from the level frame where the
+    centripetal acceleration of a right turn points right and the turn rate down:
+        f = (0, -a_c * cos(bank) + (g + a_v) * sin(bank), a_c * sin(bank) + (g + a_v) * cos(bank))
+        w = (roll rate, -turn rate * sin(bank), -turn rate * cos(bank))
+*/
+void HostFlightGenerator::EncodeBmi270Frame(Bmi270FifoFrame_t *p_frame) {
+    double bank_rad = m_state.bank_deg * M_PI / 180.0;
+    double centripetal_mps2 = m_state.airspeed_mps * m_state.turn_rate_dps * M_PI / 180.0;
+    double vertical_mps2 = BMI270_STANDARD_GRAVITY + m_state.vertical_acceleration_mps2;
+    double acceleration[3] = {0.0, -centripetal_mps2 * cos(bank_rad) + vertical_mps2 * sin(bank_rad), centripetal_mps2 * sin(bank_rad) + vertical_mps2 * cos(bank_rad)};
+    double rotation[3] = {m_state.roll_rate_dps, -m_state.turn_rate_dps * sin(bank_rad), -m_state.turn_rate_dps * cos(bank_rad)};
+    int16_t raw[6];
+
+    for (int i = 0; i < 3; i++) {
+        double value = (rotation[i] + m_config.imu_rotation_noise_dps * m_imu_normal(m_imu_random)) * BMI270_GYR_LSB_PER_DPS;
+        raw[i] = (int16_t)fmax(INT16_MIN, fmin(INT16_MAX, round(value)));
+    }
+    for (int i = 0; i < 3; i++) {
+        double value = (acceleration[i] + m_config.imu_acceleration_noise_mps2 * m_imu_normal(m_imu_random)) / BMI270_STANDARD_GRAVITY * BMI270_ACC_LSB_PER_G;
+        raw[3 + i] = (int16_t)fmax(INT16_MIN, fmin(INT16_MAX, round(value)));
+    }
+
+    p_frame->gyr_x = raw[0];
+    p_frame->gyr_y = raw[1];
+    p_frame->gyr_z = raw[2];
+    p_frame->acc_x = raw[3];
+    p_frame->acc_y = raw[4];
+    p_frame->acc_z = raw[5];
+}
+
+void HostFlightGenerator::format_time(char *buffer, size_t size) const {
+    uint32_t centiseconds = (uint32_t)llround(m_state.time_s * 100.0) + m_config.start_time_s * 100;
+    uint32_t seconds = (centiseconds / 100) % 86400;
+    snprintf(buffer, size, "%02u%02u%02u.%02u", seconds / 3600, seconds / 60 % 60, seconds % 60, centiseconds % 100);
+}
+
+/* ddmm.mmmmm and dddmm.mmmmm, rounded once in 1e-5 minutes so the minutes never read 60. */
+void HostFlightGenerator::format_position(char *latitude, size_t latitude_size, char *longitude, size_t longitude_size, char *p_north, char *p_east) const {
+    double latitude_deg = m_config.start_latitude_deg + m_state.north_m / HOST_METERS_PER_DEGREE;
+    double longitude_deg = m_config.start_longitude_deg + m_state.east_m / (HOST_METERS_PER_DEGREE * cos(m_config.start_latitude_deg * M_PI / 180.0));
+
+    long long units = llround(fabs(latitude_deg) * 60.0 * 100000.0);
+    snprintf(latitude, latitude_size, "%02lld%02lld.%05lld", units / 6000000, units % 6000000 / 100000, units % 100000);
+    *p_north = (latitude_deg >= 0) ? 'N' : 'S';
+
+    units = llround(fabs(longitude_deg) * 60.0 * 100000.0);
+    snprintf(longitude, longitude_size, "%03lld%02lld.%05lld", units / 6000000, units % 6000000 / 100000, units % 100000);
+    *p_east = (longitude_deg >= 0) ? 'E' : 'W';
+}
+
+void HostFlightGenerator::finish_sentence(char *sentence, size_t size) const {
+    size_t length = strlen(sentence);
+    uint8_t checksum = 0;
+    for (size_t i = 1; i < length; i++) {
+        checksum ^= (uint8_t)sentence[i];
+    }
+    snprintf(sentence + length, size - length, "*%02X", checksum);
+}
+
+/* The firmware adds the geoid separation to the altitude above mean sea level. */
+void HostFlightGenerator::EncodeGga(char *sentence, size_t size) {
+    char time[16], latitude[16], longitude[16];
+    char north, east;
+    format_time(time, sizeof(time));
+    format_position(latitude, sizeof(latitude), longitude, sizeof(longitude), &north, &east);
+
+    double altitude_m = m_state.altitude_m;
+    if (m_config.gnss_noise_m > 0) {
+        altitude_m += m_config.gnss_noise_m * m_normal(m_random);
+    }
+
+    snprintf(sentence, size, "$GNGGA,%s,%s,%c,%s,%c,1,12,1.00,%.1f,M,%.1f,M,,", time, latitude, north, longitude, east, altitude_m - m_config.geoid_separation_m, m_config.geoid_separation_m);
+    finish_sentence(sentence, size);
+}
+
+void HostFlightGenerator::EncodeRmc(char *sentence, size_t size) const {
+    char time[16], latitude[16], longitude[16];
+    char north, east;
+    format_time(time, sizeof(time));
+    format_position(latitude, sizeof(latitude), longitude, sizeof(longitude), &north, &east);
+
+    snprintf(sentence, size, "$GNRMC,%s,A,%s,%c,%s,%c,%.3f,%.2f,%06u,,,A,V", time, latitude, north, longitude, east, m_state.sensor_ground_speed_mps * HOST_METERS_PER_SECOND_TO_KNOTS, m_state.sensor_track_deg, m_config.start_date);
+    finish_sentence(sentence, size);
+}
+
+void HostFlightGenerator::EncodeVtg(char *sentence, size_t size) const {
+    snprintf(sentence, size, "$GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,A", m_state.sensor_track_deg, m_state.sensor_ground_speed_mps * HOST_METERS_PER_SECOND_TO_KNOTS, m_state.sensor_ground_speed_mps * 3.6);
+    finish_sentence(sentence, size);
+}
+
+/*
+    The estimate is compared with the truth shifted by 0 to max_lag_s, the shift with the smallest error is the lag of the
+    estimate. Samples before max_lag_s are left out at every shift, so all shifts are scored on the same samples.
+*/
+void HostScoreVario(const std::vector<double> &truth, const std::vector<double> &estimate, double period_s, double max_lag_s, HostVarioScore_t *p_score) {
+    size_t count = (truth.size() < estimate.size()) ? truth.size() : estimate.size();
+    size_t max_shift = (period_s > 0) ? (size_t)(max_lag_s / period_s) : 0;
+
+    memset(p_score, 0, sizeof(HostVarioScore_t));
+    if (count <= max_shift) {
+        return;
+    }
+
+    double best_sum = -1;
+    for (size_t shift = 0; shift <= max_shift; shift++) {
+        double sum = 0;
+        for (size_t i = max_shift; i < count; i++) {
+            double error = estimate[i] - truth[i - shift];
+            sum += error * error;
+            if (shift == 0 && fabs(error) > p_score->max_error_mps) {
+                p_score->max_error_mps = fabs(error);
+            }
+        }
+
+        if (shift == 0) {
+            p_score->rms_error_mps = sqrt(sum / (count - max_shift));
+        }
+        if (best_sum < 0 || sum < best_sum) {
+            best_sum = sum;
+            p_score->lag_s = shift * period_s;
+        }
+    }
+
+    p_score->samples = (uint32_t)(count - max_shift);
+    p_score->lagged_rms_error_mps = sqrt(best_sum / p_score->samples);
+}
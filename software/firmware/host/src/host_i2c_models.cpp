@@ -0,0 +1,451 @@
+#include <math.h>
+#include <string.h>
+
+#include "drivers/axp192_pmu.h"
+#include "drivers/bmi270_imu.h"
+#include "drivers/dps3xx_barometer.h"
+#include "drivers/ft6x36u_touch.h"
+#include "host_clock.h"
+#include "host_i2c_models.h"
+
+#define HOST_DPS3XX_MEAS_CTRL_MASK          (0x07)
+#define HOST_DPS3XX_SENSOR_RDY              (0x40)
+#define HOST_DPS3XX_COEF_RDY                (0x80)
+#define HOST_DPS3XX_FIFO_EN                 (0x02)
+#define HOST_DPS3XX_FIFO_FLUSH              (0x80)
+#define HOST_DPS3XX_FIFO_FULL               (0x01)
+#define HOST_DPS3XX_FIFO_EMPTY              (0x02)
+#define HOST_DPS3XX_RATE_SHIFT              (4)
+#define HOST_DPS3XX_RESULT_MASK             (0xffffff)
+
+static uint8_t bcd_encode(int value) {
+    return (uint8_t)(((value / 10) << 4) | (value % 10));
+}
+
+static int bcd_decode(uint8_t bcd) {
+    return (bcd >> 4) * 10 + (bcd & 0x0f);
+}
+
+/***********************************************************************************************************************
+ * DPS3xx
+***********************************************************************************************************************/
+HostDps3xxModel::HostDps3xxModel() : m_time_scale(1.0), m_reset_us(0), m_measurement_end_us(0),
+    m_measurement(DPS3XX_REG_VALUE_MEAS_CTRL_STOP), m_raw_pressure(0), m_raw_temperature(0), m_raw_pressure_slope(0.0),
+    m_slope_start_us(0), m_measurements(0), m_status_reads(0), m_temperature_end_us(0), m_pressure_end_us(0), m_background_start_us(0), m_last_pressure_us(0), m_background_temperatures(0), m_background_pressures(0), m_fifo_lost(0) {
+    // Calibration and identification are read-only, the configuration registers come out of the reset.
+    uint8_t coefs[sizeof(Dps3xxCoefRegs_t)] = {0};
+    this->SetCoefs(coefs, sizeof(coefs));
+    this->SetRegister(DPS3XX_REG_ADDR_ID, DPS3XX_REG_VALUE_ID, 0x00);
+    this->SetRegister(DPS3XX_REG_ADDR_COEF_SRC, HOST_DPS3XX_COEF_SRC_EXTERNAL, 0x00);
+    this->reset();
+}
+
+void HostDps3xxModel::SetCoefs(const uint8_t *p_coefs, uint16_t size) {
+    this->SetRegisters(DPS3XX_REG_ADDR_COEF, p_coefs, size, 0x00);
+}
+
+void HostDps3xxModel::SetSample(int32_t raw_pressure, int32_t raw_temperature) {
+    m_raw_pressure = raw_pressure;
+    m_raw_temperature = raw_temperature;
+}
+
+void HostDps3xxModel::SetPressureSlope(double raw_per_s, int64_t start_us) {
+    m_raw_pressure_slope = raw_per_s;
+    m_slope_start_us = start_us;
+}
+
+int64_t HostDps3xxModel::MeasurementTimeUs(uint8_t cfg) const {
+    uint32_t conversions = 1U << ((cfg & 0x0f) > DPS3XX_REG_VALUE_PM_PRC_128 ? DPS3XX_REG_VALUE_PM_PRC_128 : (cfg & 0x0f));
+    return (int64_t)((HOST_DPS3XX_MEASUREMENT_BASE_US + (conversions - 1) * HOST_DPS3XX_MEASUREMENT_STEP_US) * m_time_scale);
+}
+
+esp_err_t HostDps3xxModel::Read(uint32_t reg_addr, uint8_t *buffer, uint16_t size) {
+    this->update();
+    uint8_t address = (uint8_t)(reg_addr & HOST_I2C_REG_ADDR_MASK);
+
+    // With the FIFO enabled the pressure result registers are its output, a read pops a single entry whatever its size.
+    if (address == DPS3XX_REG_ADDR_PSR_B2 && (m_registers[DPS3XX_REG_ADDR_CFG_REG] & HOST_DPS3XX_FIFO_EN)) {
+        uint32_t entry = DPS3XX_FIFO_EMPTY;
+        if (!m_fifo.empty()) {
+            entry = m_fifo.front();
+            m_fifo.pop_front();
+        }
+        for (uint16_t i = 0; i < DPS3XX_FIFO_ENTRY_SIZE && i < size; i++) {
+            buffer[i] = (uint8_t)(entry >> (16 - 8 * i));
+        }
+        this->update_fifo_status();
+        if (size <= DPS3XX_FIFO_ENTRY_SIZE) {
+            return ESP_OK;
+        }
+        return HostI2cRegisterFile::Read(address + DPS3XX_FIFO_ENTRY_SIZE, buffer + DPS3XX_FIFO_ENTRY_SIZE, size - DPS3XX_FIFO_ENTRY_SIZE);
+    }
+
+    // Reading a result clears its ready flag.
+    esp_err_t result = HostI2cRegisterFile::Read(reg_addr, buffer, size);
+    if (address <= DPS3XX_REG_ADDR_MEAS_CFG && address + size > DPS3XX_REG_ADDR_MEAS_CFG) {
+        m_status_reads++;
+    }
+    if (address <= DPS3XX_REG_ADDR_PSR_B0 && address + size > DPS3XX_REG_ADDR_PSR_B2) {
+        m_registers[DPS3XX_REG_ADDR_MEAS_CFG] &= ~DPS3XX_REG_VALUE_PRS_RDY;
+    }
+    if (address <= DPS3XX_REG_ADDR_TMP_B0 && address + size > DPS3XX_REG_ADDR_TMP_B2) {
+        m_registers[DPS3XX_REG_ADDR_MEAS_CFG] &= ~DPS3XX_REG_VALUE_TMP_RDY;
+    }
+
+    return result;
+}
+
+esp_err_t HostDps3xxModel::Write(uint32_t reg_addr, const uint8_t *buffer, uint16_t size) {
+    this->update();
+    esp_err_t result = HostI2cRegisterFile::Write(reg_addr, buffer, size);
+
+    uint8_t address = (uint8_t)(reg_addr & HOST_I2C_REG_ADDR_MASK);
+    for (uint16_t i = 0; i < size; i++) {
+        uint8_t index = (uint8_t)(address + i);
+        if (index == DPS3XX_REG_ADDR_RESET && (buffer[i] & 0x0f) == DPS3XX_REG_VALUE_SOFT_RESET) {
+            this->reset();
+        } else if (index == DPS3XX_REG_ADDR_RESET && (buffer[i] & HOST_DPS3XX_FIFO_FLUSH)) {
+            m_fifo.clear();
+            this->update_fifo_status();
+        } else if (index == DPS3XX_REG_ADDR_MEAS_CFG) {
+            m_measurement = buffer[i] & HOST_DPS3XX_MEAS_CTRL_MASK;
+            if (m_measurement == DPS3XX_REG_VALUE_MEAS_CTRL_TMP) {
+                m_registers[DPS3XX_REG_ADDR_MEAS_CFG] &= ~DPS3XX_REG_VALUE_TMP_RDY;
+                m_measurement_end_us = HostClockNowUs() + this->MeasurementTimeUs(m_registers[DPS3XX_REG_ADDR_TMP_CFG]);
+            } else if (m_measurement == DPS3XX_REG_VALUE_MEAS_CTRL_PRS) {
+                m_registers[DPS3XX_REG_ADDR_MEAS_CFG] &= ~DPS3XX_REG_VALUE_PRS_RDY;
+                m_measurement_end_us = HostClockNowUs() + this->MeasurementTimeUs(m_registers[DPS3XX_REG_ADDR_PRS_CFG]);
+            } else if (m_measurement >= DPS3XX_REG_VALUE_MEAS_CTRL_BG_PRS) {
+                int64_t temperature_us = (m_measurement != DPS3XX_REG_VALUE_MEAS_CTRL_BG_PRS) ? this->MeasurementTimeUs(m_registers[DPS3XX_REG_ADDR_TMP_CFG]) : 0;
+                m_background_start_us = HostClockNowUs();
+                m_temperature_end_us = m_background_start_us + temperature_us;
+                m_pressure_end_us = m_temperature_end_us + this->MeasurementTimeUs(m_registers[DPS3XX_REG_ADDR_PRS_CFG]);
+                m_background_temperatures = 0;
+                m_background_pressures = 0;
+            } else {
+                m_measurement = DPS3XX_REG_VALUE_MEAS_CTRL_STOP;
+            }
+        }
+    }
+
+    return result;
+}
+
+void HostDps3xxModel::reset() {
+    for (uint8_t reg_addr = DPS3XX_REG_ADDR_PSR_B2; reg_addr <= DPS3XX_REG_ADDR_TMP_B0; reg_addr++) {
+        this->SetRegister(reg_addr, 0x00, 0x00);
+    }
+    this->SetRegister(DPS3XX_REG_ADDR_PRS_CFG, 0x00);
+    this->SetRegister(DPS3XX_REG_ADDR_TMP_CFG, 0x00);
+    this->SetRegister(DPS3XX_REG_ADDR_MEAS_CFG, 0x00, HOST_DPS3XX_MEAS_CTRL_MASK);
+    this->SetRegister(DPS3XX_REG_ADDR_CFG_REG, 0x00);
+    this->SetRegister(DPS3XX_REG_ADDR_INT_STS, 0x00, 0x00);
+    this->SetRegister(DPS3XX_REG_ADDR_FIFO_STS, 0x00, 0x00);
+    this->SetRegister(DPS3XX_REG_ADDR_RESET, 0x00, 0x00);
+
+    m_reset_us = HostClockNowUs();
+    m_measurement = DPS3XX_REG_VALUE_MEAS_CTRL_STOP;
+    m_fifo.clear();
+    this->update_fifo_status();
+}
+
+/* Brings the status flags and the result registers up to the host clock. */
+void HostDps3xxModel::update() {
+    int64_t now_us = HostClockNowUs();
+    uint8_t meas_cfg = m_registers[DPS3XX_REG_ADDR_MEAS_CFG];
+
+    if (now_us >= m_reset_us + DPS3XX_RESET_SENSOR_READY_MS * 1000) {
+        meas_cfg |= HOST_DPS3XX_SENSOR_RDY;
+    }
+    if (now_us >= m_reset_us + DPS3XX_RESET_COEF_READY_MS * 1000) {
+        meas_cfg |= HOST_DPS3XX_COEF_RDY;
+    }
+
+    // A command mode measurement returns to standby when its result is latched.
+    if ((m_measurement == DPS3XX_REG_VALUE_MEAS_CTRL_TMP || m_measurement == DPS3XX_REG_VALUE_MEAS_CTRL_PRS) && now_us >= m_measurement_end_us) {
+        uint8_t result_addr = (m_measurement == DPS3XX_REG_VALUE_MEAS_CTRL_TMP) ? DPS3XX_REG_ADDR_TMP_B2 : DPS3XX_REG_ADDR_PSR_B2;
+        int32_t raw_value = (m_measurement == DPS3XX_REG_VALUE_MEAS_CTRL_TMP) ? m_raw_temperature : m_raw_pressure;
+        m_registers[result_addr + 0] = (uint8_t)(raw_value >> 16);
+        m_registers[result_addr + 1] = (uint8_t)(raw_value >> 8);
+        m_registers[result_addr + 2] = (uint8_t)(raw_value);
+
+        meas_cfg |= (m_measurement == DPS3XX_REG_VALUE_MEAS_CTRL_TMP) ? DPS3XX_REG_VALUE_TMP_RDY : DPS3XX_REG_VALUE_PRS_RDY;
+        meas_cfg &= ~HOST_DPS3XX_MEAS_CTRL_MASK;
+        m_measurement = DPS3XX_REG_VALUE_MEAS_CTRL_STOP;
+        m_measurements++;
+    }
+
+    m_registers[DPS3XX_REG_ADDR_MEAS_CFG] = meas_cfg;
+    if (m_measurement >= DPS3XX_REG_VALUE_MEAS_CTRL_BG_PRS) {
+        this->update_background(now_us);
+    }
+}
+
+/* The background results ended by the host clock, in the order they end. A new time scale holds from the next one. */
+void HostDps3xxModel::update_background(int64_t now_us) {
+    bool temperature = (m_measurement != DPS3XX_REG_VALUE_MEAS_CTRL_BG_PRS);
+    bool pressure = (m_measurement != DPS3XX_REG_VALUE_MEAS_CTRL_BG_TMP);
+    int64_t temperature_period_us = (int64_t)(1000000.0 / (1 << ((m_registers[DPS3XX_REG_ADDR_TMP_CFG] >> HOST_DPS3XX_RATE_SHIFT) & 0x07)) * m_time_scale);
+    int64_t pressure_period_us = (int64_t)(1000000.0 / (1 << ((m_registers[DPS3XX_REG_ADDR_PRS_CFG] >> HOST_DPS3XX_RATE_SHIFT) & 0x07)) * m_time_scale);
+
+    for ( ; ; ) {
+        int64_t temperature_end_us = temperature ? m_temperature_end_us : INT64_MAX;
+        int64_t pressure_end_us = pressure ? m_pressure_end_us : INT64_MAX;
+        bool next_pressure = (pressure_end_us < temperature_end_us);
+        if ((next_pressure ? pressure_end_us : temperature_end_us) > now_us) {
+            break;
+        }
+        if (next_pressure) {
+            m_last_pressure_us = m_pressure_end_us;
+            m_pressure_end_us += pressure_period_us;
+        } else {
+            m_temperature_end_us += temperature_period_us;
+        }
+        this->put_result(next_pressure);
+    }
+}
+
+/* A background result goes to the FIFO, bit 0 set for a pressure, or to the result registers without it. */
+void HostDps3xxModel::put_result(bool pressure) {
+    int32_t raw_pressure = m_raw_pressure;
+    if (pressure && m_raw_pressure_slope != 0.0) {
+        raw_pressure += (int32_t)lround(m_raw_pressure_slope * (m_last_pressure_us - m_slope_start_us) / 1000000.0);
+    }
+    uint32_t raw_value = (uint32_t)(pressure ? raw_pressure : m_raw_temperature) & HOST_DPS3XX_RESULT_MASK;
+    if (pressure) {
+        m_background_pressures++;
+    } else {
+        m_background_temperatures++;
+    }
+    m_measurements++;
+
+    if ((m_registers[DPS3XX_REG_ADDR_CFG_REG] & HOST_DPS3XX_FIFO_EN) == 0) {
+        uint8_t result_addr = pressure ? DPS3XX_REG_ADDR_PSR_B2 : DPS3XX_REG_ADDR_TMP_B2;
+        m_registers[result_addr + 0] = (uint8_t)(raw_value >> 16);
+        m_registers[result_addr + 1] = (uint8_t)(raw_value >> 8);
+        m_registers[result_addr + 2] = (uint8_t)(raw_value);
+        m_registers[DPS3XX_REG_ADDR_MEAS_CFG] |= pressure ? DPS3XX_REG_VALUE_PRS_RDY : DPS3XX_REG_VALUE_TMP_RDY;
+        return;
+    }
+
+    if (m_fifo.size() >= DPS3XX_FIFO_ENTRIES) {
+        m_fifo_lost++;
+    } else {
+        m_fifo.push_back(pressure ? (raw_value | DPS3XX_FIFO_ENTRY_PRESSURE) : (raw_value & ~(uint32_t)DPS3XX_FIFO_ENTRY_PRESSURE));
+    }
+    this->update_fifo_status();
+}
+
+void HostDps3xxModel::update_fifo_status() {
+    m_registers[DPS3XX_REG_ADDR_FIFO_STS] = (m_fifo.empty() ? HOST_DPS3XX_FIFO_EMPTY : 0x00) | ((m_fifo.size() >= DPS3XX_FIFO_ENTRIES) ? HOST_DPS3XX_FIFO_FULL : 0x00);
+}
+
+/***********************************************************************************************************************
+ * BMI270
+***********************************************************************************************************************/
+HostBmi270Model::HostBmi270Model() : m_init_failure(false), m_init_end_us(0), m_config_bytes(0), m_config_in_order(true), m_refused_bytes(0) {
+    this->SetRegister(BMI270_REG_ADDR_CHIP_ID, BMI270_REG_VALUE_CHIP_ID, 0x00);
+    this->reset();
+}
+
+bool HostBmi270Model::IsInitialized() {
+    this->update();
+    return (m_registers[BMI270_REG_ADDR_INTERNAL_STATUS] & BMI270_INTERNAL_STATUS_MESSAGE_MASK) == BMI270_REG_VALUE_STATUS_INIT_OK;
+}
+
+void HostBmi270Model::PushFrames(const uint8_t *p_frames, uint16_t size) {
+    Bmi270PwrCtrlReg_t pwr_ctrl;
+    pwr_ctrl.byte = m_registers[BMI270_REG_ADDR_PWR_CTRL];
+    if (!this->IsInitialized() || !pwr_ctrl.acc_en || !pwr_ctrl.gyr_en) {
+        m_refused_bytes += size;
+        return;
+    }
+
+    m_fifo.insert(m_fifo.end(), p_frames, p_frames + size);
+    while (m_fifo.size() > HOST_BMI270_FIFO_SIZE) {
+        m_fifo.erase(m_fifo.begin(), m_fifo.begin() + sizeof(Bmi270FifoFrame_t));
+    }
+}
+
+esp_err_t HostBmi270Model::Read(uint32_t reg_addr, uint8_t *buffer, uint16_t size) {
+    this->update();
+    uint8_t address = (uint8_t)(reg_addr & HOST_I2C_REG_ADDR_MASK);
+
+    // FIFO_DATA doesn't auto increment, a burst read pops as many bytes as it reads.
+    if (address == BMI270_REG_ADDR_FIFO_DATA) {
+        for (uint16_t i = 0; i < size; i++) {
+            buffer[i] = 0x00;
+            if (!m_fifo.empty()) {
+                buffer[i] = m_fifo.front();
+                m_fifo.pop_front();
+            }
+        }
+        return ESP_OK;
+    }
+
+    m_registers[BMI270_REG_ADDR_FIFO_LENGTH_0] = (uint8_t)(m_fifo.size() & 0xff);
+    m_registers[BMI270_REG_ADDR_FIFO_LENGTH_1] = (uint8_t)(m_fifo.size() >> 8);
+    return HostI2cRegisterFile::Read(reg_addr, buffer, size);
+}
+
+esp_err_t HostBmi270Model::Write(uint32_t reg_addr, const uint8_t *buffer, uint16_t size) {
+    this->update();
+    uint8_t address = (uint8_t)(reg_addr & HOST_I2C_REG_ADDR_MASK);
+
+    // INIT_DATA is a port into the config memory, a write goes on from the offset of INIT_ADDR_0/1 and moves it on.
+    if (address == BMI270_REG_ADDR_INIT_DATA) {
+        uint32_t words = ((uint32_t)m_registers[BMI270_REG_ADDR_INIT_ADDR_1] << BMI270_INIT_ADDR_1_SHIFT) | (m_registers[BMI270_REG_ADDR_INIT_ADDR_0] & BMI270_INIT_ADDR_0_MASK);
+        m_config_in_order = m_config_in_order && m_registers[BMI270_REG_ADDR_INIT_CTRL] == BMI270_REG_VALUE_INIT_CTRL_LOAD && words * 2 == m_config_bytes && size % 2 == 0;
+        m_config_bytes = words * 2 + size;
+        words += size / 2;
+        m_registers[BMI270_REG_ADDR_INIT_ADDR_0] = (uint8_t)(words & BMI270_INIT_ADDR_0_MASK);
+        m_registers[BMI270_REG_ADDR_INIT_ADDR_1] = (uint8_t)(words >> BMI270_INIT_ADDR_1_SHIFT);
+        return ESP_OK;
+    }
+
+    esp_err_t result = HostI2cRegisterFile::Write(reg_addr, buffer, size);
+    for (uint16_t i = 0; i < size; i++) {
+        uint8_t index = (uint8_t)(address + i);
+        if (index == BMI270_REG_ADDR_INIT_CTRL && buffer[i] == BMI270_REG_VALUE_INIT_CTRL_LOAD) {
+            m_config_bytes = 0;
+            m_config_in_order = true;
+            m_init_end_us = 0;
+            this->SetRegister(BMI270_REG_ADDR_INTERNAL_STATUS, BMI270_REG_VALUE_STATUS_NOT_INIT, 0x00);
+        } else if (index == BMI270_REG_ADDR_INIT_CTRL && buffer[i] == BMI270_REG_VALUE_INIT_CTRL_START) {
+            m_init_end_us = HostClockNowUs() + HOST_BMI270_INIT_US;
+        } else if (index == BMI270_REG_ADDR_CMD && buffer[i] == BMI270_REG_VALUE_CMD_SOFT_RESET) {
+            this->reset();
+        } else if (index == BMI270_REG_ADDR_CMD && buffer[i] == BMI270_REG_VALUE_CMD_FIFO_FLUSH) {
+            m_fifo.clear();
+        }
+    }
+
+    return result;
+}
+
+void HostBmi270Model::reset() {
+    this->SetRegister(BMI270_REG_ADDR_INTERNAL_STATUS, BMI270_REG_VALUE_STATUS_NOT_INIT, 0x00);
+    this->SetRegister(BMI270_REG_ADDR_INIT_CTRL, BMI270_REG_VALUE_INIT_CTRL_LOAD);
+    this->SetRegister(BMI270_REG_ADDR_INIT_ADDR_0, 0x00);
+    this->SetRegister(BMI270_REG_ADDR_INIT_ADDR_1, 0x00);
+    this->SetRegister(BMI270_REG_ADDR_PWR_CTRL, 0x00);
+
+    m_init_end_us = 0;
+    m_config_bytes = 0;
+    m_config_in_order = true;
+    m_fifo.clear();
+}
+
+/* The initialization started is reported once its time has passed. */
+void HostBmi270Model::update() {
+    if (m_init_end_us == 0 || HostClockNowUs() < m_init_end_us) {
+        return;
+    }
+
+    bool uploaded = (m_config_in_order && m_config_bytes == BMI270_CONFIG_FILE_SIZE);
+    uint8_t status = (uploaded && !m_init_failure) ? BMI270_REG_VALUE_STATUS_INIT_OK : BMI270_REG_VALUE_STATUS_INIT_ERR;
+    this->SetRegister(BMI270_REG_ADDR_INTERNAL_STATUS, status, 0x00);
+    m_init_end_us = 0;
+}
+
+/***********************************************************************************************************************
+ * AXP192
+***********************************************************************************************************************/
+HostAxp192Model::HostAxp192Model() {
+    this->SetBattery(4000, 0, false);
+}
+
+void HostAxp192Model::SetBattery(uint32_t voltage_mv, uint32_t charging_current_ma, bool vbus_present) {
+    Axp192PowerStatusReg_t power_status = {0};
+    power_status.vbus_pres = vbus_present;
+    power_status.vbus_vld = vbus_present;
+    power_status.charging = (charging_current_ma > 0);
+
+    Axp192ChargingStatusReg_t charging_status = {0};
+    charging_status.has_battery = 1;
+    charging_status.battery_charging = (charging_current_ma > 0);
+
+    // Battery voltage is 12 bits of 1.1mV, charging current 13 bits of 0.5mA.
+    uint32_t raw_voltage = voltage_mv * 10 / 11;
+    uint32_t raw_current = charging_current_ma * 2;
+
+    this->SetRegister(AXP192_REG_ADDR_POWER_STATUS, power_status.byte, 0x00);
+    this->SetRegister(AXP192_REG_ADDR_CHARGING_STATUS, charging_status.byte, 0x00);
+    this->SetRegister(AXP192_REG_ADDR_BATTERY_VOLTAGE_H, (uint8_t)(raw_voltage >> 4), 0x00);
+    this->SetRegister(AXP192_REG_ADDR_BATTERY_VOLTAGE_H + 1, (uint8_t)(raw_voltage & 0x0f), 0x00);
+    this->SetRegister(AXP192_REG_ADDR_CHARGING_CURRENT_H, (uint8_t)(raw_current >> 5), 0x00);
+    this->SetRegister(AXP192_REG_ADDR_CHARGING_CURRENT_H + 1, (uint8_t)(raw_current & 0x1f), 0x00);
+}
+
+/***********************************************************************************************************************
+ * BM8563
+***********************************************************************************************************************/
+HostBm8563Model::HostBm8563Model() : m_base_time(0), m_base_us(0) {
+    this->SetTime(0);
+}
+
+void HostBm8563Model::SetTime(time_t time) {
+    m_base_time = time;
+    m_base_us = HostClockNowUs();
+}
+
+time_t HostBm8563Model::GetTime() const {
+    return m_base_time + (time_t)((HostClockNowUs() - m_base_us) / 1000000);
+}
+
+esp_err_t HostBm8563Model::Read(uint32_t reg_addr, uint8_t *buffer, uint16_t size) {
+    time_t now = this->GetTime();
+    struct tm tm_now;
+    gmtime_r(&now, &tm_now);
+
+    // Seconds, minutes, hours, day, weekday, century and month, year, the voltage low flag is never set.
+    m_registers[HOST_BM8563_REG_ADDR_DATETIME + 0] = bcd_encode(tm_now.tm_sec);
+    m_registers[HOST_BM8563_REG_ADDR_DATETIME + 1] = bcd_encode(tm_now.tm_min);
+    m_registers[HOST_BM8563_REG_ADDR_DATETIME + 2] = bcd_encode(tm_now.tm_hour);
+    m_registers[HOST_BM8563_REG_ADDR_DATETIME + 3] = bcd_encode(tm_now.tm_mday);
+    m_registers[HOST_BM8563_REG_ADDR_DATETIME + 4] = (uint8_t)tm_now.tm_wday;
+    m_registers[HOST_BM8563_REG_ADDR_DATETIME + 5] = bcd_encode(tm_now.tm_mon + 1) | ((tm_now.tm_year >= 200) ? 0x80 : 0x00);
+    m_registers[HOST_BM8563_REG_ADDR_DATETIME + 6] = bcd_encode(tm_now.tm_year % 100);
+
+    return HostI2cRegisterFile::Read(reg_addr, buffer, size);
+}
+
+esp_err_t HostBm8563Model::Write(uint32_t reg_addr, const uint8_t *buffer, uint16_t size) {
+    esp_err_t result = HostI2cRegisterFile::Write(reg_addr, buffer, size);
+
+    uint8_t address = (uint8_t)(reg_addr & HOST_I2C_REG_ADDR_MASK);
+    if (address <= HOST_BM8563_REG_ADDR_DATETIME && address + size >= HOST_BM8563_REG_ADDR_DATETIME + HOST_BM8563_DATETIME_SIZE) {
+        const uint8_t *p_regs = &(m_registers[HOST_BM8563_REG_ADDR_DATETIME]);
+        struct tm tm_set = {0};
+        tm_set.tm_sec = bcd_decode(p_regs[0] & 0x7f);
+        tm_set.tm_min = bcd_decode(p_regs[1] & 0x7f);
+        tm_set.tm_hour = bcd_decode(p_regs[2] & 0x3f);
+        tm_set.tm_mday = bcd_decode(p_regs[3] & 0x3f);
+        tm_set.tm_mon = bcd_decode(p_regs[5] & 0x1f) - 1;
+        tm_set.tm_year = bcd_decode(p_regs[6]) + ((p_regs[5] & 0x80) ? 200 : 100);
+        this->SetTime(timegm(&tm_set));
+    }
+
+    return result;
+}
+
+/***********************************************************************************************************************
+ * FT6x36U
+***********************************************************************************************************************/
+HostFt6x36uModel::HostFt6x36uModel() {
+    this->SetRegister(HOST_FT6X36U_REG_ADDR_CHIP_ID, HOST_FT6X36U_CHIP_ID, 0x00);
+    this->SetRegister(HOST_FT6X36U_REG_ADDR_VENDOR_ID, HOST_FT6X36U_VENDOR_ID, 0x00);
+    this->Release();
+}
+
+void HostFt6x36uModel::Touch(uint16_t x, uint16_t y) {
+    this->SetRegister(FT6X36U_REG_ADDR_TD_STATUS, 1, 0x00);
+    this->SetRegister(FT6X36U_REG_ADDR_TOUCH1_X_MSB, (uint8_t)((x >> 8) & FT6X36U_TOUCH_DATA_MSB_MASK), 0x00);
+    this->SetRegister(FT6X36U_REG_ADDR_TOUCH1_X_LSB, (uint8_t)(x & FT6X36U_TOUCH_DATA_LSB_MASK), 0x00);
+    this->SetRegister(FT6X36U_REG_ADDR_TOUCH1_Y_MSB, (uint8_t)((y >> 8) & FT6X36U_TOUCH_DATA_MSB_MASK), 0x00);
+    this->SetRegister(FT6X36U_REG_ADDR_TOUCH1_Y_LSB, (uint8_t)(y & FT6X36U_TOUCH_DATA_LSB_MASK), 0x00);
+}
+
+void HostFt6x36uModel::Release() {
+    this->SetRegister(FT6X36U_REG_ADDR_TD_STATUS, 0, 0x00);
+}
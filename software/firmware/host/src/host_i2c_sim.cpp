@@ -0,0 +1,680 @@
+/*
+    Host I2C simulation: runs the I2C part of the boot sequence of app_main and the DPS3xx measurement loop against the
+    register models of host_i2c_models.h on the virtual clock, with the bus timing and fault injection of HostI2cBus.
+        - boot with every device, without the anemometer, with the first barometer resets not acknowledged and with the
+          RTC probe timing out: which devices are initialized, the bus time and the boot time of each step
+        - Dps3xxBarometer::fetch_data against a nominal and a slow DPS3xx in background mode: transactions, bus
+          occupancy and MEAS_CFG polls per sample, the sample period, the spacing of the sample timestamps, the time
+          from the end of the last pressure of a burst to its read and the temperatures measured per pressure
+        - a switch to the ground mode and back without a reset: the sample period follows, the same air reads the same
+          pressure and temperature in both modes
+        - fetch_data held up past the FIFO: the overflow is counted and the samples go on
+        - fetch_data with random NACKs and timeouts: every fault fails its burst, a timeout holds the bus for the
+          I2cMaster timeout
+        - RTC, touch and PMU register models read back through their drivers
+        - BMI270 brought up against its model: no frame before the config file upload, the frames pushed after it
+          fetched, and init_device failing when the model never reports the initialization done
+        - the barometer and anemometer tasks on the same air sinking through a pressure ramp: the anemometer starts on
+          the phase of the barometer, every total pressure is paired with the static pressure of its sample, the
+          differential pressure stays at 0 where unpaired samples would read the ramp of the periods between them
+
+    Usage: bluethroat_host_i2c [-n samples] [-o overhead us] [-v]
+        -n  barometer samples per fetch run, 50 by default
+        -o  driver overhead of every transaction in us, 50 by default
+        -v  verbose firmware log
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include "utilities/i2c_master.h"
+#include "drivers/axp192_pmu.h"
+#include "drivers/bmi270_imu.h"
+#include "drivers/bm8563_rtc.h"
+#include "drivers/dps3xx_anemometer.h"
+#include "drivers/dps3xx_barometer.h"
+#include "drivers/ft6x36u_touch.h"
+#include "bluethroat_global.h"
+#include "bluethroat_msg_proc.h"
+#include "host_clock.h"
+#include "host_i2c_bus.h"
+#include "host_i2c_models.h"
+
+#define HOST_DEFAULT_SAMPLES            (50)
+#define HOST_DEFAULT_OVERHEAD_US        (50)
+#define HOST_FAULT_SAMPLES              (500)
+#define HOST_NACK_PROBABILITY           (0.01)
+#define HOST_TIMEOUT_PROBABILITY        (0.002)
+#define HOST_SLOW_DPS3XX_TIME_SCALE     (1.15)
+/* The wake timer drains a burst once its last pressure ended, the measurement times are rounded up to the ms, and the
+   drain reads the entries one by one */
+#define HOST_MAX_RESULT_AGE_MS          (3.0)
+#define HOST_RESET_NACKS                (3)
+#define HOST_RTC_START_TIME             (1720339200)    /* 2024-07-07 08:00:00 UTC */
+#define HOST_RTC_RUN_MS                 (10000)
+#define HOST_BATTERY_MV                 (3900)
+#define HOST_IMU_FRAMES                 (5)
+/* Scaled results of the air of the mode switch, about 1000 hPa and 25 degrees with the coefficients below */
+#define HOST_MODE_SCALED_PRESSURE       (-0.38)
+#define HOST_MODE_SCALED_TEMPERATURE    (0.295)
+#define HOST_MODE_PRESSURE_TOLERANCE    (0.5)           /* Pa */
+#define HOST_MODE_TEMPERATURE_TOLERANCE (0.01)          /* degrees */
+/* A 5 m/s sink near the ground, the deep filters of both sensors filled before the differential pressure is read */
+#define HOST_PAIR_PRESSURE_SLOPE        (60.0)          /* Pa/s */
+#define HOST_PAIR_WARMUP_SAMPLES        (2 << FILTER_DEPTH_DEEP)
+#define HOST_PAIR_MAX_START_SKEW_US     (500)
+#define HOST_PAIR_PRESSURE_TOLERANCE    (0.5)           /* Pa */
+
+/* Coefficients of a DPS310, the zeros of the model make every pressure 0 */
+static const Dps3xxCoefData_t s_mode_coefs = {.c0 = 204, .c1 = -261, .c00 = 80469, .c10 = -54769, .c01 = -2289, .c11 = 1339, .c20 = -9765, .c21 = 157, .c30 = -1069};
+
+#define HOST_CHECK(condition, format, ...)                                                                              \
+    do {                                                                                                                \
+        if (!(condition)) {                                                                                             \
+            fprintf(stderr, "%s:%d: check failed: " format "\n", __FILE__, __LINE__, ##__VA_ARGS__);                    \
+            s_failures++;                                                                                               \
+        }                                                                                                               \
+    } while (0)
+
+typedef struct {
+    HostAxp192Model pmu;
+    HostFt6x36uModel touch;
+    HostBm8563Model rtc;
+    HostDps3xxModel barometer;
+    HostDps3xxModel anemometer;
+    HostBmi270Model imu;
+} HostModels_t;
+
+typedef struct {
+    I2cMaster *p_masters[I2C_NUM_MAX];
+    Axp192Pmu *p_pmu;
+    Ft6x36uTouch *p_touch;
+    Bm8563Rtc *p_rtc;
+    Dps3xxBarometer *p_barometer;
+    Dps3xxAnemometer *p_anemometer;
+} HostBoot_t;
+
+typedef struct {
+    const char *name;
+    int64_t start_us;
+    HostI2cStats_t start_stats;
+} HostStep_t;
+
+typedef struct {
+    const char *name;
+    I2cDeviceIndex_t index;                 /* device of the scenario, I2C_DEVICE_INDEX_MAX for none */
+    bool detach;                            /* the device is not on the bus */
+    HostI2cFault_t fault;                   /* or it answers with these faults */
+    const Dps3xxCoefData_t *p_coefs;        /* of both DPS3xx, the zeros of the model for none */
+} HostBootScenario_t;
+
+static uint32_t s_failures = 0;
+static uint32_t s_overhead_us = HOST_DEFAULT_OVERHEAD_US;
+
+static void bus_stats(HostI2cStats_t *p_stats) {
+    memset(p_stats, 0, sizeof(HostI2cStats_t));
+    for (int port = 0; port < I2C_NUM_MAX; port++) {
+        const HostI2cStats_t *p_port = &(HostI2cBus::GetBus(port)->m_stats);
+        p_stats->transactions += p_port->transactions;
+        p_stats->nacks += p_port->nacks;
+        p_stats->timeouts += p_port->timeouts;
+        p_stats->busy_us += p_port->busy_us;
+    }
+}
+
+static void step_begin(HostStep_t *p_step, const char *name) {
+    p_step->name = name;
+    p_step->start_us = HostClockNowUs();
+    bus_stats(&(p_step->start_stats));
+}
+
+static int64_t step_end(HostStep_t *p_step, bool present) {
+    HostI2cStats_t stats;
+    bus_stats(&stats);
+    int64_t elapsed_us = HostClockNowUs() - p_step->start_us;
+    printf("    %-18s %-8s %4u transactions %2u nacks %2u timeouts %8.3f ms on the bus %7.1f ms\n", p_step->name,
+        present ? "present" : "absent", stats.transactions - p_step->start_stats.transactions,
+        stats.nacks - p_step->start_stats.nacks, stats.timeouts - p_step->start_stats.timeouts,
+        (stats.busy_us - p_step->start_stats.busy_us) / 1000.0, elapsed_us / 1000.0);
+    return elapsed_us;
+}
+
+/* Fresh models on the buses, blocking timing so the bus time shows on the virtual clock. */
+static HostModels_t *attach_models() {
+    HostModels_t *p_models = new HostModels_t();
+    HostI2cDevice *p_devices[I2C_DEVICE_INDEX_MAX] = {NULL};
+    p_devices[I2C_DEVICE_INDEX_AXP192_PMU] = &(p_models->pmu);
+    p_devices[I2C_DEVICE_INDEX_FT6X36_TOUCH] = &(p_models->touch);
+    p_devices[I2C_DEVICE_INDEX_BM8563_RTC] = &(p_models->rtc);
+    p_devices[I2C_DEVICE_INDEX_DPS3XX_BAROMETER] = &(p_models->barometer);
+    p_devices[I2C_DEVICE_INDEX_DPS3XX_ANEMOMETER] = &(p_models->anemometer);
+    p_devices[I2C_DEVICE_INDEX_BMI270_ACCELEROMETER] = &(p_models->imu);
+
+    for (int port = 0; port < I2C_NUM_MAX; port++) {
+        HostI2cBus *p_bus = HostI2cBus::GetBus(port);
+        p_bus->m_devices.clear();
+        p_bus->ClearFaults();
+        p_bus->ResetStats();
+    }
+    for (int i = 0; i < I2C_DEVICE_INDEX_MAX; i++) {
+        if (p_devices[i] != NULL) {
+            HostI2cBus::GetBus(g_I2cDeviceMap[i].port)->Attach(g_I2cDeviceMap[i].addr, p_devices[i]);
+        }
+    }
+
+    return p_models;
+}
+
+/* Steps 2 to 9 of app_main, the I2C devices in the same order and on the same conditions. */
+static int64_t boot(HostBoot_t *p_boot) {
+    memset(p_boot, 0, sizeof(HostBoot_t));
+    int64_t start_us = HostClockNowUs();
+
+    p_boot->p_masters[I2C_NUM_0] = new I2cMaster(I2C_NUM_0, CONFIG_I2C_PORT_0_SDA, CONFIG_I2C_PORT_0_SCL, false, false, CONFIG_I2C_PORT_0_FREQ_HZ, CONFIG_I2C_PORT_0_LOCK_TIMEOUT, CONFIG_I2C_PORT_0_TIMEOUT);
+    p_boot->p_masters[I2C_NUM_1] = new I2cMaster(I2C_NUM_1, CONFIG_I2C_PORT_1_SDA, CONFIG_I2C_PORT_1_SCL, false, false, CONFIG_I2C_PORT_1_FREQ_HZ, CONFIG_I2C_PORT_1_LOCK_TIMEOUT, CONFIG_I2C_PORT_1_TIMEOUT);
+    for (int port = 0; port < I2C_NUM_MAX; port++) {
+        HostI2cBus *p_bus = HostI2cBus::GetBus(port);
+        p_bus->m_timing.overhead_us = s_overhead_us;
+        p_bus->m_timing.blocking = true;
+    }
+
+    HostStep_t step;
+    const I2cDevice_t *p_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_AXP192_PMU]);
+    I2cMaster *p_master = p_boot->p_masters[p_device->port];
+    step_begin(&step, "axp192 pmu");
+    if (p_master->ProbeDevice(p_device->addr) == ESP_OK && Axp192Pmu::CheckDeviceId(p_master, p_device->addr) == ESP_OK) {
+        (p_boot->p_pmu = new Axp192Pmu())->Init(p_master, p_device->addr, p_device->int_pins);
+    }
+    step_end(&step, p_boot->p_pmu != NULL);
+
+    // The touch controller is not probed.
+    p_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_FT6X36_TOUCH]);
+    p_master = p_boot->p_masters[p_device->port];
+    step_begin(&step, "ft6x36u touch");
+    if (Ft6x36uTouch::CheckDeviceId(p_master, p_device->addr) == ESP_OK) {
+        (p_boot->p_touch = new Ft6x36uTouch())->Init(p_master, p_device->addr, p_device->int_pins);
+    }
+    step_end(&step, p_boot->p_touch != NULL);
+
+    p_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_BM8563_RTC]);
+    p_master = p_boot->p_masters[p_device->port];
+    step_begin(&step, "bm8563 rtc");
+    if (p_master->ProbeDevice(p_device->addr) == ESP_OK && Bm8563Rtc::CheckDeviceId(p_master, p_device->addr) == ESP_OK) {
+        (p_boot->p_rtc = new Bm8563Rtc())->Init(p_master, p_device->addr, p_device->int_pins);
+    }
+    step_end(&step, p_boot->p_rtc != NULL);
+
+    p_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_BAROMETER]);
+    p_master = p_boot->p_masters[p_device->port];
+    step_begin(&step, "dps3xx barometer");
+    if (p_master->ProbeDevice(p_device->addr) == ESP_OK && Dps3xxBarometer::CheckDeviceId(p_master, p_device->addr) == ESP_OK) {
+        Dps3xxSync *p_sync = new Dps3xxSync();
+        if (p_sync->Init() != ESP_OK) {
+            delete p_sync;
+            p_sync = NULL;
+        }
+        (p_boot->p_barometer = new Dps3xxBarometer(p_sync))->Init(p_master, p_device->addr, p_device->int_pins);
+    }
+    step_end(&step, p_boot->p_barometer != NULL);
+
+    p_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_ANEMOMETER]);
+    p_master = p_boot->p_masters[p_device->port];
+    step_begin(&step, "dps3xx anemometer");
+    if (p_master->ProbeDevice(p_device->addr) == ESP_OK && Dps3xxAnemometer::CheckDeviceId(p_master, p_device->addr) == ESP_OK) {
+        (p_boot->p_anemometer = new Dps3xxAnemometer(p_boot->p_barometer))->Init(p_master, p_device->addr, p_device->int_pins);
+    }
+    step_end(&step, p_boot->p_anemometer != NULL);
+
+    return HostClockNowUs() - start_us;
+}
+
+/* The drivers are left alone as on the device, only the masters and the models go. */
+static void shutdown(HostBoot_t *p_boot, HostModels_t *p_models) {
+    for (int port = 0; port < I2C_NUM_MAX; port++) {
+        delete p_boot->p_masters[port];
+        HostI2cBus::GetBus(port)->m_devices.clear();
+        HostI2cBus::GetBus(port)->ClearFaults();
+    }
+    delete p_models;
+}
+
+/* The coefficient registers of the DPS3xx, the layout Dps3xxBarometer::get_coefs() unpacks. */
+static void encode_coefs(const Dps3xxCoefData_t *p_coefs, uint8_t *p_bytes) {
+    const int32_t words[5] = {p_coefs->c01, p_coefs->c11, p_coefs->c20, p_coefs->c21, p_coefs->c30};
+
+    memset(p_bytes, 0, sizeof(Dps3xxCoefRegs_t));
+    p_bytes[0] = (uint8_t)(p_coefs->c0 >> 4);
+    p_bytes[1] = (uint8_t)(((p_coefs->c0 & 0x0f) << 4) | ((p_coefs->c1 >> 8) & 0x0f));
+    p_bytes[2] = (uint8_t)(p_coefs->c1);
+    p_bytes[3] = (uint8_t)(p_coefs->c00 >> 12);
+    p_bytes[4] = (uint8_t)(p_coefs->c00 >> 4);
+    p_bytes[5] = (uint8_t)(((p_coefs->c00 & 0x0f) << 4) | ((p_coefs->c10 >> 16) & 0x0f));
+    p_bytes[6] = (uint8_t)(p_coefs->c10 >> 8);
+    p_bytes[7] = (uint8_t)(p_coefs->c10);
+    for (int i = 0; i < 5; i++) {
+        p_bytes[8 + 2 * i] = (uint8_t)(words[i] >> 8);
+        p_bytes[9 + 2 * i] = (uint8_t)(words[i]);
+    }
+}
+
+/* Boots against fresh models with one device missing or faulty. */
+static int64_t run_boot(const HostBootScenario_t *p_scenario, HostBoot_t *p_boot, HostModels_t **pp_models) {
+    *pp_models = attach_models();
+    if (p_scenario->p_coefs != NULL) {
+        uint8_t coefs[sizeof(Dps3xxCoefRegs_t)];
+        encode_coefs(p_scenario->p_coefs, coefs);
+        (*pp_models)->barometer.SetCoefs(coefs, sizeof(coefs));
+        (*pp_models)->anemometer.SetCoefs(coefs, sizeof(coefs));
+    }
+    if (p_scenario->index < I2C_DEVICE_INDEX_MAX) {
+        HostI2cBus *p_bus = HostI2cBus::GetBus(g_I2cDeviceMap[p_scenario->index].port);
+        if (p_scenario->detach) {
+            p_bus->Detach(g_I2cDeviceMap[p_scenario->index].addr);
+        } else {
+            p_bus->SetFault(g_I2cDeviceMap[p_scenario->index].addr, &(p_scenario->fault));
+        }
+    }
+
+    printf("boot, %s:\n", p_scenario->name);
+    int64_t boot_us = boot(p_boot);
+    HostI2cStats_t stats;
+    bus_stats(&stats);
+    printf("    %u transactions, %.3f ms on the bus, boot %.1f ms\n", stats.transactions, stats.busy_us / 1000.0, boot_us / 1000.0);
+    return boot_us;
+}
+
+static void check_boot() {
+    static const HostBootScenario_t scenarios[] = {
+        {.name = "every device", .index = I2C_DEVICE_INDEX_MAX},
+        {.name = "no anemometer", .index = I2C_DEVICE_INDEX_DPS3XX_ANEMOMETER, .detach = true},
+        {.name = "barometer resets not acknowledged", .index = I2C_DEVICE_INDEX_DPS3XX_BAROMETER, .fault = {.after_count = 2, .nack_count = HOST_RESET_NACKS}},
+        {.name = "rtc probe timeout", .index = I2C_DEVICE_INDEX_BM8563_RTC, .fault = {.timeout_count = 1}},
+    };
+    HostBoot_t boot;
+    HostModels_t *p_models;
+    HostI2cStats_t stats;
+
+    int64_t nominal_us = run_boot(&(scenarios[0]), &boot, &p_models);
+    HOST_CHECK(boot.p_pmu != NULL && boot.p_touch != NULL && boot.p_rtc != NULL && boot.p_barometer != NULL && boot.p_anemometer != NULL, "a device is missing");
+    shutdown(&boot, p_models);
+
+    int64_t boot_us = run_boot(&(scenarios[1]), &boot, &p_models);
+    HOST_CHECK(boot.p_anemometer == NULL && boot.p_barometer != NULL && boot.p_rtc != NULL, "anemometer found or barometer missing");
+    HOST_CHECK(boot_us < nominal_us, "boot without anemometer took %.1f ms", boot_us / 1000.0);
+    shutdown(&boot, p_models);
+
+    // The barometer reset is retried every tick until it is acknowledged, the first retry only waits for the next tick.
+    boot_us = run_boot(&(scenarios[2]), &boot, &p_models);
+    HostI2cBus::GetBus(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_BAROMETER].port)->GetStats(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_BAROMETER].addr, &stats);
+    HOST_CHECK(boot.p_barometer != NULL && boot.p_anemometer != NULL, "barometer or anemometer missing");
+    HOST_CHECK(stats.nacks == HOST_RESET_NACKS, "%u barometer nacks", stats.nacks);
+    HOST_CHECK(boot_us > nominal_us + (HOST_RESET_NACKS - 2) * portTICK_PERIOD_MS * 1000, "boot with reset retries took %.1f ms", boot_us / 1000.0);
+    shutdown(&boot, p_models);
+
+    // The probe holds the bus for the whole I2C timeout, the RTC is left out.
+    boot_us = run_boot(&(scenarios[3]), &boot, &p_models);
+    HOST_CHECK(boot.p_rtc == NULL && boot.p_barometer != NULL, "rtc found or barometer missing");
+    HOST_CHECK(boot_us >= nominal_us + (CONFIG_I2C_PORT_0_TIMEOUT - portTICK_PERIOD_MS) * 1000, "boot with rtc timeout took %.1f ms", boot_us / 1000.0);
+    shutdown(&boot, p_models);
+}
+
+/* The measurement loop of the barometer task, on a barometer initialized by boot(). */
+static uint32_t run_fetch(const char *name, HostBoot_t *p_boot, HostDps3xxModel *p_model, uint32_t samples, double *p_period_ms, double *p_transactions, uint32_t *p_uneven, double *p_age_ms) {
+    const I2cDevice_t *p_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_BAROMETER]);
+    HostI2cBus *p_bus = HostI2cBus::GetBus(p_device->port);
+    uint8_t raw_data[sizeof(Dps3xxData_t)];
+    uint32_t failures = 0;
+    uint32_t last_timestamp = 0;
+    bool has_timestamp = false;
+    int64_t age_us = 0;
+    uint32_t bursts = 0;
+
+    p_bus->ResetStats();
+    p_model->m_status_reads = 0;
+    *p_uneven = 0;
+    int64_t start_us = HostClockNowUs();
+    for (uint32_t i = 0; i < samples; i++) {
+        if (p_boot->p_barometer->fetch_data(raw_data, sizeof(raw_data)) != ESP_OK) {
+            failures++;
+            continue;
+        }
+        // The first sample of a burst is handed over right after the read, the last pressure ended before it.
+        if (p_boot->p_barometer->m_sample_index == 1) {
+            age_us += HostClockNowUs() - p_model->m_last_pressure_us;
+            bursts++;
+        }
+        uint32_t timestamp = p_boot->p_barometer->m_sample_timestamp;
+        if (has_timestamp && timestamp - last_timestamp != p_boot->p_barometer->GetSamplePeriodMs()) {
+            (*p_uneven)++;
+        }
+        last_timestamp = timestamp;
+        has_timestamp = true;
+    }
+    int64_t elapsed_us = HostClockNowUs() - start_us;
+
+    HostI2cStats_t stats;
+    p_bus->GetStats(p_device->addr, &stats);
+    *p_period_ms = elapsed_us / 1000.0 / samples;
+    *p_transactions = (double)stats.transactions / samples;
+    *p_age_ms = (bursts > 0) ? age_us / 1000.0 / bursts : 0.0;
+    printf("fetch, %s: %u samples, %u failed, %.2f transactions and %.3f ms on the bus per sample (%.2f%% of the time), one sample every %.1f ms\n",
+        name, samples, failures, *p_transactions, stats.busy_us / 1000.0 / samples, 100.0 * stats.busy_us / elapsed_us, *p_period_ms);
+    if (failures == 0) {
+        printf("    %.2f MEAS_CFG polls per sample, %u samples not a period after the previous one, the last pressure read %.2f ms after it ended\n",
+            (double)p_model->m_status_reads / samples, *p_uneven, *p_age_ms);
+    } else {
+        printf("    %u nacks, %u timeouts, %u ms of the bus held by timeouts\n", stats.nacks, stats.timeouts, stats.timeouts * CONFIG_I2C_PORT_0_TIMEOUT);
+    }
+    return failures;
+}
+
+/*
+    The barometer switched to a mode by the next fetch, then the air of HOST_MODE_SCALED_PRESSURE and
+    HOST_MODE_SCALED_TEMPERATURE measured at the oversampling of the mode, compensated by the driver.
+*/
+static void run_mode(const char *name, HostBoot_t *p_boot, HostDps3xxModel *p_model, Dps3xxMode_t mode, uint32_t samples, float *p_pressure, float *p_temperature) {
+    Dps3xxBarometer *p_barometer = p_boot->p_barometer;
+    double period_ms, transactions, age_ms;
+    uint32_t uneven;
+
+    // The samples left of the last burst of the old mode come first, the switch follows them.
+    uint8_t raw_data[sizeof(Dps3xxData_t)];
+    p_barometer->SetMode(mode);
+    while (p_barometer->m_sample_index < p_barometer->m_sample_count) {
+        (void)p_barometer->fetch_data(raw_data, sizeof(raw_data));
+    }
+    uint32_t failures = run_fetch(name, p_boot, p_model, samples, &period_ms, &transactions, &uneven, &age_ms);
+    double nominal_ms = p_barometer->GetSamplePeriodMs();
+    HOST_CHECK(failures == 0 && p_barometer->GetMode() == mode, "%u failed samples, mode %d", failures, p_barometer->GetMode());
+    HOST_CHECK(p_model->m_status_reads == 0, "%u MEAS_CFG polls", p_model->m_status_reads);
+    HOST_CHECK(uneven == 0, "%u samples not a period after the previous one", uneven);
+    HOST_CHECK(age_ms < HOST_MAX_RESULT_AGE_MS, "the last pressure read %.2f ms after it ended", age_ms);
+    HOST_CHECK(fabs(period_ms - nominal_ms) < nominal_ms * DPS3XX_FIFO_BURST_SAMPLES / samples + 0.1, "sample period %.1f ms, expected %.1f ms", period_ms, nominal_ms);
+
+    // The FIFO holds the results of the old air, a few bursts drain them.
+    p_model->SetSample((int32_t)lround(HOST_MODE_SCALED_PRESSURE * (float)p_barometer->m_pressure_cfg.scale_factor), (int32_t)lround(HOST_MODE_SCALED_TEMPERATURE * (float)p_barometer->m_temperature_cfg.scale_factor));
+    BluethroatMsg_t message = {};
+    for (uint32_t i = 0; i < DPS3XX_FIFO_ENTRIES; i++) {
+        if (p_barometer->fetch_data(raw_data, sizeof(raw_data)) != ESP_OK || p_barometer->process_data(raw_data, sizeof(raw_data), &message) != ESP_OK) {
+            HOST_CHECK(false, "%s sample %u failed", name, i);
+            break;
+        }
+    }
+    *p_pressure = message.barometer_data.pressure;
+    *p_temperature = message.barometer_data.temperature;
+}
+
+static void check_fetch(uint32_t samples) {
+    static const HostBootScenario_t scenario = {.name = "every device", .index = I2C_DEVICE_INDEX_MAX};
+    HostBoot_t boot;
+    HostModels_t *p_models;
+    double period_ms, transactions, age_ms;
+    uint32_t uneven;
+
+    (void)run_boot(&scenario, &boot, &p_models);
+    if (boot.p_barometer == NULL) {
+        HOST_CHECK(false, "barometer missing");
+        shutdown(&boot, p_models);
+        return;
+    }
+    double nominal_ms = boot.p_barometer->GetSamplePeriodMs();
+    // The first burst comes at most a wake after the boot.
+    double tolerance_ms = nominal_ms * DPS3XX_FIFO_BURST_SAMPLES / samples + 0.1;
+
+    // A read per FIFO entry and the empty marker, no status poll, the samples a period apart, a temperature every few
+    // pressures.
+    uint32_t ratio = 1U << (boot.p_barometer->m_pressure_cfg.mesurement_rate - boot.p_barometer->m_temperature_cfg.mesurement_rate);
+    uint32_t pressures = p_models->barometer.m_background_pressures;
+    uint32_t temperatures = p_models->barometer.m_background_temperatures;
+    uint32_t failures = run_fetch("nominal dps3xx", &boot, &(p_models->barometer), samples, &period_ms, &transactions, &uneven, &age_ms);
+    HOST_CHECK(failures == 0, "%u failed samples", failures);
+    HOST_CHECK(p_models->barometer.m_status_reads == 0, "%u MEAS_CFG polls", p_models->barometer.m_status_reads);
+    HOST_CHECK(transactions <= 1.0 + 1.0 / ratio + 1.0 / DPS3XX_FIFO_BURST_SAMPLES + 0.05, "%.2f transactions per sample", transactions);
+    HOST_CHECK(uneven == 0, "%u samples not a period after the previous one", uneven);
+    HOST_CHECK(age_ms < HOST_MAX_RESULT_AGE_MS, "the last pressure read %.2f ms after it ended", age_ms);
+    HOST_CHECK(fabs(period_ms - nominal_ms) < tolerance_ms, "sample period %.1f ms, expected %.1f ms", period_ms, nominal_ms);
+    pressures = p_models->barometer.m_background_pressures - pressures;
+    temperatures = p_models->barometer.m_background_temperatures - temperatures;
+    printf("    %u pressures and %u temperatures measured, a temperature every %u pressures\n", pressures, temperatures, ratio);
+    HOST_CHECK(ratio <= DPS3XX_TEMPERATURE_RATIO && ratio * 2 > DPS3XX_TEMPERATURE_RATIO, "a temperature every %u pressures", ratio);
+    HOST_CHECK(temperatures * ratio + ratio >= pressures && pressures + ratio >= temperatures * ratio, "%u pressures and %u temperatures", pressures, temperatures);
+
+    // A part slower than the datasheet delivers fewer samples per burst, the task keeps up with it.
+    p_models->barometer.m_time_scale = HOST_SLOW_DPS3XX_TIME_SCALE;
+    failures = run_fetch("slow dps3xx", &boot, &(p_models->barometer), samples, &period_ms, &transactions, &uneven, &age_ms);
+    HOST_CHECK(failures == 0, "%u failed samples", failures);
+    HOST_CHECK(fabs(period_ms - nominal_ms * HOST_SLOW_DPS3XX_TIME_SCALE) < tolerance_ms * HOST_SLOW_DPS3XX_TIME_SCALE, "sample period %.1f ms", period_ms);
+    p_models->barometer.m_time_scale = 1.0;
+
+    // A task held up past the FIFO loses the results it can't hold, and carries on.
+    uint32_t overflows = boot.p_barometer->m_overflows;
+    // Held up for as many pressure periods as the FIFO has entries, it fills with the temperatures in between.
+    vTaskDelay(pdMS_TO_TICKS(boot.p_barometer->GetSamplePeriodMs() * DPS3XX_FIFO_ENTRIES));
+    failures = run_fetch("held up task", &boot, &(p_models->barometer), samples, &period_ms, &transactions, &uneven, &age_ms);
+    HOST_CHECK(failures == 0, "%u failed samples", failures);
+    HOST_CHECK(boot.p_barometer->m_overflows == overflows + 1 && p_models->barometer.m_fifo_lost > 0, "%u overflows, %u results lost", boot.p_barometer->m_overflows - overflows, p_models->barometer.m_fifo_lost);
+
+    // Every fault fails its burst, fetch_data gives up at the first error.
+    const I2cDevice_t *p_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_BAROMETER]);
+    HostI2cBus *p_bus = HostI2cBus::GetBus(p_device->port);
+    HostI2cFault_t fault = {.nack_probability = HOST_NACK_PROBABILITY, .timeout_probability = HOST_TIMEOUT_PROBABILITY};
+    p_bus->SetFault(p_device->addr, &fault);
+    failures = run_fetch("random faults", &boot, &(p_models->barometer), HOST_FAULT_SAMPLES, &period_ms, &transactions, &uneven, &age_ms);
+    HostI2cStats_t stats;
+    p_bus->GetStats(p_device->addr, &stats);
+    HOST_CHECK(failures > 0 && failures == stats.nacks + stats.timeouts, "%u failed samples, %u nacks, %u timeouts", failures, stats.nacks, stats.timeouts);
+    p_bus->ClearFaults();
+
+    // The rates of the ground mode and back, the coefficients scaled again for each oversampling.
+    float ground_pressure, ground_temperature, flight_pressure, flight_temperature;
+    boot.p_barometer->m_coefs = s_mode_coefs;
+    run_mode("ground mode", &boot, &(p_models->barometer), DPS3XX_MODE_LOW_POWER, samples, &ground_pressure, &ground_temperature);
+    run_mode("flight mode", &boot, &(p_models->barometer), DPS3XX_MODE_HIGH_RESOLUTION, samples, &flight_pressure, &flight_temperature);
+    printf("    %.2f Pa and %.3f degrees in the ground mode, %.2f Pa and %.3f degrees in the flight mode\n", ground_pressure, ground_temperature, flight_pressure, flight_temperature);
+    HOST_CHECK(fabsf(ground_pressure - flight_pressure) < HOST_MODE_PRESSURE_TOLERANCE, "%.2f Pa in the ground mode, %.2f Pa in the flight mode", ground_pressure, flight_pressure);
+    HOST_CHECK(fabsf(ground_temperature - flight_temperature) < HOST_MODE_TEMPERATURE_TOLERANCE, "%.3f degrees in the ground mode, %.3f in the flight mode", ground_temperature, flight_temperature);
+
+    shutdown(&boot, p_models);
+}
+
+/* RTC, touch and PMU read through their drivers. */
+static void check_models() {
+    static const HostBootScenario_t scenario = {.name = "every device", .index = I2C_DEVICE_INDEX_MAX};
+    HostBoot_t boot;
+    HostModels_t *p_models;
+
+    (void)run_boot(&scenario, &boot, &p_models);
+    if (boot.p_rtc == NULL || boot.p_touch == NULL || boot.p_pmu == NULL) {
+        HOST_CHECK(false, "rtc, touch or pmu missing");
+        shutdown(&boot, p_models);
+        return;
+    }
+
+    struct tm tm_time;
+    p_models->rtc.SetTime(HOST_RTC_START_TIME);
+    // The delay ends on a tick, one more keeps the whole run whatever the time of the boot.
+    vTaskDelay(pdMS_TO_TICKS(HOST_RTC_RUN_MS) + 1);
+    HOST_CHECK(boot.p_rtc->get_time(&tm_time) == ESP_OK, "rtc read failed");
+    HOST_CHECK(timegm(&tm_time) == HOST_RTC_START_TIME + HOST_RTC_RUN_MS / 1000, "rtc time %lld", (long long)timegm(&tm_time));
+    time_t set_time = HOST_RTC_START_TIME + 86400 * 365;
+    gmtime_r(&set_time, &tm_time);
+    HOST_CHECK(boot.p_rtc->set_time(&tm_time) == ESP_OK && p_models->rtc.GetTime() == set_time, "rtc set to %lld", (long long)p_models->rtc.GetTime());
+
+    // A tap on the left button, sent when it is released.
+    QueueHandle_t queue = xQueueCreate(BLUETHROAT_MSG_QUEUE_LENGTH, sizeof(BluethroatMsg_t));
+    uint8_t touch_data[FT6X36U_TOUCH_DATA_LENGTH];
+    BluethroatMsg_t message;
+    boot.p_touch->SetMessageQueue(queue);
+    p_models->touch.Touch((BUTTON_LEFT_BORDER_LEFT + BUTTON_LEFT_BORDER_RIGHT) / 2, (BUTTON_BORDER_TOP + BUTTON_BORDER_BOTTOM) / 2);
+    (void)boot.p_touch->read_buffer(FT6X36U_REG_ADDR_TD_STATUS, touch_data, sizeof(touch_data));
+    p_models->touch.Release();
+    (void)boot.p_touch->read_buffer(FT6X36U_REG_ADDR_TD_STATUS, touch_data, sizeof(touch_data));
+    HOST_CHECK(xQueueReceive(queue, &message, 0) == pdTRUE && message.type == BLUETHROAT_MSG_TYPE_BUTTON_DATA && message.button_data.index == BUTTON_INDEX_LEFT && message.button_data.act == BUTTON_ACT_PRESSED, "no left button press");
+    boot.p_touch->SetMessageQueue(NULL);
+    vQueueDelete(queue);
+
+    Axp192PmuStatus_t pmu_status;
+    p_models->pmu.SetBattery(HOST_BATTERY_MV, 0, false);
+    HOST_CHECK(boot.p_pmu->fetch_data((uint8_t *)&pmu_status, sizeof(pmu_status)) == ESP_OK, "pmu read failed");
+    uint32_t voltage = (((uint32_t)pmu_status.battery_voltage[0] << 4) | (pmu_status.battery_voltage[1] & 0x0f)) * 11 / 10;
+    HOST_CHECK(voltage + 2 >= HOST_BATTERY_MV && voltage <= HOST_BATTERY_MV, "battery %u mV", voltage);
+
+    printf("models: rtc, touch and pmu read back through their drivers\n");
+    shutdown(&boot, p_models);
+}
+
+/*
+    The BMI270 is left out of the boot, it is brought up on its own against its model. Frames pushed before the
+    config file upload are refused, the ones pushed after it are fetched as they were pushed, and a model which never
+    reports the initialization done fails init_device.
+*/
+static void check_imu() {
+    static const HostBootScenario_t scenario = {.name = "every device", .index = I2C_DEVICE_INDEX_MAX};
+    const I2cDevice_t *p_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_BMI270_ACCELEROMETER]);
+    HostBoot_t boot;
+    HostModels_t *p_models;
+
+    (void)run_boot(&scenario, &boot, &p_models);
+    I2cMaster *p_master = boot.p_masters[p_device->port];
+
+    Bmi270FifoFrame_t frames[HOST_IMU_FRAMES];
+    for (int i = 0; i < HOST_IMU_FRAMES; i++) {
+        frames[i] = {.gyr_x = (int16_t)i, .gyr_y = 0, .gyr_z = 0, .acc_x = 0, .acc_y = 0, .acc_z = (int16_t)BMI270_ACC_LSB_PER_G};
+    }
+    p_models->imu.PushFrames((const uint8_t *)frames, sizeof(frames));
+    HOST_CHECK(p_models->imu.m_refused_bytes == sizeof(frames), "%u bytes of frames taken before the config file upload", (uint32_t)sizeof(frames) - p_models->imu.m_refused_bytes);
+
+    HostStep_t step;
+    step_begin(&step, "bmi270 imu");
+    Bmi270Imu *p_imu = new Bmi270Imu();
+    esp_err_t result = p_imu->Init(p_master, p_device->addr, p_device->int_pins);
+    step_end(&step, result == ESP_OK);
+    HOST_CHECK(result == ESP_OK && p_models->imu.IsInitialized(), "imu not initialized by its config file");
+
+    uint8_t raw_data[MAX_RAW_DATA_BUFFER_LENGTH];
+    const Bmi270FifoBurst_t *p_burst = (const Bmi270FifoBurst_t *)raw_data;
+    p_models->imu.PushFrames((const uint8_t *)frames, sizeof(frames));
+    HOST_CHECK(p_imu->fetch_data(raw_data, sizeof(raw_data)) == ESP_OK && p_burst->frames == HOST_IMU_FRAMES && memcmp(p_burst->frame, frames, sizeof(frames)) == 0,
+        "%u frames fetched after the initialization, %d pushed", p_burst->frames, HOST_IMU_FRAMES);
+
+    // The reset of a new init_device clears the initialization, the model refuses the next one.
+    p_models->imu.SetInitFailure(true);
+    HOST_CHECK(p_imu->Init(p_master, p_device->addr, p_device->int_pins) != ESP_OK, "imu initialized by a failed initialization");
+    p_models->imu.PushFrames((const uint8_t *)frames, sizeof(frames));
+    HOST_CHECK(p_imu->fetch_data(raw_data, sizeof(raw_data)) == ESP_OK && p_burst->frames == 0, "%u frames fetched after a failed initialization", p_burst->frames);
+
+    printf("imu: %d frames fetched after the config file upload, none before it or after a failed initialization\n", HOST_IMU_FRAMES);
+    shutdown(&boot, p_models);
+}
+
+/*
+    Both DPS3xx tasks on the same air, a pressure ramp from the start. The tasks go on to the end of the run, the models
+    stay on the bus.
+*/
+static void check_pair(uint32_t samples) {
+    static const HostBootScenario_t scenario = {.name = "every device, calibrated", .index = I2C_DEVICE_INDEX_MAX, .p_coefs = &s_mode_coefs};
+    HostBoot_t boot;
+    HostModels_t *p_models;
+
+    // The coefficients of a real part read at reset, both started by Init() in the order of app_main.
+    (void)run_boot(&scenario, &boot, &p_models);
+    if (boot.p_barometer == NULL || boot.p_anemometer == NULL || boot.p_barometer->m_p_sync == NULL) {
+        HOST_CHECK(false, "barometer, anemometer or sync missing");
+        return;
+    }
+    Dps3xxBarometer *p_barometer = boot.p_barometer;
+    Dps3xxAnemometer *p_anemometer = boot.p_anemometer;
+    int64_t period_us = p_barometer->GetSamplePeriodUs();
+    int64_t skew_us = (p_models->anemometer.m_background_start_us - p_models->barometer.m_background_start_us) % period_us;
+    if (skew_us > period_us / 2) {
+        skew_us -= period_us;
+    }
+
+    // The pressure rises by the slope, about c10 per scaled raw pressure.
+    float scale_factor = (float)p_barometer->m_pressure_cfg.scale_factor;
+    int32_t raw_pressure = (int32_t)lround(HOST_MODE_SCALED_PRESSURE * scale_factor);
+    int32_t raw_temperature = (int32_t)lround(HOST_MODE_SCALED_TEMPERATURE * (float)p_barometer->m_temperature_cfg.scale_factor);
+    double raw_slope = HOST_PAIR_PRESSURE_SLOPE / s_mode_coefs.c10 * scale_factor;
+    int64_t now_us = HostClockNowUs();
+    p_models->barometer.SetSample(raw_pressure, raw_temperature);
+    p_models->anemometer.SetSample(raw_pressure, raw_temperature);
+    p_models->barometer.SetPressureSlope(raw_slope, now_us);
+    p_models->anemometer.SetPressureSlope(raw_slope, now_us);
+
+    QueueHandle_t queue = xQueueCreate(BLUETHROAT_MSG_QUEUE_LENGTH, sizeof(BluethroatMsg_t));
+    p_barometer->Start(&(g_TaskParam[TASK_INDEX_DPS3XX_BAROMETER]), queue);
+    p_anemometer->Start(&(g_TaskParam[TASK_INDEX_DPS3XX_ANEMOMETER]), queue);
+
+    BluethroatMsg_t message;
+    uint32_t static_samples = 0;
+    uint32_t total_samples = 0;
+    uint32_t unpaired = 0;
+    double max_error = 0.0;
+    while (total_samples < HOST_PAIR_WARMUP_SAMPLES + samples) {
+        if (xQueueReceive(queue, &message, pdMS_TO_TICKS(1000)) != pdTRUE) {
+            HOST_CHECK(false, "no DPS3xx sample within 1 s");
+            return;
+        }
+        if (message.type == BLUETHROAT_MSG_TYPE_BAROMETER_DATA) {
+            static_samples++;
+        } else if (message.type == BLUETHROAT_MSG_TYPE_ANEMOMETER_DATA) {
+            total_samples++;
+            if (total_samples == HOST_PAIR_WARMUP_SAMPLES) {
+                unpaired = p_anemometer->m_unpaired;
+            } else if (total_samples > HOST_PAIR_WARMUP_SAMPLES) {
+                double error = fabs((double)message.anemometer_data.total_pressure - message.anemometer_data.static_pressure);
+                max_error = (error > max_error) ? error : max_error;
+            }
+        }
+    }
+    unpaired = p_anemometer->m_unpaired - unpaired;
+
+    printf("pair: %u static and %u total pressures, anemometer started %lld us off the phase of the barometer, %u bursts read without it\n",
+        static_samples, total_samples, (long long)skew_us, p_anemometer->m_unsynced_bursts);
+    printf("    %u total pressures unpaired, differential pressure at most %.3f Pa on a ramp of %.2f Pa per period\n",
+        unpaired, max_error, HOST_PAIR_PRESSURE_SLOPE * period_us / 1000000.0);
+    HOST_CHECK(skew_us > -HOST_PAIR_MAX_START_SKEW_US && skew_us < HOST_PAIR_MAX_START_SKEW_US, "anemometer started %lld us off the phase of the barometer", (long long)skew_us);
+    HOST_CHECK(unpaired == 0, "%u total pressures unpaired", unpaired);
+    HOST_CHECK(p_anemometer->m_unsynced_bursts == 0, "%u bursts read without the barometer", p_anemometer->m_unsynced_bursts);
+    HOST_CHECK(max_error < HOST_PAIR_PRESSURE_TOLERANCE, "differential pressure %.3f Pa on the same air", max_error);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t samples = HOST_DEFAULT_SAMPLES;
+    int option;
+
+    esp_log_level_set("*", ESP_LOG_NONE);
+    while ((option = getopt(argc, argv, "n:o:v")) != -1) {
+        switch (option) {
+        case 'n': samples = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'o': s_overhead_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'v': esp_log_level_set("*", ESP_LOG_DEBUG); break;
+        default:
+            fprintf(stderr, "Usage: %s [-n samples] [-o overhead us] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (samples == 0) {
+        samples = HOST_DEFAULT_SAMPLES;
+    }
+
+    // Before the first driver, the boot runs on the virtual clock.
+    HostClockSetMode(HOST_CLOCK_VIRTUAL);
+
+    check_boot();
+    check_fetch(samples);
+    check_models();
+    check_imu();
+    check_pair(samples);
+
+    printf("%u failed checks\n", s_failures);
+    return (s_failures == 0) ? 0 : 1;
+}
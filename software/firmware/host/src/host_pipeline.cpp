@@ -0,0 +1,596 @@
+/*
+    Host pipeline: raw DPS3xx register bytes -> Dps3xxBarometer::process_data -> BluethroatMsgProc::process_message ->
+    BluethraotVario -> SoundSetVerticalSpeed -> Ns4168Sound::play_sound -> I2S samples.
+    NMEA sentences and an AXP192 battery status are fed through NeoM9nGnss::process_gnss_sentence and
+    Axp192Pmu::process_data once per second of flight time. When the script has an IMU, BMI270 FIFO frames are generated
+    at the output data rate and fed in bursts of a BMI270 task interval through Bmi270Imu::process_data. When it has an
+    anemometer, the total pressure frames follow each barometer frame, with the same stamp, through
+    Dps3xxAnemometer::process_data. With a static port instead, the frames of the second static pressure follow each
+    barometer frame the same way.
+
+    The flight comes from the flight generator (host_flight_generator.h), a script or the default profile: level, climb
+    at +2 m/s, sink at -3 m/s. Sensor samples are stamped with the nominal DPS3xx single shot period and handed to the
+    host rig as raw frames, the rig generates the audio stream until it catches up with the sample time, so the tone
+    schedule matches the one on the device while the whole run takes only as long as the computation itself.
+    The vario is scored against the true vertical speed of the generator, its error and its lag are printed. With the
+    total energy compensation of an anemometer, it is scored against the true vertical speed of the energy. With a
+    polar, the netto vario is scored against the true vertical speed of the air mass, the firmware is given the polar of
+    the script. With a wind, the wind the firmware fits to the GNSS ground velocity of the circles is scored against
+    the wind of the script on every GNSS fix from the first fit on. In a thermal, the core the thermal assistant locates
+    is scored against the true core, relative to the glider, on every GNSS fix it is located on. The airtime and the
+    distance of the flight detector are scored against the time and the ground track flown off the ground segments.
+    The short and the long climb averages are scored, on every report once the long window is full, against the mean
+    true vertical speed over their windows. With a static port, the samples averaged from both ports and the failure
+    of a stuck barometer are counted. The barometric altitude is scored against the true altitude, from its error at the
+    first scored sample on, for the drift the temperature compensation leaves. With a waypoint, the firmware is given it
+    and the MacCready setting of the script, and on every GNSS fix in flight, from the first wind fit on when there is a
+    wind, the arrival altitude of the final glide is scored against the one of the best airspeed found by a search of
+    the polar of the script, with the true wind, density and distance, and the required glide against the true one.
+
+    Usage: bluethroat_host_pipeline [-n samples] [-s flight.txt] [-o audio.raw] [-r frames.btr] [-t trace.txt] [-g truth.csv] [-e max rms error] [-x score=limit]... [-v] [-c]
+        -n  number of barometer samples of the default profile, 3000 by default
+        -s  fly a flight script instead of the default profile
+        -o  write the raw I2S stream (signed 8-bit, 4 bytes per sample) to a file
+        -r  record the generated frames with the firmware frame recorder, for bluethroat_host_replay
+        -t  write the output trace of the rig, one line per barometer sample
+        -g  write the ground truth next to the vario, one line per barometer sample, the true total energy vertical
+            speed last
+        -e  exit with 1 when the rms error of the vario, at its lag, is above this many m/s
+        -x  exit with 1 when a score is above its limit, may be repeated, every score is printed either way:
+            netto           rms error of the netto vario, at its lag, m/s, or no polar
+            wind            rms error of the wind vector, m/s, or no wind was fitted
+            core            rms distance of the thermal core to the true one, m, or no core was located
+            airtime         error of the airtime of the flight detector, s, or not one takeoff and one landing
+            distance        error of the distance of the flight detector, percent
+            average         rms error of the climb averages, m/s, or none was reported
+            static_port     samples a stuck barometer takes to be found failed, or the second static port was never
+                            averaged in
+            altitude_drift  rms drift of the barometric altitude, m
+            arrival         rms error of the arrival altitude of the final glide, m, or it was never scored
+        -v  verbose firmware log
+        -c  check the vario and the speaker state at the end of each glide, exit with 1 on mismatch
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <esp_log.h>
+
+#include "bluethroat_global.h"
+#include "bluethroat_vario.h"
+#include "host_firmware_stubs.h"
+#include "host_flight_generator.h"
+#include "host_rig.h"
+
+#define HOST_DEFAULT_SAMPLES            (3000)
+#define HOST_DEFAULT_VOLUME             (50)
+#define HOST_CLIMB_RATE_MPS             (2.0)
+#define HOST_SINK_RATE_MPS              (-3.0)
+#define HOST_CHECK_TOLERANCE_MPS        (0.5)
+#define HOST_SCORE_SETTLE_S             (5.0)
+#define HOST_SCORE_MAX_LAG_S            (5.0)
+#define HOST_BATTERY_FULL_MV            (4150)
+#define HOST_BATTERY_DRAIN_MV_PER_HOUR  (300)
+#define HOST_GAS_CONSTANT               (287.05)
+#define HOST_CELSIUS_TO_KELVIN          (273.15)
+#define HOST_SEA_LEVEL_DENSITY          (1.225)
+#define HOST_GLIDE_MAX_IAS_MPS          (40.0)
+#define HOST_GLIDE_SEARCH_STEP_MPS      (0.01)
+
+/* Scores of a flight checked against the limits of -x, a score without a limit is only printed */
+typedef enum {
+    HOST_SCORE_NETTO = 0,
+    HOST_SCORE_WIND,
+    HOST_SCORE_CORE,
+    HOST_SCORE_AIRTIME,
+    HOST_SCORE_DISTANCE,
+    HOST_SCORE_AVERAGE,
+    HOST_SCORE_STATIC_PORT,
+    HOST_SCORE_ALTITUDE_DRIFT,
+    HOST_SCORE_ARRIVAL,
+    HOST_SCORE_MAX,
+} HostScoreIndex_t;
+
+static const char *s_score_names[HOST_SCORE_MAX] = {"netto", "wind", "core", "airtime", "distance", "average", "static_port", "altitude_drift", "arrival"};
+
+/* "score=limit" of -x, the limit has to be above 0. */
+static bool parse_score_limit(const char *p_arg, double *p_limits) {
+    const char *p_value = strchr(p_arg, '=');
+    if (p_value == NULL) {
+        return false;
+    }
+    for (int i = 0; i < HOST_SCORE_MAX; i++) {
+        if (strlen(s_score_names[i]) == (size_t)(p_value - p_arg) && strncmp(p_arg, s_score_names[i], p_value - p_arg) == 0) {
+            p_limits[i] = strtod(p_value + 1, NULL);
+            return p_limits[i] > 0;
+        }
+    }
+    return false;
+}
+
+/* Battery status registers of a discharging battery, voltage in 1.1mV steps as 8 high bits and 4 low bits. */
+static void encode_pmu_status(uint32_t timestamp, Axp192PmuStatus_t *p_status) {
+    uint32_t voltage = HOST_BATTERY_FULL_MV - (uint32_t)((uint64_t)timestamp * HOST_BATTERY_DRAIN_MV_PER_HOUR / 3600000);
+    uint32_t raw_voltage = voltage * 10 / 11;
+
+    memset(p_status, 0, sizeof(Axp192PmuStatus_t));
+    p_status->charging_status.has_battery = 1;
+    p_status->battery_voltage[0] = (uint8_t)(raw_voltage >> 4);
+    p_status->battery_voltage[1] = (uint8_t)(raw_voltage & 0x0f);
+}
+
+static SoundState_t sound_state(const Ns4168Sound *p_sound, int32_t vertical_speed_in_multiple) {
+    if (vertical_speed_in_multiple >= p_sound->m_speed_lift_latch_in_multiple) {
+        return SOUND_SPEED_LIFT;
+    } else if (vertical_speed_in_multiple <= p_sound->m_speed_sink_latch_in_multiple) {
+        return SOUND_SPEED_SINK;
+    } else {
+        return SOUND_IDLE;
+    }
+}
+
+static bool check_segment(uint32_t segment, const Ns4168Sound *p_sound, double expected) {
+    SoundState_t state = sound_state(p_sound, p_sound->m_vertical_speed_in_multiple);
+    SoundState_t expected_state = sound_state(p_sound, (int32_t)(expected * VERTICAL_SPEED_MULTIPLE));
+    bool passed = fabs(g_HostGuiState.vertical_speed - expected) <= HOST_CHECK_TOLERANCE_MPS && state == expected_state;
+    printf("check glide %-3u vario %+7.3f m/s (expected %+5.2f), sound state %d (expected %d): %s\n", segment, g_HostGuiState.vertical_speed, expected, state, expected_state, passed ? "pass" : "FAIL");
+    return passed;
+}
+
+/*
+    Error of the arrival altitude and relative error of the required glide of the firmware, against the ones of the true
+    state and the barometric altitude, the error of the altimeter is scored apart. The best airspeed of the truth is searched for over the polar of the script, the one of the least sink plus
+    MacCready setting over the ground speed toward the waypoint, the crosswind taken out of it.
+*/
+static void score_final_glide(const HostFlightGenerator *p_generator, double margin_m, double *p_arrival_error_m, double *p_required_glide_error) {
+    const HostFlightState_t *p_state = &(p_generator->m_state);
+    double east_m, north_m, wind_east_mps, wind_north_mps;
+    p_generator->GetWaypoint(&east_m, &north_m);
+    p_generator->GetWind(&wind_east_mps, &wind_north_mps);
+    double distance_m = sqrt(east_m * east_m + north_m * north_m);
+    double course_rad = atan2(east_m, north_m);
+    double tailwind_mps = wind_east_mps * sin(course_rad) + wind_north_mps * cos(course_rad);
+    double crosswind_mps = wind_east_mps * cos(course_rad) - wind_north_mps * sin(course_rad);
+    double density = p_state->pressure_pa / (HOST_GAS_CONSTANT * (p_state->temperature_c + HOST_CELSIUS_TO_KELVIN));
+    double density_ratio = sqrt(density / HOST_SEA_LEVEL_DENSITY);
+    double height_m = GetBarometricAltitude() - p_generator->m_config.waypoint_altitude_m - margin_m;
+
+    double best_cost = INFINITY;
+    double arrival_m = -INFINITY;
+    for (double ias_mps = p_generator->m_polar.GetMinSinkSpeed(); ias_mps <= HOST_GLIDE_MAX_IAS_MPS; ias_mps += HOST_GLIDE_SEARCH_STEP_MPS) {
+        double tas_mps = ias_mps / density_ratio;
+        double sink_mps = p_generator->m_polar.GetSink((float)ias_mps) / density_ratio;
+        double ground_speed_mps = tailwind_mps + sqrt(fmax(tas_mps * tas_mps - crosswind_mps * crosswind_mps, 0.0));
+        if (ground_speed_mps > 0 && (sink_mps + p_generator->m_config.maccready_mps) / ground_speed_mps < best_cost) {
+            best_cost = (sink_mps + p_generator->m_config.maccready_mps) / ground_speed_mps;
+            arrival_m = height_m - distance_m * sink_mps / ground_speed_mps;
+        }
+    }
+
+    double required_glide = (height_m > 0 && distance_m < height_m * GLIDE_COMPUTER_MAX_GLIDE) ? distance_m / height_m : GLIDE_COMPUTER_MAX_GLIDE;
+    *p_arrival_error_m = g_HostGuiState.arrival_altitude - arrival_m;
+    *p_required_glide_error = (g_HostGuiState.required_glide - required_glide) / required_glide;
+}
+
+/* Level, climb and sink, a third of the samples each. */
+static void add_default_profile(HostFlightGenerator *p_generator, uint32_t samples, double period_s) {
+    double phase_s = (samples / 3) * period_s;
+    HostFlightSegment_t level = {.type = HOST_SEGMENT_GLIDE, .duration_s = phase_s, .lift_mps = 0.0};
+    HostFlightSegment_t climb = {.type = HOST_SEGMENT_GLIDE, .duration_s = phase_s, .lift_mps = HOST_CLIMB_RATE_MPS};
+    HostFlightSegment_t sink = {.type = HOST_SEGMENT_GLIDE, .duration_s = phase_s, .lift_mps = HOST_SINK_RATE_MPS};
+    p_generator->AddSegment(&level);
+    p_generator->AddSegment(&climb);
+    p_generator->AddSegment(&sink);
+}
+
+/*
+    Hand a frame to the rig, and to the recorder when recording. The pipeline produces frames much faster than a sensor,
+    when both recorder buffers are waiting for the file it waits for them instead of dropping the frame.
+*/
+static esp_err_t feed_frame(HostRig *p_rig, FrameType_t type, uint8_t source, uint32_t timestamp, const void *p_data, uint8_t size) {
+    FrameHeader_t header = {.type = (uint8_t)type, .source = source, .size = size, .timestamp = timestamp};
+
+    if (g_pFrameRecorder != NULL && g_pFrameRecorder->Record(type, source, timestamp, p_data, size) == ESP_ERR_NO_MEM && !g_pFrameRecorder->m_file_full) {
+        g_pFrameRecorder->Flush();
+        g_pFrameRecorder->Record(type, source, timestamp, p_data, size);
+    }
+
+    return p_rig->ProcessFrame(&header, (const uint8_t *)p_data);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t samples = HOST_DEFAULT_SAMPLES;
+    const char *script_file_name = NULL;
+    const char *audio_file_name = NULL;
+    const char *recording_file_name = NULL;
+    const char *trace_file_name = NULL;
+    const char *truth_file_name = NULL;
+    double max_rms_error_mps = 0;
+    double limits[HOST_SCORE_MAX] = {0};
+    bool check = false;
+    int option;
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    while ((option = getopt(argc, argv, "n:s:o:r:t:g:e:x:vc")) != -1) {
+        switch (option) {
+        case 'n': samples = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 's': script_file_name = optarg; break;
+        case 'o': audio_file_name = optarg; break;
+        case 'r': recording_file_name = optarg; break;
+        case 't': trace_file_name = optarg; break;
+        case 'g': truth_file_name = optarg; break;
+        case 'e': max_rms_error_mps = strtod(optarg, NULL); break;
+        case 'x':
+            if (!parse_score_limit(optarg, limits)) {
+                fprintf(stderr, "Invalid score limit %s.\n", optarg);
+                return 2;
+            }
+            break;
+        case 'v': esp_log_level_set("*", ESP_LOG_DEBUG); break;
+        case 'c': check = true; break;
+        default:
+            fprintf(stderr, "Usage: %s [-n samples] [-s flight.txt] [-o audio.raw] [-r frames.btr] [-t trace.txt] [-g truth.csv] [-e max rms error] [-x score=limit]... [-v] [-c]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // The recorder is started first, as on the device, so it catches the calibration read when the barometer resets.
+    FrameRecorder *p_recorder = NULL;
+    if (recording_file_name != NULL) {
+        p_recorder = new FrameRecorder(recording_file_name, CONFIG_FRAME_RECORDER_BUFFER_SIZE, CONFIG_FRAME_RECORDER_MAX_FILE_SIZE);
+        if (p_recorder->Init() != ESP_OK) {
+            fprintf(stderr, "Failed to create recording %s.\n", recording_file_name);
+            return 1;
+        }
+        p_recorder->Start(&(g_TaskParam[TASK_INDEX_FRAME_RECORDER]), NULL);
+    }
+
+    HostRig rig;
+    if (rig.Init(HOST_DEFAULT_VOLUME) != ESP_OK) {
+        return 1;
+    }
+
+    FILE *p_trace_file = NULL;
+    if (trace_file_name != NULL) {
+        if ((p_trace_file = fopen(trace_file_name, "w")) == NULL) {
+            fprintf(stderr, "Failed to open %s.\n", trace_file_name);
+            return 1;
+        }
+        rig.SetTrace(p_trace_file, NULL);
+    }
+
+    FILE *p_truth_file = NULL;
+    if (truth_file_name != NULL) {
+        if ((p_truth_file = fopen(truth_file_name, "w")) == NULL) {
+            fprintf(stderr, "Failed to open %s.\n", truth_file_name);
+            return 1;
+        }
+        fprintf(p_truth_file, "time_ms,segment,altitude_m,vertical_speed_mps,pressure_pa,sensor_pressure_pa,temperature_c,vario_mps,total_energy_speed_mps,air_mass_speed_mps,netto_mps\n");
+    }
+
+    FILE *p_audio_file = NULL;
+    if (audio_file_name != NULL) {
+        if ((p_audio_file = fopen(audio_file_name, "wb")) == NULL) {
+            fprintf(stderr, "Failed to open %s.\n", audio_file_name);
+            return 1;
+        }
+        rig.m_p_sink->Capture(p_audio_file);
+    }
+
+    HostFlightGenerator generator;
+    if (script_file_name != NULL && generator.LoadScript(script_file_name) != ESP_OK) {
+        return 1;
+    }
+
+    const I2cDevice_t *p_barometer_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_BAROMETER]);
+    uint8_t coefs[sizeof(Dps3xxCoefRegs_t)];
+    generator.EncodeCoefs(coefs, sizeof(coefs));
+    FrameHeader_t coef_header = {.type = FRAME_TYPE_DPS3XX_COEF, .source = (uint8_t)p_barometer_device->addr, .size = sizeof(coefs), .timestamp = 0};
+    if (rig.ProcessFrame(&coef_header, coefs) != ESP_OK) {
+        fprintf(stderr, "Failed to initialize DPS3xx on host bus.\n");
+        return 1;
+    }
+
+    // The anemometer is calibrated after the barometer, whose deep filter gives it the static pressure.
+    const I2cDevice_t *p_anemometer_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_ANEMOMETER]);
+    bool second_dps3xx = generator.m_config.anemometer_enabled || generator.m_config.static_port_enabled;
+    rig.SetSecondStatic(generator.m_config.static_port_enabled);
+    if (second_dps3xx) {
+        coef_header.source = (uint8_t)p_anemometer_device->addr;
+        if (rig.ProcessFrame(&coef_header, coefs) != ESP_OK) {
+            fprintf(stderr, "Failed to initialize DPS3xx anemometer on host bus.\n");
+            return 1;
+        }
+    }
+    bool total_energy = generator.m_config.anemometer_enabled && g_pBluethraotVario->GetTotalEnergy();
+
+    if (generator.m_config.polar_enabled) {
+        int32_t speeds_kmh[GLIDER_POLAR_POINTS], sinks_cms[GLIDER_POLAR_POINTS];
+        for (int i = 0; i < GLIDER_POLAR_POINTS; i++) {
+            speeds_kmh[i] = (int32_t)lround(generator.m_config.polar_speeds_kmh[i]);
+            sinks_cms[i] = (int32_t)lround(generator.m_config.polar_sinks_mps[i] * 100.0);
+        }
+        if (g_pBluethraotVario->SetPolar(speeds_kmh, sinks_cms) != ESP_OK) {
+            fprintf(stderr, "Failed to set the polar of the script.\n");
+            return 1;
+        }
+    }
+
+    GlideComputer *p_glide = &(rig.m_p_msg_proc->m_glide_computer);
+    if (generator.m_config.waypoint_enabled) {
+        p_glide->SetWaypoint((int32_t)lround(generator.m_config.waypoint_latitude_deg * 1000000.0), (int32_t)lround(generator.m_config.waypoint_longitude_deg * 1000000.0), (float)generator.m_config.waypoint_altitude_m);
+    }
+    p_glide->SetMacCready((float)generator.m_config.maccready_mps);
+
+    uint32_t period_ms = rig.m_p_barometer->GetSamplePeriodMs();
+    double period_s = period_ms / 1000.0;
+    if (script_file_name == NULL) {
+        add_default_profile(&generator, samples, period_s);
+        generator.Reset();
+    }
+
+    const I2cDevice_t *p_imu_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_BMI270_ACCELEROMETER]);
+    uint32_t imu_frame_ms = 1000 / BMI270_OUTPUT_DATA_RATE_HZ;
+    uint32_t imu_burst_ms = pdTICKS_TO_MS(g_TaskParam[TASK_INDEX_BMI270_IMU].task_interval);
+    uint32_t next_imu_ms = imu_frame_ms;
+    Bmi270FifoFrame_t imu_frames[BMI270_FIFO_BURST_FRAMES];
+    uint32_t imu_frame_count = 0;
+
+    bool passed = true;
+    bool more;
+    uint32_t sample = 0;
+    uint32_t next_gnss_ms = 0;
+    uint8_t raw_data[sizeof(Dps3xxData_t)];
+    std::vector<double> true_vertical_speeds;
+    std::vector<double> vario_vertical_speeds;
+    std::vector<double> true_air_mass_speeds;
+    std::vector<double> netto_vertical_speeds;
+    double wind_east_mps, wind_north_mps;
+    generator.GetWind(&wind_east_mps, &wind_north_mps);
+    uint32_t wind_fixes = 0;
+    double wind_square_error = 0;
+    uint32_t core_fixes = 0;
+    double core_square_error = 0;
+    FlightState_t flight_state = FLIGHT_STATE_GROUND;
+    uint32_t takeoffs = 0;
+    uint32_t landings = 0;
+    double true_airtime_s = 0;
+    double true_distance_m = 0;
+    // Sums of the true vertical speed of the samples before each one, the mean of a window is a difference of two.
+    std::vector<double> true_climb_sums(1, 0.0);
+    uint32_t short_window_samples = (uint32_t)lround(CONFIG_VARIO_AVERAGE_SHORT_WINDOW * 1000.0 / period_ms);
+    uint32_t long_window_samples = (uint32_t)lround(CONFIG_VARIO_AVERAGE_LONG_WINDOW * 1000.0 / period_ms);
+    uint32_t climb_count = g_HostGuiState.climb_count;
+    uint32_t average_reports = 0;
+    double average_square_error = 0;
+    bool has_altitude_error = false;
+    double start_altitude_error_m = 0;
+    double altitude_drift_m = 0;
+    double altitude_square_drift = 0;
+    uint32_t altitude_samples = 0;
+    uint32_t glide_fixes = 0;
+    double arrival_square_error = 0;
+    double required_glide_square_error = 0;
+
+    do {
+        uint32_t sample_ms = sample * period_ms;
+        uint32_t segment = generator.m_state.segment;
+        generator.EncodeDps3xx(raw_data, sizeof(raw_data));
+        feed_frame(&rig, FRAME_TYPE_DPS3XX_DATA, (uint8_t)p_barometer_device->addr, sample_ms, raw_data, sizeof(raw_data));
+        if (second_dps3xx) {
+            if (generator.m_config.static_port_enabled) {
+                generator.EncodeDps3xxStatic(raw_data, sizeof(raw_data));
+            } else {
+                generator.EncodeDps3xxTotal(raw_data, sizeof(raw_data));
+            }
+            feed_frame(&rig, FRAME_TYPE_DPS3XX_DATA, (uint8_t)p_anemometer_device->addr, sample_ms, raw_data, sizeof(raw_data));
+        }
+
+        if (sample_ms >= next_gnss_ms) {
+            char sentence[HOST_FLIGHT_NMEA_MAX_SIZE];
+            generator.EncodeGga(sentence, sizeof(sentence));
+            feed_frame(&rig, FRAME_TYPE_NMEA_SENTENCE, GNSS_UART_PORT, sample_ms, sentence, (uint8_t)strlen(sentence));
+            generator.EncodeRmc(sentence, sizeof(sentence));
+            feed_frame(&rig, FRAME_TYPE_NMEA_SENTENCE, GNSS_UART_PORT, sample_ms, sentence, (uint8_t)strlen(sentence));
+            generator.EncodeVtg(sentence, sizeof(sentence));
+            feed_frame(&rig, FRAME_TYPE_NMEA_SENTENCE, GNSS_UART_PORT, sample_ms, sentence, (uint8_t)strlen(sentence));
+
+            Axp192PmuStatus_t pmu_status;
+            encode_pmu_status(sample_ms, &pmu_status);
+            feed_frame(&rig, FRAME_TYPE_AXP192_PMU_STATUS, (uint8_t)g_I2cDeviceMap[I2C_DEVICE_INDEX_AXP192_PMU].addr, sample_ms, &pmu_status, sizeof(pmu_status));
+            next_gnss_ms += 1000;
+
+            if (g_HostGuiState.wind_count > 0) {
+                double direction_rad = g_HostGuiState.wind_direction * M_PI / 180.0;
+                double error_east_mps = -g_HostGuiState.wind_speed * sin(direction_rad) - wind_east_mps;
+                double error_north_mps = -g_HostGuiState.wind_speed * cos(direction_rad) - wind_north_mps;
+                wind_square_error += error_east_mps * error_east_mps + error_north_mps * error_north_mps;
+                wind_fixes++;
+            }
+
+            const HostFlightSegment_t *p_segment = (segment < generator.m_segments.size()) ? &(generator.m_segments[segment]) : NULL;
+            if (p_segment != NULL && p_segment->type == HOST_SEGMENT_THERMAL && g_HostGuiState.thermal_core_valid) {
+                double error_east_m = g_HostGuiState.thermal_core_east - (generator.m_circle_center_east_m + p_segment->core_offset_m - generator.m_state.east_m);
+                double error_north_m = g_HostGuiState.thermal_core_north - (generator.m_circle_center_north_m - generator.m_state.north_m);
+                core_square_error += error_east_m * error_east_m + error_north_m * error_north_m;
+                core_fixes++;
+            }
+
+            bool wind_known = generator.m_config.wind_speed_mps == 0 || g_HostGuiState.wind_count > 0;
+            if (generator.m_config.waypoint_enabled && generator.m_config.polar_enabled && wind_known && p_segment != NULL && p_segment->type != HOST_SEGMENT_GROUND && g_HostGuiState.glide_count > 0) {
+                double arrival_error_m, required_glide_error;
+                score_final_glide(&generator, p_glide->m_margin, &arrival_error_m, &required_glide_error);
+                arrival_square_error += arrival_error_m * arrival_error_m;
+                required_glide_square_error += required_glide_error * required_glide_error;
+                glide_fixes++;
+            }
+
+            if (g_HostGuiState.flight_state != flight_state) {
+                flight_state = g_HostGuiState.flight_state;
+                takeoffs += (flight_state == FLIGHT_STATE_FLYING) ? 1 : 0;
+                landings += (flight_state == FLIGHT_STATE_LANDED) ? 1 : 0;
+            }
+        }
+
+        const HostFlightState_t *p_state = &(generator.m_state);
+        if (p_truth_file != NULL) {
+            fprintf(p_truth_file, "%u,%u,%.3f,%.4f,%.2f,%.2f,%.2f,%.4f,%.4f,%.4f,%.4f\n", sample_ms, p_state->segment, p_state->altitude_m, p_state->vertical_speed_mps, p_state->pressure_pa, p_state->sensor_pressure_pa, p_state->temperature_c, g_HostGuiState.vertical_speed, p_state->total_energy_speed_mps, p_state->air_mass_speed_mps, g_HostGuiState.netto_vertical_speed);
+        }
+        // The vario starts from a zero pressure, its first seconds are left out.
+        if (p_state->time_s >= HOST_SCORE_SETTLE_S) {
+            true_vertical_speeds.push_back(total_energy ? p_state->total_energy_speed_mps : p_state->vertical_speed_mps);
+            vario_vertical_speeds.push_back(g_HostGuiState.vertical_speed);
+            true_air_mass_speeds.push_back(p_state->air_mass_speed_mps);
+            netto_vertical_speeds.push_back(g_HostGuiState.netto_vertical_speed);
+
+            double altitude_error_m = GetBarometricAltitude() - p_state->altitude_m;
+            if (!has_altitude_error) {
+                has_altitude_error = true;
+                start_altitude_error_m = altitude_error_m;
+            }
+            altitude_drift_m = altitude_error_m - start_altitude_error_m;
+            altitude_square_drift += altitude_drift_m * altitude_drift_m;
+            altitude_samples++;
+        }
+
+        true_climb_sums.push_back(true_climb_sums.back() + (total_energy ? p_state->total_energy_speed_mps : p_state->vertical_speed_mps));
+        if (g_HostGuiState.climb_count != climb_count) {
+            climb_count = g_HostGuiState.climb_count;
+            if (p_state->time_s >= HOST_SCORE_SETTLE_S && sample + 1 >= long_window_samples + (uint32_t)(HOST_SCORE_SETTLE_S / period_s)) {
+                double short_error_mps = g_HostGuiState.short_average - (true_climb_sums[sample + 1] - true_climb_sums[sample + 1 - short_window_samples]) / short_window_samples;
+                double long_error_mps = g_HostGuiState.long_average - (true_climb_sums[sample + 1] - true_climb_sums[sample + 1 - long_window_samples]) / long_window_samples;
+                average_square_error += (short_error_mps * short_error_mps + long_error_mps * long_error_mps) / 2.0;
+                average_reports++;
+            }
+        }
+
+        if (segment < generator.m_segments.size() && generator.m_segments[segment].type != HOST_SEGMENT_GROUND) {
+            true_airtime_s += period_s;
+            true_distance_m += p_state->ground_speed_mps * period_s;
+        }
+
+        more = generator.Step(period_s);
+        sample++;
+
+        // The frames of the step just flown, up to the next barometer sample, each burst stamped when it is read.
+        while (more && generator.m_config.imu_enabled && next_imu_ms <= sample * period_ms) {
+            generator.EncodeBmi270Frame(&(imu_frames[imu_frame_count++]));
+            if (next_imu_ms % imu_burst_ms == 0 || imu_frame_count == BMI270_FIFO_BURST_FRAMES) {
+                feed_frame(&rig, FRAME_TYPE_BMI270_FIFO, (uint8_t)p_imu_device->addr, next_imu_ms, imu_frames, (uint8_t)(imu_frame_count * sizeof(Bmi270FifoFrame_t)));
+                imu_frame_count = 0;
+            }
+            next_imu_ms += imu_frame_ms;
+        }
+
+        // The sample just fed was the last one of its segment.
+        if (check && segment < generator.m_segments.size() && generator.m_state.segment != segment && generator.m_segments[segment].type == HOST_SEGMENT_GLIDE) {
+            passed &= check_segment(segment, rig.m_p_sound, generator.m_segments[segment].lift_mps - generator.m_config.glider_sink_mps);
+        }
+    } while (more);
+    rig.Finish();
+
+    printf("samples %u, sample period %u ms, flight %.1f s\n", sample, period_ms, generator.Duration());
+    rig.PrintSummary(stdout);
+
+    HostVarioScore_t score;
+    HostScoreVario(true_vertical_speeds, vario_vertical_speeds, period_s, HOST_SCORE_MAX_LAG_S, &score);
+    printf("vario against truth: %u samples, rms error %.3f m/s, max error %.3f m/s, lag %.2f s, rms error %.3f m/s at that lag\n", score.samples, score.rms_error_mps, score.max_error_mps, score.lag_s, score.lagged_rms_error_mps);
+    if (max_rms_error_mps > 0 && score.lagged_rms_error_mps > max_rms_error_mps) {
+        printf("vario rms error above %.3f m/s: FAIL\n", max_rms_error_mps);
+        passed = false;
+    }
+    if (generator.m_config.polar_enabled) {
+        HostScoreVario(true_air_mass_speeds, netto_vertical_speeds, period_s, HOST_SCORE_MAX_LAG_S, &score);
+        printf("netto against air mass: %u samples, rms error %.3f m/s, max error %.3f m/s, lag %.2f s, rms error %.3f m/s at that lag\n", score.samples, score.rms_error_mps, score.max_error_mps, score.lag_s, score.lagged_rms_error_mps);
+    }
+    if (limits[HOST_SCORE_NETTO] > 0 && (!generator.m_config.polar_enabled || score.lagged_rms_error_mps > limits[HOST_SCORE_NETTO])) {
+        printf("netto rms error above %.3f m/s, or no polar: FAIL\n", limits[HOST_SCORE_NETTO]);
+        passed = false;
+    }
+
+    double wind_rms_error_mps = (wind_fixes > 0) ? sqrt(wind_square_error / wind_fixes) : 0;
+    printf("wind against truth (%.1f m/s from %.0f): %u fixes, rms error %.3f m/s, last %.1f m/s from %.0f\n", generator.m_config.wind_speed_mps, generator.m_config.wind_direction_deg, wind_fixes, wind_rms_error_mps, g_HostGuiState.wind_speed, g_HostGuiState.wind_direction);
+    if (limits[HOST_SCORE_WIND] > 0 && (wind_fixes == 0 || wind_rms_error_mps > limits[HOST_SCORE_WIND])) {
+        printf("wind rms error above %.3f m/s, or no wind: FAIL\n", limits[HOST_SCORE_WIND]);
+        passed = false;
+    }
+
+    double core_rms_error_m = (core_fixes > 0) ? sqrt(core_square_error / core_fixes) : 0;
+    printf("thermal core against truth: %u fixes, rms error %.1f m, last climb %.2f m/s\n", core_fixes, core_rms_error_m, g_HostGuiState.thermal_climb);
+    if (limits[HOST_SCORE_CORE] > 0 && (core_fixes == 0 || core_rms_error_m > limits[HOST_SCORE_CORE])) {
+        printf("thermal core rms error above %.1f m, or no core: FAIL\n", limits[HOST_SCORE_CORE]);
+        passed = false;
+    }
+
+    double airtime_s = g_HostGuiState.airtime / 1000.0;
+    double distance_error_percent = (true_distance_m > 0) ? fabs(g_HostGuiState.distance - true_distance_m) / true_distance_m * 100.0 : 0;
+    printf("flight against truth: %u takeoffs, %u landings, airtime %.1f s against %.1f s, distance %.0f m against %.0f m (%.1f%%)\n", takeoffs, landings, airtime_s, true_airtime_s, g_HostGuiState.distance, true_distance_m, distance_error_percent);
+    if (limits[HOST_SCORE_AIRTIME] > 0 && (takeoffs != 1 || landings != 1 || fabs(airtime_s - true_airtime_s) > limits[HOST_SCORE_AIRTIME])) {
+        printf("not one takeoff and one landing, or airtime error above %.1f s: FAIL\n", limits[HOST_SCORE_AIRTIME]);
+        passed = false;
+    }
+    if (limits[HOST_SCORE_DISTANCE] > 0 && distance_error_percent > limits[HOST_SCORE_DISTANCE]) {
+        printf("distance error above %.1f%%: FAIL\n", limits[HOST_SCORE_DISTANCE]);
+        passed = false;
+    }
+
+    double average_rms_error_mps = (average_reports > 0) ? sqrt(average_square_error / average_reports) : 0;
+    printf("climb averages against truth (%u s / %u s): %u reports, rms error %.3f m/s, last thermal %.2f m/s gain %.0f m\n", CONFIG_VARIO_AVERAGE_SHORT_WINDOW, CONFIG_VARIO_AVERAGE_LONG_WINDOW, average_reports, average_rms_error_mps, g_HostGuiState.thermal_average, g_HostGuiState.thermal_gain);
+    if (limits[HOST_SCORE_AVERAGE] > 0 && (average_reports == 0 || average_rms_error_mps > limits[HOST_SCORE_AVERAGE])) {
+        printf("climb average rms error above %.3f m/s, or no average: FAIL\n", limits[HOST_SCORE_AVERAGE]);
+        passed = false;
+    }
+
+    if (generator.m_config.static_port_enabled) {
+        const RedundantStatic *p_static = &(rig.m_p_msg_proc->m_redundant_static);
+        bool failed = p_static->IsFailed(STATIC_PORT_PRIMARY);
+        double failed_s = p_static->GetFailedTimestamp(STATIC_PORT_PRIMARY) / 1000.0;
+        printf("static ports: %u samples averaged, offset %.1f Pa (scripted %.1f Pa), barometer %s at %.1f s (stuck at %.1f s)\n", p_static->GetFusedCount(), p_static->GetOffset(), generator.m_config.static_port_offset_pa, failed ? "failed" : "working", failed ? failed_s : 0.0, generator.m_config.barometer_stuck_s);
+        bool stuck = generator.m_config.barometer_stuck_s > 0;
+        if (limits[HOST_SCORE_STATIC_PORT] > 0 && (p_static->GetFusedCount() == 0 || failed != stuck || (stuck && failed_s > generator.m_config.barometer_stuck_s + limits[HOST_SCORE_STATIC_PORT] * period_s))) {
+            printf("second static port never averaged in, or the barometer failure not found within %.0f samples: FAIL\n", limits[HOST_SCORE_STATIC_PORT]);
+            passed = false;
+        }
+    } else if (limits[HOST_SCORE_STATIC_PORT] > 0) {
+        printf("no static port: FAIL\n");
+        passed = false;
+    }
+
+    const TemperatureDrift *p_drift = &(rig.m_p_msg_proc->m_temperature_drift);
+    double altitude_rms_drift_m = (altitude_samples > 0) ? sqrt(altitude_square_drift / altitude_samples) : 0;
+    printf("barometric altitude against truth: rms drift %.2f m, last %+.2f m, temperature drift %+.2f Pa/C %s (scripted %+.2f Pa/C), %u GNSS fixes fitted\n", altitude_rms_drift_m, altitude_drift_m, p_drift->GetCoefficient(), p_drift->IsLearned() ? "learned" : "not learned", generator.m_config.warming_pa_per_c, p_drift->GetGnssCount());
+    if (limits[HOST_SCORE_ALTITUDE_DRIFT] > 0 && altitude_rms_drift_m > limits[HOST_SCORE_ALTITUDE_DRIFT]) {
+        printf("barometric altitude rms drift above %.2f m: FAIL\n", limits[HOST_SCORE_ALTITUDE_DRIFT]);
+        passed = false;
+    }
+
+    double arrival_rms_error_m = (glide_fixes > 0) ? sqrt(arrival_square_error / glide_fixes) : 0;
+    double required_glide_rms_error = (glide_fixes > 0) ? sqrt(required_glide_square_error / glide_fixes) * 100.0 : 0;
+    printf("final glide against truth: %u fixes, arrival rms error %.1f m, required glide rms error %.2f%%, last stf %.1f km/h, glide %.1f needing %.1f, arrival %+.0f m at %.2f km\n", glide_fixes, arrival_rms_error_m, required_glide_rms_error, g_HostGuiState.speed_to_fly * 3.6, g_HostGuiState.glide, g_HostGuiState.required_glide, g_HostGuiState.arrival_altitude, g_HostGuiState.waypoint_distance / 1000.0);
+    if (limits[HOST_SCORE_ARRIVAL] > 0 && (glide_fixes == 0 || arrival_rms_error_m > limits[HOST_SCORE_ARRIVAL])) {
+        printf("arrival altitude rms error above %.1f m, or no final glide: FAIL\n", limits[HOST_SCORE_ARRIVAL]);
+        passed = false;
+    }
+
+    if (p_recorder != NULL) {
+        p_recorder->Deinit();
+        printf("recording %s, %u bytes, %u frames dropped\n", recording_file_name, p_recorder->m_file_size, p_recorder->m_dropped_frames);
+    }
+    if (p_trace_file != NULL) {
+        fclose(p_trace_file);
+    }
+    if (p_truth_file != NULL) {
+        fclose(p_truth_file);
+    }
+    if (p_audio_file != NULL) {
+        rig.m_p_sink->Capture(NULL);
+        fclose(p_audio_file);
+    }
+
+    return passed ? 0 : 1;
+}
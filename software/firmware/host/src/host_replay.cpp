@@ -0,0 +1,132 @@
+/*
+    Host replay: feed a frame recording, made on the device by the frame recorder or by bluethroat_host_pipeline -r,
+    through the host rig, i.e. through the same process_data / process_gnss_sentence / process_message code as on the
+    device, and report the cost of every stage.
+
+    Usage: bluethroat_host_replay [-x speed] [-t trace.txt] [-e expected.txt] [-o audio.raw] [-v] frames.btr
+        -x  replay speed relative to the recording, 0 (default) replays as fast as possible
+        -t  write the output trace of the rig, one line per barometer sample
+        -e  compare the output trace with a trace written before, exit with 1 unless bit-identical
+        -o  write the raw I2S stream (signed 8-bit, 4 bytes per sample) to a file
+        -v  verbose firmware log
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+
+#include <esp_log.h>
+
+#include "host_rig.h"
+
+#define HOST_DEFAULT_VOLUME             (50)
+
+static FILE *open_file(const char *file_name, const char *mode) {
+    FILE *p_file = fopen(file_name, mode);
+    if (p_file == NULL) {
+        fprintf(stderr, "Failed to open %s.\n", file_name);
+        exit(1);
+    }
+    return p_file;
+}
+
+int main(int argc, char *argv[]) {
+    double speed = 0;
+    const char *trace_file_name = NULL;
+    const char *expected_trace_file_name = NULL;
+    const char *audio_file_name = NULL;
+    int option;
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    while ((option = getopt(argc, argv, "x:t:e:o:v")) != -1) {
+        switch (option) {
+        case 'x': speed = strtod(optarg, NULL); break;
+        case 't': trace_file_name = optarg; break;
+        case 'e': expected_trace_file_name = optarg; break;
+        case 'o': audio_file_name = optarg; break;
+        case 'v': esp_log_level_set("*", ESP_LOG_DEBUG); break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "Usage: %s [-x speed] [-t trace.txt] [-e expected.txt] [-o audio.raw] [-v] frames.btr\n", argv[0]);
+        return 2;
+    }
+
+    FILE *p_recording = open_file(argv[optind], "rb");
+    FrameFileHeader_t file_header;
+    if (fread(&file_header, sizeof(file_header), 1, p_recording) != 1 || file_header.magic != FRAME_FILE_MAGIC || file_header.header_size < sizeof(FrameHeader_t) || file_header.header_size > FRAME_MAX_PAYLOAD_SIZE) {
+        fprintf(stderr, "%s is not a frame recording.\n", argv[optind]);
+        return 1;
+    } else if (file_header.version != FRAME_FILE_VERSION) {
+        fprintf(stderr, "%s has version %u, version %u is supported.\n", argv[optind], file_header.version, FRAME_FILE_VERSION);
+        return 1;
+    }
+
+    HostRig rig;
+    if (rig.Init(HOST_DEFAULT_VOLUME) != ESP_OK) {
+        return 1;
+    }
+
+    FILE *p_trace_file = (trace_file_name != NULL) ? open_file(trace_file_name, "w") : NULL;
+    FILE *p_expected_trace_file = (expected_trace_file_name != NULL) ? open_file(expected_trace_file_name, "r") : NULL;
+    rig.SetTrace(p_trace_file, p_expected_trace_file);
+
+    FILE *p_audio_file = (audio_file_name != NULL) ? open_file(audio_file_name, "wb") : NULL;
+    rig.m_p_sink->Capture(p_audio_file);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool first_frame = true;
+    uint32_t first_timestamp = 0;
+    uint8_t header_bytes[FRAME_MAX_PAYLOAD_SIZE];
+    uint8_t payload[FRAME_MAX_PAYLOAD_SIZE];
+
+    for ( ; ; ) {
+        if (fread(header_bytes, file_header.header_size, 1, p_recording) != 1) {
+            break;
+        }
+        FrameHeader_t header;
+        memcpy(&header, header_bytes, sizeof(header));
+        if (fread(payload, 1, header.size, p_recording) != header.size) {
+            fprintf(stderr, "Recording truncated in a frame of type %u.\n", header.type);
+            break;
+        }
+
+        // Calibration frames are stamped with the real boot time even in recordings made by the host pipeline.
+        if (header.type != FRAME_TYPE_DPS3XX_COEF) {
+            if (first_frame) {
+                first_frame = false;
+                first_timestamp = header.timestamp;
+            }
+            if (speed > 0) {
+                std::this_thread::sleep_until(start + std::chrono::microseconds((uint64_t)((header.timestamp - first_timestamp) * 1000.0 / speed)));
+            }
+        }
+
+        rig.ProcessFrame(&header, payload);
+    }
+    rig.Finish();
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    rig.PrintSummary(stdout);
+    printf("replayed %.1f s of recording in %.3f s, %.0fx real time\n", (rig.m_now_ms - first_timestamp) / 1000.0, wall_s, (rig.m_now_ms - first_timestamp) / 1000.0 / wall_s);
+
+    fclose(p_recording);
+    if (p_trace_file != NULL) {
+        fclose(p_trace_file);
+    }
+    if (p_expected_trace_file != NULL) {
+        fclose(p_expected_trace_file);
+    }
+    if (p_audio_file != NULL) {
+        rig.m_p_sink->Capture(NULL);
+        fclose(p_audio_file);
+    }
+
+    return (rig.m_trace_mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,415 @@
+#include <string.h>
+#include <chrono>
+
+#include <esp_log.h>
+
+#include "bluethroat_bluetooth.h"
+#include "bluethroat_config.h"
+#include "bluethroat_global.h"
+#include "bluethroat_vario.h"
+#include "host_firmware_stubs.h"
+#include "host_rig.h"
+
+static const char *TAG = "HOST_RIG";
+
+static const char *s_stage_names[HOST_STAGE_MAX] = {
+    [HOST_STAGE_BAROMETER]  = "Dps3xxBarometer::process_data",
+    [HOST_STAGE_ANEMOMETER] = "Dps3xxAnemometer::process_data",
+    [HOST_STAGE_IMU]        = "Bmi270Imu::process_data",
+    [HOST_STAGE_PMU]        = "Axp192Pmu::process_data",
+    [HOST_STAGE_GNSS]       = "NeoM9nGnss::process_gnss_sentence",
+    [HOST_STAGE_MSG_PROC]   = "BluethroatMsgProc::process_message",
+    [HOST_STAGE_SOUND]      = "Ns4168Sound::play_sound",
+};
+
+static const char *s_frame_type_names[FRAME_TYPE_MAX] = {
+    [FRAME_TYPE_DPS3XX_COEF]        = "dps3xx coef",
+    [FRAME_TYPE_DPS3XX_DATA]        = "dps3xx data",
+    [FRAME_TYPE_AXP192_PMU_STATUS]  = "axp192 status",
+    [FRAME_TYPE_NMEA_SENTENCE]      = "nmea sentence",
+    [FRAME_TYPE_BMI270_FIFO]        = "bmi270 fifo",
+    [FRAME_TYPE_DPS3XX_MODE]        = "dps3xx mode",
+};
+
+/* Times one call of a firmware stage, the expression is evaluated once. */
+#define HOST_RIG_TIMED(stage, expression)                                                                               \
+    do {                                                                                                                \
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();                                 \
+        expression;                                                                                                     \
+        uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(); \
+        m_stats[stage].calls++;                                                                                         \
+        m_stats[stage].total_ns += ns;                                                                                  \
+        m_stats[stage].max_ns = (ns > m_stats[stage].max_ns) ? ns : m_stats[stage].max_ns;                              \
+    } while (0)
+
+HostRig::HostRig() : m_p_i2c_master(NULL), m_p_barometer(NULL), m_p_anemometer(NULL), m_p_imu(NULL), m_p_pmu(NULL), m_p_gnss(NULL),
+    m_gnss_queue(NULL), m_p_msg_proc(NULL), m_p_i2s_master(NULL), m_p_sound(NULL), m_p_sink(NULL), m_second_static(false), m_now_ms(0),
+    m_pmu_status_valid(false), m_pmu_next_ms(0), m_skipped_frames(0), m_p_trace_file(NULL),
+    m_p_expected_trace_file(NULL), m_trace_lines(0), m_trace_mismatches(0), m_p_message_log(NULL) {
+    memset(&m_pmu_status, 0, sizeof(m_pmu_status));
+    memset(m_frame_counts, 0, sizeof(m_frame_counts));
+    memset(m_stats, 0, sizeof(m_stats));
+}
+
+HostRig::~HostRig() {
+}
+
+esp_err_t HostRig::Init(int32_t volume) {
+    HostResetFirmwareStubs();
+    g_pBluethroatConfig = new BluethroatConfig();
+    BluethroatConfig::SetInteger(Ns4168Sound::m_conf_namespace, Ns4168Sound::m_conf_key_volume, volume);
+    LoadGliderPolar();
+
+    // DPS3xx ready flags in the high nibble of MEAS_CFG are read-only, the devices are always ready.
+    m_barometer_registers.SetRegister(DPS3XX_REG_ADDR_ID, DPS3XX_REG_VALUE_ID, 0x00);
+    m_barometer_registers.SetRegister(DPS3XX_REG_ADDR_MEAS_CFG, 0xf0, 0x07);
+    m_anemometer_registers.SetRegister(DPS3XX_REG_ADDR_ID, DPS3XX_REG_VALUE_ID, 0x00);
+    m_anemometer_registers.SetRegister(DPS3XX_REG_ADDR_MEAS_CFG, 0xf0, 0x07);
+
+    const I2cDevice_t *p_pmu_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_AXP192_PMU]);
+    HostI2cBus::GetBus(p_pmu_device->port)->Attach(p_pmu_device->addr, &m_pmu_registers);
+    const I2cDevice_t *p_barometer_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_BAROMETER]);
+    HostI2cBus::GetBus(p_barometer_device->port)->Attach(p_barometer_device->addr, &m_barometer_registers);
+    const I2cDevice_t *p_anemometer_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_ANEMOMETER]);
+    HostI2cBus::GetBus(p_anemometer_device->port)->Attach(p_anemometer_device->addr, &m_anemometer_registers);
+    const I2cDevice_t *p_imu_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_BMI270_ACCELEROMETER]);
+    HostI2cBus::GetBus(p_imu_device->port)->Attach(p_imu_device->addr, &m_imu_model);
+
+    m_p_i2c_master = new I2cMaster(I2C_NUM_0, CONFIG_I2C_PORT_0_SDA, CONFIG_I2C_PORT_0_SCL, false, false, CONFIG_I2C_PORT_0_FREQ_HZ, CONFIG_I2C_PORT_0_LOCK_TIMEOUT, CONFIG_I2C_PORT_0_TIMEOUT);
+
+    m_p_pmu = new Axp192Pmu();
+    if (m_p_pmu->Init(m_p_i2c_master, p_pmu_device->addr, p_pmu_device->int_pins) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize AXP192 on host bus.");
+        return ESP_FAIL;
+    }
+    // process_data() counts its report interval in task intervals.
+    m_p_pmu->m_p_task_param = &(g_TaskParam[TASK_INDEX_AXP192_PMU]);
+
+    m_p_msg_proc = new BluethroatMsgProc(&(g_TaskParam[TASK_INDEX_MSG_PROC]));
+
+    // GNSS messages are collected on a queue of the rig, the message processor thread must not consume them.
+    m_p_gnss = new NeoM9nGnss();
+    m_gnss_queue = xQueueCreate(BLUETHROAT_MSG_QUEUE_LENGTH, sizeof(BluethroatMsg_t));
+    m_p_gnss->SetMessageQueue(m_gnss_queue);
+
+    m_p_i2s_master = new I2sMaster(I2S_NUM_0, (gpio_num_t)CONFIG_I2S_PORT_0_MCLK, (gpio_num_t)CONFIG_I2S_PORT_0_BCLK, (gpio_num_t)CONFIG_I2S_PORT_0_WS, (gpio_num_t)CONFIG_I2S_PORT_0_DIN, (gpio_num_t)CONFIG_I2S_PORT_0_DOUT, (uint32_t)CONFIG_I2S_PORT_0_SAMPLE_RATE, (i2s_data_bit_width_t)CONFIG_I2S_PORT_0_SAMPLE_BITS, CONFIG_I2S_PORT_0_CHANNEL_NUM);
+    m_p_sound = new Ns4168Sound(m_p_i2s_master, CONFIG_I2S_PORT_0_SAMPLE_RATE, CONFIG_I2S_PORT_0_SAMPLE_BITS);
+    m_p_sound->Init();
+    m_p_sink = HostI2sSink::GetSink(I2S_NUM_0);
+
+    return ESP_OK;
+}
+
+esp_err_t HostRig::ProcessFrame(const FrameHeader_t *p_header, const uint8_t *p_payload) {
+    if (p_header->type >= FRAME_TYPE_MAX) {
+        m_skipped_frames++;
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    m_frame_counts[p_header->type]++;
+
+    switch (p_header->type) {
+    case FRAME_TYPE_DPS3XX_COEF:
+        // Calibration is read once at reset, it doesn't advance the time.
+        return process_coef(p_header->source, p_payload, p_header->size);
+    case FRAME_TYPE_DPS3XX_DATA:
+        advance(p_header->timestamp);
+        return process_dps3xx(p_header->source, p_header->timestamp, p_payload, p_header->size);
+    case FRAME_TYPE_AXP192_PMU_STATUS:
+        advance(p_header->timestamp);
+        return process_pmu(p_header->timestamp, p_payload, p_header->size);
+    case FRAME_TYPE_NMEA_SENTENCE:
+        advance(p_header->timestamp);
+        return process_nmea(p_payload, p_header->size);
+    case FRAME_TYPE_BMI270_FIFO:
+        advance(p_header->timestamp);
+        return process_bmi270(p_header->source, p_header->timestamp, p_payload, p_header->size);
+    case FRAME_TYPE_DPS3XX_MODE:
+        advance(p_header->timestamp);
+        return process_mode(p_header->source, p_payload, p_header->size);
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+
+void HostRig::Finish() {
+    advance(m_now_ms);
+
+    char expected_line[256];
+    if (m_p_expected_trace_file != NULL && fgets(expected_line, sizeof(expected_line), m_p_expected_trace_file) != NULL) {
+        fprintf(stderr, "trace ends at line %u, expected: %s", m_trace_lines, expected_line);
+        m_trace_mismatches++;
+    }
+}
+
+void HostRig::SetTrace(FILE *p_trace_file, FILE *p_expected_trace_file) {
+    m_p_trace_file = p_trace_file;
+    m_p_expected_trace_file = p_expected_trace_file;
+}
+
+void HostRig::SetMessageLog(std::vector<BluethroatMsg_t> *p_message_log) {
+    m_p_message_log = p_message_log;
+}
+
+/* Before the calibration frame of the second DPS3xx, the device has it from its configuration. */
+void HostRig::SetSecondStatic(bool second_static) {
+    m_second_static = second_static;
+}
+
+void HostRig::PrintSummary(FILE *p_file) {
+    uint64_t bytes_per_second = (uint64_t)CONFIG_I2S_PORT_0_SAMPLE_RATE * HOST_I2S_BYTES_PER_SAMPLE;
+
+    fprintf(p_file, "frames:");
+    for (int i = 0; i < FRAME_TYPE_MAX; i++) {
+        fprintf(p_file, " %s %u,", s_frame_type_names[i], m_frame_counts[i]);
+    }
+    fprintf(p_file, " skipped %u\n", m_skipped_frames);
+    fprintf(p_file, "flight time %.1f s, audio %.1f s, audio hash 0x%016llx\n", m_now_ms / 1000.0, (double)m_p_sink->m_bytes_written / bytes_per_second, (unsigned long long)m_p_sink->m_hash);
+    fprintf(p_file, "gui vario %+.3f m/s, altitude %.1f m, speed %.1f km/h, battery %u mV, ble pressure notifications %u\n", g_HostGuiState.vertical_speed, g_HostGuiState.altitude, g_HostGuiState.speed, g_HostGuiState.battery_voltage, g_HostBluetoothState.pressure_notify_count);
+    if (m_p_expected_trace_file != NULL) {
+        fprintf(p_file, "trace %u lines, %u mismatches\n", m_trace_lines, m_trace_mismatches);
+    }
+
+    fprintf(p_file, "%-36s %10s %12s %12s\n", "stage", "calls", "mean ns", "max ns");
+    for (int i = 0; i < HOST_STAGE_MAX; i++) {
+        const HostStageStats_t *p_stats = &(m_stats[i]);
+        fprintf(p_file, "%-36s %10llu %12llu %12llu\n", s_stage_names[i], (unsigned long long)p_stats->calls, (unsigned long long)(p_stats->calls ? p_stats->total_ns / p_stats->calls : 0), (unsigned long long)p_stats->max_ns);
+    }
+}
+
+/*
+    Run the periodic parts of the firmware up to the timestamp: the sound task writes 4 bytes per sample to I2S, the
+    AXP192 task polls the held battery status every task interval.
+*/
+void HostRig::advance(uint32_t timestamp) {
+    uint64_t bytes_per_second = (uint64_t)CONFIG_I2S_PORT_0_SAMPLE_RATE * HOST_I2S_BYTES_PER_SAMPLE;
+    while (m_p_sink->m_bytes_written * 1000 / bytes_per_second < timestamp) {
+        HOST_RIG_TIMED(HOST_STAGE_SOUND, m_p_sound->play_sound());
+    }
+
+    if (m_pmu_status_valid) {
+        BluethroatMsg_t message;
+        while (m_pmu_next_ms <= timestamp) {
+            Axp192PmuStatus_t pmu_status = m_pmu_status;
+            HOST_RIG_TIMED(HOST_STAGE_PMU, m_p_pmu->process_data((uint8_t *)&pmu_status, sizeof(pmu_status), &message));
+            if (message.type != BLUETHROAT_MSG_INVALID) {
+                process_message(&message);
+            }
+            m_pmu_next_ms += pdTICKS_TO_MS(m_p_pmu->m_p_task_param->task_interval);
+        }
+    }
+
+    m_now_ms = (timestamp > m_now_ms) ? timestamp : m_now_ms;
+}
+
+esp_err_t HostRig::process_coef(uint8_t source, const uint8_t *p_payload, uint8_t size) {
+    if (size != sizeof(Dps3xxCoefRegs_t)) {
+        ESP_LOGE(TAG, "Invalid DPS3xx coefficient frame size %u.", size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const I2cDevice_t *p_barometer_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_BAROMETER]);
+    const I2cDevice_t *p_anemometer_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_ANEMOMETER]);
+    if (source == p_barometer_device->addr) {
+        if (m_p_barometer != NULL) {
+            ESP_LOGW(TAG, "DPS3xx barometer reset again, keep the first calibration.");
+            return ESP_OK;
+        }
+        m_barometer_registers.SetRegisters(DPS3XX_REG_ADDR_COEF, p_payload, size, 0x00);
+        Dps3xxSync *p_sync = new Dps3xxSync();
+        if (p_sync->Init() != ESP_OK) {
+            delete p_sync;
+            p_sync = NULL;
+        }
+        m_p_barometer = new Dps3xxBarometer(p_sync);
+        return m_p_barometer->Init(m_p_i2c_master, p_barometer_device->addr, p_barometer_device->int_pins);
+    } else if (source == p_anemometer_device->addr) {
+        if (m_p_anemometer != NULL) {
+            ESP_LOGW(TAG, "DPS3xx anemometer reset again, keep the first calibration.");
+            return ESP_OK;
+        } else if (m_p_barometer == NULL) {
+            ESP_LOGE(TAG, "DPS3xx anemometer calibration before barometer, anemometer frames are skipped.");
+            return ESP_FAIL;
+        }
+        m_anemometer_registers.SetRegisters(DPS3XX_REG_ADDR_COEF, p_payload, size, 0x00);
+        m_p_anemometer = new Dps3xxAnemometer(m_p_barometer, m_second_static);
+        return m_p_anemometer->Init(m_p_i2c_master, p_anemometer_device->addr, p_anemometer_device->int_pins);
+    } else {
+        ESP_LOGE(TAG, "Unknown DPS3xx device address 0x%02x.", source);
+        return ESP_ERR_NOT_FOUND;
+    }
+}
+
+esp_err_t HostRig::process_dps3xx(uint8_t source, uint32_t timestamp, const uint8_t *p_payload, uint8_t size) {
+    uint8_t raw_data[MAX_RAW_DATA_BUFFER_LENGTH] = {0};
+    BluethroatMsg_t message;
+    esp_err_t result;
+
+    if (size != sizeof(Dps3xxData_t)) {
+        ESP_LOGE(TAG, "Invalid DPS3xx data frame size %u.", size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(raw_data, p_payload, size);
+
+    if (m_p_barometer != NULL && source == m_p_barometer->m_device_addr) {
+        m_p_barometer->m_sample_timestamp_us = (int64_t)timestamp * 1000;
+        m_p_barometer->m_sample_timestamp = timestamp;
+        HOST_RIG_TIMED(HOST_STAGE_BAROMETER, result = m_p_barometer->process_data(raw_data, sizeof(raw_data), &message));
+        // The device stamps the sample when it is processed, right after it is read, replay the recorded stamp instead.
+        message.barometer_data.timestamp = timestamp;
+        if (result == ESP_OK && message.type == BLUETHROAT_MSG_TYPE_BAROMETER_DATA && m_p_message_log != NULL) {
+            m_p_message_log->push_back(message);
+        }
+    } else if (m_p_anemometer != NULL && source == m_p_anemometer->m_device_addr) {
+        // The anemometer pairs its samples with the ones of the barometer by these stamps.
+        m_p_anemometer->m_sample_timestamp_us = (int64_t)timestamp * 1000;
+        m_p_anemometer->m_sample_timestamp = timestamp;
+        HOST_RIG_TIMED(HOST_STAGE_ANEMOMETER, result = m_p_anemometer->process_data(raw_data, sizeof(raw_data), &message));
+        message.anemometer_data.timestamp = timestamp;
+        if (result == ESP_OK && message.type == BLUETHROAT_MSG_TYPE_ANEMOMETER_DATA && m_p_message_log != NULL) {
+            m_p_message_log->push_back(message);
+        }
+    } else {
+        m_skipped_frames++;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (result == ESP_OK && message.type != BLUETHROAT_MSG_INVALID) {
+        process_message(&message);
+    }
+
+    if (m_p_barometer != NULL && source == m_p_barometer->m_device_addr) {
+        trace(timestamp);
+    }
+
+    return result;
+}
+
+/* The samples after a switch of the mode are scaled for its oversampling, the device switches as it did when recorded. */
+esp_err_t HostRig::process_mode(uint8_t source, const uint8_t *p_payload, uint8_t size) {
+    if (size != sizeof(uint8_t) || p_payload[0] >= DPS3XX_MODE_MAX) {
+        ESP_LOGE(TAG, "Invalid DPS3xx mode frame, size %u.", size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    Dps3xxBarometer *p_device = NULL;
+    if (m_p_barometer != NULL && source == m_p_barometer->m_device_addr) {
+        p_device = m_p_barometer;
+    } else if (m_p_anemometer != NULL && source == m_p_anemometer->m_device_addr) {
+        p_device = m_p_anemometer;
+    } else {
+        m_skipped_frames++;
+        return ESP_ERR_INVALID_STATE;
+    }
+    return p_device->ApplyMode((Dps3xxMode_t)p_payload[0]);
+}
+
+/* The IMU has no calibration frame, it is brought up by its first burst, the config file uploaded to its model. */
+esp_err_t HostRig::process_bmi270(uint8_t source, uint32_t timestamp, const uint8_t *p_payload, uint8_t size) {
+    uint8_t raw_data[MAX_RAW_DATA_BUFFER_LENGTH] = {0};
+    Bmi270FifoBurst_t *p_burst = (Bmi270FifoBurst_t *)raw_data;
+    BluethroatMsg_t message;
+    esp_err_t result;
+
+    if (size % sizeof(Bmi270FifoFrame_t) != 0 || size > sizeof(p_burst->frame)) {
+        ESP_LOGE(TAG, "Invalid BMI270 FIFO frame size %u.", size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const I2cDevice_t *p_imu_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_BMI270_ACCELEROMETER]);
+    if (source != p_imu_device->addr) {
+        m_skipped_frames++;
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (m_p_imu == NULL) {
+        m_p_imu = new Bmi270Imu();
+        if ((result = m_p_imu->Init(m_p_i2c_master, p_imu_device->addr, p_imu_device->int_pins)) != ESP_OK) {
+            return result;
+        }
+    }
+
+    p_burst->frames = (uint8_t)(size / sizeof(Bmi270FifoFrame_t));
+    memcpy(p_burst->frame, p_payload, size);
+    HOST_RIG_TIMED(HOST_STAGE_IMU, result = m_p_imu->process_data(raw_data, sizeof(raw_data), &message));
+    if (result != ESP_OK || message.type == BLUETHROAT_MSG_INVALID) {
+        return result;
+    }
+
+    // Stamped at the end of the burst, as the barometer samples.
+    message.acceleration_data.timestamp = timestamp;
+    if (m_p_message_log != NULL) {
+        m_p_message_log->push_back(message);
+    }
+    process_message(&message);
+
+    return ESP_OK;
+}
+
+esp_err_t HostRig::process_pmu(uint32_t timestamp, const uint8_t *p_payload, uint8_t size) {
+    if (size != sizeof(Axp192PmuStatus_t)) {
+        ESP_LOGE(TAG, "Invalid AXP192 status frame size %u.", size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // The device polls every task interval but records once per report interval, hold the status in between.
+    memcpy(&m_pmu_status, p_payload, size);
+    if (!m_pmu_status_valid) {
+        m_pmu_status_valid = true;
+        m_pmu_next_ms = timestamp;
+        advance(timestamp);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t HostRig::process_nmea(const uint8_t *p_payload, uint8_t size) {
+    char sentence[MNEA_SENTENCE_MAX_SIZE];
+
+    if (size >= MNEA_SENTENCE_MAX_SIZE) {
+        ESP_LOGE(TAG, "Invalid NMEA sentence frame size %u.", size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(sentence, p_payload, size);
+    sentence[size] = '\0';
+
+    BluetoothSendGnssNmea(sentence);
+    HOST_RIG_TIMED(HOST_STAGE_GNSS, m_p_gnss->process_gnss_sentence(sentence));
+
+    BluethroatMsg_t message;
+    while (xQueueReceive(m_gnss_queue, &message, 0) == pdTRUE) {
+        process_message(&message);
+    }
+
+    return ESP_OK;
+}
+
+void HostRig::process_message(BluethroatMsg_t *p_message) {
+    HOST_RIG_TIMED(HOST_STAGE_MSG_PROC, m_p_msg_proc->process_message(p_message));
+}
+
+/* Floating point values are traced in hexadecimal so equal lines mean bit-identical values. */
+void HostRig::trace(uint32_t timestamp) {
+    char line[256];
+
+    if (m_p_trace_file == NULL && m_p_expected_trace_file == NULL) {
+        return;
+    }
+
+    snprintf(line, sizeof(line), "%u %a %a %a %a %u %d %016llx\n", timestamp, g_HostGuiState.vertical_speed, g_HostGuiState.altitude, g_HostGuiState.agl, g_HostGuiState.speed, g_HostGuiState.battery_voltage, m_p_sound->m_vertical_speed_in_multiple, (unsigned long long)m_p_sink->m_hash);
+    m_trace_lines++;
+
+    if (m_p_trace_file != NULL) {
+        fputs(line, m_p_trace_file);
+    }
+
+    if (m_p_expected_trace_file != NULL) {
+        char expected_line[256];
+        if (fgets(expected_line, sizeof(expected_line), m_p_expected_trace_file) == NULL) {
+            expected_line[0] = '\0';
+        }
+        if (strcmp(line, expected_line) != 0) {
+            if (m_trace_mismatches++ == 0) {
+                fprintf(stderr, "trace mismatch at line %u\nexpected: %sactual:   %s", m_trace_lines, (expected_line[0] != '\0') ? expected_line : "<end of trace>\n", line);
+            }
+        }
+    }
+}
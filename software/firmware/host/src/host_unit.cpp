@@ -0,0 +1,423 @@
+/*
+    Host unit tests of the flight utilities, each one fed by hand with the few samples that pin its contract, so a
+    failure names the utility instead of a flight that scores worse:
+        - wind, WindEstimator: the wind and the airspeed of a drifting circle, no fit of a straight or a degenerate
+          track or of fixes off the circle, the last wind kept through a straight glide
+        - polar, GliderPolar: the sinks of its points in any order, invalid polars refused and the last one kept
+        - speed_to_fly, GlideComputer: the speed to fly against the closed form of the tangent, with netto, tailwind and
+          density, never slower than the minimum sink
+        - climb_average, ClimbAverager: windows emptied by a gap in the samples, one report after the gap instead of a
+          catch-up
+        - static_port, RedundantStatic: the mean of both ports, the failover to the second port of a stuck or out of
+          range barometer, the first port alone when the second one is out of range or too old
+        - temperature_drift, TemperatureDrift: the drift fitted on the ground once the temperature spanned enough, the
+          pressure corrected back to the one of the first sample, nothing learned in flight without the GNSS
+
+    Usage: bluethroat_host_unit [-v] [utility ...]
+        -v  verbose firmware log
+        utility  the utilities to check, all of them without one
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <esp_log.h>
+
+#include "bluethroat_message.h"
+#include "utilities/climb_averager.h"
+#include "utilities/glide_computer.h"
+#include "utilities/glider_polar.h"
+#include "utilities/redundant_static.h"
+#include "utilities/temperature_drift.h"
+#include "utilities/wind_estimator.h"
+
+/* A circle flown at 10 m/s in a 3.6 m/s wind, a fix every 15 degrees of heading */
+#define HOST_WIND_AIRSPEED_MPS          (10.0)
+#define HOST_WIND_EAST_MPS              (3.0)
+#define HOST_WIND_NORTH_MPS             (-2.0)
+#define HOST_WIND_HEADING_STEP_DEG      (15.0)
+#define HOST_WIND_TOLERANCE_MPS         (0.05)
+/* Polar of host/flights/final_glide.txt */
+#define HOST_POLAR_TOLERANCE_MPS        (0.0005)
+#define HOST_STF_TOLERANCE_MPS          (0.01)
+#define HOST_STF_SEARCH_STEP_MPS        (0.1)
+/* A sample every 100 ms, 10 s and 30 s windows */
+#define HOST_CLIMB_PERIOD_MS            (100)
+#define HOST_CLIMB_SHORT_WINDOW_MS      (10000)
+#define HOST_CLIMB_LONG_WINDOW_MS       (30000)
+#define HOST_CLIMB_TOLERANCE_MPS        (0.05)
+/* Both ports every 100 ms, the second one 50 Pa above the first */
+#define HOST_STATIC_PERIOD_MS           (100)
+#define HOST_STATIC_MAX_AGE_MS          (500)
+#define HOST_STATIC_MAX_DIFFERENCE_PA   (20.0f)
+#define HOST_STATIC_PRESSURE_PA         (90000.0f)
+#define HOST_STATIC_OFFSET_PA           (50.0f)
+#define HOST_STATIC_TOLERANCE_PA        (1.0f)
+/* A barometer warming 6 C in the sun on launch, -3 Pa per degree */
+#define HOST_DRIFT_MIN_SPAN_C           (2.0f)
+#define HOST_DRIFT_SAMPLES              (600)
+#define HOST_DRIFT_START_C              (20.0f)
+#define HOST_DRIFT_WARMING_C            (6.0f)
+#define HOST_DRIFT_PRESSURE_PA          (95000.0f)
+#define HOST_DRIFT_PA_PER_C             (-3.0f)
+#define HOST_DRIFT_NOISE_PA             (0.5f)
+#define HOST_DRIFT_COEFFICIENT_TOLERANCE (0.05f)
+
+#define HOST_CHECK(condition, format, ...)                                                                              \
+    do {                                                                                                                \
+        if (!(condition)) {                                                                                             \
+            fprintf(stderr, "%s:%d: check failed: " format "\n", __FILE__, __LINE__, ##__VA_ARGS__);                    \
+            s_failures++;                                                                                               \
+        }                                                                                                               \
+    } while (0)
+
+static uint32_t s_failures = 0;
+
+static bool add_velocity(WindEstimator *p_wind, double east_mps, double north_mps) {
+    double track_deg = fmod(atan2(east_mps, north_mps) * 180.0 / M_PI + 360.0, 360.0);
+    return p_wind->AddVelocity((float)track_deg, (float)hypot(east_mps, north_mps));
+}
+
+static void check_wind_estimator() {
+    // The ground velocities of a circle lie on a circle around the wind, with the airspeed as radius.
+    WindEstimator circle(32, 300.0f);
+    uint32_t fits = 0;
+    for (double heading_deg = 0.0; heading_deg < 720.0; heading_deg += HOST_WIND_HEADING_STEP_DEG) {
+        double heading_rad = heading_deg * M_PI / 180.0;
+        fits += add_velocity(&circle, HOST_WIND_AIRSPEED_MPS * sin(heading_rad) + HOST_WIND_EAST_MPS, HOST_WIND_AIRSPEED_MPS * cos(heading_rad) + HOST_WIND_NORTH_MPS) ? 1 : 0;
+    }
+    printf("wind: %u fits of the circles, %.3f m/s east %.3f m/s north, airspeed %.3f m/s\n", fits, circle.GetWindEast(), circle.GetWindNorth(), circle.GetAirspeed());
+    HOST_CHECK(fits > 0 && circle.IsValid(), "no wind fitted to the circles");
+    HOST_CHECK(fabs(circle.GetWindEast() - HOST_WIND_EAST_MPS) < HOST_WIND_TOLERANCE_MPS && fabs(circle.GetWindNorth() - HOST_WIND_NORTH_MPS) < HOST_WIND_TOLERANCE_MPS,
+        "wind %.3f m/s east %.3f m/s north", circle.GetWindEast(), circle.GetWindNorth());
+    HOST_CHECK(fabs(circle.GetAirspeed() - HOST_WIND_AIRSPEED_MPS) < HOST_WIND_TOLERANCE_MPS, "airspeed %.3f m/s", circle.GetAirspeed());
+    HOST_CHECK(fabsf(circle.GetWindDirection() - (float)(atan2(-HOST_WIND_EAST_MPS, -HOST_WIND_NORTH_MPS) * 180.0 / M_PI + 360.0)) < 1.0f, "wind from %.1f degrees", circle.GetWindDirection());
+
+    // A straight glide out of the thermal, once the circles left the window it is not fitted and the wind is kept.
+    for (int i = 0; i < 64; i++) {
+        (void)add_velocity(&circle, HOST_WIND_AIRSPEED_MPS + HOST_WIND_EAST_MPS, HOST_WIND_NORTH_MPS);
+    }
+    HOST_CHECK(circle.IsValid() && circle.GetAge() >= 32, "straight glide fitted %u fixes ago", circle.GetAge());
+    HOST_CHECK(fabs(circle.GetWindEast() - HOST_WIND_EAST_MPS) < HOST_WIND_TOLERANCE_MPS && fabs(circle.GetWindNorth() - HOST_WIND_NORTH_MPS) < HOST_WIND_TOLERANCE_MPS,
+        "wind %.3f m/s east %.3f m/s north after a straight glide", circle.GetWindEast(), circle.GetWindNorth());
+
+    // Without a turn to wait for, the fit itself refuses the fixes of a straight track, all on one point.
+    WindEstimator straight(16, 0.0f);
+    fits = 0;
+    for (int i = 0; i < 32; i++) {
+        fits += straight.AddVelocity(90.0f, 10.0f) ? 1 : 0;
+    }
+    HOST_CHECK(fits == 0 && !straight.IsValid(), "%u fits of a straight track", fits);
+
+    // Every other fix at 14 m/s instead of 10 m/s, the fixes sit 2 m/s off the circle between, more than the residual.
+    WindEstimator rings(32, 300.0f);
+    fits = 0;
+    for (int i = 0; i < 64; i++) {
+        double heading_rad = i * HOST_WIND_HEADING_STEP_DEG * M_PI / 180.0;
+        double airspeed = HOST_WIND_AIRSPEED_MPS + ((i % 2) ? 4.0 : 0.0);
+        fits += add_velocity(&rings, airspeed * sin(heading_rad) + HOST_WIND_EAST_MPS, airspeed * cos(heading_rad) + HOST_WIND_NORTH_MPS) ? 1 : 0;
+    }
+    HOST_CHECK(fits == 0 && !rings.IsValid(), "%u fits of fixes off the circle", fits);
+
+    // A turn of 120 degrees with the fixes on a line, no circle goes through them.
+    WindEstimator line(16, 90.0f);
+    fits = 0;
+    for (double track_deg = 30.0; track_deg <= 150.0; track_deg += 8.0) {
+        fits += line.AddVelocity((float)track_deg, (float)(5.0 / sin(track_deg * M_PI / 180.0))) ? 1 : 0;
+    }
+    HOST_CHECK(fits == 0 && !line.IsValid(), "%u fits of fixes on a line", fits);
+}
+
+static void check_glider_polar() {
+    const float speeds[GLIDER_POLAR_POINTS] = {26.0f / 3.6f, 37.0f / 3.6f, 52.0f / 3.6f};
+    const float sinks[GLIDER_POLAR_POINTS] = {1.15f, 1.10f, 2.00f};
+    const float unsorted_speeds[GLIDER_POLAR_POINTS] = {speeds[2], speeds[0], speeds[1]};
+    const float unsorted_sinks[GLIDER_POLAR_POINTS] = {sinks[2], sinks[0], sinks[1]};
+
+    GliderPolar polar;
+    HOST_CHECK(polar.SetPoints(unsorted_speeds, unsorted_sinks) == ESP_OK, "valid polar refused");
+    for (int i = 0; i < GLIDER_POLAR_POINTS; i++) {
+        HOST_CHECK(fabsf(polar.GetSink(speeds[i]) - sinks[i]) < HOST_POLAR_TOLERANCE_MPS, "sink %.4f m/s at %.2f m/s, %.4f m/s expected", polar.GetSink(speeds[i]), speeds[i], sinks[i]);
+    }
+    HOST_CHECK(polar.GetMinSinkSpeed() > speeds[0] && polar.GetMinSinkSpeed() < speeds[1] && polar.GetMinSink() < sinks[1], "minimum sink %.3f m/s at %.2f m/s", polar.GetMinSink(), polar.GetMinSinkSpeed());
+    printf("polar: sink = %.5f * v^2 + %.5f * v + %.5f, minimum sink %.3f m/s at %.2f m/s\n", polar.m_a, polar.m_b, polar.m_c, polar.GetMinSink(), polar.GetMinSinkSpeed());
+
+    static const struct {
+        const char *name;
+        float speeds[GLIDER_POLAR_POINTS];
+        float sinks[GLIDER_POLAR_POINTS];
+    } invalid[] = {
+        {"two speeds too close", {8.0f, 8.2f, 14.0f}, {1.0f, 1.0f, 2.0f}},
+        {"twice the same speed", {8.0f, 14.0f, 8.0f}, {1.0f, 2.0f, 1.1f}},
+        {"a straight line", {8.0f, 11.0f, 14.0f}, {1.0f, 1.5f, 2.0f}},
+        {"bent downwards", {8.0f, 11.0f, 14.0f}, {1.0f, 1.8f, 2.0f}},
+        {"a climb in still air", {8.0f, 11.0f, 14.0f}, {0.5f, -0.2f, 0.5f}},
+    };
+    float sink = polar.GetSink(speeds[1]);
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        HOST_CHECK(polar.SetPoints(invalid[i].speeds, invalid[i].sinks) == ESP_ERR_INVALID_ARG, "polar of %s accepted", invalid[i].name);
+        HOST_CHECK(polar.GetSink(speeds[1]) == sink, "polar changed by %s", invalid[i].name);
+    }
+}
+
+/* m/s, true airspeed of the tangent from the MacCready setting over the netto, moved back by the tailwind, in double. */
+static double closed_form_speed_to_fly(const GliderPolar *p_polar, double maccready, double netto, double tailwind, double density_ratio) {
+    double u = tailwind * density_ratio;
+    double rate = (maccready - netto) * density_ratio;
+    double discriminant = u * u + (p_polar->m_c + rate - p_polar->m_b * u) / p_polar->m_a;
+    double speed = (discriminant > 0.0) ? fmax(sqrt(discriminant) - u, p_polar->GetMinSinkSpeed()) : p_polar->GetMinSinkSpeed();
+    return speed / density_ratio;
+}
+
+/* Glide ratio over the ground of a true airspeed, climbing again at the MacCready setting in the netto. */
+static double glide_ratio(const GliderPolar *p_polar, double speed, double maccready, double netto, double tailwind, double density_ratio) {
+    double sink = p_polar->GetSink((float)(speed * density_ratio)) / density_ratio;
+    return (speed + tailwind) / (sink + maccready - netto);
+}
+
+static void check_speed_to_fly() {
+    const float speeds[GLIDER_POLAR_POINTS] = {26.0f / 3.6f, 37.0f / 3.6f, 52.0f / 3.6f};
+    const float sinks[GLIDER_POLAR_POINTS] = {1.15f, 1.10f, 2.00f};
+    GliderPolar polar;
+    (void)polar.SetPoints(speeds, sinks);
+
+    static const struct {
+        float maccready;
+        float netto;
+        float tailwind;
+        float density_ratio;
+    } cases[] = {
+        {0.0f, 0.0f, 0.0f, 1.0f},
+        {1.5f, 0.0f, 0.0f, 1.0f},
+        {1.5f, -1.0f, 0.0f, 1.0f},
+        {1.0f, 0.0f, -5.0f, 1.0f},
+        {1.0f, 0.0f, 5.0f, 1.0f},
+        {2.0f, -0.5f, -3.0f, 0.8f},
+        {0.0f, 3.0f, 0.0f, 1.0f},             /* lift above the setting, the minimum sink */
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        GlideComputer glide(cases[i].maccready, 0.0f);
+        GnssRmcData_t rmc;
+        memset(&rmc, 0, sizeof(rmc));
+        rmc.course = 90.0f;
+        glide.SetWind(cases[i].tailwind, 0.0f);
+        glide.AddNetto(cases[i].netto);
+        glide.AddFix(&rmc, 1000.0f, &polar, cases[i].density_ratio);
+
+        double expected = closed_form_speed_to_fly(&polar, cases[i].maccready, cases[i].netto, cases[i].tailwind, cases[i].density_ratio);
+        double speed = glide.GetSpeedToFly();
+        printf("speed to fly: maccready %.1f m/s, netto %+.1f m/s, tailwind %+.1f m/s, density ratio %.2f: %.3f m/s, closed form %.3f m/s\n",
+            cases[i].maccready, cases[i].netto, cases[i].tailwind, cases[i].density_ratio, speed, expected);
+        HOST_CHECK(fabs(speed - expected) < HOST_STF_TOLERANCE_MPS, "speed to fly %.3f m/s, closed form %.3f m/s", speed, expected);
+        HOST_CHECK(speed * cases[i].density_ratio >= polar.GetMinSinkSpeed() - HOST_STF_TOLERANCE_MPS, "speed to fly %.3f m/s below the minimum sink", speed);
+        // Faster or slower glides worse, unless the glider is held at the minimum sink or the lift carries it.
+        double ratio = glide_ratio(&polar, speed, cases[i].maccready, cases[i].netto, cases[i].tailwind, cases[i].density_ratio);
+        double faster = glide_ratio(&polar, speed + HOST_STF_SEARCH_STEP_MPS, cases[i].maccready, cases[i].netto, cases[i].tailwind, cases[i].density_ratio);
+        double slower = glide_ratio(&polar, speed - HOST_STF_SEARCH_STEP_MPS, cases[i].maccready, cases[i].netto, cases[i].tailwind, cases[i].density_ratio);
+        bool at_min_sink = fabs(speed * cases[i].density_ratio - polar.GetMinSinkSpeed()) < HOST_STF_TOLERANCE_MPS;
+        HOST_CHECK(at_min_sink || cases[i].maccready < cases[i].netto || (ratio >= faster && ratio >= slower), "glide %.3f at the speed to fly, %.3f faster, %.3f slower", ratio, faster, slower);
+    }
+}
+
+static void check_climb_averager() {
+    ClimbAverager averager(HOST_CLIMB_SHORT_WINDOW_MS, HOST_CLIMB_LONG_WINDOW_MS);
+    uint32_t timestamp = 0;
+    uint32_t reports = 0;
+    for (; timestamp < 20000; timestamp += HOST_CLIMB_PERIOD_MS) {
+        reports += averager.AddSample(2.0f, 1000.0f + timestamp / 500.0f, timestamp) ? 1 : 0;
+    }
+    HOST_CHECK(reports == 19, "%u reports in 20 s", reports);
+    HOST_CHECK(fabsf(averager.GetAverage(CLIMB_WINDOW_SHORT) - 2.0f) < 1e-4f && fabsf(averager.GetAverage(CLIMB_WINDOW_LONG) - 2.0f) < 1e-4f,
+        "averages %.4f and %.4f m/s of a steady 2 m/s climb", averager.GetAverage(CLIMB_WINDOW_SHORT), averager.GetAverage(CLIMB_WINDOW_LONG));
+
+    // 15 s without a sample, longer than the short window and shorter than the long one, then a second of sink.
+    uint32_t gap_end = timestamp + 15000;
+    reports = 0;
+    for (timestamp = gap_end; timestamp < gap_end + 1000; timestamp += HOST_CLIMB_PERIOD_MS) {
+        reports += averager.AddSample(-1.0f, 1040.0f - (timestamp - gap_end) / 1000.0f, timestamp) ? 1 : 0;
+    }
+    // The long window keeps the climb of its last 30 s, to a bucket.
+    uint32_t long_start = timestamp - HOST_CLIMB_LONG_WINDOW_MS;
+    double climb_samples = (20000.0 - long_start) / HOST_CLIMB_PERIOD_MS;
+    double expected_long = (2.0 * climb_samples - 1.0 * 10.0) / (climb_samples + 10.0);
+    printf("climb averages: after a 15 s gap %.3f m/s over %u s, %.3f m/s over %u s (%.3f m/s expected), %u reports in the second after it\n",
+        averager.GetAverage(CLIMB_WINDOW_SHORT), HOST_CLIMB_SHORT_WINDOW_MS / 1000, averager.GetAverage(CLIMB_WINDOW_LONG), HOST_CLIMB_LONG_WINDOW_MS / 1000, expected_long, reports);
+    HOST_CHECK(fabsf(averager.GetAverage(CLIMB_WINDOW_SHORT) + 1.0f) < 1e-4f, "short average %.4f m/s after a gap longer than its window", averager.GetAverage(CLIMB_WINDOW_SHORT));
+    HOST_CHECK(fabs(averager.GetAverage(CLIMB_WINDOW_LONG) - expected_long) < HOST_CLIMB_TOLERANCE_MPS, "long average %.4f m/s, %.4f m/s expected", averager.GetAverage(CLIMB_WINDOW_LONG), expected_long);
+    HOST_CHECK(reports == 1, "%u reports in the second after the gap", reports);
+
+    // A gap longer than both windows empties them.
+    averager.AddSample(0.5f, 1040.0f, timestamp + HOST_CLIMB_LONG_WINDOW_MS + 1000);
+    HOST_CHECK(averager.GetAverage(CLIMB_WINDOW_SHORT) == 0.5f && averager.GetAverage(CLIMB_WINDOW_LONG) == 0.5f,
+        "averages %.4f and %.4f m/s after a gap longer than the windows", averager.GetAverage(CLIMB_WINDOW_SHORT), averager.GetAverage(CLIMB_WINDOW_LONG));
+}
+
+/* A pressure of a working sensor, it changes every sample. */
+static BarometerData_t static_sample(StaticPortIndex_t port, uint32_t sample, float pressure) {
+    BarometerData_t data;
+    memset(&data, 0, sizeof(data));
+    float noise = (float)((sample * 7 + port * 3) % 5) * 0.2f - 0.4f;
+    data.pressure = pressure + ((port == STATIC_PORT_SECONDARY) ? HOST_STATIC_OFFSET_PA : 0.0f) + noise;
+    data.pressure_filterd = data.pressure;
+    data.temperature = 20.0f;
+    data.timestamp = sample * HOST_STATIC_PERIOD_MS;
+    return data;
+}
+
+static void check_redundant_static() {
+    RedundantStatic ports(REDUNDANT_STATIC_AVERAGE, HOST_STATIC_MAX_AGE_MS, HOST_STATIC_MAX_DIFFERENCE_PA);
+    uint32_t sample = 0;
+    BarometerData_t data;
+
+    // Both working, the first port drives the vario with the mean of both.
+    for (; sample < 100; sample++) {
+        data = static_sample(STATIC_PORT_PRIMARY, sample, HOST_STATIC_PRESSURE_PA);
+        HOST_CHECK(ports.AddSample(STATIC_PORT_PRIMARY, &data), "first port ignored at sample %u", sample);
+        HOST_CHECK(fabsf(data.pressure - HOST_STATIC_PRESSURE_PA) < HOST_STATIC_TOLERANCE_PA, "mean %.2f Pa at sample %u", data.pressure, sample);
+        data = static_sample(STATIC_PORT_SECONDARY, sample, HOST_STATIC_PRESSURE_PA);
+        HOST_CHECK(!ports.AddSample(STATIC_PORT_SECONDARY, &data), "standby port drove the vario at sample %u", sample);
+    }
+    HOST_CHECK(ports.GetFusedCount() == 99 && fabsf(ports.GetOffset() - HOST_STATIC_OFFSET_PA) < HOST_STATIC_TOLERANCE_PA, "%u samples averaged, offset %.2f Pa", ports.GetFusedCount(), ports.GetOffset());
+
+    // The barometer sticks, it fails on its last repeated sample and the second port takes over, moved by the offset.
+    BarometerData_t stuck = static_sample(STATIC_PORT_PRIMARY, sample, HOST_STATIC_PRESSURE_PA);
+    uint32_t stuck_sample = sample;
+    for (; sample < stuck_sample + 20; sample++) {
+        data = stuck;
+        data.timestamp = sample * HOST_STATIC_PERIOD_MS;
+        bool primary_drives = ports.AddSample(STATIC_PORT_PRIMARY, &data);
+        data = static_sample(STATIC_PORT_SECONDARY, sample, HOST_STATIC_PRESSURE_PA);
+        bool secondary_drives = ports.AddSample(STATIC_PORT_SECONDARY, &data);
+        if (sample >= stuck_sample + REDUNDANT_STATIC_STUCK_SAMPLES) {
+            HOST_CHECK(!primary_drives && secondary_drives, "stuck barometer still driving at sample %u", sample);
+            HOST_CHECK(fabsf(data.pressure - HOST_STATIC_PRESSURE_PA) < HOST_STATIC_TOLERANCE_PA, "second port %.2f Pa off the barometer", data.pressure - HOST_STATIC_PRESSURE_PA);
+        }
+    }
+    printf("static ports: offset %.2f Pa, barometer stuck at %u ms failed at %u ms\n", ports.GetOffset(), stuck_sample * HOST_STATIC_PERIOD_MS, ports.GetFailedTimestamp(STATIC_PORT_PRIMARY));
+    HOST_CHECK(ports.IsFailed(STATIC_PORT_PRIMARY) && ports.GetFailedTimestamp(STATIC_PORT_PRIMARY) == (stuck_sample + REDUNDANT_STATIC_STUCK_SAMPLES) * HOST_STATIC_PERIOD_MS,
+        "barometer %s at %u ms", ports.IsFailed(STATIC_PORT_PRIMARY) ? "failed" : "working", ports.GetFailedTimestamp(STATIC_PORT_PRIMARY));
+
+    // It recovers on a pressure of its own, the second port goes out of the range of flight, the barometer drives alone.
+    data = static_sample(STATIC_PORT_PRIMARY, sample, HOST_STATIC_PRESSURE_PA - 1.0f);
+    HOST_CHECK(ports.AddSample(STATIC_PORT_PRIMARY, &data) && !ports.IsFailed(STATIC_PORT_PRIMARY), "barometer not recovered");
+    data = static_sample(STATIC_PORT_SECONDARY, sample, REDUNDANT_STATIC_MAX_PRESSURE);
+    HOST_CHECK(!ports.AddSample(STATIC_PORT_SECONDARY, &data) && ports.IsFailed(STATIC_PORT_SECONDARY), "second port above %.0f Pa not failed", REDUNDANT_STATIC_MAX_PRESSURE);
+    sample++;
+    uint32_t fused_count = ports.GetFusedCount();
+    data = static_sample(STATIC_PORT_PRIMARY, sample, HOST_STATIC_PRESSURE_PA);
+    float pressure = data.pressure;
+    HOST_CHECK(ports.AddSample(STATIC_PORT_PRIMARY, &data) && data.pressure == pressure && ports.GetFusedCount() == fused_count, "failed second port averaged in");
+
+    // The second port works again, then stops sending, the barometer drives alone once its last sample is too old.
+    data = static_sample(STATIC_PORT_SECONDARY, sample, HOST_STATIC_PRESSURE_PA);
+    (void)ports.AddSample(STATIC_PORT_SECONDARY, &data);
+    HOST_CHECK(!ports.IsFailed(STATIC_PORT_SECONDARY), "second port not recovered");
+    uint32_t last_sample = sample;
+    for (sample++; sample <= last_sample + HOST_STATIC_MAX_AGE_MS / HOST_STATIC_PERIOD_MS + 1; sample++) {
+        fused_count = ports.GetFusedCount();
+        data = static_sample(STATIC_PORT_PRIMARY, sample, HOST_STATIC_PRESSURE_PA);
+        (void)ports.AddSample(STATIC_PORT_PRIMARY, &data);
+        bool fresh = (sample - last_sample) * HOST_STATIC_PERIOD_MS <= HOST_STATIC_MAX_AGE_MS;
+        HOST_CHECK((ports.GetFusedCount() > fused_count) == fresh, "second port %u ms old %s", (sample - last_sample) * HOST_STATIC_PERIOD_MS, fresh ? "not averaged" : "averaged");
+    }
+}
+
+/* Pressure of a sensor drifting with its temperature, and a little noise of its own. */
+static BarometerData_t drift_sample(uint32_t sample, float pa_per_c) {
+    BarometerData_t data;
+    memset(&data, 0, sizeof(data));
+    data.temperature = HOST_DRIFT_START_C + HOST_DRIFT_WARMING_C * sample / HOST_DRIFT_SAMPLES;
+    data.pressure = HOST_DRIFT_PRESSURE_PA + pa_per_c * (data.temperature - HOST_DRIFT_START_C) + HOST_DRIFT_NOISE_PA * sinf(sample * 1.7f);
+    data.pressure_filterd = data.pressure;
+    data.timestamp = sample * 100;
+    return data;
+}
+
+static void check_temperature_drift() {
+    TemperatureDrift ground(HOST_DRIFT_MIN_SPAN_C, false);
+    BarometerData_t data;
+    uint32_t learned_sample = HOST_DRIFT_SAMPLES;
+    for (uint32_t sample = 0; sample < HOST_DRIFT_SAMPLES; sample++) {
+        data = drift_sample(sample, HOST_DRIFT_PA_PER_C);
+        ground.AddSample(&data, true);
+        if (ground.IsLearned() && learned_sample == HOST_DRIFT_SAMPLES) {
+            learned_sample = sample;
+        }
+    }
+    float learned_span = HOST_DRIFT_WARMING_C * learned_sample / HOST_DRIFT_SAMPLES;
+    printf("temperature drift: %+.3f Pa/C learned over %.2f C on the ground, variance %.5f, last pressure %.2f Pa corrected by %+.2f Pa\n",
+        ground.GetCoefficient(), learned_span, ground.GetVariance(), data.pressure, ground.GetCorrection());
+    HOST_CHECK(ground.IsLearned() && learned_span > HOST_DRIFT_MIN_SPAN_C - 0.05f && learned_span < HOST_DRIFT_MIN_SPAN_C + 0.1f, "learned over %.2f C", learned_span);
+    HOST_CHECK(fabsf(ground.GetCoefficient() - HOST_DRIFT_PA_PER_C) < HOST_DRIFT_COEFFICIENT_TOLERANCE, "drift %.3f Pa/C, %.3f Pa/C expected", ground.GetCoefficient(), HOST_DRIFT_PA_PER_C);
+    HOST_CHECK(ground.GetVariance() < TEMPERATURE_DRIFT_INITIAL_VARIANCE / 100.0f, "variance %.5f of the ground fit", ground.GetVariance());
+    HOST_CHECK(fabsf(data.pressure - HOST_DRIFT_PRESSURE_PA) < 2.0f * HOST_DRIFT_NOISE_PA, "corrected pressure %.2f Pa, %.2f Pa true", data.pressure, HOST_DRIFT_PRESSURE_PA);
+
+    // A drift beyond the largest one believed is clamped to it.
+    TemperatureDrift large(HOST_DRIFT_MIN_SPAN_C, false);
+    for (uint32_t sample = 0; sample < HOST_DRIFT_SAMPLES; sample++) {
+        data = drift_sample(sample, 50.0f);
+        large.AddSample(&data, true);
+    }
+    HOST_CHECK(large.IsLearned() && large.GetCoefficient() == TEMPERATURE_DRIFT_MAX_COEFFICIENT, "drift of 50 Pa/C learned as %.3f Pa/C", large.GetCoefficient());
+
+    // In flight the true pressure moves, nothing is fitted to it without the GNSS.
+    TemperatureDrift flight(HOST_DRIFT_MIN_SPAN_C, false);
+    for (uint32_t sample = 0; sample < HOST_DRIFT_SAMPLES; sample++) {
+        data = drift_sample(sample, HOST_DRIFT_PA_PER_C);
+        float pressure = data.pressure;
+        flight.AddSample(&data, false);
+        HOST_CHECK(data.pressure == pressure, "pressure corrected in flight before a drift was learned");
+    }
+    HOST_CHECK(!flight.IsLearned(), "drift learned in flight without the GNSS");
+}
+
+static const struct {
+    const char *name;
+    void (*check)();
+} s_utilities[] = {
+    {"wind", check_wind_estimator},
+    {"polar", check_glider_polar},
+    {"speed_to_fly", check_speed_to_fly},
+    {"climb_average", check_climb_averager},
+    {"static_port", check_redundant_static},
+    {"temperature_drift", check_temperature_drift},
+};
+
+int main(int argc, char *argv[]) {
+    int option;
+
+    esp_log_level_set("*", ESP_LOG_NONE);
+    while ((option = getopt(argc, argv, "v")) != -1) {
+        switch (option) {
+        case 'v': esp_log_level_set("*", ESP_LOG_DEBUG); break;
+        default:
+            fprintf(stderr, "Usage: %s [-v] [utility ...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (int arg = optind; arg < argc; arg++) {
+        size_t i = 0;
+        while (i < sizeof(s_utilities) / sizeof(s_utilities[0]) && strcmp(argv[arg], s_utilities[i].name) != 0) {
+            i++;
+        }
+        if (i == sizeof(s_utilities) / sizeof(s_utilities[0])) {
+            fprintf(stderr, "Unknown utility %s.\n", argv[arg]);
+            return 2;
+        }
+    }
+    for (size_t i = 0; i < sizeof(s_utilities) / sizeof(s_utilities[0]); i++) {
+        bool selected = (optind == argc);
+        for (int arg = optind; arg < argc; arg++) {
+            selected = selected || (strcmp(argv[arg], s_utilities[i].name) == 0);
+        }
+        if (selected) {
+            s_utilities[i].check();
+        }
+    }
+
+    printf("%u failed checks\n", s_failures);
+    return (s_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,320 @@
+/*
+    Host vario benchmark: replay a frame recording through the host rig, keep the barometer and acceleration messages
+    the message processor receives, and run them through every engine of BluethraotVario: the two point difference of
+    the filtered pressure, the Kalman filter of the unfiltered pressure with and without the vertical acceleration, and,
+    when the recording has BMI270 frames, the inertial engine fed with the vertical acceleration of the IMU, and, when it
+    has anemometer frames, the Kalman filter with the total energy compensation of the airspeed.
+    For each engine the noise of the vertical speed, the rms of its change from a sample to the next divided by sqrt(2),
+    and the time per sample are reported. With the ground truth written by bluethroat_host_pipeline -g, the error and
+    lag against the true vertical speed are reported too, otherwise the lag against the two point engine. The total
+    energy engine is scored against the true vertical speed of the energy, and so is the Kalman filter next to it.
+
+    Usage: bluethroat_host_vario [-g truth.csv] [-q process noise] [-m measurement noise] [-c] [-v] frames.btr
+        -g  ground truth of a recording made by bluethroat_host_pipeline -r, one line per barometer sample
+        -q  process noise of the Kalman filters in cm/s^2 (cm/s^3 with the acceleration), CONFIG_VARIO_KALMAN_PROCESS_NOISE by default
+        -m  measurement noise of the Kalman filters in cm, CONFIG_VARIO_KALMAN_MEASUREMENT_NOISE by default
+        -c  exit with 1 unless the Kalman filter is less noisy than the two point engine, and, with the ground truth,
+            closer to the true vertical speed at its lag, and unless the inertial engine lags less than the Kalman filter
+            and is closer to the true vertical speed, when it runs, and unless the total energy compensation is closer
+            to the true vertical speed of the energy than the Kalman filter, when it runs
+        -v  verbose firmware log
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include <esp_log.h>
+
+#include "bluethroat_vario.h"
+#include "host_flight_generator.h"
+#include "host_rig.h"
+
+#define HOST_DEFAULT_VOLUME             (50)
+#define HOST_SCORE_SETTLE_S             (5.0)
+#define HOST_SCORE_MAX_LAG_S            (5.0)
+
+typedef struct {
+    const char *name;
+    VarioEngine_t engine;
+    KalmanVarioOrder_t order;
+    bool total_energy;
+} HostVarioCase_t;
+
+typedef enum {
+    HOST_CASE_TWO_POINT = 0,
+    HOST_CASE_KALMAN,
+    HOST_CASE_KALMAN_ACCELERATION,
+    HOST_CASE_INERTIAL,
+    HOST_CASE_TOTAL_ENERGY,
+    HOST_CASE_MAX,
+} HostVarioCaseIndex_t;
+
+static const HostVarioCase_t s_cases[HOST_CASE_MAX] = {
+    [HOST_CASE_TWO_POINT]           = {"two point",             VARIO_ENGINE_TWO_POINT, KALMAN_VARIO_ORDER_SPEED,           false},
+    [HOST_CASE_KALMAN]              = {"kalman",                VARIO_ENGINE_KALMAN,    KALMAN_VARIO_ORDER_SPEED,           false},
+    [HOST_CASE_KALMAN_ACCELERATION] = {"kalman acceleration",   VARIO_ENGINE_KALMAN,    KALMAN_VARIO_ORDER_ACCELERATION,    false},
+    [HOST_CASE_INERTIAL]            = {"inertial",              VARIO_ENGINE_INERTIAL,  KALMAN_VARIO_ORDER_SPEED,           false},
+    [HOST_CASE_TOTAL_ENERGY]        = {"kalman total energy",   VARIO_ENGINE_KALMAN,    KALMAN_VARIO_ORDER_SPEED,           true},
+};
+
+typedef struct {
+    double noise_mps;
+    double ns_per_sample;
+    HostVarioScore_t score;
+    bool ran;
+} HostVarioResult_t;
+
+static FILE *open_file(const char *file_name, const char *mode) {
+    FILE *p_file = fopen(file_name, mode);
+    if (p_file == NULL) {
+        fprintf(stderr, "Failed to open %s.\n", file_name);
+        exit(1);
+    }
+    return p_file;
+}
+
+/*
+    The true vertical speed by sample time, from the CSV written by bluethroat_host_pipeline -g, and the one of the
+    energy, the same in a file written before it had that column.
+*/
+static void load_truth(const char *file_name, std::map<uint32_t, double> *p_truth, std::map<uint32_t, double> *p_total_energy_truth) {
+    FILE *p_file = open_file(file_name, "r");
+    char line[256];
+
+    while (fgets(line, sizeof(line), p_file) != NULL) {
+        unsigned int time_ms, segment;
+        double altitude_m, vertical_speed_mps, total_energy_speed_mps;
+        int count = sscanf(line, "%u,%u,%lf,%lf,%*f,%*f,%*f,%*f,%lf", &time_ms, &segment, &altitude_m, &vertical_speed_mps, &total_energy_speed_mps);
+        if (count >= 4) {
+            (*p_truth)[time_ms] = vertical_speed_mps;
+            (*p_total_energy_truth)[time_ms] = (count == 5) ? total_energy_speed_mps : vertical_speed_mps;
+        }
+    }
+    fclose(p_file);
+}
+
+static esp_err_t replay(const char *file_name, std::vector<BluethroatMsg_t> *p_messages) {
+    FILE *p_recording = open_file(file_name, "rb");
+    FrameFileHeader_t file_header;
+    if (fread(&file_header, sizeof(file_header), 1, p_recording) != 1 || file_header.magic != FRAME_FILE_MAGIC || file_header.version != FRAME_FILE_VERSION || file_header.header_size < sizeof(FrameHeader_t) || file_header.header_size > FRAME_MAX_PAYLOAD_SIZE) {
+        fprintf(stderr, "%s is not a frame recording of version %u.\n", file_name, FRAME_FILE_VERSION);
+        fclose(p_recording);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    HostRig rig;
+    if (rig.Init(HOST_DEFAULT_VOLUME) != ESP_OK) {
+        fclose(p_recording);
+        return ESP_FAIL;
+    }
+    rig.SetMessageLog(p_messages);
+
+    uint8_t header_bytes[FRAME_MAX_PAYLOAD_SIZE];
+    uint8_t payload[FRAME_MAX_PAYLOAD_SIZE];
+    FrameHeader_t header;
+    while (fread(header_bytes, file_header.header_size, 1, p_recording) == 1) {
+        memcpy(&header, header_bytes, sizeof(header));
+        if (fread(payload, 1, header.size, p_recording) != header.size) {
+            fprintf(stderr, "Recording truncated in a frame of type %u.\n", header.type);
+            break;
+        }
+        rig.ProcessFrame(&header, payload);
+    }
+    rig.Finish();
+    rig.SetMessageLog(NULL);
+
+    fclose(p_recording);
+    return ESP_OK;
+}
+
+/*
+    The vertical speed is taken at every barometer sample, the acceleration messages in between only move the inertial
+    engine and the anemometer messages the energy height. Samples of the first seconds are left out of the noise and
+    score, the engines start from nothing.
+*/
+static void run_case(const HostVarioCase_t *p_case, float process_noise, float measurement_noise, const std::vector<BluethroatMsg_t> &messages, std::vector<double> *p_output) {
+    BluethraotVario *p_vario = g_pBluethraotVario;
+    *(p_vario->GetKalman()) = KalmanVario(p_case->order, process_noise, measurement_noise);
+    p_vario->GetInertial()->SetNoise(CONFIG_VARIO_INERTIAL_ACCELERATION_NOISE / 100.0f, CONFIG_VARIO_INERTIAL_BIAS_NOISE / 100.0f, measurement_noise);
+    *(p_vario->GetEnergy()) = KalmanVario(KALMAN_VARIO_ORDER_SPEED, process_noise, measurement_noise);
+    p_vario->SetTotalEnergy(p_case->total_energy);
+    p_vario->SetEngine(p_case->engine);
+
+    p_output->clear();
+    for (const BluethroatMsg_t &message : messages) {
+        if (message.type == BLUETHROAT_MSG_TYPE_BAROMETER_DATA) {
+            const BarometerData_t *p_sample = &(message.barometer_data);
+            p_output->push_back(p_vario->CalculateVerticalSpeed(p_sample->temperature, p_sample->pressure, p_sample->pressure_filterd, p_sample->timestamp));
+        } else if (message.type == BLUETHROAT_MSG_TYPE_ACCELERATION_DATA) {
+            p_vario->UpdateVerticalAcceleration(message.acceleration_data.vertical, message.acceleration_data.timestamp, NULL);
+        } else if (message.type == BLUETHROAT_MSG_TYPE_ANEMOMETER_DATA) {
+            const AnemometerData_t *p_sample = &(message.anemometer_data);
+            p_vario->CalculateAirspeed(p_sample->total_pressure, p_sample->static_pressure, p_sample->total_pressure_sample, p_sample->timestamp);
+        }
+    }
+}
+
+/* Per barometer sample, the acceleration messages included. */
+static double time_case(const HostVarioCase_t *p_case, float process_noise, float measurement_noise, const std::vector<BluethroatMsg_t> &messages) {
+    std::vector<double> output;
+    output.reserve(messages.size());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    run_case(p_case, process_noise, measurement_noise, messages, &output);
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    return output.empty() ? 0 : ns / output.size();
+}
+
+static double noise(const std::vector<double> &output, size_t first) {
+    double sum = 0;
+    size_t count = 0;
+    for (size_t i = first + 1; i < output.size(); i++) {
+        double change = output[i] - output[i - 1];
+        sum += change * change;
+        count++;
+    }
+    return (count > 0) ? sqrt(sum / count / 2) : 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *truth_file_name = NULL;
+    float process_noise = CONFIG_VARIO_KALMAN_PROCESS_NOISE / 100.0f;
+    float measurement_noise = CONFIG_VARIO_KALMAN_MEASUREMENT_NOISE / 100.0f;
+    bool check = false;
+    int option;
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    while ((option = getopt(argc, argv, "g:q:m:cv")) != -1) {
+        switch (option) {
+        case 'g': truth_file_name = optarg; break;
+        case 'q': process_noise = strtof(optarg, NULL) / 100.0f; break;
+        case 'm': measurement_noise = strtof(optarg, NULL) / 100.0f; break;
+        case 'c': check = true; break;
+        case 'v': esp_log_level_set("*", ESP_LOG_DEBUG); break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "Usage: %s [-g truth.csv] [-q process noise] [-m measurement noise] [-c] [-v] frames.btr\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<BluethroatMsg_t> messages;
+    std::vector<BarometerData_t> samples;
+    size_t accelerations = 0;
+    size_t airspeeds = 0;
+    if (replay(argv[optind], &messages) != ESP_OK) {
+        return 1;
+    }
+    for (const BluethroatMsg_t &message : messages) {
+        if (message.type == BLUETHROAT_MSG_TYPE_BAROMETER_DATA) {
+            samples.push_back(message.barometer_data);
+        } else if (message.type == BLUETHROAT_MSG_TYPE_ACCELERATION_DATA) {
+            accelerations++;
+        } else if (message.type == BLUETHROAT_MSG_TYPE_ANEMOMETER_DATA) {
+            airspeeds++;
+        }
+    }
+    if (samples.size() < 2) {
+        fprintf(stderr, "%s has %zu barometer samples.\n", argv[optind], samples.size());
+        return 1;
+    }
+
+    double period_s = (samples.back().timestamp - samples.front().timestamp) / 1000.0 / (samples.size() - 1);
+    size_t first = 0;
+    while (first < samples.size() && samples[first].timestamp - samples.front().timestamp < HOST_SCORE_SETTLE_S * 1000) {
+        first++;
+    }
+
+    std::map<uint32_t, double> truth_by_time;
+    std::map<uint32_t, double> total_energy_truth_by_time;
+    std::vector<double> truth;
+    std::vector<double> total_energy_truth;
+    if (truth_file_name != NULL) {
+        load_truth(truth_file_name, &truth_by_time, &total_energy_truth_by_time);
+        for (size_t i = first; i < samples.size(); i++) {
+            std::map<uint32_t, double>::const_iterator it = truth_by_time.find(samples[i].timestamp);
+            if (it == truth_by_time.end()) {
+                fprintf(stderr, "%s has no truth at %u ms.\n", truth_file_name, samples[i].timestamp);
+                return 1;
+            }
+            truth.push_back(it->second);
+            total_energy_truth.push_back(total_energy_truth_by_time[samples[i].timestamp]);
+        }
+    }
+
+    printf("%zu barometer samples, %zu acceleration messages, %zu anemometer messages, sample period %.1f ms, kalman process noise %.2f, measurement noise %.2f m\n", samples.size(), accelerations, airspeeds, period_s * 1000, process_noise, measurement_noise);
+    printf("%-22s %10s %10s %10s %12s %10s %12s\n", "engine", "noise m/s", "ns/sample", "rms m/s", "max m/s", "lag s", "rms at lag");
+
+    HostVarioResult_t results[HOST_CASE_MAX] = {};
+    HostVarioScore_t kalman_total_energy_score = {};
+    std::vector<double> reference;
+    for (size_t i = 0; i < HOST_CASE_MAX; i++) {
+        HostVarioResult_t *p_result = &(results[i]);
+        std::vector<double> output;
+        if ((i == HOST_CASE_INERTIAL && accelerations == 0) || (i == HOST_CASE_TOTAL_ENERGY && airspeeds == 0)) {
+            continue;
+        }
+
+        run_case(&(s_cases[i]), process_noise, measurement_noise, messages, &output);
+        p_result->ns_per_sample = time_case(&(s_cases[i]), process_noise, measurement_noise, messages);
+        p_result->noise_mps = noise(output, first);
+
+        std::vector<double> scored(output.begin() + first, output.end());
+        if (i == 0) {
+            reference = scored;
+        }
+        if (i == HOST_CASE_KALMAN && !truth.empty()) {
+            HostScoreVario(total_energy_truth, scored, period_s, HOST_SCORE_MAX_LAG_S, &kalman_total_energy_score);
+        }
+        HostScoreVario(truth.empty() ? reference : (s_cases[i].total_energy ? total_energy_truth : truth), scored, period_s, HOST_SCORE_MAX_LAG_S, &(p_result->score));
+        p_result->ran = true;
+        printf("%-22s %10.4f %10.1f %10.3f %12.3f %10.2f %12.3f\n", s_cases[i].name, p_result->noise_mps, p_result->ns_per_sample, p_result->score.rms_error_mps, p_result->score.max_error_mps, p_result->score.lag_s, p_result->score.lagged_rms_error_mps);
+    }
+    if (results[HOST_CASE_TOTAL_ENERGY].ran && !truth.empty()) {
+        const HostVarioScore_t *p_score = &kalman_total_energy_score;
+        printf("%-22s %10s %10s %10.3f %12.3f %10.2f %12.3f\n", "kalman, energy truth", "", "", p_score->rms_error_mps, p_score->max_error_mps, p_score->lag_s, p_score->lagged_rms_error_mps);
+    }
+    if (truth.empty()) {
+        printf("errors and lags against the two point engine\n");
+    }
+
+    bool passed = true;
+    if (check) {
+        const HostVarioResult_t *p_two_point = &(results[HOST_CASE_TWO_POINT]);
+        const HostVarioResult_t *p_kalman = &(results[HOST_CASE_KALMAN]);
+        if (p_kalman->noise_mps >= p_two_point->noise_mps) {
+            printf("kalman noise %.4f m/s not below two point noise %.4f m/s: FAIL\n", p_kalman->noise_mps, p_two_point->noise_mps);
+            passed = false;
+        }
+        if (!truth.empty() && p_kalman->score.lagged_rms_error_mps >= p_two_point->score.lagged_rms_error_mps) {
+            printf("kalman rms error %.3f m/s not below two point rms error %.3f m/s: FAIL\n", p_kalman->score.lagged_rms_error_mps, p_two_point->score.lagged_rms_error_mps);
+            passed = false;
+        }
+        const HostVarioResult_t *p_inertial = &(results[HOST_CASE_INERTIAL]);
+        if (p_inertial->ran && !truth.empty() && p_inertial->score.lag_s >= p_kalman->score.lag_s) {
+            printf("inertial lag %.2f s not below kalman lag %.2f s: FAIL\n", p_inertial->score.lag_s, p_kalman->score.lag_s);
+            passed = false;
+        }
+        if (p_inertial->ran && !truth.empty() && p_inertial->score.rms_error_mps >= p_kalman->score.rms_error_mps) {
+            printf("inertial rms error %.3f m/s not below kalman rms error %.3f m/s: FAIL\n", p_inertial->score.rms_error_mps, p_kalman->score.rms_error_mps);
+            passed = false;
+        }
+        const HostVarioResult_t *p_total_energy = &(results[HOST_CASE_TOTAL_ENERGY]);
+        if (p_total_energy->ran && !truth.empty() && p_total_energy->score.lagged_rms_error_mps >= kalman_total_energy_score.lagged_rms_error_mps) {
+            printf("total energy rms error %.3f m/s not below kalman rms error %.3f m/s against the energy: FAIL\n", p_total_energy->score.lagged_rms_error_mps, kalman_total_energy_score.lagged_rms_error_mps);
+            passed = false;
+        }
+    }
+
+    return passed ? 0 : 1;
+}
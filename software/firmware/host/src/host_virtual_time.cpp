@@ -0,0 +1,265 @@
+/*
+    Host virtual time test: runs the firmware timeouts on the virtual clock of the FreeRTOS shim (host_clock.h) and
+    checks them to the tick, almost three hours of firmware time take a few seconds.
+        - vTaskDelay for the 660 s RTC resynchronization period of the clock task
+        - queue receive timeout, and a receive woken by a task sending after a delay
+        - auto-reload timer over an hour
+        - NS4168 disable sound and power off timeouts, seen on the speaker GPIO and power off bit of the AXP192
+        - FIFO burst wakes of the barometer task on its esp_timer, to the microsecond, and the spacing of its sample
+          timestamps
+        - loop duration of the barometer task in its task statistics, the wait for the burst not counted as work
+
+    Usage: bluethroat_host_virtual_time [-v]
+        -v  verbose firmware log
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+
+#include "bluethroat_global.h"
+#include "host_clock.h"
+#include "host_i2c_bus.h"
+#include "host_i2c_models.h"
+#include "host_rig.h"
+#include "utilities/task_stats.h"
+
+#define HOST_DEFAULT_VOLUME             (50)
+#define HOST_RTC_RESYNC_PERIOD_MS       (660 * 1000)
+#define HOST_QUEUE_TIMEOUT_MS           (5000)
+#define HOST_DELAYED_SEND_MS            (3000)
+#define HOST_DELAYED_SEND_VALUE         (0x5a5a1234)
+#define HOST_TIMER_PERIOD_MS            (1000)
+#define HOST_TIMER_RUN_MS               (3600 * 1000)
+#define HOST_LIFT_SPEED                 (2.0f)
+#define HOST_LIFT_MS                    (5000)
+#define HOST_BAROMETER_SAMPLES          (10)
+#define HOST_BAROMETER_MAX_AGE_US       (2000)
+#define HOST_BAROMETER_MAX_DURATION_US  (2000)
+
+#define HOST_CHECK(condition, format, ...)                                                                              \
+    do {                                                                                                                \
+        if (!(condition)) {                                                                                             \
+            fprintf(stderr, "%s:%d: check failed: " format "\n", __FILE__, __LINE__, ##__VA_ARGS__);                    \
+            s_failures++;                                                                                               \
+        }                                                                                                               \
+    } while (0)
+
+static uint32_t s_failures = 0;
+static std::atomic<uint32_t> s_timer_calls(0);
+
+static void delay_until(TickType_t ticks) {
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(ticks - now) > 0) {
+        vTaskDelay(ticks - now);
+    }
+}
+
+static void delayed_send_task(void *param) {
+    QueueHandle_t queue = (QueueHandle_t)param;
+    uint32_t value = HOST_DELAYED_SEND_VALUE;
+
+    vTaskDelay(pdMS_TO_TICKS(HOST_DELAYED_SEND_MS));
+    (void)xQueueSend(queue, &value, 0);
+    vTaskDelete(NULL);
+}
+
+static void timer_callback(TimerHandle_t timer) {
+    (void)timer;
+    s_timer_calls++;
+}
+
+static void check_task_delay() {
+    TickType_t start = xTaskGetTickCount();
+    vTaskDelay(pdMS_TO_TICKS(HOST_RTC_RESYNC_PERIOD_MS));
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    HOST_CHECK(elapsed == pdMS_TO_TICKS(HOST_RTC_RESYNC_PERIOD_MS), "vTaskDelay took %u ticks", elapsed);
+}
+
+static void check_queue_timeout() {
+    QueueHandle_t queue = xQueueCreate(1, sizeof(uint32_t));
+    uint32_t value = 0;
+
+    TickType_t start = xTaskGetTickCount();
+    BaseType_t result = xQueueReceive(queue, &value, pdMS_TO_TICKS(HOST_QUEUE_TIMEOUT_MS));
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    HOST_CHECK(result == errQUEUE_EMPTY && elapsed == pdMS_TO_TICKS(HOST_QUEUE_TIMEOUT_MS), "receive timeout returned %d after %u ticks", result, elapsed);
+
+    start = xTaskGetTickCount();
+    xTaskCreate(delayed_send_task, "DELAYED_SEND", 2048, queue, tskIDLE_PRIORITY + 1, NULL);
+    result = xQueueReceive(queue, &value, portMAX_DELAY);
+    elapsed = xTaskGetTickCount() - start;
+    HOST_CHECK(result == pdTRUE && value == HOST_DELAYED_SEND_VALUE && elapsed == pdMS_TO_TICKS(HOST_DELAYED_SEND_MS), "delayed receive returned %d, value 0x%08x after %u ticks", result, value, elapsed);
+
+    vQueueDelete(queue);
+}
+
+static void check_timer() {
+    TimerHandle_t timer = xTimerCreate("HOST_TIMER", pdMS_TO_TICKS(HOST_TIMER_PERIOD_MS), pdTRUE, NULL, timer_callback);
+    xTimerStart(timer, 0);
+
+    // Half a period more, the last expiry and the end of the delay don't fall on the same tick.
+    vTaskDelay(pdMS_TO_TICKS(HOST_TIMER_RUN_MS + HOST_TIMER_PERIOD_MS / 2));
+    uint32_t calls = s_timer_calls;
+    HOST_CHECK(calls == HOST_TIMER_RUN_MS / HOST_TIMER_PERIOD_MS, "timer called %u times", calls);
+
+    xTimerStop(timer, 0);
+    vTaskDelay(pdMS_TO_TICKS(10 * HOST_TIMER_PERIOD_MS));
+    HOST_CHECK(s_timer_calls == calls, "stopped timer called %u times", s_timer_calls - calls);
+    xTimerDelete(timer, 0);
+}
+
+static uint8_t read_pmu_register(HostRig *p_rig, uint8_t reg_addr) {
+    uint8_t value = 0;
+    (void)p_rig->m_p_i2c_master->ReadByte(g_I2cDeviceMap[I2C_DEVICE_INDEX_AXP192_PMU].addr, reg_addr, &value);
+    return value;
+}
+
+static bool speaker_enabled(HostRig *p_rig) {
+    Axp192Gpio012LevelCtrlReg_t level_ctrl;
+    level_ctrl.byte = read_pmu_register(p_rig, AXP192_REG_ADDR_GPIO012_LEVEL_CTRL);
+    return level_ctrl.gpio2_level == 1;
+}
+
+static bool powered_off(HostRig *p_rig) {
+    Axp192PowerOffCtrlReg_t power_off_ctrl;
+    power_off_ctrl.byte = read_pmu_register(p_rig, AXP192_REG_ADDR_POWER_OFF_CTRL);
+    return power_off_ctrl.power_off == 1;
+}
+
+/* The sound task runs on its own, paced by the I2S writes, as on the device. */
+static void check_sound_timeouts(HostRig *p_rig) {
+    uint64_t bytes_per_second = (uint64_t)CONFIG_I2S_PORT_0_SAMPLE_RATE * HOST_I2S_BYTES_PER_SAMPLE;
+    TickType_t start = xTaskGetTickCount();
+    uint64_t start_bytes = p_rig->m_p_sink->m_bytes_written;
+    p_rig->m_p_sound->Start(&(g_TaskParam[TASK_INDEX_SOUND]), NULL);
+
+    SoundSetVerticalSpeed(HOST_LIFT_SPEED);
+    vTaskDelay(pdMS_TO_TICKS(HOST_LIFT_MS));
+    HOST_CHECK(speaker_enabled(p_rig), "speaker disabled in lift");
+
+    SoundSetVerticalSpeed(0.0f);
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    TickType_t last_beep = p_rig->m_p_sound->m_last_beep_time_ticks;
+    TickType_t disable_sound = last_beep + p_rig->m_p_sound->m_disable_sound_timeout_ticks;
+    TickType_t power_off = last_beep + p_rig->m_p_sound->m_power_off_timeout_ticks;
+
+    delay_until(disable_sound - pdMS_TO_TICKS(1000));
+    HOST_CHECK(speaker_enabled(p_rig), "speaker disabled %u ticks before the disable sound timeout", pdMS_TO_TICKS(1000));
+    delay_until(disable_sound + pdMS_TO_TICKS(1000));
+    HOST_CHECK(!speaker_enabled(p_rig), "speaker enabled %u ticks after the disable sound timeout", pdMS_TO_TICKS(1000));
+
+    // Every buffer takes its play time, the task never runs ahead of the stream by more than one buffer.
+    double audio_s = (double)(p_rig->m_p_sink->m_bytes_written - start_bytes) / bytes_per_second;
+    double elapsed_s = pdTICKS_TO_MS(xTaskGetTickCount() - start) / 1000.0;
+    HOST_CHECK(audio_s >= elapsed_s - 0.1 && audio_s <= elapsed_s + 0.1, "%.3f s of audio written in %.3f s", audio_s, elapsed_s);
+
+    delay_until(power_off - pdMS_TO_TICKS(1000));
+    HOST_CHECK(!powered_off(p_rig), "powered off %u ticks before the power off timeout", pdMS_TO_TICKS(1000));
+    // The task waits a second before it powers off.
+    delay_until(power_off + pdMS_TO_TICKS(2000));
+    HOST_CHECK(powered_off(p_rig), "not powered off %u ticks after the power off timeout", pdMS_TO_TICKS(2000));
+
+    printf("sound: speaker off after %.1f s, power off after %.1f s of silence\n", pdTICKS_TO_MS(disable_sound - last_beep) / 1000.0, pdTICKS_TO_MS(power_off - last_beep) / 1000.0);
+}
+
+/*
+    The barometer task against a DPS3xx model in background mode: it wakes once per burst on the wake timer, exactly a
+    burst apart to the microsecond, the samples of a burst are stamped a sample period apart and the last one is
+    received right after it was taken. The task waits for the burst inside fetch_data, its loop duration must stay
+    well below the burst period.
+*/
+static void check_barometer_waits(HostRig *p_rig) {
+    uint8_t coefs[sizeof(Dps3xxCoefRegs_t)] = {0};
+    // c00 = 80469, the pressure is constant with the other coefficients at 0.
+    coefs[3] = 0x13;
+    coefs[4] = 0xa5;
+    coefs[5] = 0x50;
+    // The task runs to the end of the test, the model stays on the bus.
+    const I2cDevice_t *p_device = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_BAROMETER]);
+    HostDps3xxModel *p_model = new HostDps3xxModel();
+    p_model->SetCoefs(coefs, sizeof(coefs));
+    HostI2cBus::GetBus(p_device->port)->Attach(p_device->addr, p_model);
+    const FrameHeader_t coef_header = {.type = FRAME_TYPE_DPS3XX_COEF, .source = (uint8_t)p_device->addr, .size = sizeof(coefs), .timestamp = 0};
+    HOST_CHECK(p_rig->ProcessFrame(&coef_header, coefs) == ESP_OK, "barometer initialization failed");
+    if (p_rig->m_p_barometer == NULL) {
+        return;
+    }
+
+    QueueHandle_t queue = xQueueCreate(BLUETHROAT_MSG_QUEUE_LENGTH, sizeof(BluethroatMsg_t));
+    p_rig->m_p_barometer->Start(&(g_TaskParam[TASK_INDEX_DPS3XX_BAROMETER]), queue);
+
+    uint32_t period_ms = p_rig->m_p_barometer->GetSamplePeriodMs();
+    int64_t burst_us = (int64_t)p_rig->m_p_barometer->GetSamplePeriodUs() * DPS3XX_FIFO_BURST_SAMPLES;
+    BluethroatMsg_t message;
+    int64_t last_us = 0;
+    int64_t last_age_us = 0;
+    uint32_t last_timestamp = 0;
+    for (int i = 0; i <= HOST_BAROMETER_SAMPLES; i++) {
+        if (xQueueReceive(queue, &message, pdMS_TO_TICKS(1000)) != pdTRUE) {
+            HOST_CHECK(false, "no barometer sample within 1 s");
+            return;
+        }
+
+        // The timestamps are in ms, the received time in us.
+        int64_t now_us = HostClockNowUs();
+        int64_t age_us = now_us - (int64_t)message.barometer_data.timestamp * 1000;
+        if (i > 0) {
+            HOST_CHECK(now_us == last_us || now_us - last_us == burst_us, "barometer sample %d after %lld us, expected 0 or %lld", i, (long long)(now_us - last_us), (long long)burst_us);
+            HOST_CHECK(message.barometer_data.timestamp - last_timestamp == period_ms, "barometer timestamp %d after %u ms", i, message.barometer_data.timestamp - last_timestamp);
+            HOST_CHECK(now_us == last_us || last_age_us < HOST_BAROMETER_MAX_AGE_US, "last barometer sample of a burst received %lld us after it was taken", (long long)last_age_us);
+        }
+        HOST_CHECK(age_us >= 0 && age_us < burst_us, "barometer sample %d received %lld us after it was taken", i, (long long)age_us);
+        last_us = now_us;
+        last_age_us = age_us;
+        last_timestamp = message.barometer_data.timestamp;
+    }
+
+    TaskStats_t stats;
+    HOST_CHECK(TaskStatsGet(TASK_INDEX_DPS3XX_BAROMETER, &stats) == ESP_OK && stats.loops > 0, "no barometer loop in the task statistics");
+    HOST_CHECK(stats.duration_max_us < HOST_BAROMETER_MAX_DURATION_US, "barometer loop of %u us, a burst every %lld us", stats.duration_max_us, (long long)burst_us);
+    printf("barometer: one sample every %u ms, a burst every %.1f ms, loop duration max %u us\n", period_ms, burst_us / 1000.0, stats.duration_max_us);
+}
+
+int main(int argc, char *argv[]) {
+    int option;
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    while ((option = getopt(argc, argv, "v")) != -1) {
+        switch (option) {
+        case 'v': esp_log_level_set("*", ESP_LOG_DEBUG); break;
+        default:
+            fprintf(stderr, "Usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Before the rig, its constructors may create timers and semaphores.
+    HostClockSetMode(HOST_CLOCK_VIRTUAL);
+    std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+
+    // Without a report timer, the statistics are only read by the barometer check.
+    TaskStats task_stats(0);
+    HostRig rig;
+    if (task_stats.Init() != ESP_OK || rig.Init(HOST_DEFAULT_VOLUME) != ESP_OK) {
+        return 1;
+    }
+
+    check_task_delay();
+    check_queue_timeout();
+    check_timer();
+    check_sound_timeouts(&rig);
+    check_barometer_waits(&rig);
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    printf("virtual time %.1f s in %.2f s, %u failed checks\n", HostClockNowUs() / 1000000.0, wall_s, s_failures);
+    return (s_failures == 0) ? 0 : 1;
+}
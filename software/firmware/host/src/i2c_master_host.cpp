@@ -0,0 +1,326 @@
+#include <string.h>
+
+#include <esp_err.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "utilities/i2c_master.h"
+#include "host_clock.h"
+#include "host_i2c_bus.h"
+
+static const char *TAG = "HOST_I2C";
+
+/***********************************************************************************************************************
+ * Register file device
+***********************************************************************************************************************/
+HostI2cRegisterFile::HostI2cRegisterFile() {
+    memset(m_registers, 0, sizeof(m_registers));
+    memset(m_write_masks, 0xff, sizeof(m_write_masks));
+}
+
+void HostI2cRegisterFile::SetRegister(uint8_t reg_addr, uint8_t value, uint8_t write_mask) {
+    m_registers[reg_addr] = value;
+    m_write_masks[reg_addr] = write_mask;
+}
+
+void HostI2cRegisterFile::SetRegisters(uint8_t reg_addr, const uint8_t *values, uint16_t size, uint8_t write_mask) {
+    for (uint16_t i = 0; i < size; i++) {
+        this->SetRegister((uint8_t)(reg_addr + i), values[i], write_mask);
+    }
+}
+
+esp_err_t HostI2cRegisterFile::Read(uint32_t reg_addr, uint8_t *buffer, uint16_t size) {
+    uint8_t address = (uint8_t)(reg_addr & HOST_I2C_REG_ADDR_MASK);
+    for (uint16_t i = 0; i < size; i++) {
+        buffer[i] = m_registers[(uint8_t)(address + i)];
+    }
+    return ESP_OK;
+}
+
+esp_err_t HostI2cRegisterFile::Write(uint32_t reg_addr, const uint8_t *buffer, uint16_t size) {
+    uint8_t address = (uint8_t)(reg_addr & HOST_I2C_REG_ADDR_MASK);
+    for (uint16_t i = 0; i < size; i++) {
+        uint8_t index = (uint8_t)(address + i);
+        m_registers[index] = (m_registers[index] & ~m_write_masks[index]) | (buffer[i] & m_write_masks[index]);
+    }
+    return ESP_OK;
+}
+
+/***********************************************************************************************************************
+ * Bus
+***********************************************************************************************************************/
+HostI2cBus HostI2cBus::m_bus[I2C_NUM_MAX];
+
+HostI2cBus::HostI2cBus() : m_random(HOST_I2C_DEFAULT_SEED) {
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_timing = {.clock_hz = 100000, .overhead_us = 0, .blocking = false};
+}
+
+HostI2cBus *HostI2cBus::GetBus(i2c_port_t port) {
+    if (port >= 0 && port < I2C_NUM_MAX) {
+        return &(m_bus[port]);
+    } else {
+        return NULL;
+    }
+}
+
+void HostI2cBus::Attach(uint16_t device_addr, HostI2cDevice *p_device) {
+    m_devices[device_addr] = p_device;
+}
+
+void HostI2cBus::Detach(uint16_t device_addr) {
+    m_devices.erase(device_addr);
+}
+
+HostI2cDevice *HostI2cBus::Find(uint16_t device_addr) {
+    std::map<uint16_t, HostI2cDevice *>::iterator it = m_devices.find(device_addr);
+    return (it != m_devices.end()) ? it->second : NULL;
+}
+
+void HostI2cBus::SetTiming(const HostI2cTiming_t *p_timing) {
+    m_timing = *p_timing;
+}
+
+void HostI2cBus::SetFault(uint16_t device_addr, const HostI2cFault_t *p_fault) {
+    m_faults[device_addr] = *p_fault;
+}
+
+void HostI2cBus::ClearFaults(uint32_t seed) {
+    m_faults.clear();
+    m_random.seed(seed);
+}
+
+void HostI2cBus::ResetStats() {
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_device_stats.clear();
+}
+
+void HostI2cBus::GetStats(uint16_t device_addr, HostI2cStats_t *p_stats) {
+    std::map<uint16_t, HostI2cStats_t>::iterator it = m_device_stats.find(device_addr);
+    if (it != m_device_stats.end()) {
+        *p_stats = it->second;
+    } else {
+        memset(p_stats, 0, sizeof(HostI2cStats_t));
+    }
+}
+
+esp_err_t HostI2cBus::Probe(uint16_t device_addr, TickType_t timeout) {
+    HostI2cStats_t delta = {.transactions = 1, .probes = 1};
+    esp_err_t result = this->inject_fault(device_addr);
+    if (result == ESP_OK && this->Find(device_addr) == NULL) {
+        result = ESP_FAIL;
+    }
+
+    delta.busy_us = this->duration_us(result, 2 + HOST_I2C_CLOCKS_PER_BYTE * this->address_bytes(device_addr), timeout);
+    delta.nacks = (result == ESP_FAIL) ? 1 : 0;
+    delta.timeouts = (result == ESP_ERR_TIMEOUT) ? 1 : 0;
+    this->account(device_addr, &delta);
+
+    return result;
+}
+
+esp_err_t HostI2cBus::Read(uint16_t device_addr, uint32_t reg_addr, uint8_t *buffer, uint16_t size, TickType_t timeout) {
+    HostI2cStats_t delta = {.transactions = 1};
+    HostI2cDevice *p_device = this->Find(device_addr);
+    esp_err_t result = this->inject_fault(device_addr);
+    if (result == ESP_OK) {
+        result = (p_device != NULL) ? p_device->Read(reg_addr, buffer, size) : ESP_FAIL;
+    }
+
+    // Register address phase, then a repeated start and the data phase.
+    uint32_t clocks = 2 + HOST_I2C_CLOCKS_PER_BYTE * (this->address_bytes(device_addr) + size);
+    if (!(reg_addr & HOST_I2C_NO_REG_FLAG)) {
+        clocks += 1 + HOST_I2C_CLOCKS_PER_BYTE * (this->address_bytes(device_addr) + this->register_bytes(reg_addr));
+    }
+    delta.busy_us = this->duration_us(result, clocks, timeout);
+    delta.read_bytes = (result == ESP_OK) ? size : 0;
+    delta.nacks = (result == ESP_FAIL) ? 1 : 0;
+    delta.timeouts = (result == ESP_ERR_TIMEOUT) ? 1 : 0;
+    this->account(device_addr, &delta);
+
+    return result;
+}
+
+esp_err_t HostI2cBus::Write(uint16_t device_addr, uint32_t reg_addr, const uint8_t *buffer, uint16_t size, TickType_t timeout) {
+    HostI2cStats_t delta = {.transactions = 1};
+    HostI2cDevice *p_device = this->Find(device_addr);
+    esp_err_t result = this->inject_fault(device_addr);
+    if (result == ESP_OK) {
+        result = (p_device != NULL) ? p_device->Write(reg_addr, buffer, size) : ESP_FAIL;
+    }
+
+    uint32_t clocks = 2 + HOST_I2C_CLOCKS_PER_BYTE * (this->address_bytes(device_addr) + this->register_bytes(reg_addr) + size);
+    delta.busy_us = this->duration_us(result, clocks, timeout);
+    delta.write_bytes = (result == ESP_OK) ? size : 0;
+    delta.nacks = (result == ESP_FAIL) ? 1 : 0;
+    delta.timeouts = (result == ESP_ERR_TIMEOUT) ? 1 : 0;
+    this->account(device_addr, &delta);
+
+    return result;
+}
+
+esp_err_t HostI2cBus::inject_fault(uint16_t device_addr) {
+    std::map<uint16_t, HostI2cFault_t>::iterator it = m_faults.find(device_addr);
+    if (it == m_faults.end()) {
+        return ESP_OK;
+    }
+
+    HostI2cFault_t *p_fault = &(it->second);
+    if (p_fault->after_count > 0) {
+        p_fault->after_count--;
+        return ESP_OK;
+    } else if (p_fault->nack_count > 0) {
+        p_fault->nack_count--;
+        return ESP_FAIL;
+    } else if (p_fault->timeout_count > 0) {
+        p_fault->timeout_count--;
+        return ESP_ERR_TIMEOUT;
+    } else if (p_fault->nack_probability <= 0 && p_fault->timeout_probability <= 0) {
+        return ESP_OK;
+    }
+
+    double draw = std::uniform_real_distribution<double>(0.0, 1.0)(m_random);
+    if (draw < p_fault->nack_probability) {
+        return ESP_FAIL;
+    } else if (draw < p_fault->nack_probability + p_fault->timeout_probability) {
+        return ESP_ERR_TIMEOUT;
+    } else {
+        return ESP_OK;
+    }
+}
+
+uint32_t HostI2cBus::address_bytes(uint16_t device_addr) const {
+    return (device_addr & HOST_I2C_ADDR_10_BIT_FLAG) ? 2 : 1;
+}
+
+uint32_t HostI2cBus::register_bytes(uint32_t reg_addr) const {
+    if (reg_addr & HOST_I2C_NO_REG_FLAG) {
+        return 0;
+    } else {
+        return (reg_addr & HOST_I2C_REG_16_BIT_FLAG) ? 2 : 1;
+    }
+}
+
+/* A NACK stops the command link after the first address byte, a timeout holds the bus for the whole timeout. */
+uint64_t HostI2cBus::duration_us(esp_err_t result, uint32_t clocks, TickType_t timeout) const {
+    if (result == ESP_ERR_TIMEOUT) {
+        return (uint64_t)timeout * portTICK_PERIOD_MS * 1000;
+    } else if (result == ESP_FAIL) {
+        clocks = 2 + HOST_I2C_CLOCKS_PER_BYTE;
+    }
+    return m_timing.overhead_us + ((uint64_t)clocks * 1000000 + m_timing.clock_hz - 1) / m_timing.clock_hz;
+}
+
+void HostI2cBus::account(uint16_t device_addr, const HostI2cStats_t *p_delta) {
+    HostI2cStats_t *p_stats[2] = {&m_stats, &(m_device_stats[device_addr])};
+    for (HostI2cStats_t *p : p_stats) {
+        p->transactions += p_delta->transactions;
+        p->probes += p_delta->probes;
+        p->read_bytes += p_delta->read_bytes;
+        p->write_bytes += p_delta->write_bytes;
+        p->nacks += p_delta->nacks;
+        p->timeouts += p_delta->timeouts;
+        p->busy_us += p_delta->busy_us;
+    }
+
+    if (m_timing.blocking) {
+        HostClockSleepUntilUs(HostClockNowUs() + (int64_t)p_delta->busy_us);
+    }
+}
+
+/***********************************************************************************************************************
+ * I2cMaster implementation on the host bus.
+ * Locking follows the device implementation, the transactions and their timing are left to the bus of the port.
+***********************************************************************************************************************/
+I2cMaster * I2cMaster::m_instance[I2C_NUM_MAX] = {NULL};
+
+I2cMaster::I2cMaster(i2c_port_t port, int sda_io_num, int scl_io_num, bool sda_pullup_en, bool scl_pullup_en, uint32_t clk_speed, uint16_t lock_timeout, uint16_t timeout) : m_mutex(NULL) {
+    (void)this->init_controller(port, sda_io_num, scl_io_num, sda_pullup_en, scl_pullup_en, clk_speed, lock_timeout, timeout);
+}
+
+I2cMaster::~I2cMaster() {
+    (void)this->deinit_controller();
+}
+
+esp_err_t I2cMaster::init_controller(i2c_port_t port, int sda_io_num, int scl_io_num, bool sda_pullup_en, bool scl_pullup_en, uint32_t clk_speed, uint16_t lock_timeout, uint16_t timeout) {
+    (void)sda_io_num; (void)scl_io_num; (void)sda_pullup_en; (void)scl_pullup_en;
+
+    if (port < 0 || port >= I2C_NUM_MAX || I2cMaster::m_instance[port] != NULL) {
+        ESP_LOGE(TAG, "I2C port %d is invalid or has already binded.", port);
+        return ESP_FAIL;
+    }
+
+    I2cMaster::m_instance[port] = this;
+    this->m_port = port;
+    this->m_lock_timeout = pdMS_TO_TICKS(lock_timeout);
+    this->m_timeout = pdMS_TO_TICKS(timeout);
+    this->m_mutex = xSemaphoreCreateMutex();
+    HostI2cBus::GetBus(port)->m_timing.clock_hz = clk_speed;
+
+    return (this->m_mutex != NULL) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t I2cMaster::deinit_controller() {
+    if (this->m_port >= 0 && this->m_port < I2C_NUM_MAX && I2cMaster::m_instance[this->m_port] == this) {
+        I2cMaster::m_instance[this->m_port] = NULL;
+    }
+
+    if (this->m_mutex != NULL) {
+        vSemaphoreDelete(this->m_mutex);
+        this->m_mutex = NULL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t I2cMaster::lock() {
+    return (xSemaphoreTake(this->m_mutex, this->m_lock_timeout) == pdTRUE) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t I2cMaster::unlock() {
+    return (xSemaphoreGive(this->m_mutex) == pdTRUE) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t I2cMaster::ProbeDevice(uint16_t device_addr) {
+    if (this->lock() != ESP_OK) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    esp_err_t result = HostI2cBus::GetBus(this->m_port)->Probe(device_addr, this->m_timeout);
+    this->unlock();
+
+    return result;
+}
+
+esp_err_t I2cMaster::ReadBuffer(uint16_t device_addr, uint32_t reg_addr, uint8_t *buffer, uint16_t size) {
+    if (this->lock() != ESP_OK) {
+        ESP_LOGE(TAG, "Lock could not be obtained for port %d.", this->m_port);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    esp_err_t result = HostI2cBus::GetBus(this->m_port)->Read(device_addr, reg_addr, buffer, size, this->m_timeout);
+    this->unlock();
+
+    return result;
+}
+
+esp_err_t I2cMaster::WriteBuffer(uint16_t device_addr, uint32_t reg_addr, const uint8_t *buffer, uint16_t size) {
+    if (this->lock() != ESP_OK) {
+        ESP_LOGE(TAG, "Lock could not be obtained for port %d.", this->m_port);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    esp_err_t result = HostI2cBus::GetBus(this->m_port)->Write(device_addr, reg_addr, buffer, size, this->m_timeout);
+    this->unlock();
+
+    return result;
+}
+
+esp_err_t I2cMaster::ReadByte(uint16_t device_addr, uint32_t reg_addr, uint8_t *p_byte) {
+    return this->ReadBuffer(device_addr, reg_addr, p_byte, sizeof(uint8_t));
+}
+
+esp_err_t I2cMaster::WriteByte(uint16_t device_addr, uint32_t reg_addr, const uint8_t byte_value) {
+    return this->WriteBuffer(device_addr, reg_addr, &byte_value, sizeof(uint8_t));
+}
@@ -0,0 +1,120 @@
+#include <esp_err.h>
+#include <esp_log.h>
+
+#include "utilities/i2s_master.h"
+#include "host_clock.h"
+#include "host_i2s_sink.h"
+
+struct HostI2sChannel {
+    i2s_port_t port;
+    uint32_t sample_rate;
+    int64_t play_end_us;
+};
+
+static HostI2sChannel s_channels[SOC_I2S_NUM] = {{I2S_NUM_0, 0, 0}, {I2S_NUM_1, 0, 0}};
+
+/***********************************************************************************************************************
+ * Sink
+***********************************************************************************************************************/
+HostI2sSink HostI2sSink::m_sink[SOC_I2S_NUM];
+
+HostI2sSink::HostI2sSink() : m_bytes_written(0), m_hash(HOST_I2S_FNV1A_OFFSET_BASIS), m_p_capture_file(NULL) {
+}
+
+HostI2sSink *HostI2sSink::GetSink(i2s_port_t port) {
+    if (port >= 0 && port < SOC_I2S_NUM) {
+        return &(m_sink[port]);
+    } else {
+        return NULL;
+    }
+}
+
+void HostI2sSink::Reset() {
+    m_bytes_written = 0;
+    m_hash = HOST_I2S_FNV1A_OFFSET_BASIS;
+}
+
+void HostI2sSink::Capture(FILE *p_file) {
+    m_p_capture_file = p_file;
+}
+
+esp_err_t HostI2sSink::Write(const void *src, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)src;
+    uint64_t hash = m_hash;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * HOST_I2S_FNV1A_PRIME;
+    }
+    m_hash = hash;
+    m_bytes_written += size;
+
+    if (m_p_capture_file != NULL && fwrite(src, 1, size, m_p_capture_file) != size) {
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+/***********************************************************************************************************************
+ * I2S channel functions and I2sMaster implementation on the host sink.
+ * In real time mode writes never block, the caller decides how the audio stream is paced against the sensor samples.
+ * On the virtual clock a write waits until the previous one is played, like a full DMA buffer on the device, so the
+ * sound task is paced by the audio it writes.
+***********************************************************************************************************************/
+esp_err_t i2s_channel_write(i2s_chan_handle_t handle, const void *src, size_t size, size_t *bytes_written, uint32_t timeout_ms) {
+    (void)timeout_ms;
+
+    if (handle == NULL) {
+        *bytes_written = 0;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (HostClockGetMode() == HOST_CLOCK_VIRTUAL && handle->sample_rate > 0) {
+        HostClockSleepUntilUs(handle->play_end_us);
+        // After an underrun the DMA starts again with this buffer.
+        int64_t now_us = HostClockNowUs();
+        handle->play_end_us = (handle->play_end_us > now_us) ? handle->play_end_us : now_us;
+        handle->play_end_us += (int64_t)size * 1000000 / ((int64_t)handle->sample_rate * HOST_I2S_BYTES_PER_SAMPLE);
+    }
+
+    esp_err_t result = HostI2sSink::GetSink(handle->port)->Write(src, size);
+    *bytes_written = (result == ESP_OK) ? size : 0;
+    return result;
+}
+
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void *dest, size_t size, size_t *bytes_read, uint32_t timeout_ms) {
+    (void)handle; (void)dest; (void)size; (void)timeout_ms;
+
+    *bytes_read = 0;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+I2sMaster::I2sMaster(i2s_port_t port, gpio_num_t mclk_pin, gpio_num_t bclk_pin, gpio_num_t ws_pin, gpio_num_t din_pin, gpio_num_t dout_pin, uint32_t sample_rate, i2s_data_bit_width_t bit_per_sample, uint8_t channel_num) {
+    m_read_handle = NULL;
+    m_write_handle = NULL;
+    (void)this->init_controller(port, mclk_pin, bclk_pin, ws_pin, din_pin, dout_pin, sample_rate, bit_per_sample, channel_num);
+}
+
+I2sMaster::~I2sMaster() {
+    (void)this->deinit_controller();
+}
+
+esp_err_t I2sMaster::init_controller(i2s_port_t port, gpio_num_t mclk_pin, gpio_num_t bclk_pin, gpio_num_t ws_pin, gpio_num_t din_pin, gpio_num_t dout_pin, uint32_t sample_rate, i2s_data_bit_width_t bit_per_sample, uint8_t channel_num) {
+    (void)mclk_pin; (void)bclk_pin; (void)ws_pin; (void)din_pin; (void)dout_pin; (void)bit_per_sample; (void)channel_num;
+
+    if (port < 0 || port >= SOC_I2S_NUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_channels[port].sample_rate = sample_rate;
+    s_channels[port].play_end_us = 0;
+    m_port = port;
+    m_read_handle = &(s_channels[port]);
+    m_write_handle = &(s_channels[port]);
+    return ESP_OK;
+}
+
+esp_err_t I2sMaster::deinit_controller() {
+    m_read_handle = NULL;
+    m_write_handle = NULL;
+    return ESP_OK;
+}
@@ -5,7 +5,10 @@
 
 #include <services/gatt/ble_svc_gatt.h>
 
+#include "utilities/climb_averager.h"
+
 void bluetooth_init(QueueHandle_t queue_handle);
 void bluetooth_deinit(void);
 int BluetoothSendPressure(float pressure);
 int BluetoothSendGnssNmea(const char *nmea);
+int BluetoothSendClimb(const ClimbRecord_t *p_record);
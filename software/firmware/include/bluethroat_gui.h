@@ -14,6 +14,10 @@
 #include "res/fonts/user_font_utils.h"
 
 #include "bluethroat_message.h"
+#include "utilities/task_stats.h"
+#include "utilities/climb_averager.h"
+#include "utilities/glide_computer.h"
+#include "utilities/thermal_assistant.h"
 
 /***********************************************************************************************************************
  * Force type casting to eliminate warning: bitwise operation between different enumeration types '<unnamed enum>' and 
@@ -55,6 +59,19 @@
 #define DEFAULT_ICON_VOLUME_COLOR               LV_COLOR_MAKE(0xFF, 0xFF, 0xFF)
 #define DEFAULT_ICON_LOCK_COLOR                 LV_COLOR_MAKE(0xFF, 0xFF, 0xFF)
 
+#define DEFAULT_THERMAL_TRAIL_COLOR             LV_COLOR_MAKE(0x7F, 0x7F, 0x7F)
+#define DEFAULT_THERMAL_CORE_COLOR              LV_COLOR_MAKE(0x1F, 0xFF, 0x7F)
+#define DEFAULT_THERMAL_GLIDER_COLOR            LV_COLOR_MAKE(0xFF, 0xFF, 0xFF)
+
+/* The map tab, north up around the glider */
+#define THERMAL_MAP_WIDTH                       (320)
+#define THERMAL_MAP_HEIGHT                      (240)
+#define THERMAL_MAP_CENTER_X                    (160)
+#define THERMAL_MAP_CENTER_Y                    (136)
+#define THERMAL_MAP_SCALE                       (1.0f)      /* pixels per meter */
+#define THERMAL_MAP_CORE_SIZE                   (16)
+#define THERMAL_MAP_GLIDER_SIZE                 (8)
+
 #define LV_SELECTOR(A, B) ((lv_style_selector_t)A | (lv_style_selector_t)B)
 
 typedef enum {
@@ -73,6 +90,9 @@ lv_obj_t * bluethroat_draw_panel(lv_obj_t *parent, lv_obj_t *ref, lv_align_t ali
 lv_obj_t * bluethroat_draw_label(lv_obj_t *parent, lv_obj_t *ref, lv_align_t align, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h, lv_color_t bg_color, lv_opa_t bg_opacity, lv_coord_t padding, lv_text_align_t text_align, lv_color_t text_color, const lv_font_t *font, const char *text);
 lv_obj_t * bluethroat_draw_icon(lv_obj_t *parent, lv_obj_t *ref, lv_align_t align, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h, lv_color_t bg_color, lv_opa_t bg_opacity, lv_coord_t padding, lv_text_align_t text_align, lv_color_t text_color, const lv_font_t *font, const char *text);
 lv_obj_t * bluethroat_draw_vario_meter(lv_obj_t * parent, lv_obj_t * ref, lv_align_t align, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h, lv_meter_indicator_t **sink_arc, lv_meter_indicator_t **lift_arc);
+lv_obj_t * bluethroat_draw_thermal_trail(lv_obj_t *parent);
+lv_obj_t * bluethroat_draw_thermal_marker(lv_obj_t *parent, lv_coord_t size, lv_color_t color);
+lv_obj_t * bluethroat_draw_task_stats_table(lv_obj_t *parent, lv_obj_t *ref, lv_align_t align, lv_coord_t x, lv_coord_t y);
 
 class BluethroatGui {
 public:
@@ -82,6 +102,7 @@ public:
     lv_obj_t *m_flying_dashboard_tab = NULL;
     lv_obj_t *m_flying_map_tab = NULL;
     lv_obj_t *m_flying_chart_tab = NULL;
+    lv_obj_t *m_flying_debug_tab = NULL;
 
     lv_obj_t *m_clock_label = NULL;
     lv_obj_t *m_battery_icon = NULL;
@@ -107,6 +128,24 @@ public:
     lv_meter_indicator_t *m_sink_arc = NULL;
     lv_meter_indicator_t *m_lift_arc = NULL;
     lv_obj_t *m_vario_label = NULL;
+    lv_obj_t *m_netto_label = NULL;
+    lv_obj_t *m_average_label = NULL;
+    lv_obj_t *m_average_description_label = NULL;
+
+    lv_obj_t *m_thermal_trail = NULL;
+    lv_point_t m_thermal_trail_points[THERMAL_ASSISTANT_HISTORY];
+    lv_obj_t *m_thermal_core = NULL;
+    lv_obj_t *m_thermal_glider = NULL;
+    lv_obj_t *m_thermal_panel = NULL;
+    lv_obj_t *m_thermal_label = NULL;
+    lv_obj_t *m_wind_panel = NULL;
+    lv_obj_t *m_wind_label = NULL;
+    lv_obj_t *m_speed_to_fly_panel = NULL;
+    lv_obj_t *m_speed_to_fly_label = NULL;
+    lv_obj_t *m_glide_panel = NULL;
+    lv_obj_t *m_glide_label = NULL;
+
+    lv_obj_t *m_task_stats_table = NULL;
 
     lv_obj_t *config_screen = NULL;
     lv_obj_t *config_tabview = NULL;
@@ -124,4 +163,11 @@ void GuiSetGnssStatus(GuiGnssStatus_t status);
 void GuiSetSpeed(float speed);
 void GuiSetAltitude(float altitude);
 void GuiSetAgl(float agl);
-void GuiSetVerticalSpeed(float vertical_speed);
\ No newline at end of file
+void GuiSetVerticalSpeed(float vertical_speed);
+void GuiSetNettoVerticalSpeed(float netto_vertical_speed, float relative_vertical_speed);
+void GuiSetWind(float speed, float direction);
+void GuiSetThermal(const ThermalAssistant *p_thermal);
+void GuiSetClimbAverages(const ClimbAverager *p_averager);
+void GuiSetGlide(const GlideComputer *p_glide);
+void GuiSetFlightStats(FlightState_t state, uint32_t airtime, float distance);
+void GuiSetTaskStats(const TaskStats_t *p_stats, uint32_t count);
\ No newline at end of file
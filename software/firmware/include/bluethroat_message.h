@@ -17,6 +17,10 @@ typedef enum {
     BLUETHROAT_MSG_TYPE_GNSS_GGA_DATA,
     BLUETHROAT_MSG_TYPE_GNSS_VTG_DATA,
     BLUETHROAT_MSG_TYPE_BLUETOOTH_STATE,
+    BLUETHROAT_MSG_TYPE_WIND_DATA,
+    BLUETHROAT_MSG_TYPE_FLIGHT_STATE,
+    BLUETHROAT_MSG_TYPE_STATIC_PRESSURE_DATA,   /* barometer_data of the second DPS3xx as a static port */
+    BLUETHROAT_MSG_TYPE_REPORT_REQUEST,         /* a report timer fired, the report is made by the message processor */
     // ensure to occupy 4 byte space to avoid efficiency reduction caused by misalignment
     BLUETHROAT_MSG_INVALID = 0x7fffffff,
 } BluethroatMsgType_t;
@@ -58,12 +62,15 @@ typedef struct {
     float pressure;
     float pressure_filterd;
     uint32_t timestamp;
+    uint32_t trace_sequence;        /* latency trace sequence, 0 if the sample is not traced */
 } BarometerData_t;
 
 typedef struct {
     float temperature;
-    float total_pressure;
-    float static_pressure;
+    float total_pressure;           /* deep FIR filtered */
+    float static_pressure;          /* deep FIR filtered, of the barometer */
+    uint32_t timestamp;             /* same place as the barometer data timestamp */
+    float total_pressure_sample;    /* unfiltered, of this sample */
 } AnemometerData_t;
 
 typedef struct {
@@ -72,9 +79,11 @@ typedef struct {
 } HygrometerData_t;
 
 typedef struct {
-    float x;
+    float x;                                /* m/s^2, mean specific force of a burst in the sensor frame */
     float y;
     float z;
+    float vertical;                         /* m/s^2, mean vertical acceleration of a burst, positive upward */
+    uint32_t timestamp;
 } AccelerationData_t;
 
 typedef struct {
@@ -136,6 +145,7 @@ typedef struct {
     float latitude_second;
     float langitude_second;
     float course;
+    uint32_t time;                         /* ms of the UTC day of the fix */
 } __attribute__ ((packed)) GnssRmcData_t;
 
 typedef struct {
@@ -159,6 +169,37 @@ typedef struct {
     float speed_kmh;
 } __attribute__ ((packed)) GnssVtgData_t;
 
+typedef struct {
+    float speed;                            /* m/s */
+    float direction;                        /* degrees clockwise from north the wind blows from */
+    float east;                             /* m/s, velocity of the air mass, the drift of a thermal */
+    float north;
+    float airspeed;                         /* m/s, the airspeed of the circles it was fitted on */
+    uint32_t age;                           /* GNSS fixes since it was fitted, 0 when fitted on the last one */
+} WindData_t;
+
+typedef enum {
+    FLIGHT_STATE_GROUND = 0,                /* before the first takeoff */
+    FLIGHT_STATE_FLYING,
+    FLIGHT_STATE_LANDED,
+} FlightState_t;
+
+typedef struct {
+    FlightState_t state;
+    uint32_t timestamp;                     /* ms, barometer time the state was entered at, dated back to its start */
+    uint32_t airtime;                       /* ms */
+    float distance;                         /* m flown since the takeoff */
+} FlightStateData_t;
+
+typedef enum {
+    REPORT_TASK_STATS = 0,
+    REPORT_LATENCY_TRACE,
+} ReportType_t;
+
+typedef struct {
+    ReportType_t report;
+} ReportRequest_t;
+
 typedef enum {
     SERVICE_STATE_DISCONNECTED,
     SERVICE_STATE_CONNECTED,
@@ -186,7 +227,10 @@ typedef struct {
         GnssRmcData_t gnss_rmc_data;
         GnssGgaData_t gnss_gga_data;
         GnssVtgData_t gnss_vtg_data;
+        WindData_t wind_data;
+        FlightStateData_t flight_state;
         BluetoothState_t bluetooth_state;
+        ReportRequest_t report_request;
     };
 } BluethroatMsg_t;
 
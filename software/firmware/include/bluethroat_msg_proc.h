@@ -5,6 +5,12 @@
 
 #include "bluethroat_message.h"
 #include "bluethroat_task.h"
+#include "utilities/climb_averager.h"
+#include "utilities/flight_detector.h"
+#include "utilities/glide_computer.h"
+#include "utilities/redundant_static.h"
+#include "utilities/temperature_drift.h"
+#include "utilities/thermal_assistant.h"
 
 #define BLUETHROAT_MSG_QUEUE_LENGTH     (32)
 
@@ -13,6 +19,13 @@ public:
     const TaskParam_t *m_p_task_param;
     TaskHandle_t m_task_handle;
     QueueHandle_t m_queue_handle;
+    ThermalAssistant m_thermal_assistant;
+    FlightDetector m_flight_detector;
+    ClimbAverager m_climb_averager;
+    RedundantStatic m_redundant_static;
+    TemperatureDrift m_temperature_drift;
+    GlideComputer m_glide_computer;
+    bool m_barometer_flying;                /* the barometer is in the flight mode */
 
 public:
     BluethroatMsgProc(const TaskParam_t *p_task_param);
@@ -20,6 +33,12 @@ public:
 
 public:
 	void message_loop();
+	void process_message(const BluethroatMsg_t *p_message);
+
+private:
+	void process_barometer(BarometerData_t *p_data);
+	void publish_flight_state();
+	void update_barometer_mode();
 
 };
 
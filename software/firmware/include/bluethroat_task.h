@@ -12,7 +12,9 @@ typedef enum {
     TASK_INDEX_DPS3XX_BAROMETER,
     TASK_INDEX_DPS3XX_ANEMOMETER,
     TASK_INDEX_NEO_M9N_GNSS,
+    TASK_INDEX_BMI270_IMU,
     TASK_INDEX_SOUND,
+    TASK_INDEX_FRAME_RECORDER,
     TASK_INDEX_MAX,
 } TaskIndex_t;
 
@@ -1,5 +1,20 @@
+#pragma once
+
 #include <stdint.h>
 
+#include <esp_err.h>
+
+#include "utilities/glider_polar.h"
+#include "utilities/inertial_vario.h"
+#include "utilities/kalman_vario.h"
+
+typedef enum {
+    VARIO_ENGINE_TWO_POINT = 0,             /* altitude difference of two consecutive filtered samples */
+    VARIO_ENGINE_KALMAN,                    /* Kalman filter of the altitude of the unfiltered samples */
+    VARIO_ENGINE_INERTIAL,                  /* vertical acceleration of the IMU corrected by the unfiltered samples */
+    VARIO_ENGINE_MAX,
+} VarioEngine_t;
+
 class BluethraotVario {
 private:
     uint16_t m_latitude_degree;
@@ -10,18 +25,84 @@ private:
     float m_longitude_second;
     uint16_t m_altitude;
 
+    VarioEngine_t m_engine;
+    KalmanVario m_kalman;                   /* also the fallback of the inertial engine without acceleration */
+    InertialVario m_inertial;
+    float m_vertical_acceleration;          /* of the last acceleration message */
+    uint32_t m_acceleration_timestamp;
+    uint32_t m_inertial_timestamp;          /* time the inertial state is at */
+
+    bool m_total_energy;                    /* add the rate of the energy height to the vertical speed */
+    KalmanVario m_energy;                   /* of the energy height V^2 / 2g, the same filter as the altitude */
+    float m_static_pressure;                /* Pa, unfiltered, of the last barometer sample */
+    float m_static_temperature;             /* C, of the last barometer sample */
+    float m_true_airspeed;                  /* m/s, of the deep filtered pressures */
+    float m_indicated_airspeed;             /* m/s, at the sea level density of the ISA */
+    float m_energy_height;                  /* m, of the unfiltered pressures */
+    uint32_t m_anemometer_timestamp;
+
+    GliderPolar m_polar;
+    float m_ground_speed;                   /* m/s, of the GNSS, the airspeed without an anemometer */
+    float m_netto_vertical_speed;           /* m/s, of the air mass, the vertical speed plus the sink of the polar */
+    float m_relative_vertical_speed;        /* m/s, the climb circling at the minimum sink, netto less the minimum sink */
+    float m_qnh;
+    float m_barometric_altitude;            /* above the QNH, of the last unfiltered sample */
+
     float m_last_temperature;
     float m_last_pressure;
+    float m_last_altitude;                  /* standard altitude of the last sample the engine used */
     uint32_t m_last_timestamp;
 
+public:
+    static const char *m_conf_namespace;
+    static const char *m_conf_key_speeds[GLIDER_POLAR_POINTS];
+    static const char *m_conf_key_sinks[GLIDER_POLAR_POINTS];
+
 public:
     BluethraotVario();
     ~BluethraotVario();
 
 public:
-    float CalculateVerticalSpeed(float temperature, float pressure, uint32_t timestamp);
+    void SetEngine(VarioEngine_t engine);
+    VarioEngine_t GetEngine() const { return m_engine; }
+    KalmanVario *GetKalman() { return &m_kalman; }
+    InertialVario *GetInertial() { return &m_inertial; }
+    KalmanVario *GetEnergy() { return &m_energy; }
+    void SetTotalEnergy(bool total_energy) { m_total_energy = total_energy; }
+    bool GetTotalEnergy() const { return m_total_energy; }
+    float GetTrueAirspeed() const { return m_true_airspeed; }
+    float GetIndicatedAirspeed() const { return m_indicated_airspeed; }
+    esp_err_t LoadPolar();
+    esp_err_t SetPolar(const int32_t *p_speeds_kmh, const int32_t *p_sinks_cms);
+    const GliderPolar *GetPolar() const { return &m_polar; }
+    void SetGroundSpeed(float ground_speed) { m_ground_speed = ground_speed; }
+    float GetDensityRatio() const;
+    float GetNettoVerticalSpeed() const { return m_netto_vertical_speed; }
+    float GetRelativeVerticalSpeed() const { return m_relative_vertical_speed; }
+    void SetQnh(float qnh) { m_qnh = qnh; }
+    float GetQnh() const { return m_qnh; }
+    float GetBarometricAltitude() const { return m_barometric_altitude; }
+    float CalculateVerticalSpeed(float temperature, float pressure, float pressure_filtered, uint32_t timestamp);
+    bool UpdateVerticalAcceleration(float vertical_acceleration, uint32_t timestamp, float *p_vertical_speed);
+    float CalculateAirspeed(float total_pressure, float static_pressure, float total_pressure_sample, uint32_t timestamp);
+
+private:
+    bool airspeed_valid(uint32_t timestamp) const;
+    float air_density() const;
+    esp_err_t set_polar(const int32_t *p_speeds_kmh, const int32_t *p_sinks_cms);
+    void update_netto(float vertical_speed, uint32_t timestamp);
 };
 
 extern BluethraotVario *g_pBluethraotVario;
 
-float CalculateVerticalSpeed(float temperature, float pressure, uint32_t timestamp);
+float CalculateVerticalSpeed(float temperature, float pressure, float pressure_filtered, uint32_t timestamp);
+bool UpdateVerticalAcceleration(float vertical_acceleration, uint32_t timestamp, float *p_vertical_speed);
+float CalculateAirspeed(float total_pressure, float static_pressure, float total_pressure_sample, uint32_t timestamp);
+float GetBarometricAltitude();
+float GetTrueAirspeed();
+esp_err_t LoadGliderPolar();
+void SetGroundSpeed(float ground_speed);
+const GliderPolar *GetGliderPolar();
+float GetDensityRatio();
+float GetNettoVerticalSpeed();
+float GetRelativeVerticalSpeed();
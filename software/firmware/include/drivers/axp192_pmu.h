@@ -666,6 +666,9 @@ public:
     };
 #endif
 #endif
+#if CONFIG_FRAME_RECORDER_ENABLED
+    TickType_t m_last_record_ticks;
+#endif
 
 public:
     Axp192Pmu();
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "utilities/i2c_device.h"
+
+/***********************************************************************************************************************
+* Bmi270 chip ID register address and value defination
+***********************************************************************************************************************/
+#define BMI270_REG_ADDR_CHIP_ID                 (0x00)
+#define BMI270_REG_VALUE_CHIP_ID                (0x24)
+
+/***********************************************************************************************************************
+* Bmi270 status registers address and value defination
+* The message field of INTERNAL_STATUS reports the initialization of the device by its config file.
+***********************************************************************************************************************/
+#define BMI270_REG_ADDR_INTERNAL_STATUS         (0x21)
+#define BMI270_INTERNAL_STATUS_MESSAGE_MASK     (0x0f)
+#define BMI270_REG_VALUE_STATUS_NOT_INIT        (0x00)
+#define BMI270_REG_VALUE_STATUS_INIT_OK         (0x01)
+#define BMI270_REG_VALUE_STATUS_INIT_ERR        (0x02)
+
+/***********************************************************************************************************************
+* Bmi270 FIFO fill level and data registers address defination
+* FIFO_LENGTH is the fill level in bytes, 14 bits over two registers. FIFO_DATA doesn't auto increment, a burst read
+* of it pops as many bytes as it reads.
+***********************************************************************************************************************/
+#define BMI270_REG_ADDR_FIFO_LENGTH_0           (0x24)
+#define BMI270_REG_ADDR_FIFO_LENGTH_1           (0x25)
+#define BMI270_REG_ADDR_FIFO_DATA               (0x26)
+
+#define BMI270_FIFO_LENGTH_MASK                 (0x3fff)
+
+/***********************************************************************************************************************
+* Bmi270 accelerometer configuration registers address, structure and related configuration value defination
+***********************************************************************************************************************/
+#define BMI270_REG_ADDR_ACC_CONF                (0x40)
+
+typedef union {
+    uint8_t byte;
+    struct {
+#if _BYTE_ORDER == _LITTLE_ENDIAN
+        uint8_t acc_odr         : 4;
+        uint8_t acc_bwp         : 3;
+        uint8_t acc_filter_perf : 1;
+#else
+        uint8_t acc_filter_perf : 1;
+        uint8_t acc_bwp         : 3;
+        uint8_t acc_odr         : 4;
+#endif
+    };
+} __attribute__ ((packed)) Bmi270AccConfReg_t;
+
+#define BMI270_REG_VALUE_ODR_25HZ               (0x06)
+#define BMI270_REG_VALUE_ODR_50HZ               (0x07)
+#define BMI270_REG_VALUE_ODR_100HZ              (0x08)
+#define BMI270_REG_VALUE_ODR_200HZ              (0x09)
+
+#define BMI270_REG_VALUE_ACC_BWP_OSR4           (0x00)
+#define BMI270_REG_VALUE_ACC_BWP_OSR2           (0x01)
+#define BMI270_REG_VALUE_ACC_BWP_NORMAL         (0x02)
+
+#define BMI270_REG_ADDR_ACC_RANGE               (0x41)
+
+#define BMI270_REG_VALUE_ACC_RANGE_2G           (0x00)
+#define BMI270_REG_VALUE_ACC_RANGE_4G           (0x01)
+#define BMI270_REG_VALUE_ACC_RANGE_8G           (0x02)
+#define BMI270_REG_VALUE_ACC_RANGE_16G          (0x03)
+
+/***********************************************************************************************************************
+* Bmi270 gyroscope configuration registers address, structure and related configuration value defination
+***********************************************************************************************************************/
+#define BMI270_REG_ADDR_GYR_CONF                (0x42)
+
+typedef union {
+    uint8_t byte;
+    struct {
+#if _BYTE_ORDER == _LITTLE_ENDIAN
+        uint8_t gyr_odr         : 4;
+        uint8_t gyr_bwp         : 2;
+        uint8_t gyr_noise_perf  : 1;
+        uint8_t gyr_filter_perf : 1;
+#else
+        uint8_t gyr_filter_perf : 1;
+        uint8_t gyr_noise_perf  : 1;
+        uint8_t gyr_bwp         : 2;
+        uint8_t gyr_odr         : 4;
+#endif
+    };
+} __attribute__ ((packed)) Bmi270GyrConfReg_t;
+
+#define BMI270_REG_VALUE_GYR_BWP_OSR4           (0x00)
+#define BMI270_REG_VALUE_GYR_BWP_OSR2           (0x01)
+#define BMI270_REG_VALUE_GYR_BWP_NORMAL         (0x02)
+
+#define BMI270_REG_ADDR_GYR_RANGE               (0x43)
+
+#define BMI270_REG_VALUE_GYR_RANGE_2000DPS      (0x00)
+#define BMI270_REG_VALUE_GYR_RANGE_1000DPS      (0x01)
+#define BMI270_REG_VALUE_GYR_RANGE_500DPS       (0x02)
+#define BMI270_REG_VALUE_GYR_RANGE_250DPS       (0x03)
+#define BMI270_REG_VALUE_GYR_RANGE_125DPS       (0x04)
+
+/***********************************************************************************************************************
+* Bmi270 FIFO configuration registers address, structure and related configuration value defination
+***********************************************************************************************************************/
+#define BMI270_REG_ADDR_FIFO_CONFIG_0           (0x48)
+
+typedef union {
+    uint8_t byte;
+    struct {
+#if _BYTE_ORDER == _LITTLE_ENDIAN
+        uint8_t fifo_stop_on_full   : 1;
+        uint8_t fifo_time_en        : 1;
+        uint8_t                     : 6;
+#else
+        uint8_t                     : 6;
+        uint8_t fifo_time_en        : 1;
+        uint8_t fifo_stop_on_full   : 1;
+#endif
+    };
+} __attribute__ ((packed)) Bmi270FifoConfig0Reg_t;
+
+#define BMI270_REG_ADDR_FIFO_CONFIG_1           (0x49)
+
+typedef union {
+    uint8_t byte;
+    struct {
+#if _BYTE_ORDER == _LITTLE_ENDIAN
+        uint8_t fifo_tag_int1_en    : 2;
+        uint8_t fifo_tag_int2_en    : 2;
+        uint8_t fifo_header_en      : 1;
+        uint8_t fifo_aux_en         : 1;
+        uint8_t fifo_acc_en         : 1;
+        uint8_t fifo_gyr_en         : 1;
+#else
+        uint8_t fifo_gyr_en         : 1;
+        uint8_t fifo_acc_en         : 1;
+        uint8_t fifo_aux_en         : 1;
+        uint8_t fifo_header_en      : 1;
+        uint8_t fifo_tag_int2_en    : 2;
+        uint8_t fifo_tag_int1_en    : 2;
+#endif
+    };
+} __attribute__ ((packed)) Bmi270FifoConfig1Reg_t;
+
+/***********************************************************************************************************************
+* Bmi270 config file upload registers address and value defination
+* The config file is written to INIT_DATA in chunks, INIT_ADDR_0 and INIT_ADDR_1 hold the offset of a chunk in words,
+* its 4 low bits in INIT_ADDR_0 and the others in INIT_ADDR_1. INIT_CTRL is 0 while it is written, 1 starts the
+* initialization, INTERNAL_STATUS reports it within 20ms.
+***********************************************************************************************************************/
+#define BMI270_REG_ADDR_INIT_CTRL               (0x59)
+#define BMI270_REG_VALUE_INIT_CTRL_LOAD         (0x00)
+#define BMI270_REG_VALUE_INIT_CTRL_START        (0x01)
+
+#define BMI270_REG_ADDR_INIT_ADDR_0             (0x5B)
+#define BMI270_REG_ADDR_INIT_ADDR_1             (0x5C)
+#define BMI270_INIT_ADDR_0_MASK                 (0x0f)
+#define BMI270_INIT_ADDR_1_SHIFT                (4)
+
+#define BMI270_REG_ADDR_INIT_DATA               (0x5E)
+
+#define BMI270_CONFIG_FILE_SIZE                 (8192)
+#define BMI270_CONFIG_CHUNK_SIZE                (128)       /* bytes of an INIT_DATA burst write, a whole number of words */
+#define BMI270_INIT_POLL_MS                     (10)
+#define BMI270_INIT_TIMEOUT_MS                  (150)       // (initialization time, 20ms)
+
+/*
+    Bosch config file of the BMI270, the bmi270_config_file array of the BMI270 SensorAPI (BSD-3-Clause) written out as
+    raw bytes to src/drivers/bmi270_config.bin, embedded in the firmware by the build.
+*/
+extern const uint8_t g_bmi270_config_file[] asm("_binary_bmi270_config_bin_start");
+
+/***********************************************************************************************************************
+* Bmi270 power configuration, power control and command registers address and related value defination
+***********************************************************************************************************************/
+#define BMI270_REG_ADDR_PWR_CONF                (0x7C)
+#define BMI270_REG_VALUE_PWR_CONF_PERFORMANCE   (0x00)      /* advanced power save and FIFO self wake-up off */
+
+#define BMI270_REG_ADDR_PWR_CTRL                (0x7D)
+
+typedef union {
+    uint8_t byte;
+    struct {
+#if _BYTE_ORDER == _LITTLE_ENDIAN
+        uint8_t aux_en          : 1;
+        uint8_t gyr_en          : 1;
+        uint8_t acc_en          : 1;
+        uint8_t temp_en         : 1;
+        uint8_t                 : 4;
+#else
+        uint8_t                 : 4;
+        uint8_t temp_en         : 1;
+        uint8_t acc_en          : 1;
+        uint8_t gyr_en          : 1;
+        uint8_t aux_en          : 1;
+#endif
+    };
+} __attribute__ ((packed)) Bmi270PwrCtrlReg_t;
+
+#define BMI270_REG_ADDR_CMD                     (0x7E)
+#define BMI270_REG_VALUE_CMD_FIFO_FLUSH         (0xB0)
+#define BMI270_REG_VALUE_CMD_SOFT_RESET         (0xB6)
+
+#define BMI270_RESET_READY_MS                   (2)         // (2ms)
+#define BMI270_POWER_SAVE_EXIT_MS               (1)         // (450us)
+#define BMI270_POWER_UP_MS                      (50)        // (gyroscope start-up time, 45ms)
+
+/***********************************************************************************************************************
+* Bmi270 headerless FIFO frame with the gyroscope and the accelerometer enabled, little endian
+***********************************************************************************************************************/
+typedef struct {
+    int16_t gyr_x;
+    int16_t gyr_y;
+    int16_t gyr_z;
+    int16_t acc_x;
+    int16_t acc_y;
+    int16_t acc_z;
+} __attribute__ ((packed)) Bmi270FifoFrame_t;
+
+/***********************************************************************************************************************
+* FIFO burst handed from fetch_data() to process_data(), it must fit the raw data buffer of the I2C device task.
+* At the 100Hz output data rate a burst covers up to 100ms, a task interval of 50ms leaves room for a late loop.
+***********************************************************************************************************************/
+#define BMI270_FIFO_BURST_FRAMES                (10)
+#define BMI270_OUTPUT_DATA_RATE_HZ              (100)
+
+typedef struct {
+    uint8_t frames;
+    Bmi270FifoFrame_t frame[BMI270_FIFO_BURST_FRAMES];
+} __attribute__ ((packed)) Bmi270FifoBurst_t;
+
+static_assert(sizeof(Bmi270FifoBurst_t) <= MAX_RAW_DATA_BUFFER_LENGTH, "BMI270 FIFO burst doesn't fit the raw data buffer");
+
+/***********************************************************************************************************************
+* Bmi270 sensitivity of the configured ranges, +-4g and +-500dps
+***********************************************************************************************************************/
+#define BMI270_ACC_LSB_PER_G                    (8192.0f)
+#define BMI270_GYR_LSB_PER_DPS                  (65.536f)
+#define BMI270_STANDARD_GRAVITY                 (9.80665f)
+
+/***********************************************************************************************************************
+* @brief Bmi270 IMU class
+* This class reads the accelerometer and the gyroscope of the BMI270 through its FIFO, a burst read of all the frames
+* queued since the last loop instead of a register read per sample, and estimates the vertical acceleration.
+* The attitude is kept as the unit vector of the vertical in the sensor frame: it is turned by the gyroscope every
+* frame, and pulled towards the measured specific force with the time constant CONFIG_I2C_DEVICE_BMI270_ATTITUDE_TIME,
+* only while the magnitude of the specific force is close to gravity. The vertical acceleration is the specific force
+* along the vertical minus the gravity, measured as the mean specific force of the first second.
+* The mean acceleration and vertical acceleration of each burst are sent as an acceleration message.
+* The Bosch config file is uploaded after the reset, the device doesn't output data until it reports its
+* initialization done, and init_device fails when it never does.
+***********************************************************************************************************************/
+class Bmi270Imu : public I2cDevice {
+public:
+    /* Construction member variables */
+    float m_attitude_time_constant;                 /* s, of the accelerometer correction of the attitude */
+    float m_attitude_gate;                          /* relative deviation of the specific force from gravity */
+
+    /* Runtime member variables */
+    bool m_attitude_valid;
+    float m_up[3];                                  /* unit vector of the vertical in the sensor frame */
+    float m_gravity;                                /* m/s^2, specific force at rest */
+    float m_gravity_sum;
+    uint32_t m_gravity_frames;
+    uint32_t m_overflows;                           /* bursts which left frames in the FIFO */
+
+public:
+    Bmi270Imu();
+    ~Bmi270Imu();
+
+public:
+    virtual esp_err_t init_device();
+    virtual esp_err_t deinit_device();
+    virtual esp_err_t fetch_data(uint8_t *data, uint8_t size);
+    virtual esp_err_t process_data(uint8_t *in_data, uint8_t in_size, BluethroatMsg_t *p_message);
+
+public:
+    static esp_err_t CheckDeviceId(I2cMaster *p_i2c_master, uint16_t device_addr);
+
+private:
+    esp_err_t upload_config();
+    float update_attitude(const float *p_acceleration, const float *p_rotation, float delta_time);
+};
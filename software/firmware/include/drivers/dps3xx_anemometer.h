@@ -1,13 +1,42 @@
+#include <sdkconfig.h>
+
 #include "drivers/dps3xx_barometer.h"
 
+#if CONFIG_VARIO_SECOND_DPS3XX_STATIC
+#define DPS3XX_ANEMOMETER_STATIC_PORT   (true)
+#else
+#define DPS3XX_ANEMOMETER_STATIC_PORT   (false)
+#endif
+
+/*
+    The second DPS3xx. With a pitot tube it reads the total pressure, the airspeed comes from it and the static pressure
+    of the barometer. As a static port, without a pitot tube, its samples are sent as they are for the redundant static
+    pressure (utilities/redundant_static.h).
+    It follows the barometer through a Dps3xxSync: its background measurement starts on the phase of the barometer and
+    it reads its FIFO once the barometer processed a burst. With a pitot tube every total pressure is paired with the
+    static pressure of the barometer sample taken with it, the two are averaged by filters of the same depth over the
+    same samples.
+*/
 class Dps3xxAnemometer : public Dps3xxBarometer {
 public:
     Dps3xxBarometer *m_p_barometer;
+    bool m_static_port;
+    FirFilter<uint32_t, uint32_t> *m_p_static_filter;   /* FIR deep filter for the paired static pressures */
+    uint32_t m_unpaired;                                /* total pressures without a static pressure of their sample */
+    uint32_t m_unsynced_bursts;                         /* bursts read without the barometer */
 
 public:
-    Dps3xxAnemometer(Dps3xxBarometer *p_barometer);
+    Dps3xxAnemometer(Dps3xxBarometer *p_barometer, bool static_port = DPS3XX_ANEMOMETER_STATIC_PORT);
     ~Dps3xxAnemometer();
 
 public:
+    virtual esp_err_t fetch_data(uint8_t *data, uint8_t size);
     virtual esp_err_t process_data(uint8_t *in_data, uint8_t in_size, BluethroatMsg_t *p_message);
+
+protected:
+    virtual void wait_start();
+    virtual esp_err_t wait_burst();
+
+private:
+    Dps3xxSync *get_sync() const { return (m_p_barometer != NULL) ? m_p_barometer->m_p_sync : NULL; }
 };
\ No newline at end of file
@@ -3,10 +3,15 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <time.h>
+#include <sdkconfig.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 #include "utilities/i2c_device.h"
 #include "utilities/low_pass_filter.h"
 #include "utilities/sme_float.h"
+#include "drivers/dps3xx_sync.h"
 
 /***********************************************************************************************************************
 * Dps3xx coefficient scale factor defination
@@ -204,6 +209,9 @@ typedef union {
 #define DPS3XX_REG_VALUE_SPI_MODE_4WIRE     (0x00)
 #define DPS3XX_REG_VALUE_SPI_MODE_3WIRE     (0x01)
 
+// The result shift must be enabled above 8 times oversampling, and only then.
+#define DPS3XX_REG_VALUE_SHIFT_MIN_PRC      (DPS3XX_REG_VALUE_PM_PRC_16)
+
 /***********************************************************************************************************************
 * Dps3xx interrupt status registers address and structure defination
 ***********************************************************************************************************************/
@@ -273,6 +281,40 @@ typedef union {
 #define DPS3XX_RESET_SENSOR_READY_MS        (12)    // (12ms)
 #define DPS3XX_RESET_COEF_READY_MS          (40)    // (40ms)
 
+/***********************************************************************************************************************
+* Dps3xx FIFO defination
+* With fifo_en set, the background measurements are queued in a FIFO of 32 results read at the pressure result
+* registers, a 3 bytes read at PSR_B2 pops one entry, a longer read doesn't pop the next ones. Bit 0 of an entry is set
+* for a pressure and clear for a temperature, an empty FIFO reads 0x800000.
+***********************************************************************************************************************/
+#define DPS3XX_FIFO_ENTRIES                 (32)
+#define DPS3XX_FIFO_ENTRY_SIZE              (3)
+#define DPS3XX_FIFO_ENTRY_PRESSURE          (0x01)
+#define DPS3XX_FIFO_EMPTY                   (0x800000)
+
+/* Pressure samples per FIFO burst, the task wakes once per burst */
+#define DPS3XX_FIFO_BURST_SAMPLES           (CONFIG_I2C_DEVICE_DPS3XX_FIFO_BURST_SAMPLES)
+/* Bursts without a pressure before fetch_data() gives up */
+#define DPS3XX_FIFO_EMPTY_BURSTS            (4)
+/* Ticks the task waits for the wake timer past its deadline before it drains the FIFO anyway */
+#define DPS3XX_WAKE_TIMEOUT_TICKS           (2)
+
+/* Pressures per temperature, rounded down to a power of two */
+#define DPS3XX_TEMPERATURE_RATIO            (CONFIG_I2C_DEVICE_DPS3XX_TEMPERATURE_RATIO)
+
+/***********************************************************************************************************************
+* Dps3xx measurement modes, the pressure rate and oversampling of the ground and of the flight. The temperature is
+* oversampled as much as the measurement time the pressures leave in a second allows, up to the most of the mode.
+***********************************************************************************************************************/
+typedef enum {
+    DPS3XX_MODE_LOW_POWER = 0,              /* 4 pressures a second oversampled 8 times, about 75 ms of measurement */
+    DPS3XX_MODE_HIGH_RESOLUTION,            /* 8 pressures a second oversampled 64 times, about 900 ms */
+    DPS3XX_MODE_MAX,
+} Dps3xxMode_t;
+
+/* Longest pressure period of the modes, the one of the low power mode, ms */
+#define DPS3XX_MODE_MAX_PERIOD_MS           (1000 >> DPS3XX_REG_VALUE_PM_RATE_4)
+
 /***********************************************************************************************************************
 * Dps3xx chip and revision ID registers address，structure and related configuration value defination
 ***********************************************************************************************************************/
@@ -361,12 +403,27 @@ typedef union {
 * measurement time, and the scale factor for the pressure and temperature data calculation.
 ***********************************************************************************************************************/
 typedef struct {
-    uint8_t mesurement_rate;        /* pressure measurement rate, effect in background mode */
+    uint8_t mesurement_rate;        /* measurements per second, 2 to the power of it, in background mode */
     uint8_t oversampling_rate;
-    TickType_t mesurement_time;     /* single measurement time, in ticks, call delay to wait for result */
+    uint32_t mesurement_time;       /* single measurement time, in ms, the rates times it must fit in a second */
     float32_t scale_factor;
 } Dps3xxMeasureConfig_t;
 
+/***********************************************************************************************************************
+* Dps3xx coefficient data structure defination, the coefficients read at reset and scaled again for every mode
+***********************************************************************************************************************/
+typedef struct {
+    int32_t c0;
+    int32_t c1;
+    int32_t c00;
+    int32_t c10;
+    int32_t c01;
+    int32_t c11;
+    int32_t c20;
+    int32_t c21;
+    int32_t c30;
+} Dps3xxCoefData_t;
+
 /***********************************************************************************************************************
 * Dps3xx scaled coefficient data structure defination
 ***********************************************************************************************************************/
@@ -382,6 +439,15 @@ typedef struct {
     float32_t scaled_c30;
 } Dps3xxScaledCoefData_t;
 
+/***********************************************************************************************************************
+* Dps3xx sample of a FIFO burst, a pressure result with the last temperature result before it, in the result register
+* order, and its timestamp
+***********************************************************************************************************************/
+typedef struct {
+    Dps3xxData_t data;
+    int64_t timestamp_us;           /* us since boot, as esp_timer_get_time() */
+} Dps3xxSample_t;
+
 /***********************************************************************************************************************
 * Default value and depth of FIR filter defination
 ***********************************************************************************************************************/
@@ -397,19 +463,62 @@ typedef struct {
 * The Dps3xx barometer sensor is a digital pressure sensor with a 24-bit ADC and a 24-bit temperature sensor.
 * The sensor can be configured to measure the pressure and temperature in different modes, including single measurement
 * mode, background measurement mode, and background measurement mode with FIFO and interrupt.
-* Since the hardware doesn't connect the interrupt pin, the interrupt and FIFO mode are not used in this class. and the
-* background measurement mode is not used to measure the pressure and temperature data.
+* The sensor measures in background mode at the rates of the pressure and temperature configurations, the results are
+* queued in its FIFO. The hardware doesn't connect the interrupt pin, the task wakes every DPS3XX_FIFO_BURST_SAMPLES
+* pressure periods instead and drains the FIFO with a read per entry up to the empty marker, where the command mode
+* took two triggers, two status polls and a read for each sample. The wakes come from a one-shot esp_timer on the
+* microsecond clock, not from the RTOS tick which would round them to 10 ms: the first one when the last pressure of
+* the first burst ends, counted from the start of the background measurement, the next ones a burst apart on
+* the phase of the first, so the task reads the results as soon as they end. Every pressure is paired with the
+* last temperature before it, and stamped in microseconds a pressure period after the previous one, within the period
+* before the burst, so the samples stay evenly spaced whatever the phase of the wake. fetch_data() hands one sample
+* after the other to process_data(), the messages carry the timestamps in milliseconds.
+* The temperature is measured once every DPS3XX_TEMPERATURE_RATIO pressures, it changes far slower than the pressure
+* and the pressures get the measurement time. process_data() caches the temperature terms of the compensation, they are
+* only computed again when the temperature result changes.
+* SetMode() switches the rates and the oversampling at runtime, the task applies it between two bursts: the background
+* measurement is stopped, the FIFO flushed and the coefficients scaled again from the ones read at reset, without a
+* reset. The cached temperature result is moved to the scale of its new oversampling, the first pressures of the new
+* mode are compensated with it.
+* Given a Dps3xxSync, the barometer leads the anemometer through it: the start of every background measurement, every
+* pressure and the end of every burst are handed to it. The sync is given at construction, so the first measurement
+* started by Init() is already handed to it.
 ***********************************************************************************************************************/
 class Dps3xxBarometer : public I2cDevice {
 public:
     Dps3xxMeasureConfig_t m_pressure_cfg;               /* pressure measurement config */
     Dps3xxMeasureConfig_t m_temperature_cfg;            /* temperature measurement config */
+    Dps3xxCoefData_t m_coefs;                           /* coefficient data read at reset */
     Dps3xxScaledCoefData_t m_coef_data;                 /* scaled coefficient data */
+    Dps3xxMode_t m_mode;
+    volatile Dps3xxMode_t m_requested_mode;             /* applied by the task at the next burst */
     FirFilter<uint32_t, uint32_t> *m_p_shallow_filter;  /* FIR shallow filter for pressure data */
     FirFilter<uint32_t, uint32_t> *m_p_deep_filter;     /* FIR deep filter for pressure data */
+    bool m_trace_latency;                               /* stamp the fetched samples in the latency trace */
+    uint32_t m_trace_sequence;                          /* latency trace sequence of the last fetched sample */
+    Dps3xxSample_t m_samples[DPS3XX_FIFO_ENTRIES];      /* samples of the last FIFO burst */
+    uint8_t m_sample_count;
+    uint8_t m_sample_index;                             /* next sample handed to process_data() */
+    uint8_t m_temperature[DPS3XX_FIFO_ENTRY_SIZE];      /* last temperature result */
+    bool m_has_temperature;
+    int64_t m_sample_timestamp_us;                      /* us, of the sample handed to process_data() */
+    uint32_t m_sample_timestamp;                        /* ms, of the same sample */
+    bool m_has_timestamp;
+    esp_timer_handle_t m_wake_timer;                    /* one-shot timer of the burst wakes */
+    SemaphoreHandle_t m_wake_semaphore;                 /* given by the wake timer */
+    int64_t m_next_wake_us;
+    Dps3xxSync *m_p_sync;                               /* followed by the anemometer, not owned, may be NULL */
+    int64_t m_start_us;                                 /* start of the background measurement */
+    uint32_t m_overflows;                               /* bursts which found the FIFO full */
+    int32_t m_cached_raw_temperature;                   /* raw temperature of the cached compensation terms */
+    bool m_has_cached_temperature;
+    float32_t m_cached_temperature;
+    float32_t m_cached_pressure_offset;                 /* c00 + c01 * T */
+    float32_t m_cached_pressure_gain;                   /* c10 + c11 * T */
+    uint32_t m_temperature_updates;                     /* compensation terms computed */
 
 public:
-    Dps3xxBarometer();
+    Dps3xxBarometer(Dps3xxSync *p_sync = NULL);
     ~Dps3xxBarometer();
 
 public:
@@ -420,7 +529,36 @@ public:
 
 public:
     static esp_err_t CheckDeviceId(I2cMaster *p_i2c_master, uint16_t device_addr);
+    uint32_t GetSamplePeriodMs() const { return 1000U >> m_pressure_cfg.mesurement_rate; }
+    uint32_t GetSamplePeriodUs() const { return 1000000U >> m_pressure_cfg.mesurement_rate; }
+    void SetMode(Dps3xxMode_t mode) { m_requested_mode = mode; }
+    Dps3xxMode_t GetMode() const { return m_mode; }
+    Dps3xxMode_t GetRequestedMode() const { return m_requested_mode; }
+    esp_err_t ApplyMode(Dps3xxMode_t mode);
+
+protected:
+    virtual void wait_start();
+    virtual esp_err_t wait_burst();
+    esp_err_t wait_until(int64_t wake_us);
 
 private:
     esp_err_t get_coefs();
+    esp_err_t read_fifo();
+    void start_wakes();
+    static void wake_callback(void *arg);
+    void select_mode(Dps3xxMode_t mode);
+    esp_err_t write_measure_config();
+    void scale_coefs();
+    static void set_measure_config(Dps3xxMeasureConfig_t *p_cfg, uint8_t mesurement_rate, uint8_t oversampling_rate);
 };
+
+extern Dps3xxBarometer *g_pDps3xxBarometer;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t BarometerSetMode(Dps3xxMode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sdkconfig.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include "utilities/sme_float.h"
+
+/* Static pressures kept for the pairing, two bursts of the barometer */
+#define DPS3XX_SYNC_HISTORY                 (2 * CONFIG_I2C_DEVICE_DPS3XX_FIFO_BURST_SAMPLES)
+/* Ticks the anemometer waits for the barometer to start in its new mode */
+#define DPS3XX_SYNC_START_TIMEOUT_TICKS     (3)
+
+typedef struct {
+    int64_t timestamp_us;
+    float32_t pressure;
+} Dps3xxSyncSample_t;
+
+/***********************************************************************************************************************
+* @brief Dps3xx sync class
+* Coordinates the two DPS3xx on the bus, the barometer leads and the anemometer follows.
+* The background measurement of the anemometer starts on the phase of the one of the barometer, a whole number of
+* periods after it, so both measure at the same instants. The anemometer then drains its FIFO right after the barometer
+* processed a burst, instead of on its own wake timer, and pairs each total pressure with the static pressure of the
+* barometer sample with the nearest timestamp. The differential pressure of a pair doesn't carry the change of the
+* static pressure between two samples, which a climb or a sink puts there when the two sensors are read apart.
+* The barometer task writes, the anemometer task reads, the history is kept in a short critical section.
+***********************************************************************************************************************/
+class Dps3xxSync {
+public:
+    /* Runtime member variables */
+    portMUX_TYPE m_spinlock;
+    SemaphoreHandle_t m_burst_semaphore;    /* given once the barometer processed a burst */
+    bool m_started;
+    int64_t m_start_us;                     /* background measurement start of the barometer */
+    uint32_t m_period_us;                   /* pressure period of the barometer */
+    Dps3xxSyncSample_t m_samples[DPS3XX_SYNC_HISTORY];
+    uint8_t m_sample_count;
+    uint8_t m_next_sample;
+
+public:
+    Dps3xxSync();
+    ~Dps3xxSync();
+
+public:
+    esp_err_t Init();
+    void Restart(int64_t start_us, uint32_t period_us);
+    void PutSample(int64_t timestamp_us, float32_t pressure);
+    void EndBurst();
+
+    bool GetAlignedStart(int64_t now_us, uint32_t period_us, int64_t *p_start_us);
+    bool WaitBurst(TickType_t ticks);
+    bool GetPressure(int64_t timestamp_us, float32_t *p_pressure, int64_t *p_skew_us);
+};
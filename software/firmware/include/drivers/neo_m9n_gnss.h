@@ -3,6 +3,7 @@
 #include <driver/uart.h>
 
 #include "utilities/task_object.h"
+#include "utilities/wind_estimator.h"
 #include "bluethroat_message.h"
 
 #define MNEA_SENTENCE_MAX_SIZE          (0x80)
@@ -36,6 +37,7 @@ public:
     gpio_num_t m_uart_cts_pin;
     int m_uart_baudrate;
    	QueueHandle_t m_uart_queue;
+    WindEstimator m_wind_estimator;
 
 public:
     NeoM9nGnss();
@@ -50,7 +52,9 @@ public:
     virtual esp_err_t deinit_device();
     virtual void task_cpp_entry();
 
-private:
+public:
     void process_gnss_sentence(char *sentence);
+
+private:
     int splite_sentence(char *sentence, char *fields[], int max_fields);
 };
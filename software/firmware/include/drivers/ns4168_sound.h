@@ -226,6 +226,7 @@ public:
 
     bool m_sound_enabled;
     TickType_t m_last_beep_time_ticks;
+    volatile bool m_flying;                     /* no power off timeout in flight, see SoundSetFlying */
 
     int32_t m_vertical_accel_in_multiple;
     int32_t m_vertical_speed_in_multiple;
@@ -234,6 +235,9 @@ public:
     int32_t m_speed_lift_latch_in_multiple;
     int32_t m_speed_sink_latch_in_multiple;
 
+    volatile uint32_t m_trace_sequence;         /* latency trace sequence of the last vertical speed */
+    uint32_t m_playing_trace_sequence;          /* latency trace sequence waiting for its first I2S write */
+
     /* Mutex member variables */
     SemaphoreHandle_t m_sound_mutex;
 
@@ -254,6 +258,7 @@ public:
     void set_volume(int32_t volume);
     void set_disable_sound_timeout(int32_t timeout_ms);
     void set_power_off_timeout(int32_t timeout_ms);
+    void set_flying(bool flying);
 
 public:
     void set_acceleration_params(int32_t tone_freq_hz, int32_t beep_period_ms);
@@ -271,6 +276,10 @@ public:
     void play_speed_lift_sound(int32_t vertical_speed);
     void play_speed_sink_sound(int32_t vertical_speed);
     void play_silence_sound();
+    void play_sound();
+
+private:
+    void write_sound_buffer(size_t size);
 };
 
 extern Ns4168Sound *g_pNs4168Sound;
@@ -278,6 +287,7 @@ extern Ns4168Sound *g_pNs4168Sound;
 void SoundSetVolume(int32_t volume);
 void SoundSetDisableSoundTimeout(int32_t timeout_ms);
 void SoundSetPowerOffTimeout(int32_t timeout_ms);
+void SoundSetFlying(bool flying);
 
 void SoundSetAccelParams(int32_t tone_freq_hz, int32_t beep_period_ms);
 void SoundSetSpeedLiftParams(int32_t tone_freq_hz_base, int32_t tone_freq_hz_step, int32_t beep_period_ms_base, int32_t beep_period_ms_step);
@@ -288,4 +298,4 @@ void SoundSetSpeedLiftWaveform(Waveform_t tone_waveform);
 void SoundSetSpeedSinkWaveform(Waveform_t tone_waveform);
 
 void SoundSetVerticalAccel(float vertical_accel);
-void SoundSetVerticalSpeed(float vertical_speed);
+void SoundSetVerticalSpeed(float vertical_speed, uint32_t trace_sequence = 0);
@@ -0,0 +1,38 @@
+/*
+    Pressure to altitude in the ISA troposphere, h = 44330.77 * (1 - (p / 101325)^0.190263), without pow().
+    The altitude is tabulated every 256Pa from 24576Pa to 110592Pa, about 10400m to -700m, in Q16.16 meters, and
+    linearly interpolated. The table is computed by the compiler, the constexpr ln() and exp() of baro_altitude.cpp
+    only run at compile time and nothing of them is left in the firmware but the 1.3KB of the table.
+    The interpolation error is largest at the low pressure end, where the curve bends most, and stays under
+    BARO_ALTITUDE_MAX_ERROR_M over the whole table; pressures out of the table are clamped to its ends.
+
+    Altitudes above a QNH other than the standard pressure are the standard altitudes rescaled:
+        h_qnh(p) = C * (h(p) - h(qnh)) / (C - h(qnh)), C = 44330.77
+    which is exact for the formula above.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "utilities/sme_float.h"
+
+#define BARO_ALTITUDE_STANDARD_PRESSURE     (101325.0f)
+#define BARO_ALTITUDE_SCALE_M               (44330.77)          /* T0 / L of the ISA troposphere */
+#define BARO_ALTITUDE_EXPONENT              (0.190263)          /* R * L / (g * M) */
+
+#define BARO_ALTITUDE_STEP_SHIFT            (8)                 /* 256Pa between table entries */
+#define BARO_ALTITUDE_MIN_PRESSURE          (96 << BARO_ALTITUDE_STEP_SHIFT)
+#define BARO_ALTITUDE_MAX_PRESSURE          (432 << BARO_ALTITUDE_STEP_SHIFT)
+#define BARO_ALTITUDE_TABLE_SIZE            (((BARO_ALTITUDE_MAX_PRESSURE - BARO_ALTITUDE_MIN_PRESSURE) >> BARO_ALTITUDE_STEP_SHIFT) + 1)
+#define BARO_ALTITUDE_MAX_ERROR_M           (0.1f)
+
+/* Standard altitude in Q16.16 meters of a pressure in Q24.8 Pa */
+int32_t PressureToAltitudeQ16(int32_t pressure_q8);
+
+/* Standard altitude in meters, the float32_t one without any floating point operation */
+float PressureToAltitude(float pressure);
+float32_t PressureToAltitude(const float32_t &pressure);
+
+/* Altitude in meters above the QNH in Pa */
+float PressureToAltitude(float pressure, float qnh);
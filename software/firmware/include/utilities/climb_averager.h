@@ -0,0 +1,84 @@
+/*
+    Running averages of the vertical speed over a short and a long window, and over the current thermal. A window is a
+    ring of buckets of the same duration, a sample adds to the bucket of its time and a running sum of the buckets
+    gives the average, the oldest bucket drops out when time moves on to a new one. The window is exact to a bucket
+    whatever the rate of the samples, and a sample costs a few adds, the sums are summed again from the buckets every
+    turn of the ring so the float error doesn't build up. The thermal average is a plain sum since the thermal was
+    entered, and the gain the barometric altitude since then.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define CLIMB_AVERAGER_BUCKETS              (20)
+#define CLIMB_AVERAGER_REPORT_INTERVAL      (1000)      /* ms */
+
+typedef enum {
+    CLIMB_WINDOW_SHORT = 0,
+    CLIMB_WINDOW_LONG,
+    CLIMB_WINDOW_MAX,
+} ClimbWindowIndex_t;
+
+typedef struct {
+    uint32_t duration;                      /* ms, of the window */
+    uint32_t bucket_duration;
+    float sums[CLIMB_AVERAGER_BUCKETS];
+    uint32_t counts[CLIMB_AVERAGER_BUCKETS];
+    uint32_t index;                         /* bucket of the last sample */
+    uint32_t bucket_start;                  /* ms, start of that bucket */
+    uint32_t turns;                         /* buckets since the sums were summed again */
+    float sum;
+    uint32_t count;
+} ClimbWindow_t;
+
+/* Record of the BLE climb characteristic, little endian */
+typedef struct {
+    int16_t vertical_speed;                 /* cm/s, of the last sample */
+    int16_t short_average;                  /* cm/s */
+    int16_t long_average;                   /* cm/s */
+    int16_t thermal_average;                /* cm/s, of the current or the last thermal */
+    int16_t thermal_gain;                   /* m */
+    uint16_t thermal_duration;              /* s */
+} __attribute__ ((packed)) ClimbRecord_t;
+
+class ClimbAverager {
+public:
+    /* Runtime member variables */
+    ClimbWindow_t m_windows[CLIMB_WINDOW_MAX];
+    bool m_started;
+    float m_vertical_speed;
+    float m_altitude;
+    uint32_t m_timestamp;
+    uint32_t m_report_timestamp;
+    bool m_in_thermal;
+    float m_thermal_sum;
+    uint32_t m_thermal_count;
+    float m_thermal_start_altitude;
+    uint32_t m_thermal_start_timestamp;
+    float m_thermal_gain;
+    uint32_t m_thermal_duration;
+
+public:
+    ClimbAverager(uint32_t short_window, uint32_t long_window);
+    ~ClimbAverager() {}
+
+public:
+    void Reset();
+    bool AddSample(float vertical_speed, float altitude, uint32_t timestamp);
+    void StartThermal();
+    void StopThermal() { m_in_thermal = false; }
+
+    float GetVerticalSpeed() const { return m_vertical_speed; }
+    float GetAverage(ClimbWindowIndex_t window) const;
+    uint32_t GetWindowDuration(ClimbWindowIndex_t window) const { return m_windows[window].duration; }
+    bool IsInThermal() const { return m_in_thermal; }
+    float GetThermalAverage() const;
+    float GetThermalGain() const { return m_thermal_gain; }
+    uint32_t GetThermalDuration() const { return m_thermal_duration; }     /* ms */
+    void GetRecord(ClimbRecord_t *p_record) const;
+
+private:
+    void init_window(ClimbWindow_t *p_window, uint32_t duration);
+    void add_to_window(ClimbWindow_t *p_window, float vertical_speed, uint32_t timestamp);
+};
@@ -0,0 +1,62 @@
+/*
+    Takeoff and landing detection. The glider is moving while the GNSS ground speed is above the takeoff speed or the
+    vario shows a climb or a sink no one stands in, and still while the ground speed is below the landing speed, the
+    vario is quiet and, with an IMU, the vertical acceleration is calm. A takeoff takes the takeoff time of moving and a
+    landing the landing time of still, the speeds and the times of the two apart make the hysteresis, so a launch run or
+    a gust on the hill doesn't start a flight and a ridge soaring in a headwind doesn't end it. Both are dated back to
+    the start of their condition, the airtime and the distance count from there. The barometer samples are the clock,
+    a sample or a fix costs a few compares.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "bluethroat_message.h"
+
+class FlightDetector {
+public:
+    /* Construction member variables */
+    float m_takeoff_speed;                  /* m/s, ground speed */
+    uint32_t m_takeoff_time;                /* ms */
+    float m_landing_speed;
+    uint32_t m_landing_time;
+
+    /* Runtime member variables */
+    FlightState_t m_state;
+    uint32_t m_now;                         /* ms, timestamp of the last barometer sample */
+    float m_vertical_speed;
+    float m_ground_speed;
+    uint32_t m_ground_speed_timestamp;
+    bool m_has_ground_speed;
+    float m_acceleration_activity;          /* m/s^2, smoothed magnitude of the vertical acceleration */
+    uint32_t m_acceleration_timestamp;
+    bool m_has_acceleration;
+    bool m_pending;                         /* the condition of the next state holds since m_pending_timestamp */
+    uint32_t m_pending_timestamp;
+    float m_pending_distance;               /* m flown since then */
+    uint32_t m_takeoff_timestamp;
+    uint32_t m_landing_timestamp;
+    float m_distance;                       /* m flown since the takeoff */
+
+public:
+    FlightDetector(float takeoff_speed, uint32_t takeoff_time, float landing_speed, uint32_t landing_time);
+    ~FlightDetector() {}
+
+public:
+    void Reset();
+    bool AddVerticalSpeed(float vertical_speed, uint32_t timestamp);
+    void AddGroundSpeed(float ground_speed);
+    void AddAcceleration(float vertical_acceleration, uint32_t timestamp);
+
+    FlightState_t GetState() const { return m_state; }
+    bool IsPending() const { return m_pending; }
+    uint32_t GetAirtime() const;            /* ms */
+    float GetDistance() const { return m_distance; }
+    uint32_t GetTakeoffTimestamp() const { return m_takeoff_timestamp; }
+    uint32_t GetLandingTimestamp() const { return m_landing_timestamp; }
+
+private:
+    bool is_moving() const;
+    bool is_still() const;
+};
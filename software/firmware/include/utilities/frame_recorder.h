@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdio.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#include "utilities/task_object.h"
+
+/***********************************************************************************************************************
+* Frame recording file format, all fields are little endian.
+* The file starts with a FrameFileHeader_t and is followed by frames, each frame is a FrameHeader_t followed by size
+* bytes of payload. The payload is the raw data as read from the device, before any processing.
+***********************************************************************************************************************/
+#define FRAME_FILE_MAGIC                    (0x43525442)    // "BTRC"
+#define FRAME_FILE_VERSION                  (1)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;                   /* size of FrameHeader_t, lets a reader skip unknown frame types */
+} __attribute__ ((packed)) FrameFileHeader_t;
+
+typedef enum {
+    FRAME_TYPE_DPS3XX_COEF = 0,             /* Dps3xxCoefRegs_t, recorded once after each device reset */
+    FRAME_TYPE_DPS3XX_DATA,                 /* Dps3xxData_t */
+    FRAME_TYPE_AXP192_PMU_STATUS,           /* Axp192PmuStatus_t */
+    FRAME_TYPE_NMEA_SENTENCE,               /* NMEA sentence without the trailing "\r\n" and '\0' */
+    FRAME_TYPE_BMI270_FIFO,                 /* Bmi270FifoFrame_t frames of a FIFO burst */
+    FRAME_TYPE_DPS3XX_MODE,                 /* Dps3xxMode_t as a byte, recorded at each switch of the mode */
+    FRAME_TYPE_MAX,
+} FrameType_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t source;                         /* I2C address of the device, or UART port of the GNSS module */
+    uint8_t size;                           /* size of the payload following the header */
+    uint32_t timestamp;                     /* milliseconds since boot, as esp_log_timestamp() */
+} __attribute__ ((packed)) FrameHeader_t;
+
+#define FRAME_MAX_PAYLOAD_SIZE              (0xff)
+
+/***********************************************************************************************************************
+* @brief Frame recorder class
+* Sensor tasks append frames to one of two RAM buffers, a full buffer is handed over to the recorder task which writes
+* it to the file, so the sensor tasks never wait for the flash. When the recorder task falls behind and both buffers are
+* in use, frames are dropped and counted. A partially filled buffer is written after FRAME_RECORDER_FLUSH_INTERVAL.
+***********************************************************************************************************************/
+#define FRAME_RECORDER_BUFFER_COUNT         (2)
+#define FRAME_RECORDER_FLUSH_INTERVAL       (pdMS_TO_TICKS(5000))
+#define FRAME_RECORDER_FLUSH_TIMEOUT        (pdMS_TO_TICKS(2000))
+
+class FrameRecorder : public TaskObject {
+public:
+    /* Construction member variables */
+    const char *m_p_path;
+    uint32_t m_buffer_size;
+    uint32_t m_max_file_size;
+
+    /* Runtime member variables */
+    FILE *m_p_file;
+    uint32_t m_file_size;
+    uint8_t *m_p_buffers[FRAME_RECORDER_BUFFER_COUNT];
+    uint32_t m_buffer_lengths[FRAME_RECORDER_BUFFER_COUNT];
+    bool m_buffer_busy[FRAME_RECORDER_BUFFER_COUNT];
+    uint32_t m_active_buffer;
+    uint32_t m_dropped_frames;
+    bool m_file_full;
+
+    /* Synchronization member variables */
+    SemaphoreHandle_t m_mutex;
+    QueueHandle_t m_write_queue;            /* indexes of the buffers waiting to be written */
+
+public:
+    FrameRecorder(const char *p_path, uint32_t buffer_size, uint32_t max_file_size);
+    ~FrameRecorder();
+
+public:
+    esp_err_t init_device();
+    esp_err_t deinit_device();
+    void task_cpp_entry();
+
+public:
+    esp_err_t Record(FrameType_t type, uint8_t source, uint32_t timestamp, const void *p_data, uint8_t size);
+    esp_err_t Flush();
+
+private:
+    bool submit_active_buffer();
+    void write_buffer(uint32_t index);
+};
+
+extern FrameRecorder *g_pFrameRecorder;
+
+esp_err_t FrameRecorderRecord(FrameType_t type, uint8_t source, const void *p_data, uint8_t size);
+esp_err_t FrameRecorderRecordAt(FrameType_t type, uint8_t source, uint32_t timestamp, const void *p_data, uint8_t size);
+esp_err_t FrameRecorderFlush();
@@ -0,0 +1,85 @@
+/*
+    Speed to fly and final glide. Every GNSS fix gives the course, to the waypoint when one is selected and along the
+    track otherwise, and the wind of the last circles splits into a tailwind along it and a crosswind across it. The
+    MacCready speed to fly is the airspeed of the tangent to the polar from the MacCready setting above the netto of the
+    air, moved back by the tailwind, sink' * (v + u) = sink + m - w, the root of a quadratic for the quadratic polar. The
+    polar is of the indicated airspeed at the sea level density, the speeds, the tailwind and the setting are scaled to
+    it by the square root of the density ratio and back. The netto is the mean since the previous fix, smoothed over a
+    few fixes, so the speed to fly follows the air without a jump for every gust.
+    The final glide is flown at the speed to fly of the still air, a thermal on the way promises nothing: the glide
+    ratio over the ground it makes with the wind against the one the height above the waypoint and the margin leaves for
+    the distance to it, and the height over the margin it arrives with. A fix costs a few float operations, whatever
+    the flight, and nothing allocates.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "bluethroat_message.h"
+#include "utilities/glider_polar.h"
+
+/* Weight of the netto of a fix in the smoothed one, about 5 fixes */
+#define GLIDE_COMPUTER_NETTO_ALPHA          (0.2f)
+/* Glide ratio shown as unreachable, a glide above it is of a glider that doesn't sink */
+#define GLIDE_COMPUTER_MAX_GLIDE            (99.0f)
+
+class GlideComputer {
+public:
+    /* Construction member variables */
+    float m_maccready;                      /* m/s */
+    float m_margin;                         /* m, above the waypoint to arrive with */
+
+    /* Runtime member variables */
+    bool m_has_waypoint;
+    int32_t m_waypoint_latitude_minutes;    /* whole minutes, north positive */
+    float m_waypoint_latitude_second;
+    int32_t m_waypoint_longitude_minutes;   /* east positive */
+    float m_waypoint_longitude_second;
+    float m_waypoint_altitude;              /* m */
+    float m_wind_east;                      /* m/s, velocity of the air mass */
+    float m_wind_north;
+    float m_netto_sum;
+    uint32_t m_netto_count;
+    float m_netto;                          /* m/s, smoothed over the fixes */
+    bool m_has_netto;
+    bool m_valid;
+    float m_course;                         /* degrees, to the waypoint or of the track */
+    float m_tailwind;                       /* m/s, along the course */
+    float m_crosswind;                      /* m/s, across it, positive from the left */
+    float m_speed_to_fly;                   /* m/s, true airspeed in the netto */
+    float m_final_glide_speed;              /* m/s, true airspeed in still air */
+    float m_distance;                       /* m to the waypoint */
+    float m_required_glide;                 /* over the ground, to the waypoint and the margin */
+    float m_glide;                          /* over the ground at the final glide speed */
+    float m_arrival_altitude;               /* m above the waypoint and the margin, -FLT_MAX without headway */
+
+public:
+    GlideComputer(float maccready, float margin);
+    ~GlideComputer() {}
+
+public:
+    void Reset();
+    void SetMacCready(float maccready) { m_maccready = maccready; }
+    float GetMacCready() const { return m_maccready; }
+    void SetWaypoint(int32_t latitude, int32_t longitude, float altitude);
+    void ClearWaypoint() { m_has_waypoint = false; }
+    void SetWind(float east, float north);
+    void AddNetto(float netto);
+    void AddFix(const GnssRmcData_t *p_rmc, float altitude, const GliderPolar *p_polar, float density_ratio);
+
+    bool HasWaypoint() const { return m_has_waypoint; }
+    bool IsValid() const { return m_valid; }
+    float GetCourse() const { return m_course; }
+    float GetTailwind() const { return m_tailwind; }
+    float GetSpeedToFly() const { return m_speed_to_fly; }
+    float GetFinalGlideSpeed() const { return m_final_glide_speed; }
+    float GetDistance() const { return m_distance; }
+    float GetRequiredGlide() const { return m_required_glide; }
+    float GetGlide() const { return m_glide; }
+    float GetArrivalAltitude() const { return m_arrival_altitude; }
+
+private:
+    void locate_waypoint(const GnssRmcData_t *p_rmc, float *p_east, float *p_north) const;
+    float speed_to_fly(const GliderPolar *p_polar, float density_ratio, float netto) const;
+};
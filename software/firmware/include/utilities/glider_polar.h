@@ -0,0 +1,34 @@
+/*
+    Speed polar of the wing: the sink in still air as a quadratic of the airspeed, sink = a * v^2 + b * v + c, fitted
+    through three measured points, typically the minimum sink, the trim and the full speed bar. The sink is positive
+    down and both are at the sea level density of the ISA, the indicated airspeed. The fit is solved once when the
+    points change, GetSink() is a few float operations and never allocates.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+
+#define GLIDER_POLAR_POINTS                 (3)
+
+class GliderPolar {
+public:
+    /* Runtime member variables */
+    float m_a;                              /* s/m */
+    float m_b;
+    float m_c;                              /* m/s */
+    float m_min_sink_speed;                 /* m/s, the vertex of the parabola */
+    float m_min_sink;                       /* m/s */
+
+public:
+    GliderPolar();
+    ~GliderPolar() {}
+
+public:
+    esp_err_t SetPoints(const float *p_speeds, const float *p_sinks);
+    float GetSink(float speed) const { return (m_a * speed + m_b) * speed + m_c; }
+    float GetMinSinkSpeed() const { return m_min_sink_speed; }
+    float GetMinSink() const { return m_min_sink; }
+};
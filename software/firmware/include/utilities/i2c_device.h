@@ -5,7 +5,7 @@
 #include "utilities/task_object.h"
 #include "utilities/i2c_master.h"
 
-#define MAX_RAW_DATA_BUFFER_LENGTH		(32)
+#define MAX_RAW_DATA_BUFFER_LENGTH		(128)		/* a BMI270 FIFO burst, the largest fetch, must fit */
 
 class I2cDevice : public TaskObject{
 public:
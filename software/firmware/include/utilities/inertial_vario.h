@@ -0,0 +1,44 @@
+/*
+    Kalman filter of the altitude driven by the vertical acceleration of the IMU, corrected by the barometric altitude.
+    The state is the altitude, the vertical speed and the bias of the measured vertical acceleration. Between the
+    barometer samples the state is moved by the measured acceleration, Propagate() runs for every acceleration message,
+    and every barometer sample corrects it, Correct(). The acceleration noise is the rms of the measured vertical
+    acceleration, mostly the attitude error in turns, and the bias noise the rate its slow part drifts at.
+    Unlike KalmanVario, which has to wait for the altitude to move before it sees a change of the vertical speed, the
+    vertical speed follows the measured acceleration right away and the barometer only takes out its drift.
+    The matrices are fixed size members, neither call allocates nor locks.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define INERTIAL_VARIO_ORDER                (3)
+
+class InertialVario {
+public:
+    /* Construction member variables */
+    float m_acceleration_noise;             /* rms of the measured vertical acceleration, m/s^2 */
+    float m_bias_noise;                     /* random walk of the acceleration bias, m/s^2/sqrt(s) */
+    float m_measurement_noise;              /* rms of the altitude samples, m */
+
+    /* Runtime member variables */
+    bool m_initialized;
+    float m_state[INERTIAL_VARIO_ORDER];    /* altitude, vertical speed, acceleration bias */
+    float m_covariance[INERTIAL_VARIO_ORDER][INERTIAL_VARIO_ORDER];
+
+public:
+    InertialVario(float acceleration_noise, float bias_noise, float measurement_noise);
+    ~InertialVario() {}
+
+public:
+    void SetNoise(float acceleration_noise, float bias_noise, float measurement_noise);
+    void Reset();
+    bool IsInitialized() const { return m_initialized; }
+    float Propagate(float acceleration, float delta_time);
+    float Correct(float altitude);
+
+    float GetAltitude() const { return m_state[0]; }
+    float GetVerticalSpeed() const { return m_state[1]; }
+    float GetBias() const { return m_state[2]; }
+};
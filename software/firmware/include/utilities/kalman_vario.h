@@ -0,0 +1,50 @@
+/*
+    Kalman filter of the altitude, estimating the vertical speed from barometric altitude samples.
+    The state is the altitude and the vertical speed, optionally with the vertical acceleration, moved from sample to
+    sample by a constant speed (or constant acceleration) model. The model is disturbed by a piecewise constant
+    acceleration (or jerk) white noise between the samples, the process noise, and every sample is a measurement of the
+    altitude with a white noise, the measurement noise. A larger process noise follows changes of the vertical speed
+    sooner and lets through more of the measurement noise.
+    The matrices are fixed size members, Update() neither allocates nor locks, it costs a few dozen float operations.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define KALMAN_VARIO_MAX_ORDER              (3)
+
+typedef enum {
+    KALMAN_VARIO_ORDER_SPEED = 2,           /* altitude, vertical speed */
+    KALMAN_VARIO_ORDER_ACCELERATION = 3,    /* altitude, vertical speed, vertical acceleration */
+} KalmanVarioOrder_t;
+
+class KalmanVario {
+public:
+    /* Construction member variables */
+    KalmanVarioOrder_t m_order;
+    float m_process_noise;                  /* rms of the acceleration (order 2, m/s^2) or jerk (order 3, m/s^3) */
+    float m_measurement_noise;              /* rms of the altitude samples, m */
+
+    /* Runtime member variables */
+    bool m_initialized;
+    float m_state[KALMAN_VARIO_MAX_ORDER];
+    float m_covariance[KALMAN_VARIO_MAX_ORDER][KALMAN_VARIO_MAX_ORDER];
+
+public:
+    KalmanVario(KalmanVarioOrder_t order, float process_noise, float measurement_noise);
+    ~KalmanVario() {}
+
+public:
+    void SetNoise(float process_noise, float measurement_noise);
+    void Reset();
+    float Update(float altitude, float delta_time);
+
+    float GetAltitude() const { return m_state[0]; }
+    float GetVerticalSpeed() const { return m_state[1]; }
+    float GetAcceleration() const { return (m_order == KALMAN_VARIO_ORDER_ACCELERATION) ? m_state[2] : 0.0f; }
+
+private:
+    void predict(float delta_time);
+    void correct(float altitude);
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/timers.h>
+
+/***********************************************************************************************************************
+* Stages of a barometer sample on its way to the speaker, each stamped with esp_timer_get_time()
+***********************************************************************************************************************/
+typedef enum {
+    LATENCY_STAGE_FETCH = 0,                /* Dps3xxBarometer::fetch_data has read the measurement */
+    LATENCY_STAGE_DEQUEUE,                  /* the message processor takes the sample off its queue */
+    LATENCY_STAGE_VARIO,                    /* CalculateVerticalSpeed returns */
+    LATENCY_STAGE_SOUND_SET,                /* SoundSetVerticalSpeed hands the vertical speed to the sound task */
+    LATENCY_STAGE_I2S_WRITE,                /* the first I2sMaster::Write carrying the new tone returns */
+    LATENCY_STAGE_MAX,
+} LatencyStage_t;
+
+/* 0 is never a valid sequence, messages and drivers use it for "not traced" */
+#define LATENCY_TRACE_NO_SEQUENCE           (0)
+
+/***********************************************************************************************************************
+* Histogram of the latency from LATENCY_STAGE_FETCH to each later stage, bins are limited by the upper edges in ms.
+***********************************************************************************************************************/
+#define LATENCY_HISTOGRAM_BINS              (11)
+#define LATENCY_HISTOGRAM_EDGES_MS          {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, UINT32_MAX}
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t bins[LATENCY_HISTOGRAM_BINS];
+} LatencyHistogram_t;
+
+typedef struct {
+    uint32_t sequence;
+    bool completed;
+    int64_t stamps_us[LATENCY_STAGE_MAX];
+} LatencyRecord_t;
+
+/***********************************************************************************************************************
+* @brief Latency trace class
+* A ring of records indexed by the sample sequence number, a record is completed by its I2S write stamp and added to the
+* histograms. The sound task only plays the latest vertical speed, so records overwritten before completion are the
+* samples whose tone has never been played, they are counted as superseded.
+* All stamps are taken in a short critical section. The report timer posts a report request to the message queue, the
+* message processor logs the report and sends it over BLE, off the small stack of the timer service task.
+***********************************************************************************************************************/
+#define LATENCY_TRACE_RING_SIZE             (32)
+
+class LatencyTrace {
+public:
+    /* Construction member variables */
+    TickType_t m_report_interval_ticks;
+
+    /* Runtime member variables */
+    uint32_t m_next_sequence;
+    LatencyRecord_t m_records[LATENCY_TRACE_RING_SIZE];
+    LatencyHistogram_t m_histograms[LATENCY_STAGE_MAX];
+    uint32_t m_superseded_samples;
+    TimerHandle_t m_report_timer;
+    QueueHandle_t m_queue_handle;           /* of the message processor, the report requests go to it */
+
+    /* Synchronization member variables */
+    portMUX_TYPE m_spinlock;
+
+public:
+    LatencyTrace(TickType_t report_interval_ticks);
+    ~LatencyTrace();
+
+public:
+    esp_err_t Init();
+    uint32_t Begin();
+    void Stamp(uint32_t sequence, LatencyStage_t stage);
+    void GetHistograms(LatencyHistogram_t *p_histograms, uint32_t *p_superseded_samples);
+    void SetMessageQueue(QueueHandle_t queue_handle) { m_queue_handle = queue_handle; }
+    void RequestReport();
+    void Report();
+
+private:
+    void complete_record(LatencyRecord_t *p_record);
+};
+
+extern LatencyTrace *g_pLatencyTrace;
+
+uint32_t LatencyTraceBegin();
+void LatencyTraceStamp(uint32_t sequence, LatencyStage_t stage);
+void LatencyTraceReport();
@@ -0,0 +1,84 @@
+/*
+    Redundant static pressure of the two DPS3xx, when the second one is a static port instead of a pitot anemometer.
+    Each port keeps its last sample and its health: a pressure out of the range of flight or a sample repeated for
+    a while is a failed sensor, and a port that stops sending is failed once its last sample is older than the max
+    age. While both ports are healthy, the offset of the second one to the first, their calibrations are apart by up to
+    1 hPa, is learned with a slow low pass, and the two ports disagree when the difference of their filtered pressures
+    strays from it by more than the max difference for a few samples in a row.
+    The first port drives the vario, the second one only when the first one has failed, moved onto the first one by
+    the offset so the altitude doesn't jump. In the average mode the sample that drives the vario is the mean of both
+    ports, the last sample of the other one moved by the offset, which lowers the white noise of the sensors by about
+    sqrt(2) without a filter. Two ports that disagree can't tell which one is wrong, the vario then follows the first
+    one alone until they agree again. In the cross-check mode the second port is only a standby. A sample costs a few
+    compares and adds.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "bluethroat_message.h"
+
+/* Static pressure of flight, Pa, below about 9000 m and above the lowest sea level pressure */
+#define REDUNDANT_STATIC_MIN_PRESSURE       (30000.0f)
+#define REDUNDANT_STATIC_MAX_PRESSURE       (110000.0f)
+/* Samples with the same pressure make a stuck sensor, the noise of a working one changes every sample */
+#define REDUNDANT_STATIC_STUCK_SAMPLES      (8)
+/* Samples in a row the ports have to disagree, or agree again, for the state to change */
+#define REDUNDANT_STATIC_DISAGREE_SAMPLES   (8)
+/* Smoothing of the offset, a time constant of about 100 samples */
+#define REDUNDANT_STATIC_OFFSET_ALPHA       (0.01f)
+
+typedef enum {
+    REDUNDANT_STATIC_AVERAGE = 0,
+    REDUNDANT_STATIC_CROSS_CHECK,
+} RedundantStaticMode_t;
+
+typedef enum {
+    STATIC_PORT_PRIMARY = 0,                /* the barometer */
+    STATIC_PORT_SECONDARY,                  /* the second DPS3xx */
+    STATIC_PORT_MAX,
+} StaticPortIndex_t;
+
+typedef struct {
+    BarometerData_t sample;                 /* last one */
+    bool has_sample;
+    uint32_t repeat_count;                  /* samples with the pressure of the last one */
+    bool failed;
+    uint32_t failed_timestamp;              /* ms, of the sample it failed on */
+} StaticPort_t;
+
+class RedundantStatic {
+public:
+    /* Construction member variables */
+    RedundantStaticMode_t m_mode;
+    uint32_t m_max_age;                     /* ms */
+    float m_max_difference;                 /* Pa */
+
+    /* Runtime member variables */
+    StaticPort_t m_ports[STATIC_PORT_MAX];
+    float m_offset;                         /* Pa, second port minus the first one */
+    bool m_has_offset;
+    uint32_t m_disagree_count;              /* samples in a row against the current state */
+    bool m_disagree;
+    uint32_t m_fused_count;                 /* samples that drove the vario as the mean of both ports */
+
+public:
+    RedundantStatic(RedundantStaticMode_t mode, uint32_t max_age, float max_difference);
+    ~RedundantStatic() {}
+
+public:
+    void Reset();
+    bool AddSample(StaticPortIndex_t port, BarometerData_t *p_data);
+
+    bool IsFailed(StaticPortIndex_t port) const { return m_ports[port].failed; }
+    uint32_t GetFailedTimestamp(StaticPortIndex_t port) const { return m_ports[port].failed_timestamp; }
+    bool IsDisagreeing() const { return m_disagree; }
+    float GetOffset() const { return m_offset; }
+    uint32_t GetFusedCount() const { return m_fused_count; }
+
+private:
+    void check_health(StaticPortIndex_t port, const BarometerData_t *p_data);
+    bool is_usable(StaticPortIndex_t port, uint32_t timestamp) const;
+    void compare_ports();
+};
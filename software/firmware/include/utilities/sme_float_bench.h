@@ -0,0 +1,24 @@
+/*
+    Benchmark of float32_t (sme_float.h) against the hardware float and a Q-format integer implementation.
+    Every float32_t operator, the DPS3xx compensation polynomial of Dps3xxBarometer::process_data and the NMEA seconds
+    conversion of NeoM9nGnss are timed with the CPU cycle counter over the same operands, and the results of each
+    implementation are compared with a double precision reference.
+    Q-format values are Q16.16 in int32_t, except the compensated pressure which is Q24.8 to hold 110000Pa.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#define SME_FLOAT_BENCH_SAMPLES             (64)    /* operands per round, small enough to stay in the data cache */
+
+typedef enum {
+    SME_FLOAT_BENCH_IMPL_FLOAT32_T = 0,
+    SME_FLOAT_BENCH_IMPL_FLOAT,
+    SME_FLOAT_BENCH_IMPL_FIXED,
+    SME_FLOAT_BENCH_IMPL_MAX,
+} SmeFloatBenchImpl_t;
+
+/* Run every case for the given number of rounds and log the table, returns ESP_FAIL if a result is out of tolerance */
+esp_err_t SmeFloatBenchmark(uint32_t rounds);
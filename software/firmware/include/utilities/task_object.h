@@ -27,6 +27,8 @@ public:
 public:
     esp_err_t create_task();
     esp_err_t delete_task();
+    uint32_t task_index() const;
+    BaseType_t send_message(const BluethroatMsg_t *p_message);
 
 public:
     virtual esp_err_t init_device() = 0;
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/timers.h>
+
+#include "bluethroat_task.h"
+
+/***********************************************************************************************************************
+* One slot per task of g_TaskParam, the last slot collects the messages dropped by senders which are not in the table,
+* e.g. the NimBLE host task and the touch callback of LVGL.
+***********************************************************************************************************************/
+#define TASK_STATS_INDEX_OTHER              (TASK_INDEX_MAX)
+#define TASK_STATS_SLOTS                    (TASK_INDEX_MAX + 1)
+#define TASK_STATS_REPORT_INTERVAL_MS       (5000)
+
+typedef struct {
+    uint32_t loops;                         /* loops completed since boot */
+    uint32_t duration_max_us;               /* loop duration, from the wake-up or the fetched data to the next wait */
+    uint64_t duration_total_us;
+    uint32_t jitter_max_us;                 /* wake-up later than the previous loop end plus task_interval */
+    uint64_t jitter_total_us;
+    uint32_t stack_high_water;              /* minimum free stack in bytes, 0 if the task is unknown */
+    uint32_t dropped_messages;              /* failed xQueueSend to the message processor */
+} TaskStats_t;
+
+/* Record of the BLE task statistics characteristic, one per slot, little endian */
+typedef struct {
+    uint8_t index;
+    uint32_t loops;
+    uint32_t duration_mean_us;
+    uint32_t duration_max_us;
+    uint32_t jitter_mean_us;
+    uint32_t jitter_max_us;
+    uint32_t stack_high_water;
+    uint32_t dropped_messages;
+} __attribute__ ((packed)) TaskStatsRecord_t;
+
+/***********************************************************************************************************************
+* @brief Task statistics class
+* Every task loop is bracketed by LoopBegin and LoopEnd, the begin is stamped when the task wakes up and the end before
+* it waits again in vTaskDelay or xQueueReceive. A driver loop marks LoopFetched when fetch_data returns, its duration
+* starts there, so the waits inside fetch_data, e.g. the DPS3xx barometer waiting for its burst, are not counted as work.
+* For a task waiting on events with a zero task_interval the jitter is the time spent waiting for the event.
+* The stack high-water mark is read from the task handle seen by the first LoopBegin, only when the stats are read.
+* The report timer only posts a report request to the message queue, the timer service task has a small stack and
+* serves every other timer. The message processor makes the report, the GUI update waits for LVGL there.
+***********************************************************************************************************************/
+class TaskStats {
+public:
+    /* Construction member variables */
+    TickType_t m_report_interval_ticks;
+
+    /* Runtime member variables */
+    TaskStats_t m_stats[TASK_STATS_SLOTS];
+    TaskHandle_t m_task_handles[TASK_STATS_SLOTS];
+    int64_t m_loop_begin_us[TASK_STATS_SLOTS];
+    int64_t m_loop_work_us[TASK_STATS_SLOTS];   /* start of the duration, the begin or the fetched data */
+    int64_t m_last_loop_end_us[TASK_STATS_SLOTS];
+    TimerHandle_t m_report_timer;
+    QueueHandle_t m_queue_handle;           /* of the message processor, the report requests go to it */
+
+    /* Synchronization member variables */
+    portMUX_TYPE m_spinlock;
+
+public:
+    TaskStats(TickType_t report_interval_ticks);
+    ~TaskStats();
+
+public:
+    esp_err_t Init();
+    void LoopBegin(uint32_t index);
+    void LoopFetched(uint32_t index);
+    void LoopEnd(uint32_t index);
+    void QueueSendFailed(uint32_t index);
+    void Get(uint32_t index, TaskStats_t *p_stats);
+    void SetMessageQueue(QueueHandle_t queue_handle) { m_queue_handle = queue_handle; }
+    void RequestReport();
+    void Report();
+};
+
+extern TaskStats *g_pTaskStats;
+
+const char *TaskStatsName(uint32_t index);
+void TaskStatsLoopBegin(uint32_t index);
+void TaskStatsLoopFetched(uint32_t index);
+void TaskStatsLoopEnd(uint32_t index);
+BaseType_t TaskStatsQueueSend(uint32_t index, QueueHandle_t queue_handle, const void *p_item);
+esp_err_t TaskStatsGet(uint32_t index, TaskStats_t *p_stats);
+esp_err_t TaskStatsGetRecord(uint32_t index, TaskStatsRecord_t *p_record);
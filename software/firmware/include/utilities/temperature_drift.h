@@ -0,0 +1,92 @@
+/*
+    Temperature drift of the barometer. The compensation of the DPS3xx leaves the pressure off by a few Pa per degree
+    of the die, a sensor warming in the sun reads a slowly falling pressure, a false climb of a few meters. The drift
+    is modelled as linear in the temperature since the first sample, p = p_true + k * (t - t0), and every sample is
+    corrected by it, so the altitude at power-up stays the one the QNH was set to.
+    On the ground before the first takeoff the true pressure doesn't move, k is the least squares slope of the
+    pressure against the temperature, used once the temperature has spanned the min span, with the variance of that
+    slope. In flight each GNSS altitude gives the pressure error of the uncorrected sample, and a Kalman filter of k, of
+    a slope of the error against the altitude and of an offset is corrected by it. The temperature of the air falls as
+    the glider climbs, and the barometric altitude of a day warmer or colder than the ISA is off in proportion to the
+    height climbed, the altitude slope keeps that one out of k; the offset takes the geoid and the QNH, and follows the
+    slow wander of the GNSS altitude. k only moves when the temperature moves more than the altitude explains, by the
+    sun or by the sensor heating itself: a few minutes on the ground give a k the GNSS noise hardly moves, without them
+    the flight learns it.
+    The correction applied moves to the one of k by a small step per sample, a new k doesn't make the altitude jump.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "bluethroat_message.h"
+
+#define TEMPERATURE_DRIFT_ORDER                 (3)         /* k, Pa/C, altitude slope, Pa/km, offset, Pa */
+
+/* Largest drift believed, Pa per degree, a fit beyond it is of something else */
+#define TEMPERATURE_DRIFT_MAX_COEFFICIENT       (20.0f)
+/* Largest change of the correction, Pa per sample, about 0.05 m/s at the single shot rate */
+#define TEMPERATURE_DRIFT_MAX_STEP              (0.1f)
+/* Variance of k before it is learned, (Pa/C)^2 */
+#define TEMPERATURE_DRIFT_INITIAL_VARIANCE      (100.0f)
+/* Variance of the altitude slope at the takeoff, (Pa/km)^2, a day 15 C off the ISA is about 600 Pa/km */
+#define TEMPERATURE_DRIFT_SLOPE_VARIANCE        (360000.0f)
+/* Process noise per GNSS fix, of k, (Pa/C)^2, of the slope, (Pa/km)^2, and of the offset, Pa^2 */
+#define TEMPERATURE_DRIFT_COEFFICIENT_NOISE     (0.0001f)
+#define TEMPERATURE_DRIFT_SLOPE_NOISE           (1.0f)
+#define TEMPERATURE_DRIFT_OFFSET_NOISE          (0.01f)
+/* Rms of the GNSS altitude, m */
+#define TEMPERATURE_DRIFT_GNSS_NOISE            (5.0f)
+/* Smallest residual variance of the ground fit, Pa^2, about the noise of a sample */
+#define TEMPERATURE_DRIFT_MIN_RESIDUAL          (1.0f)
+
+class TemperatureDrift {
+public:
+    /* Construction member variables */
+    float m_min_span;                       /* C */
+    bool m_gnss_correction;
+
+    /* Runtime member variables */
+    bool m_has_sample;
+    float m_reference_temperature;          /* C, of the first sample */
+    float m_reference_pressure;             /* Pa */
+    float m_temperature;                    /* C, of the last sample */
+    float m_pressure;                       /* Pa, of the last sample, uncorrected */
+    float m_coefficient;                    /* Pa per C */
+    float m_variance;                       /* of the coefficient */
+    bool m_learned;
+    float m_correction;                     /* Pa, applied to the last sample */
+    uint32_t m_ground_count;                /* running means and sums of squares of the ground fit */
+    float m_ground_temperature;
+    float m_ground_pressure;
+    float m_ground_temperature_square;
+    float m_ground_temperature_pressure;
+    float m_ground_pressure_square;
+    float m_min_temperature;
+    float m_max_temperature;
+    bool m_has_fix;
+    float m_reference_altitude;             /* m, of the first GNSS fix in flight */
+    float m_state[TEMPERATURE_DRIFT_ORDER];
+    float m_covariance[TEMPERATURE_DRIFT_ORDER][TEMPERATURE_DRIFT_ORDER];
+    uint32_t m_gnss_count;                  /* fixes the flight filter was corrected by */
+
+public:
+    TemperatureDrift(float min_span, bool gnss_correction);
+    ~TemperatureDrift() {}
+
+public:
+    void Reset();
+    void AddSample(BarometerData_t *p_data, bool on_ground);
+    void AddGnssAltitude(float gnss_altitude, float barometric_altitude);
+
+    bool IsLearned() const { return m_learned; }
+    float GetCoefficient() const { return m_coefficient; }
+    float GetVariance() const { return m_variance; }
+    float GetCorrection() const { return m_correction; }
+    uint32_t GetGnssCount() const { return m_gnss_count; }
+
+private:
+    void learn_on_ground(float temperature, float pressure);
+    void correct_flight(const float *p_measurement, float error, float error_variance);
+    void set_coefficient(float coefficient);
+};
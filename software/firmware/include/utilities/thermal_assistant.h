@@ -0,0 +1,81 @@
+/*
+    Thermal centering assistant. Every GNSS fix adds a sample, the barometric altitude and the mean climb since the
+    previous fix at the middle of the way flown since it, to a fixed size ring. The glider is circling while the turn
+    rate of its track, smoothed over a few fixes, stays above a threshold, with hysteresis, and a thermal starts with the
+    circles. The core of the thermal is the centroid of the positions of the thermal, weighted by how much more they
+    climbed than the weakest one, every position first moved by the drift of the wind since it was flown so the core is
+    where the lift is now, not where it was. A fix costs one pass over the ring, whatever the history, and nothing
+    allocates.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "bluethroat_message.h"
+
+#define THERMAL_ASSISTANT_HISTORY           (64)
+
+typedef struct {
+    float east;                             /* m from the first fix */
+    float north;
+    float altitude;                         /* m, barometric */
+    float climb;                            /* m/s, mean since the previous fix */
+    uint32_t timestamp;                     /* ms of the UTC day of the fix */
+} ThermalSample_t;
+
+class ThermalAssistant {
+public:
+    /* Runtime member variables */
+    ThermalSample_t m_samples[THERMAL_ASSISTANT_HISTORY];
+    uint32_t m_index;                       /* slot of the next sample */
+    uint32_t m_count;
+    bool m_has_origin;
+    int32_t m_origin_latitude_minutes;      /* whole minutes of the first fix, north positive */
+    int32_t m_origin_longitude_minutes;     /* east positive */
+    float m_meters_per_longitude_second;
+    float m_east;                           /* m from the first fix, of the last fix */
+    float m_north;
+    float m_climb_sum;
+    uint32_t m_climb_count;
+    float m_last_climb;
+    float m_last_track;
+    uint32_t m_last_timestamp;
+    float m_turn_rate;                      /* degrees/s, smoothed, positive to the right */
+    bool m_circling;
+    uint32_t m_thermal_samples;             /* samples of the ring since the circles started */
+    float m_thermal_start_altitude;
+    uint32_t m_thermal_start_timestamp;
+    float m_wind_east;                      /* m/s, drift of the air mass */
+    float m_wind_north;
+    bool m_core_valid;
+    float m_core_east;                      /* m from the first fix, at the time of the last fix */
+    float m_core_north;
+    float m_thermal_climb;                  /* m/s, mean over the thermal */
+
+public:
+    ThermalAssistant();
+    ~ThermalAssistant() {}
+
+public:
+    void Reset();
+    void SetWind(float east, float north);
+    void AddClimb(float climb);
+    bool AddFix(const GnssRmcData_t *p_rmc, float altitude);
+
+    uint32_t GetSampleCount() const { return m_count; }
+    const ThermalSample_t *GetSample(uint32_t age) const;
+    void GetDriftedPosition(uint32_t age, float *p_east, float *p_north) const;
+    bool IsCircling() const { return m_circling; }
+    bool IsCoreValid() const { return m_core_valid; }
+    float GetCoreEast() const;              /* m from the glider */
+    float GetCoreNorth() const;
+    float GetThermalClimb() const { return m_thermal_climb; }
+    float GetThermalGain() const;
+    uint32_t GetThermalDuration() const;    /* ms */
+
+private:
+    void locate(const GnssRmcData_t *p_rmc, float *p_east, float *p_north);
+    void update_circling(float track, uint32_t delta_time);
+    void locate_core();
+};
@@ -0,0 +1,59 @@
+/*
+    Wind from the drift of the circles: while the glider turns at a constant airspeed, its ground velocity vectors lie on
+    a circle whose center is the velocity of the air mass, the wind, and whose radius is the airspeed. The last fixes are
+    kept in a circular buffer and a least squares circle (the algebraic fit of Kasa) is solved from running sums of the
+    buffer, its residual included, so a fix costs an add and a remove of its moments and a 2x2 solve, whatever the
+    window. Once per window the sums are summed again from the buffer against the rounding of the removals, a pass over
+    the window every window fixes. The fit is only trusted once the track has turned through most of a circle within the
+    window and the fixes sit close to the circle, a straight glide or a change of airspeed keeps the last estimate
+    instead.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define WIND_ESTIMATOR_MAX_WINDOW           (64)
+
+class WindEstimator {
+public:
+    /* Construction member variables */
+    uint32_t m_window;                      /* fixes in the fit */
+    float m_min_turn;                       /* degrees the track must turn through within the window */
+
+    /* Runtime member variables */
+    float m_east[WIND_ESTIMATOR_MAX_WINDOW];    /* m/s, ground velocity of the fixes */
+    float m_north[WIND_ESTIMATOR_MAX_WINDOW];
+    float m_turn[WIND_ESTIMATOR_MAX_WINDOW];    /* degrees, track change since the previous fix */
+    uint32_t m_index;                       /* slot of the next fix */
+    uint32_t m_count;
+    float m_last_track;
+    float m_turn_sum;
+    float m_sum_x, m_sum_y, m_sum_xx, m_sum_yy, m_sum_xy, m_sum_z, m_sum_xz, m_sum_yz, m_sum_zz;   /* z = x^2 + y^2 */
+    bool m_valid;
+    float m_wind_east;                      /* m/s, velocity of the air mass */
+    float m_wind_north;
+    float m_airspeed;                       /* m/s, radius of the fitted circle */
+    uint32_t m_age;                         /* fixes since the last fit */
+
+public:
+    WindEstimator(uint32_t window, float min_turn);
+    ~WindEstimator() {}
+
+public:
+    void Reset();
+    bool AddVelocity(float track, float speed);
+
+    bool IsValid() const { return m_valid; }
+    float GetWindEast() const { return m_wind_east; }
+    float GetWindNorth() const { return m_wind_north; }
+    float GetWindSpeed() const;
+    float GetWindDirection() const;
+    float GetAirspeed() const { return m_airspeed; }
+    uint32_t GetAge() const { return m_age; }
+
+private:
+    void accumulate(float x, float y, float sign);
+    void recalculate();
+    bool fit();
+};
@@ -2,6 +2,8 @@
 #include <esp_log.h>
 
 #include "freertos/FreeRTOSConfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "esp_nimble_hci.h"
 #include "host/ble_hs.h"
 #include "host/util/util.h"
@@ -14,6 +16,7 @@
 #include "services/gatt/ble_svc_gatt.h"
 
 #include "bluethroat_message.h"
+#include "utilities/task_stats.h"
 
 #include "bluethroat_bluetooth.h"
 
@@ -53,6 +56,7 @@ static int gatt_access_manufacturer_name(uint16_t conn_handle, uint16_t attr_han
 static int gatt_access_model_number(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg);
 static int gatt_access_pressure(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg);
 static int gatt_access_nordic_tx(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg);
+static int gatt_access_task_stats(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg);
 static int bluetooth_gap_event(struct ble_gap_event *event, void *arg);
 static void bluetooth_advertise(void);
 static void bluetooth_on_sync(void);
@@ -79,6 +83,10 @@ static QueueHandle_t bluethroat_queue_handle = NULL;
             TAS characteristic              (234337bf-f931-4d2d-a13c-07e2f06a0249)
         Nordic UART Service                 (6e400001-b5a3-f393-e0a9-e50e24dcca9e)
             TX characteristic               (6e400003-b5a3-f393-e0a9-e50e24dcca9e)
+        Bluethroat Diagnostics Service      (b7e70001-5c3a-4f0e-9d2b-6f1c2a7d8e90)
+            Task statistics characteristic  (b7e70002-5c3a-4f0e-9d2b-6f1c2a7d8e90), TaskStatsRecord_t per task
+        Bluethroat Flight Service           (b7e70101-5c3a-4f0e-9d2b-6f1c2a7d8e90)
+            Climb characteristic            (b7e70102-5c3a-4f0e-9d2b-6f1c2a7d8e90), ClimbRecord_t every second
         LeBip service + characteristic
         Skydrop (1&2) service + characteristic
         RN4781 service + characteristic
@@ -97,6 +105,10 @@ static const ble_uuid128_t gatt_fbmini_airspeed_service_uuid           = BLE_UUI
 static const ble_uuid128_t gatt_fbmini_tas_characteristic_uuid         = BLE_UUID128_INIT(0x49, 0x02, 0x6a, 0xf0, 0xe2, 0x07, 0x3c, 0xa1, 0x2d, 0x4d, 0x31, 0xf9, 0xbf, 0x37, 0x43 ,0x23);
 static const ble_uuid128_t gatt_nordic_uart_service_uuid               = BLE_UUID128_INIT(0x9e, 0xca, 0xdc, 0x24, 0x0e, 0xe5, 0xa9, 0xe0, 0x93, 0xf3, 0xa3, 0xb5, 0x01, 0x00, 0x40 ,0x6e);
 static const ble_uuid128_t gatt_nordic_tx_characteristic_uuid          = BLE_UUID128_INIT(0x9e, 0xca, 0xdc, 0x24, 0x0e, 0xe5, 0xa9, 0xe0, 0x93, 0xf3, 0xa3, 0xb5, 0x03, 0x00, 0x40 ,0x6e);
+static const ble_uuid128_t gatt_diagnostics_service_uuid               = BLE_UUID128_INIT(0x90, 0x8e, 0x7d, 0x2a, 0x1c, 0x6f, 0x2b, 0x9d, 0x0e, 0x4f, 0x3a, 0x5c, 0x01, 0x00, 0xe7 ,0xb7);
+static const ble_uuid128_t gatt_task_stats_characteristic_uuid         = BLE_UUID128_INIT(0x90, 0x8e, 0x7d, 0x2a, 0x1c, 0x6f, 0x2b, 0x9d, 0x0e, 0x4f, 0x3a, 0x5c, 0x02, 0x00, 0xe7 ,0xb7);
+static const ble_uuid128_t gatt_flight_service_uuid                    = BLE_UUID128_INIT(0x90, 0x8e, 0x7d, 0x2a, 0x1c, 0x6f, 0x2b, 0x9d, 0x0e, 0x4f, 0x3a, 0x5c, 0x01, 0x01, 0xe7 ,0xb7);
+static const ble_uuid128_t gatt_climb_characteristic_uuid              = BLE_UUID128_INIT(0x90, 0x8e, 0x7d, 0x2a, 0x1c, 0x6f, 0x2b, 0x9d, 0x0e, 0x4f, 0x3a, 0x5c, 0x02, 0x01, 0xe7 ,0xb7);
 
 static const char *device_name = "Bluethroat";
 static const char *manufacturer_name = "SnailTrail.ORG";
@@ -110,11 +122,17 @@ static uint16_t pressure_handle = BLE_HS_CONN_HANDLE_NONE;
 static uint16_t battery_level_handle;
 static uint16_t fbmini_tas_handle;
 static uint16_t nordic_tx_handle;
+static uint16_t climb_handle;
 
 static bool pressure_notify_state;
 static bool battery_level_notify_state;
 static bool fbmini_tas_notify_state;
 static bool nordic_tx_notify_state;
+static bool climb_notify_state;
+
+/* Last climb record, for the reads between the notifications, written by MSG_PROC and read by the NimBLE host task */
+static ClimbRecord_t climb_record;
+static portMUX_TYPE climb_record_lock = SPINLOCK_INITIALIZER;
 
 static int gatt_access_manufacturer_name(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
     if (ble_uuid_cmp(ctxt->chr->uuid, &(gatt_manufacturer_name_characteristic_uuid.u)) == 0) {
@@ -164,11 +182,45 @@ static int gatt_access_nordic_tx(uint16_t conn_handle, uint16_t attr_handle, str
     }    
 }
 
+static int gatt_access_task_stats(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
+    if (ble_uuid_cmp(ctxt->chr->uuid, &(gatt_task_stats_characteristic_uuid.u)) == 0) {
+        /* TASK_STATS_SLOTS records fit in one attribute value, a client reads the tail with read blob requests */
+        TaskStatsRecord_t record;
+        for (uint32_t index = 0; index < TASK_STATS_SLOTS; index++) {
+            if (TaskStatsGetRecord(index, &record) != ESP_OK) {
+                return BLE_ATT_ERR_UNLIKELY;
+            } else if (os_mbuf_append(ctxt->om, &record, sizeof(record)) != 0) {
+                return BLE_ATT_ERR_INSUFFICIENT_RES;
+            }
+        }
+        return 0;
+    } else {
+        char buffer[BLE_UUID_STR_LEN];
+        BLUETOOTH_LOGE("Receive access request of unknown characteristic: %s", ble_uuid_to_str(ctxt->chr->uuid, buffer));
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+}
+
+static int gatt_access_climb(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
+    if (ble_uuid_cmp(ctxt->chr->uuid, &(gatt_climb_characteristic_uuid.u)) == 0) {
+        ClimbRecord_t record;
+        taskENTER_CRITICAL(&climb_record_lock);
+        record = climb_record;
+        taskEXIT_CRITICAL(&climb_record_lock);
+        int result = os_mbuf_append(ctxt->om, &record, sizeof(record));
+        return (result == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    } else {
+        char buffer[BLE_UUID_STR_LEN];
+        BLUETOOTH_LOGE("Receive access request of unknown characteristic: %s", ble_uuid_to_str(ctxt->chr->uuid, buffer));
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+}
+
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
 
-static const struct ble_gatt_svc_def gatt_svr_svcs[5] =
+static const struct ble_gatt_svc_def gatt_svr_svcs[7] =
 {
     {
         /* Service: Device Information */
@@ -229,6 +281,41 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[5] =
             },
         }
     },
+    {
+        /* Service: Bluethroat Diagnostics */
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = &(gatt_diagnostics_service_uuid.u),
+        .characteristics = (struct ble_gatt_chr_def[])
+        {
+            {
+                /* Characteristic: Task statistics */
+                .uuid = &(gatt_task_stats_characteristic_uuid.u),
+                .access_cb = gatt_access_task_stats,
+                .flags = BLE_GATT_CHR_F_READ,
+            },
+            {
+                0, /* No more characteristics in this service */
+            },
+        }
+    },
+    {
+        /* Service: Bluethroat Flight */
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = &(gatt_flight_service_uuid.u),
+        .characteristics = (struct ble_gatt_chr_def[])
+        {
+            {
+                /* Characteristic: Climb */
+                .uuid = &(gatt_climb_characteristic_uuid.u),
+                .access_cb = gatt_access_climb,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
+                .val_handle = &climb_handle,
+            },
+            {
+                0, /* No more characteristics in this service */
+            },
+        }
+    },
     {
         .type = 0, /* No more services */
     },
@@ -250,7 +337,7 @@ static void bluetooth_report_state() {
             message.bluetooth_state.nordic_uart_service_state = nordic_tx_notify_state ? SERVICE_STATE_CONNECTED : SERVICE_STATE_DISCONNECTED;
         }
 
-        (void)xQueueSend(bluethroat_queue_handle, &message, 0);
+        (void)TaskStatsQueueSend(TASK_STATS_INDEX_OTHER, bluethroat_queue_handle, &message);
     }
 }
 
@@ -268,6 +355,7 @@ static int bluetooth_gap_event(struct ble_gap_event *event, void *arg) {
             battery_level_notify_state = false;
             fbmini_tas_notify_state = false;
             nordic_tx_notify_state = false;
+            climb_notify_state = false;
 
             bluetooth_advertise();
         } else {
@@ -288,6 +376,7 @@ static int bluetooth_gap_event(struct ble_gap_event *event, void *arg) {
         battery_level_notify_state = false;
         fbmini_tas_notify_state = false;
         nordic_tx_notify_state = false;
+        climb_notify_state = false;
 
         bluetooth_advertise();
         bluetooth_report_state();
@@ -312,6 +401,8 @@ static int bluetooth_gap_event(struct ble_gap_event *event, void *arg) {
             fbmini_tas_notify_state = event->subscribe.cur_notify;
         } else if (event->subscribe.attr_handle == nordic_tx_handle) {
             nordic_tx_notify_state = event->subscribe.cur_notify;
+        } else if (event->subscribe.attr_handle == climb_handle) {
+            climb_notify_state = event->subscribe.cur_notify;
         }
 
         bluetooth_report_state();
@@ -453,4 +544,18 @@ int BluetoothSendGnssNmea(const char *nmea) {
     } else {
         return ESP_OK;
     }
-}
\ No newline at end of file
+}
+
+int BluetoothSendClimb(const ClimbRecord_t *p_record) {
+    struct os_mbuf * om;
+
+    taskENTER_CRITICAL(&climb_record_lock);
+    climb_record = *p_record;
+    taskEXIT_CRITICAL(&climb_record_lock);
+    if (climb_notify_state) {
+        om = ble_hs_mbuf_from_flat(p_record, sizeof(ClimbRecord_t));
+        return ble_gattc_notify_custom(connection_handle, climb_handle, om);
+    } else {
+        return ESP_OK;
+    }
+}
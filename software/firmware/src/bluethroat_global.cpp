@@ -13,7 +13,7 @@ const I2cDevice_t g_I2cDeviceMap[] = {
     [I2C_DEVICE_INDEX_DPS3XX_BAROMETER]     = {.port = I2C_NUM_0,       .addr = 0x0076,     .int_pins = {GPIO_NUM_NC}},
     [I2C_DEVICE_INDEX_DPS3XX_ANEMOMETER]    = {.port = I2C_NUM_0,       .addr = 0x0077,     .int_pins = {GPIO_NUM_NC}},
     [I2C_DEVICE_INDEX_BMP280_BAROMETER]     = {.port = I2C_NUM_0,       .addr = 0x0076,     .int_pins = {GPIO_NUM_NC}},
-    [I2C_DEVICE_INDEX_BMI270_ACCELEROMETER] = {.port = I2C_NUM_0,       .addr = 0x0077,     .int_pins = {GPIO_NUM_NC}},
+    [I2C_DEVICE_INDEX_BMI270_ACCELEROMETER] = {.port = I2C_NUM_0,       .addr = 0x0068,     .int_pins = {GPIO_NUM_NC}},
     [I2C_DEVICE_INDEX_SHT3X_HYGROMETER]     = {.port = I2C_NUM_0,       .addr = 0x0077,     .int_pins = {GPIO_NUM_NC}},
 #elif CONFIG_BLUETHROAD_TARGET_DEVICE_M5CORES3
     [I2C_DEVICE_INDEX_AXP192_PMU]           = {.port = I2C_NUM_0,       .addr = 0x0034,     .int_pins = {GPIO_NUM_NC}},
@@ -36,7 +36,9 @@ const TaskParam_t g_TaskParam[] = {
     [TASK_INDEX_DPS3XX_BAROMETER]       = {.task_name = "DPS3XX_BARO",      .task_stack_size = (2048 * 2),      .task_priority = ((configMAX_PRIORITIES -  8) | portPRIVILEGE_BIT),     .task_core_id = TASK_CORE_1,    .task_interval = (pdMS_TO_TICKS(              0))},
     [TASK_INDEX_DPS3XX_ANEMOMETER]      = {.task_name = "DPS3XX_ANEMO",     .task_stack_size = (2048 * 2),      .task_priority = ((configMAX_PRIORITIES -  8) | portPRIVILEGE_BIT),     .task_core_id = TASK_CORE_1,    .task_interval = (pdMS_TO_TICKS(              0))},
     [TASK_INDEX_NEO_M9N_GNSS]           = {.task_name = "NEO_M9N_GNSS",     .task_stack_size = (2048 * 2),      .task_priority = ((configMAX_PRIORITIES -  8) | portPRIVILEGE_BIT),     .task_core_id = TASK_CORE_1,    .task_interval = (pdMS_TO_TICKS(              0))},
+    [TASK_INDEX_BMI270_IMU]             = {.task_name = "BMI270_IMU",       .task_stack_size = (2048 * 2),      .task_priority = ((configMAX_PRIORITIES -  8) | portPRIVILEGE_BIT),     .task_core_id = TASK_CORE_1,    .task_interval = (pdMS_TO_TICKS(             50))},
     [TASK_INDEX_SOUND]                  = {.task_name = "SOUND",            .task_stack_size = (2048 * 2),      .task_priority = ((configMAX_PRIORITIES -  8) | portPRIVILEGE_BIT),     .task_core_id = TASK_CORE_1,    .task_interval = (pdMS_TO_TICKS(              0))},
+    [TASK_INDEX_FRAME_RECORDER]         = {.task_name = "FRAME_RECORDER",   .task_stack_size = (2048 * 2),      .task_priority = ((tskIDLE_PRIORITY     +  1) | portPRIVILEGE_BIT),     .task_core_id = TASK_CORE_0,    .task_interval = (pdMS_TO_TICKS(              0))},
 #elif CONFIG_BLUETHROAD_TARGET_DEVICE_M5CORES3
 #else
     #error Invalid target device configuration, run menuconfig and reconfigure it properly
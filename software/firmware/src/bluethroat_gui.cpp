@@ -161,6 +161,64 @@ lv_obj_t * bluethroat_draw_vario_meter(lv_obj_t * parent, lv_obj_t * ref, lv_ali
 	return meter;
 }
 
+/* The track of the last fixes, drifted with the wind, around the glider at the center of the map tab. */
+lv_obj_t * bluethroat_draw_thermal_trail(lv_obj_t *parent) {
+	lv_obj_t *line = lv_line_create(parent);
+	lv_obj_set_style_line_width(line, 2, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+	lv_obj_set_style_line_color(line, DEFAULT_THERMAL_TRAIL_COLOR, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+	lv_obj_set_style_line_rounded(line, true, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+	lv_obj_set_pos(line, 0, 0);
+	return line;
+}
+
+lv_obj_t * bluethroat_draw_thermal_marker(lv_obj_t *parent, lv_coord_t size, lv_color_t color) {
+	lv_obj_t *marker = lv_obj_create(parent);
+	lv_obj_set_size(marker, size, size);
+	lv_obj_set_style_radius(marker, LV_RADIUS_CIRCLE, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+	lv_obj_set_style_bg_color(marker, color, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+	lv_obj_set_style_bg_opa(marker, LV_OPA_COVER, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+	lv_obj_set_style_border_width(marker, 0, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+	lv_obj_set_style_pad_all(marker, 0, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+	lv_obj_clear_flag(marker, LV_OBJ_FLAG_SCROLLABLE);
+	return marker;
+}
+
+static lv_coord_t thermal_map_x(float east) {
+	return (lv_coord_t)LV_CLAMP(0, THERMAL_MAP_CENTER_X + (int32_t)lroundf(east * THERMAL_MAP_SCALE), THERMAL_MAP_WIDTH - 1);
+}
+
+static lv_coord_t thermal_map_y(float north) {
+	return (lv_coord_t)LV_CLAMP(0, THERMAL_MAP_CENTER_Y - (int32_t)lroundf(north * THERMAL_MAP_SCALE), THERMAL_MAP_HEIGHT - 1);
+}
+
+static const char *task_stats_columns[] = {"task", "loops", "mean ms", "max ms", "jitter ms", "stack", "drop"};
+static const lv_coord_t task_stats_column_widths[] = {88, 44, 36, 36, 44, 36, 36};
+
+lv_obj_t * bluethroat_draw_task_stats_table(lv_obj_t *parent, lv_obj_t *ref, lv_align_t align, lv_coord_t x, lv_coord_t y) {
+	lv_obj_t *table = lv_table_create(parent);
+	lv_obj_set_style_bg_color(table, DEFAULT_SCREEN_BG_COLOR, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+	lv_obj_set_style_bg_color(table, DEFAULT_SCREEN_BG_COLOR, LV_SELECTOR(LV_PART_ITEMS, LV_STATE_DEFAULT));
+	lv_obj_set_style_text_color(table, DEFAULT_PANEL_VALUE_COLOR, LV_SELECTOR(LV_PART_ITEMS, LV_STATE_DEFAULT));
+	lv_obj_set_style_text_font(table, &antonio_regular_12, LV_SELECTOR(LV_PART_ITEMS, LV_STATE_DEFAULT));
+	lv_obj_set_style_pad_all(table, 1, LV_SELECTOR(LV_PART_ITEMS, LV_STATE_DEFAULT));
+	lv_obj_set_style_border_width(table, 0, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+
+	uint16_t columns = sizeof(task_stats_columns) / sizeof(task_stats_columns[0]);
+	lv_table_set_col_cnt(table, columns);
+	lv_table_set_row_cnt(table, TASK_STATS_SLOTS + 1);
+	for (uint16_t column = 0; column < columns; column++) {
+		lv_table_set_col_width(table, column, task_stats_column_widths[column]);
+		lv_table_set_cell_value(table, 0, column, task_stats_columns[column]);
+	}
+	for (uint16_t row = 1; row <= TASK_STATS_SLOTS; row++) {
+		lv_table_set_cell_value(table, row, 0, TaskStatsName(row - 1));
+	}
+
+	lv_obj_set_size(table, 320, 216);
+	lv_obj_align_to(table, ref, align, x, y);
+	return table;
+}
+
 void BluethroatGui::Init(void) {
 	if (pdTRUE == lvgl_acquire_token()) {
 		m_flying_screen = lv_scr_act();
@@ -181,19 +239,53 @@ void BluethroatGui::Init(void) {
 		lv_obj_clear_flag(m_flying_dashboard_tab, LV_OBJ_FLAG_SCROLLABLE);
 
 		m_vario_meter = bluethroat_draw_vario_meter(m_flying_dashboard_tab, m_flying_dashboard_tab, LV_ALIGN_TOP_LEFT, 4, 20, 180, 180, &m_sink_arc, &m_lift_arc);
-		bluethroat_draw_label(m_flying_dashboard_tab, m_vario_meter, LV_ALIGN_CENTER, 0, 50, 80, 40, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_CENTER, DEFAULT_PANEL_DESCRIPTION_COLOR, &antonio_regular_12, "v-speed\n(m/s)");
+		bluethroat_draw_label(m_flying_dashboard_tab, m_vario_meter, LV_ALIGN_CENTER, 0, 30, 80, 16, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_CENTER, DEFAULT_PANEL_DESCRIPTION_COLOR, &antonio_regular_12, "v-speed (m/s)");
 		m_vario_label = bluethroat_draw_label(m_flying_dashboard_tab, m_vario_meter, LV_ALIGN_CENTER, 0, 0, 80, 40, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_CENTER, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_40, "-99.9");
+		bluethroat_draw_label(m_flying_dashboard_tab, m_vario_meter, LV_ALIGN_CENTER, 0, -60, 80, 16, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_CENTER, DEFAULT_PANEL_DESCRIPTION_COLOR, &antonio_regular_12, "netto / relative");
+		m_netto_label = bluethroat_draw_label(m_flying_dashboard_tab, m_vario_meter, LV_ALIGN_CENTER, 0, -38, 100, 24, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_CENTER, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_20, "-99.9 / -99.9");
+		m_average_label = bluethroat_draw_label(m_flying_dashboard_tab, m_vario_meter, LV_ALIGN_CENTER, 0, 50, 120, 24, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_CENTER, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_20, "--");
+		m_average_description_label = bluethroat_draw_label(m_flying_dashboard_tab, m_vario_meter, LV_ALIGN_CENTER, 0, 72, 96, 16, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_CENTER, DEFAULT_PANEL_DESCRIPTION_COLOR, &antonio_regular_12, "average / thermal");
 
 		m_flying_map_tab = lv_tabview_add_tab(m_flying_tabview, "map");
-		lv_obj_set_style_bg_color(m_flying_map_tab, LV_COLOR_MAKE(0x3f, 0x00, 0x3f), LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+		lv_obj_set_style_bg_color(m_flying_map_tab, DEFAULT_SCREEN_BG_COLOR, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
 		lv_obj_set_style_bg_opa(m_flying_map_tab, DEFAULT_SCREEN_BG_OPACITY, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+		lv_obj_set_style_pad_all(m_flying_map_tab, 0, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
 		lv_obj_clear_flag(m_flying_map_tab, LV_OBJ_FLAG_SCROLLABLE);
 
+		m_thermal_trail		= bluethroat_draw_thermal_trail(m_flying_map_tab);
+		m_thermal_core		= bluethroat_draw_thermal_marker(m_flying_map_tab, THERMAL_MAP_CORE_SIZE, DEFAULT_THERMAL_CORE_COLOR);
+		m_thermal_glider	= bluethroat_draw_thermal_marker(m_flying_map_tab, THERMAL_MAP_GLIDER_SIZE, DEFAULT_THERMAL_GLIDER_COLOR);
+		lv_obj_add_flag(m_thermal_core, LV_OBJ_FLAG_HIDDEN);
+		lv_obj_set_pos(m_thermal_glider, THERMAL_MAP_CENTER_X - THERMAL_MAP_GLIDER_SIZE / 2, THERMAL_MAP_CENTER_Y - THERMAL_MAP_GLIDER_SIZE / 2);
+
+		m_thermal_panel		= bluethroat_draw_panel(m_flying_map_tab, m_flying_map_tab, LV_ALIGN_TOP_LEFT, 0, 16, 104, 44, DEFAULT_PANEL_BG_COLOR, DEFAULT_PANEL_BG_OPACITY, DEFAULT_PANEL_RADIUS, DEFAULT_PANEL_BORDER_WIDTH, DEFAULT_PANEL_BORDER_COLOR, DEFAULT_PANEL_BORDER_OPACITY, DEFAULT_PANEL_PADDING);
+		bluethroat_draw_label(m_thermal_panel, m_thermal_panel, LV_ALIGN_TOP_LEFT, 0, 0, 0, 0, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_LEFT, DEFAULT_PANEL_DESCRIPTION_COLOR, &antonio_regular_12, "Thermal(m/s / gain m)");
+		m_thermal_label		= bluethroat_draw_label(m_thermal_panel, m_thermal_panel, LV_ALIGN_BOTTOM_RIGHT, 0, 0, 96, 20, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_RIGHT, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_20, "--");
+
+		m_wind_panel		= bluethroat_draw_panel(m_flying_map_tab, m_flying_map_tab, LV_ALIGN_TOP_RIGHT, 0, 16, 104, 44, DEFAULT_PANEL_BG_COLOR, DEFAULT_PANEL_BG_OPACITY, DEFAULT_PANEL_RADIUS, DEFAULT_PANEL_BORDER_WIDTH, DEFAULT_PANEL_BORDER_COLOR, DEFAULT_PANEL_BORDER_OPACITY, DEFAULT_PANEL_PADDING);
+		bluethroat_draw_label(m_wind_panel, m_wind_panel, LV_ALIGN_TOP_LEFT, 0, 0, 0, 0, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_LEFT, DEFAULT_PANEL_DESCRIPTION_COLOR, &antonio_regular_12, "Wind(km/h / from)");
+		m_wind_label		= bluethroat_draw_label(m_wind_panel, m_wind_panel, LV_ALIGN_BOTTOM_RIGHT, 0, 0, 96, 20, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_RIGHT, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_20, "--");
+
+		m_speed_to_fly_panel	= bluethroat_draw_panel(m_flying_map_tab, m_flying_map_tab, LV_ALIGN_BOTTOM_LEFT, 0, 0, 104, 44, DEFAULT_PANEL_BG_COLOR, DEFAULT_PANEL_BG_OPACITY, DEFAULT_PANEL_RADIUS, DEFAULT_PANEL_BORDER_WIDTH, DEFAULT_PANEL_BORDER_COLOR, DEFAULT_PANEL_BORDER_OPACITY, DEFAULT_PANEL_PADDING);
+		bluethroat_draw_label(m_speed_to_fly_panel, m_speed_to_fly_panel, LV_ALIGN_TOP_LEFT, 0, 0, 0, 0, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_LEFT, DEFAULT_PANEL_DESCRIPTION_COLOR, &antonio_regular_12, "STF(km/h / to go km)");
+		m_speed_to_fly_label	= bluethroat_draw_label(m_speed_to_fly_panel, m_speed_to_fly_panel, LV_ALIGN_BOTTOM_RIGHT, 0, 0, 96, 20, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_RIGHT, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_20, "--");
+
+		m_glide_panel		= bluethroat_draw_panel(m_flying_map_tab, m_flying_map_tab, LV_ALIGN_BOTTOM_RIGHT, 0, 0, 104, 44, DEFAULT_PANEL_BG_COLOR, DEFAULT_PANEL_BG_OPACITY, DEFAULT_PANEL_RADIUS, DEFAULT_PANEL_BORDER_WIDTH, DEFAULT_PANEL_BORDER_COLOR, DEFAULT_PANEL_BORDER_OPACITY, DEFAULT_PANEL_PADDING);
+		bluethroat_draw_label(m_glide_panel, m_glide_panel, LV_ALIGN_TOP_LEFT, 0, 0, 0, 0, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_LEFT, DEFAULT_PANEL_DESCRIPTION_COLOR, &antonio_regular_12, "Glide(need / arrival m)");
+		m_glide_label		= bluethroat_draw_label(m_glide_panel, m_glide_panel, LV_ALIGN_BOTTOM_RIGHT, 0, 0, 96, 20, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_RIGHT, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_20, "--");
+
 		m_flying_chart_tab = lv_tabview_add_tab(m_flying_tabview, "chart");
 		lv_obj_set_style_bg_color(m_flying_chart_tab, DEFAULT_SCREEN_BG_COLOR, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
 		lv_obj_set_style_bg_opa(m_flying_chart_tab, DEFAULT_SCREEN_BG_OPACITY, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
 		lv_obj_clear_flag(m_flying_chart_tab, LV_OBJ_FLAG_SCROLLABLE);
 
+		m_flying_debug_tab = lv_tabview_add_tab(m_flying_tabview, "debug");
+		lv_obj_set_style_bg_color(m_flying_debug_tab, DEFAULT_SCREEN_BG_COLOR, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+		lv_obj_set_style_bg_opa(m_flying_debug_tab, DEFAULT_SCREEN_BG_OPACITY, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+		lv_obj_set_style_pad_all(m_flying_debug_tab, 0, LV_SELECTOR(LV_PART_MAIN, LV_STATE_DEFAULT));
+
+		m_task_stats_table = bluethroat_draw_task_stats_table(m_flying_debug_tab, m_flying_debug_tab, LV_ALIGN_TOP_LEFT, 0, 24);
+
 		lv_obj_t *status_bar = bluethroat_draw_panel(m_flying_screen, m_flying_screen, LV_ALIGN_TOP_MID, 0, 0, 320, 24, DEFAULT_PANEL_BG_COLOR, DEFAULT_PANEL_BG_OPACITY, 0, 0, DEFAULT_PANEL_BORDER_COLOR, DEFAULT_PANEL_BORDER_OPACITY, 0);
 
 		m_clock_label		= bluethroat_draw_label(status_bar, status_bar, LV_ALIGN_LEFT_MID, 4, 0, 64, 16, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_LEFT, DEFAULT_LABEL_CLOCK_COLOR, &antonio_regular_16, "23:59:59");
@@ -219,11 +311,11 @@ void BluethroatGui::Init(void) {
 
 		m_distance_panel	= bluethroat_draw_panel(m_flying_dashboard_tab, m_flying_screen, LV_ALIGN_BOTTOM_LEFT, 0, 0, 100, 44, DEFAULT_PANEL_BG_COLOR, DEFAULT_PANEL_BG_OPACITY, DEFAULT_PANEL_RADIUS, DEFAULT_PANEL_BORDER_WIDTH, DEFAULT_PANEL_BORDER_COLOR, DEFAULT_PANEL_BORDER_OPACITY, DEFAULT_PANEL_PADDING);
 		bluethroat_draw_label(m_distance_panel, m_distance_panel, LV_ALIGN_TOP_LEFT, 0, 0, 0, 0, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_LEFT, DEFAULT_PANEL_DESCRIPTION_COLOR, &antonio_regular_12, "Distance");
-		m_distance_label	= bluethroat_draw_label(m_distance_panel, m_distance_panel, LV_ALIGN_BOTTOM_RIGHT, 0, 0, 92, 20, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_RIGHT, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_20, "999.99 km");
+		m_distance_label	= bluethroat_draw_label(m_distance_panel, m_distance_panel, LV_ALIGN_BOTTOM_RIGHT, 0, 0, 92, 20, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_RIGHT, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_20, "--");
 
 		m_airtime_panel		= bluethroat_draw_panel(m_flying_dashboard_tab, m_distance_panel, LV_ALIGN_OUT_RIGHT_MID, 8, 0, 100, 44, DEFAULT_PANEL_BG_COLOR, DEFAULT_PANEL_BG_OPACITY, DEFAULT_PANEL_RADIUS, DEFAULT_PANEL_BORDER_WIDTH, DEFAULT_PANEL_BORDER_COLOR, DEFAULT_PANEL_BORDER_OPACITY, DEFAULT_PANEL_PADDING);
 		bluethroat_draw_label(m_airtime_panel, m_airtime_panel, LV_ALIGN_TOP_LEFT, 0, 0, 0, 0, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_LEFT, DEFAULT_PANEL_DESCRIPTION_COLOR, &antonio_regular_12, "Airtime");
-		m_airtime_label		= bluethroat_draw_label(m_airtime_panel, m_airtime_panel, LV_ALIGN_BOTTOM_RIGHT, 0, 0, 92, 20, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_RIGHT, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_20, "99.99 h");
+		m_airtime_label		= bluethroat_draw_label(m_airtime_panel, m_airtime_panel, LV_ALIGN_BOTTOM_RIGHT, 0, 0, 92, 20, DEFAULT_LABEL_BG_COLOR, DEFAULT_LABEL_BG_OPACITY, DEFAULT_LABEL_PADDING, LV_TEXT_ALIGN_RIGHT, DEFAULT_PANEL_VALUE_COLOR, &antonio_regular_20, "--");
 
 		lvgl_release_token();
 	}
@@ -358,6 +450,31 @@ void GuiSetSpeed(float speed) {
 	}
 }
 
+/* Airtime in ms and distance in m of the flight, none before the first takeoff. */
+void GuiSetFlightStats(FlightState_t state, uint32_t airtime, float distance) {
+	if (g_p_BluethroatGui && g_p_BluethroatGui->m_airtime_label && g_p_BluethroatGui->m_distance_label) {
+		if (pdTRUE == lvgl_acquire_token()) {
+			if (state == FLIGHT_STATE_GROUND) {
+				lv_label_set_text(g_p_BluethroatGui->m_airtime_label, "--");
+				lv_label_set_text(g_p_BluethroatGui->m_distance_label, "--");
+			} else {
+				char airtime_string[16];
+				char distance_string[16];
+				uint32_t seconds = airtime / 1000;
+				snprintf(airtime_string, sizeof(airtime_string), "%u:%02u:%02u", (unsigned int)(seconds / 3600), (unsigned int)(seconds / 60 % 60), (unsigned int)(seconds % 60));
+				snprintf(distance_string, sizeof(distance_string), "%.2f km", distance / 1000.0f);
+				lv_label_set_text(g_p_BluethroatGui->m_airtime_label, airtime_string);
+				lv_label_set_text(g_p_BluethroatGui->m_distance_label, distance_string);
+			}
+			lvgl_release_token();
+		} else {
+			BLUETHROAT_GUI_LOGE("GuiSetFlightStats failed, lvgl_acquire_token failed");
+		}
+	} else {
+		BLUETHROAT_GUI_LOGE("GuiSetFlightStats failed, g_p_BluethroatGui=%p", g_p_BluethroatGui);
+	}
+}
+
 void GuiSetAltitude(float altitude) {
 	if (g_p_BluethroatGui && g_p_BluethroatGui->m_autitude_label) {
 		if (pdTRUE == lvgl_acquire_token()) {
@@ -388,6 +505,118 @@ void GuiSetAgl(float agl) {
 	}
 }
 
+void GuiSetNettoVerticalSpeed(float netto_vertical_speed, float relative_vertical_speed) {
+	if (g_p_BluethroatGui && g_p_BluethroatGui->m_netto_label) {
+		if (pdTRUE == lvgl_acquire_token()) {
+			char netto_string[24];
+			snprintf(netto_string, sizeof(netto_string), "%.1f / %.1f", netto_vertical_speed, relative_vertical_speed);
+			lv_label_set_text(g_p_BluethroatGui->m_netto_label, netto_string);
+			lvgl_release_token();
+		} else {
+			BLUETHROAT_GUI_LOGE("GuiSetNettoVerticalSpeed failed, lvgl_acquire_token failed");
+		}
+	} else {
+		BLUETHROAT_GUI_LOGE("GuiSetNettoVerticalSpeed failed, g_p_BluethroatGui=%p", g_p_BluethroatGui);
+	}
+}
+
+/* Short, long and thermal averages, with the windows and the gain of the thermal under them. */
+void GuiSetClimbAverages(const ClimbAverager *p_averager) {
+	if (g_p_BluethroatGui && g_p_BluethroatGui->m_average_label && g_p_BluethroatGui->m_average_description_label) {
+		if (pdTRUE == lvgl_acquire_token()) {
+			char average_string[32];
+			char description_string[32];
+			snprintf(average_string, sizeof(average_string), "%.1f / %.1f / %.1f", p_averager->GetAverage(CLIMB_WINDOW_SHORT), p_averager->GetAverage(CLIMB_WINDOW_LONG), p_averager->GetThermalAverage());
+			snprintf(description_string, sizeof(description_string), "%us / %us / %+.0fm", (unsigned int)(p_averager->GetWindowDuration(CLIMB_WINDOW_SHORT) / 1000), (unsigned int)(p_averager->GetWindowDuration(CLIMB_WINDOW_LONG) / 1000), p_averager->GetThermalGain());
+			lv_label_set_text(g_p_BluethroatGui->m_average_label, average_string);
+			lv_label_set_text(g_p_BluethroatGui->m_average_description_label, description_string);
+			lvgl_release_token();
+		} else {
+			BLUETHROAT_GUI_LOGE("GuiSetClimbAverages failed, lvgl_acquire_token failed");
+		}
+	} else {
+		BLUETHROAT_GUI_LOGE("GuiSetClimbAverages failed, g_p_BluethroatGui=%p", g_p_BluethroatGui);
+	}
+}
+
+void GuiSetGlide(const GlideComputer *p_glide) {
+	if (g_p_BluethroatGui && g_p_BluethroatGui->m_speed_to_fly_label && g_p_BluethroatGui->m_glide_label) {
+		if (pdTRUE == lvgl_acquire_token()) {
+			char speed_to_fly_string[32];
+			char glide_string[32];
+			if (p_glide->HasWaypoint()) {
+				snprintf(speed_to_fly_string, sizeof(speed_to_fly_string), "%.0f / %.1f", p_glide->GetSpeedToFly() * 3.6f, p_glide->GetDistance() / 1000.0f);
+			} else {
+				snprintf(speed_to_fly_string, sizeof(speed_to_fly_string), "%.0f", p_glide->GetSpeedToFly() * 3.6f);
+			}
+			if (!p_glide->HasWaypoint()) {
+				snprintf(glide_string, sizeof(glide_string), "--");
+			} else if (p_glide->GetGlide() <= 0.0f) {
+				snprintf(glide_string, sizeof(glide_string), "%.1f / --", p_glide->GetRequiredGlide());
+			} else {
+				snprintf(glide_string, sizeof(glide_string), "%.1f / %+.0f", p_glide->GetRequiredGlide(), p_glide->GetArrivalAltitude());
+			}
+			lv_label_set_text(g_p_BluethroatGui->m_speed_to_fly_label, speed_to_fly_string);
+			lv_label_set_text(g_p_BluethroatGui->m_glide_label, glide_string);
+			lvgl_release_token();
+		} else {
+			BLUETHROAT_GUI_LOGE("GuiSetGlide failed, lvgl_acquire_token failed");
+		}
+	} else {
+		BLUETHROAT_GUI_LOGE("GuiSetGlide failed, g_p_BluethroatGui=%p", g_p_BluethroatGui);
+	}
+}
+
+void GuiSetThermal(const ThermalAssistant *p_thermal) {
+	if (g_p_BluethroatGui && g_p_BluethroatGui->m_thermal_trail && g_p_BluethroatGui->m_thermal_core && g_p_BluethroatGui->m_thermal_label) {
+		if (pdTRUE == lvgl_acquire_token()) {
+			uint32_t count = p_thermal->GetSampleCount();
+			for (uint32_t age = 0; age < count; age++) {
+				float east, north;
+				p_thermal->GetDriftedPosition(age, &east, &north);
+				g_p_BluethroatGui->m_thermal_trail_points[age].x = thermal_map_x(east - p_thermal->m_east);
+				g_p_BluethroatGui->m_thermal_trail_points[age].y = thermal_map_y(north - p_thermal->m_north);
+			}
+			lv_line_set_points(g_p_BluethroatGui->m_thermal_trail, g_p_BluethroatGui->m_thermal_trail_points, (uint16_t)count);
+
+			if (p_thermal->IsCoreValid()) {
+				lv_obj_set_pos(g_p_BluethroatGui->m_thermal_core, thermal_map_x(p_thermal->GetCoreEast()) - THERMAL_MAP_CORE_SIZE / 2, thermal_map_y(p_thermal->GetCoreNorth()) - THERMAL_MAP_CORE_SIZE / 2);
+				lv_obj_clear_flag(g_p_BluethroatGui->m_thermal_core, LV_OBJ_FLAG_HIDDEN);
+			} else {
+				lv_obj_add_flag(g_p_BluethroatGui->m_thermal_core, LV_OBJ_FLAG_HIDDEN);
+			}
+
+			if (p_thermal->IsCircling()) {
+				char thermal_string[24];
+				snprintf(thermal_string, sizeof(thermal_string), "%+.1f / %+.0f", p_thermal->GetThermalClimb(), p_thermal->GetThermalGain());
+				lv_label_set_text(g_p_BluethroatGui->m_thermal_label, thermal_string);
+			} else {
+				lv_label_set_text(g_p_BluethroatGui->m_thermal_label, "--");
+			}
+			lvgl_release_token();
+		} else {
+			BLUETHROAT_GUI_LOGE("GuiSetThermal failed, lvgl_acquire_token failed");
+		}
+	} else {
+		BLUETHROAT_GUI_LOGE("GuiSetThermal failed, g_p_BluethroatGui=%p", g_p_BluethroatGui);
+	}
+}
+
+void GuiSetWind(float speed, float direction) {
+	if (g_p_BluethroatGui && g_p_BluethroatGui->m_wind_label) {
+		if (pdTRUE == lvgl_acquire_token()) {
+			char wind_string[24];
+			snprintf(wind_string, sizeof(wind_string), "%.0f / %03.0f", speed * 3.6f, direction);
+			lv_label_set_text(g_p_BluethroatGui->m_wind_label, wind_string);
+			lvgl_release_token();
+		} else {
+			BLUETHROAT_GUI_LOGE("GuiSetWind failed, lvgl_acquire_token failed");
+		}
+	} else {
+		BLUETHROAT_GUI_LOGE("GuiSetWind failed, g_p_BluethroatGui=%p", g_p_BluethroatGui);
+	}
+}
+
 void GuiSetVerticalSpeed(float vertical_speed) {
 	if (g_p_BluethroatGui) {
 		if (g_p_BluethroatGui->m_vario_label) {
@@ -435,4 +664,26 @@ void GuiSetVerticalSpeed(float vertical_speed) {
 		BLUETHROAT_GUI_LOGE("GuiSetSpeed failed, g_p_BluethroatGui=%p, m_speed_label=%p", g_p_BluethroatGui, g_p_BluethroatGui->m_speed_label);
 	}
 
-}
\ No newline at end of file
+}
+
+void GuiSetTaskStats(const TaskStats_t *p_stats, uint32_t count) {
+	if (g_p_BluethroatGui && g_p_BluethroatGui->m_task_stats_table) {
+		if (pdTRUE == lvgl_acquire_token()) {
+			for (uint32_t index = 0; index < count && index < TASK_STATS_SLOTS; index++) {
+				const TaskStats_t *p_task_stats = &(p_stats[index]);
+				uint16_t row = index + 1;
+				lv_table_set_cell_value_fmt(g_p_BluethroatGui->m_task_stats_table, row, 1, "%lu", (unsigned long)p_task_stats->loops);
+				lv_table_set_cell_value_fmt(g_p_BluethroatGui->m_task_stats_table, row, 2, "%.1f", (p_task_stats->loops > 0) ? p_task_stats->duration_total_us / 1000.0 / p_task_stats->loops : 0.0);
+				lv_table_set_cell_value_fmt(g_p_BluethroatGui->m_task_stats_table, row, 3, "%.1f", p_task_stats->duration_max_us / 1000.0);
+				lv_table_set_cell_value_fmt(g_p_BluethroatGui->m_task_stats_table, row, 4, "%.1f", p_task_stats->jitter_max_us / 1000.0);
+				lv_table_set_cell_value_fmt(g_p_BluethroatGui->m_task_stats_table, row, 5, "%lu", (unsigned long)p_task_stats->stack_high_water);
+				lv_table_set_cell_value_fmt(g_p_BluethroatGui->m_task_stats_table, row, 6, "%lu", (unsigned long)p_task_stats->dropped_messages);
+			}
+			lvgl_release_token();
+		} else {
+			BLUETHROAT_GUI_LOGE("GuiSetTaskStats failed, lvgl_acquire_token failed");
+		}
+	} else {
+		BLUETHROAT_GUI_LOGE("GuiSetTaskStats failed, g_p_BluethroatGui=%p", g_p_BluethroatGui);
+	}
+}
@@ -5,10 +5,24 @@
 #include "adapters/lvgl_adapter.h"
 
 #include "utilities/i2s_master.h"
+#include "utilities/task_stats.h"
+#if CONFIG_FRAME_RECORDER_ENABLED
+#include <esp_spiffs.h>
+#include "utilities/frame_recorder.h"
+#endif
+#if CONFIG_SME_FLOAT_BENCHMARK_ENABLED
+#include "utilities/sme_float_bench.h"
+#endif
+#if CONFIG_LATENCY_TRACE_ENABLED
+#include "utilities/latency_trace.h"
+#endif
 
 #include "drivers/bm8563_rtc.h"
 #include "drivers/dps3xx_barometer.h"
 #include "drivers/dps3xx_anemometer.h"
+#if CONFIG_I2C_DEVICE_BMI270
+#include "drivers/bmi270_imu.h"
+#endif
 #include "drivers/ft6x36u_touch.h"
 #include "drivers/axp192_pmu.h"
 #include "drivers/neo_m9n_gnss.h"
@@ -19,6 +33,7 @@
 #include "bluethroat_msg_proc.h"
 #include "bluethroat_clock.h"
 #include "bluethroat_bluetooth.h"
+#include "bluethroat_vario.h"
 
 #define BLUETHROAT_MAIN_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
 #define BLUETHROAT_MAIN_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
@@ -67,6 +82,10 @@ void app_main() {
     esp_log_level_set("SYS_CLOCK", ESP_LOG_INFO);
     esp_log_level_set("NS4168_SOUND", ESP_LOG_INFO);
     esp_log_level_set("BLUETHROAT_VARIO", ESP_LOG_INFO);
+    esp_log_level_set("FRAME_RECORDER", ESP_LOG_INFO);
+    esp_log_level_set("SME_FLOAT_BENCH", ESP_LOG_INFO);
+    esp_log_level_set("LATENCY_TRACE", ESP_LOG_INFO);
+    esp_log_level_set("TASK_STATS", ESP_LOG_INFO);
 
 
     BLUETHROAT_MAIN_LOGD("ESP-IDF version: %s, size of unsigned int is: %d, sizeof unsigned long is %d", esp_get_idf_version(), sizeof(unsigned int), sizeof(unsigned long));
@@ -75,8 +94,46 @@ void app_main() {
     BLUETHROAT_MAIN_LOGI("bluethroat paragliding variometer version %s, powered by snailtrail.org", esp_app_get_description()->version);
     BLUETHROAT_MAIN_LOGI("safe and happy flying all the time, pilots!");
 
+#if CONFIG_SME_FLOAT_BENCHMARK_ENABLED
+    /* step 0: benchmark float32_t while no other task is running */
+    if (SmeFloatBenchmark(CONFIG_SME_FLOAT_BENCHMARK_ROUNDS) != ESP_OK) {
+        BLUETHROAT_MAIN_LOGE("float32_t benchmark results are out of tolerance");
+    }
+#endif
+
     /* step 1: init nvs flash configuration */
     g_pBluethroatConfig = new BluethroatConfig();
+    LoadGliderPolar();
+
+    /* step 1.0: collect the statistics of every task loop from the first one */
+    TaskStats *p_TaskStats = new TaskStats(pdMS_TO_TICKS(TASK_STATS_REPORT_INTERVAL_MS));
+    if (p_TaskStats->Init() != ESP_OK) {
+        BLUETHROAT_MAIN_LOGE("Failed to init task statistics");
+    }
+
+#if CONFIG_FRAME_RECORDER_ENABLED
+    /* step 1.1: start raw frame recording before any device is reset, the recording needs the calibration data */
+    const esp_vfs_spiffs_conf_t spiffs_conf = {.base_path = "/spiffs", .partition_label = NULL, .max_files = 4, .format_if_mount_failed = true};
+    if (esp_vfs_spiffs_register(&spiffs_conf) == ESP_OK) {
+        FrameRecorder *p_FrameRecorder = new FrameRecorder(CONFIG_FRAME_RECORDER_PATH, CONFIG_FRAME_RECORDER_BUFFER_SIZE, CONFIG_FRAME_RECORDER_MAX_FILE_SIZE);
+        if (p_FrameRecorder->Init() == ESP_OK) {
+            p_FrameRecorder->Start(&(g_TaskParam[TASK_INDEX_FRAME_RECORDER]), NULL);
+        } else {
+            BLUETHROAT_MAIN_LOGE("Failed to init frame recorder, frame recording disabled");
+            delete p_FrameRecorder;
+        }
+    } else {
+        BLUETHROAT_MAIN_LOGE("Failed to mount spiffs partition, frame recording disabled");
+    }
+#endif
+
+#if CONFIG_LATENCY_TRACE_ENABLED
+    /* step 1.2: start latency trace before the barometer produces the first sample */
+    LatencyTrace *p_LatencyTrace = new LatencyTrace(pdMS_TO_TICKS(CONFIG_LATENCY_TRACE_REPORT_INTERVAL_S * 1000));
+    if (p_LatencyTrace->Init() != ESP_OK) {
+        BLUETHROAT_MAIN_LOGE("Failed to init latency trace");
+    }
+#endif
 
     /* step 2: init i2c bus master */
     BLUETHROAT_MAIN_ASSERT(I2C_NUM_MAX == 2 && CONFIG_I2C_PORT_0_ENABLED && CONFIG_I2C_PORT_1_ENABLED, "Invalid I2C configuration, run menuconfig and reconfigure it properly");
@@ -116,13 +173,21 @@ void app_main() {
         (p_Bm8563Rtc = new Bm8563Rtc())->Init(pim_bm8563_rtc, pid_bm8563_rtc->addr, pid_bm8563_rtc->int_pins);
     }
 
-    /* step 8: init dps3xx barometer */
+    /* step 8: init dps3xx barometer, with the sync the anemometer follows from its first measurement */
     const I2cDevice_t *pid_dps3xx_barometer = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_BAROMETER]);
     I2cMaster *pim_dps3xx_barometer = p_i2c_master[pid_dps3xx_barometer->port];
     Dps3xxBarometer *p_Dps3xxBarometer = NULL;
     if (pim_dps3xx_barometer->ProbeDevice(pid_dps3xx_barometer->addr) == ESP_OK && Dps3xxBarometer::CheckDeviceId(pim_dps3xx_barometer, pid_dps3xx_barometer->addr) == ESP_OK) {
-        (p_Dps3xxBarometer = new Dps3xxBarometer())->Init(pim_dps3xx_barometer, pid_dps3xx_barometer->addr, pid_dps3xx_barometer->int_pins);
+        Dps3xxSync *p_Dps3xxSync = new Dps3xxSync();
+        if (p_Dps3xxSync->Init() != ESP_OK) {
+            BLUETHROAT_MAIN_LOGE("Failed to init dps3xx sync, anemometer not synchronized with the barometer");
+            delete p_Dps3xxSync;
+            p_Dps3xxSync = NULL;
+        }
+        (p_Dps3xxBarometer = new Dps3xxBarometer(p_Dps3xxSync))->Init(pim_dps3xx_barometer, pid_dps3xx_barometer->addr, pid_dps3xx_barometer->int_pins);
     }
+    /* the message procedure picks the mode of the barometer, the anemometer follows it */
+    g_pDps3xxBarometer = p_Dps3xxBarometer;
 
     /* step 9: init dps3xx anemometer */
     const I2cDevice_t *pid_dps3xx_anemometer = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_DPS3XX_ANEMOMETER]);
@@ -132,6 +197,16 @@ void app_main() {
         (p_Dps3xxAnemometer = new Dps3xxAnemometer(p_Dps3xxBarometer))->Init(pim_dps3xx_anemometer, pid_dps3xx_anemometer->addr, pid_dps3xx_anemometer->int_pins);
     }
 
+#if CONFIG_I2C_DEVICE_BMI270
+    /* step 9.1: init bmi270 imu */
+    const I2cDevice_t *pid_bmi270_imu = &(g_I2cDeviceMap[I2C_DEVICE_INDEX_BMI270_ACCELEROMETER]);
+    I2cMaster *pim_bmi270_imu = p_i2c_master[pid_bmi270_imu->port];
+    Bmi270Imu *p_Bmi270Imu = NULL;
+    if (pim_bmi270_imu->ProbeDevice(pid_bmi270_imu->addr) == ESP_OK && Bmi270Imu::CheckDeviceId(pim_bmi270_imu, pid_bmi270_imu->addr) == ESP_OK) {
+        (p_Bmi270Imu = new Bmi270Imu())->Init(pim_bmi270_imu, pid_bmi270_imu->addr, pid_bmi270_imu->int_pins);
+    }
+#endif
+
     /* step 10: init ns4168 i2s sound */
 
     /* step 11: init bluethroat clock */
@@ -147,6 +222,11 @@ void app_main() {
 
     /* step 16: init main message process task */
     BluethroatMsgProc *pBluethroatMsgProc = new BluethroatMsgProc(&(g_TaskParam[TASK_INDEX_MSG_PROC]));
+    /* the report timers only post a request, the message procedure makes the reports */
+    p_TaskStats->SetMessageQueue(pBluethroatMsgProc->m_queue_handle);
+#if CONFIG_LATENCY_TRACE_ENABLED
+    p_LatencyTrace->SetMessageQueue(pBluethroatMsgProc->m_queue_handle);
+#endif
 
     /* step 17: start devices loop tasks */
     if (p_Axp192Pmu != NULL) p_Axp192Pmu->Start(&(g_TaskParam[TASK_INDEX_AXP192_PMU]), pBluethroatMsgProc->m_queue_handle);
@@ -155,6 +235,9 @@ void app_main() {
     /* bm8563 RTC doesn't need a task, so don't call Start() */
     if (p_Dps3xxBarometer != NULL) p_Dps3xxBarometer->Start(&(g_TaskParam[TASK_INDEX_DPS3XX_BAROMETER]), pBluethroatMsgProc->m_queue_handle);
     if (p_Dps3xxAnemometer != NULL) p_Dps3xxAnemometer->Start(&(g_TaskParam[TASK_INDEX_DPS3XX_ANEMOMETER]), pBluethroatMsgProc->m_queue_handle);
+#if CONFIG_I2C_DEVICE_BMI270
+    if (p_Bmi270Imu != NULL) p_Bmi270Imu->Start(&(g_TaskParam[TASK_INDEX_BMI270_IMU]), pBluethroatMsgProc->m_queue_handle);
+#endif
     if (p_NeoM9nGnss != NULL) p_NeoM9nGnss->Start(&(g_TaskParam[TASK_INDEX_NEO_M9N_GNSS]), pBluethroatMsgProc->m_queue_handle);
 
     /* step 14: init bluetooth */
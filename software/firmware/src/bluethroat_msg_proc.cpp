@@ -3,12 +3,17 @@
 #include <math.h>
 
 #include "drivers/bm8563_rtc.h"
+#include "drivers/dps3xx_barometer.h"
 #include "drivers/ns4168_sound.h"
+#include "utilities/task_stats.h"
 
 #include "bluethroat_gui.h"
 #include "bluethroat_bluetooth.h"
 #include "bluethroat_vario.h"
 #include "bluethroat_msg_proc.h"
+#if CONFIG_LATENCY_TRACE_ENABLED
+#include "utilities/latency_trace.h"
+#endif
 
 #define MSG_PROC_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
 #define MSG_PROC_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
@@ -36,11 +41,38 @@
 #define MSG_PROC_ASSERT(condition, format, ...)
 #endif
 
+#if CONFIG_VARIO_REDUNDANT_STATIC_CROSS_CHECK
+#define MSG_PROC_REDUNDANT_STATIC_MODE			REDUNDANT_STATIC_CROSS_CHECK
+#else
+#define MSG_PROC_REDUNDANT_STATIC_MODE			REDUNDANT_STATIC_AVERAGE
+#endif
+/* A static port whose last sample is older, ms, has stopped, a few periods of the slowest mode of the barometer */
+#if CONFIG_I2C_DEVICE_DPS3XX_LOW_POWER_ON_GROUND
+#define MSG_PROC_STATIC_PORT_MAX_AGE			(4UL * DPS3XX_MODE_MAX_PERIOD_MS)
+#else
+#define MSG_PROC_STATIC_PORT_MAX_AGE			(500UL)
+#endif
+
+#if CONFIG_VARIO_TEMPERATURE_GNSS_CORRECTION
+#define MSG_PROC_TEMPERATURE_GNSS_CORRECTION	true
+#else
+#define MSG_PROC_TEMPERATURE_GNSS_CORRECTION	false
+#endif
+
 static const char *TAG = "MSG_PROC";
 
-BluethroatMsgProc::BluethroatMsgProc(const TaskParam_t *p_task_param) : m_p_task_param(p_task_param) {
+BluethroatMsgProc::BluethroatMsgProc(const TaskParam_t *p_task_param) : m_p_task_param(p_task_param),
+	m_flight_detector((float)CONFIG_VARIO_TAKEOFF_SPEED / 3.6f, CONFIG_VARIO_TAKEOFF_TIME * 1000UL, (float)CONFIG_VARIO_LANDING_SPEED / 3.6f, CONFIG_VARIO_LANDING_TIME * 1000UL),
+	m_climb_averager(CONFIG_VARIO_AVERAGE_SHORT_WINDOW * 1000UL, CONFIG_VARIO_AVERAGE_LONG_WINDOW * 1000UL),
+	m_redundant_static(MSG_PROC_REDUNDANT_STATIC_MODE, MSG_PROC_STATIC_PORT_MAX_AGE, (float)CONFIG_VARIO_REDUNDANT_STATIC_MAX_DIFFERENCE),
+	m_temperature_drift((float)CONFIG_VARIO_TEMPERATURE_MIN_SPAN / 10.0f, MSG_PROC_TEMPERATURE_GNSS_CORRECTION),
+	m_glide_computer((float)CONFIG_VARIO_MACCREADY / 100.0f, (float)CONFIG_VARIO_FINAL_GLIDE_MARGIN),
+	m_barometer_flying(true) {
 	MSG_PROC_LOGI("Start blurthraot message procedure.");
 	MSG_PROC_ASSERT(this->m_p_task_param != NULL, "Invalid message procedure task parameter pointer");
+#if CONFIG_VARIO_WAYPOINT
+	m_glide_computer.SetWaypoint(CONFIG_VARIO_WAYPOINT_LATITUDE, CONFIG_VARIO_WAYPOINT_LONGITUDE, (float)CONFIG_VARIO_WAYPOINT_ALTITUDE);
+#endif
 	this->m_queue_handle = xQueueCreate(BLUETHROAT_MSG_QUEUE_LENGTH, sizeof(BluethroatMsg_t));
 	if (this->m_queue_handle != NULL) {
 		MSG_PROC_LOGI("Create message queue %s success.", this->m_p_task_param->task_name);
@@ -65,91 +97,249 @@ void BluethroatMsgProc::message_loop() {
 
 	for ( ; ; ) {
 		if (pdTRUE == xQueueReceive(this->m_queue_handle, &message, portMAX_DELAY)) {
-			MSG_PROC_LOGV("Receive message from queue, message type:%d.", message.type);
-			switch (message.type) {
-			case BLUETHROAT_MSG_TYPE_BUTTON_DATA:
-				break;
-			case BLUETHROAT_MSG_TYPE_BAROMETER_DATA:
-				BluetoothSendPressure(message.barometer_data.pressure);
-				{
-					float vertical_speed = CalculateVerticalSpeed(message.barometer_data.temperature, message.barometer_data.pressure_filterd, message.barometer_data.timestamp);
-					GuiSetVerticalSpeed(vertical_speed);
-					SoundSetVerticalSpeed(vertical_speed);
-				}
-				break;
-
-    		case BLUETHROAT_MSG_TYPE_HYGROMETER_DATA:
-				break;
-
-    		case BLUETHROAT_MSG_TYPE_ANEMOMETER_DATA:
-				break;
-
-    		case BLUETHROAT_MSG_TYPE_ACCELERATION_DATA:
-				break;
-
-    		case BLUETHROAT_MSG_TYPE_ROTATION_DATA:
-				break;
-
-    		case BLUETHROAT_MSG_TYPE_GEOMAGNATIC_DATA:
-				break;
-
-    		case BLUETHROAT_MSG_TYPE_POWER_DATA:
-				MSG_PROC_LOGD("Receive power message, battery voltage:%d, battery charging:%d, battery activiting:%d, charge undercurrent:%d.", message.pmu_data.battery_voltage, message.pmu_data.battery_charging, message.pmu_data.battery_activiting, message.pmu_data.charge_undercurrent);
-				GuiSetBatteryState(message.pmu_data.battery_voltage, message.pmu_data.battery_charging, message.pmu_data.battery_activiting, message.pmu_data.charge_undercurrent);
-				break;
-
-			case BLUETHROAT_MSG_TYPE_GNSS_STATUS:
-				MSG_PROC_LOGD("Receive gnss status message, status:%d.", message.gnss_status);
-				GuiSetGnssStatus((message.gnss_status == GNSS_STATUS_CONNECTED) ? GNSS_STATE_CONNECTED : GNSS_STATE_DISCONNECTED);
-				break;
-
-    		case BLUETHROAT_MSG_TYPE_GNSS_ZDA_DATA:
-				{
-					struct tm stm_time;
-					stm_time.tm_sec = message.gnss_zda_data.second,
-					stm_time.tm_min = message.gnss_zda_data.minute,
-					stm_time.tm_hour = message.gnss_zda_data.hour,
-					stm_time.tm_mday = message.gnss_zda_data.day,
-					stm_time.tm_mon = message.gnss_zda_data.month,
-					stm_time.tm_year = message.gnss_zda_data.year,
-					SetRtcTime(&stm_time);
-				}
-				break;
-
-			case BLUETHROAT_MSG_TYPE_GNSS_RMC_DATA:
-				break;
-
-			case BLUETHROAT_MSG_TYPE_GNSS_GGA_DATA:
-				GuiSetAltitude(message.gnss_gga_data.altitude);
-				GuiSetAgl(message.gnss_gga_data.altitude);
-				break;
-
-			case BLUETHROAT_MSG_TYPE_GNSS_VTG_DATA:
-				GuiSetSpeed(message.gnss_vtg_data.speed_kmh);
-				break;
-
-			case BLUETHROAT_MSG_TYPE_BLUETOOTH_STATE:
-				MSG_PROC_LOGD("Receive bluetooth state message, environment service state:%d, nordic uart service state:%d.", message.bluetooth_state.environment_service_state, message.bluetooth_state.nordic_uart_service_state);
-				if (message.bluetooth_state.environment_service_state == SERVICE_STATE_CONNECTED || message.bluetooth_state.nordic_uart_service_state == SERVICE_STATE_CONNECTED) {
-					GuiSetBluetoothState(BLURTOOTH_STATE_CONNECTED);
-				} else {
-					GuiSetBluetoothState(BLURTOOTH_STATE_DISCONNECTED);
-				}
-				break;
-
-			case BLUETHROAT_MSG_INVALID:
-				MSG_PROC_LOGE("Receive invalid message, message type:%d(invalid).", message.type);
-				break;
-
-    		default:
-				MSG_PROC_LOGE("Receive invalid message, message type:%d(unknown).", message.type);
-			}
+			TaskStatsLoopBegin(TASK_INDEX_MSG_PROC);
+			this->process_message(&message);
+			TaskStatsLoopEnd(TASK_INDEX_MSG_PROC);
 		} else {
 			MSG_PROC_LOGV("Receive message from queue timeout.");
 		}
 	}
 }
 
+void BluethroatMsgProc::process_message(const BluethroatMsg_t *p_message) {
+	MSG_PROC_LOGV("Receive message from queue, message type:%d.", p_message->type);
+	switch (p_message->type) {
+	case BLUETHROAT_MSG_TYPE_BUTTON_DATA:
+		break;
+	case BLUETHROAT_MSG_TYPE_BAROMETER_DATA:
+#if CONFIG_LATENCY_TRACE_ENABLED
+		LatencyTraceStamp(p_message->barometer_data.trace_sequence, LATENCY_STAGE_DEQUEUE);
+#endif
+		{
+			BarometerData_t barometer_data = p_message->barometer_data;
+			if (m_redundant_static.AddSample(STATIC_PORT_PRIMARY, &barometer_data)) {
+				process_barometer(&barometer_data);
+			}
+		}
+		break;
+
+	case BLUETHROAT_MSG_TYPE_STATIC_PRESSURE_DATA:
+		{
+			BarometerData_t barometer_data = p_message->barometer_data;
+			if (m_redundant_static.AddSample(STATIC_PORT_SECONDARY, &barometer_data)) {
+				process_barometer(&barometer_data);
+			}
+		}
+		break;
+
+	case BLUETHROAT_MSG_TYPE_HYGROMETER_DATA:
+		break;
+
+	case BLUETHROAT_MSG_TYPE_ANEMOMETER_DATA:
+		{
+			// The airspeed also feeds the total energy compensation of the next barometer sample.
+			float airspeed = CalculateAirspeed(p_message->anemometer_data.total_pressure, p_message->anemometer_data.static_pressure, p_message->anemometer_data.total_pressure_sample, p_message->anemometer_data.timestamp);
+			MSG_PROC_LOGD("Receive anemometer message, total pressure:%f, static pressure:%f, true airspeed:%f.", p_message->anemometer_data.total_pressure, p_message->anemometer_data.static_pressure, airspeed);
+			(void)airspeed;
+		}
+		break;
+
+	case BLUETHROAT_MSG_TYPE_ACCELERATION_DATA:
+		{
+			// Only the inertial engine answers, between two barometer samples.
+			float vertical_speed;
+			m_flight_detector.AddAcceleration(p_message->acceleration_data.vertical, p_message->acceleration_data.timestamp);
+			if (UpdateVerticalAcceleration(p_message->acceleration_data.vertical, p_message->acceleration_data.timestamp, &vertical_speed)) {
+				GuiSetVerticalSpeed(vertical_speed);
+				SoundSetVerticalSpeed(vertical_speed);
+			}
+		}
+		break;
+
+	case BLUETHROAT_MSG_TYPE_ROTATION_DATA:
+		break;
+
+	case BLUETHROAT_MSG_TYPE_GEOMAGNATIC_DATA:
+		break;
+
+	case BLUETHROAT_MSG_TYPE_POWER_DATA:
+		MSG_PROC_LOGD("Receive power message, battery voltage:%d, battery charging:%d, battery activiting:%d, charge undercurrent:%d.", p_message->pmu_data.battery_voltage, p_message->pmu_data.battery_charging, p_message->pmu_data.battery_activiting, p_message->pmu_data.charge_undercurrent);
+		GuiSetBatteryState(p_message->pmu_data.battery_voltage, p_message->pmu_data.battery_charging, p_message->pmu_data.battery_activiting, p_message->pmu_data.charge_undercurrent);
+		break;
+
+	case BLUETHROAT_MSG_TYPE_GNSS_STATUS:
+		MSG_PROC_LOGD("Receive gnss status message, status:%d.", p_message->gnss_status);
+		GuiSetGnssStatus((p_message->gnss_status == GNSS_STATUS_CONNECTED) ? GNSS_STATE_CONNECTED : GNSS_STATE_DISCONNECTED);
+		break;
+
+	case BLUETHROAT_MSG_TYPE_GNSS_ZDA_DATA:
+		{
+			struct tm stm_time;
+			stm_time.tm_sec = p_message->gnss_zda_data.second,
+			stm_time.tm_min = p_message->gnss_zda_data.minute,
+			stm_time.tm_hour = p_message->gnss_zda_data.hour,
+			stm_time.tm_mday = p_message->gnss_zda_data.day,
+			stm_time.tm_mon = p_message->gnss_zda_data.month,
+			stm_time.tm_year = p_message->gnss_zda_data.year,
+			SetRtcTime(&stm_time);
+		}
+		break;
+
+	case BLUETHROAT_MSG_TYPE_GNSS_RMC_DATA:
+		// One pass over the position history per fix, the map follows the fixes.
+		m_thermal_assistant.AddFix(&(p_message->gnss_rmc_data), GetBarometricAltitude());
+		GuiSetThermal(&m_thermal_assistant);
+		// The average and the gain of the thermal restart with the circles.
+		if (m_thermal_assistant.IsCircling() != m_climb_averager.IsInThermal()) {
+			if (m_thermal_assistant.IsCircling()) {
+				m_climb_averager.StartThermal();
+			} else {
+				m_climb_averager.StopThermal();
+			}
+		}
+		// The speed to fly and the final glide follow the fixes as well, in the density of the last sample.
+		{
+			const GliderPolar *p_polar = GetGliderPolar();
+			if (p_polar != NULL) {
+				m_glide_computer.AddFix(&(p_message->gnss_rmc_data), GetBarometricAltitude(), p_polar, GetDensityRatio());
+				GuiSetGlide(&m_glide_computer);
+			}
+		}
+		break;
+
+	case BLUETHROAT_MSG_TYPE_GNSS_GGA_DATA:
+#if CONFIG_VARIO_TEMPERATURE_COMPENSATION
+		if (m_flight_detector.GetState() == FLIGHT_STATE_FLYING) {
+			m_temperature_drift.AddGnssAltitude(p_message->gnss_gga_data.altitude, GetBarometricAltitude());
+		}
+#endif
+#if CONFIG_VARIO_BAROMETRIC_ALTITUDE
+		GuiSetAltitude(GetBarometricAltitude());
+#else
+		GuiSetAltitude(p_message->gnss_gga_data.altitude);
+#endif
+		GuiSetAgl(p_message->gnss_gga_data.altitude);
+		break;
+
+	case BLUETHROAT_MSG_TYPE_GNSS_VTG_DATA:
+		GuiSetSpeed(p_message->gnss_vtg_data.speed_kmh);
+		SetGroundSpeed(p_message->gnss_vtg_data.speed_kmh / 3.6f);
+		m_flight_detector.AddGroundSpeed(p_message->gnss_vtg_data.speed_kmh / 3.6f);
+		GuiSetFlightStats(m_flight_detector.GetState(), m_flight_detector.GetAirtime(), m_flight_detector.GetDistance());
+		break;
+
+	case BLUETHROAT_MSG_TYPE_WIND_DATA:
+		MSG_PROC_LOGD("Receive wind message, speed:%f, direction:%f, airspeed:%f, age:%u.", p_message->wind_data.speed, p_message->wind_data.direction, p_message->wind_data.airspeed, (unsigned int)p_message->wind_data.age);
+		GuiSetWind(p_message->wind_data.speed, p_message->wind_data.direction);
+		m_thermal_assistant.SetWind(p_message->wind_data.east, p_message->wind_data.north);
+		m_glide_computer.SetWind(p_message->wind_data.east, p_message->wind_data.north);
+		break;
+
+	case BLUETHROAT_MSG_TYPE_FLIGHT_STATE:
+		MSG_PROC_LOGI("Receive flight state message, state:%d, timestamp:%u, airtime:%u, distance:%f.", p_message->flight_state.state, (unsigned int)p_message->flight_state.timestamp, (unsigned int)p_message->flight_state.airtime, p_message->flight_state.distance);
+		// The airtime and the distance follow the GNSS fixes.
+		SoundSetFlying(p_message->flight_state.state == FLIGHT_STATE_FLYING);
+		break;
+
+	case BLUETHROAT_MSG_TYPE_BLUETOOTH_STATE:
+		MSG_PROC_LOGD("Receive bluetooth state message, environment service state:%d, nordic uart service state:%d.", p_message->bluetooth_state.environment_service_state, p_message->bluetooth_state.nordic_uart_service_state);
+		if (p_message->bluetooth_state.environment_service_state == SERVICE_STATE_CONNECTED || p_message->bluetooth_state.nordic_uart_service_state == SERVICE_STATE_CONNECTED) {
+			GuiSetBluetoothState(BLURTOOTH_STATE_CONNECTED);
+		} else {
+			GuiSetBluetoothState(BLURTOOTH_STATE_DISCONNECTED);
+		}
+		break;
+
+	case BLUETHROAT_MSG_TYPE_REPORT_REQUEST:
+		MSG_PROC_LOGV("Receive report request message, report:%d.", p_message->report_request.report);
+		switch (p_message->report_request.report) {
+		case REPORT_TASK_STATS:
+			if (g_pTaskStats != NULL) {
+				g_pTaskStats->Report();
+			}
+			break;
+#if CONFIG_LATENCY_TRACE_ENABLED
+		case REPORT_LATENCY_TRACE:
+			LatencyTraceReport();
+			break;
+#endif
+		default:
+			MSG_PROC_LOGE("Receive report request message, report:%d(unknown).", p_message->report_request.report);
+		}
+		break;
+
+	case BLUETHROAT_MSG_INVALID:
+		MSG_PROC_LOGE("Receive invalid message, message type:%d(invalid).", p_message->type);
+		break;
+
+	default:
+		MSG_PROC_LOGE("Receive invalid message, message type:%d(unknown).", p_message->type);
+	}
+}
+
+/*
+	A static pressure sample, of the barometer or of the second static port when it has taken over, to the vario. The
+	drift of the temperature is corrected first, it is learned on the ground until the first takeoff. The samples
+	of a takeoff the flight detector is still confirming are of a moving glider and stay out of it.
+*/
+void BluethroatMsgProc::process_barometer(BarometerData_t *p_data) {
+#if CONFIG_VARIO_TEMPERATURE_COMPENSATION
+	m_temperature_drift.AddSample(p_data, m_flight_detector.GetState() == FLIGHT_STATE_GROUND && !m_flight_detector.IsPending());
+#endif
+	BluetoothSendPressure(p_data->pressure);
+	float vertical_speed = CalculateVerticalSpeed(p_data->temperature, p_data->pressure, p_data->pressure_filterd, p_data->timestamp);
+#if CONFIG_LATENCY_TRACE_ENABLED
+	LatencyTraceStamp(p_data->trace_sequence, LATENCY_STAGE_VARIO);
+#endif
+	GuiSetVerticalSpeed(vertical_speed);
+	GuiSetNettoVerticalSpeed(GetNettoVerticalSpeed(), GetRelativeVerticalSpeed());
+	SoundSetVerticalSpeed(vertical_speed, p_data->trace_sequence);
+	m_thermal_assistant.AddClimb(vertical_speed);
+	m_glide_computer.AddNetto(GetNettoVerticalSpeed());
+	if (m_flight_detector.AddVerticalSpeed(vertical_speed, p_data->timestamp)) {
+		publish_flight_state();
+	}
+	update_barometer_mode();
+	if (m_climb_averager.AddSample(vertical_speed, GetBarometricAltitude(), p_data->timestamp)) {
+		ClimbRecord_t record;
+		m_climb_averager.GetRecord(&record);
+		GuiSetClimbAverages(&m_climb_averager);
+		BluetoothSendClimb(&record);
+	}
+}
+
+/*
+	A takeoff or a landing goes through the queue like the sensor messages, so whatever follows the flight state reacts
+	to it in the order of the samples around it.
+*/
+void BluethroatMsgProc::publish_flight_state() {
+	BluethroatMsg_t message;
+	message.type = BLUETHROAT_MSG_TYPE_FLIGHT_STATE;
+	message.flight_state.state = m_flight_detector.GetState();
+	message.flight_state.timestamp = (message.flight_state.state == FLIGHT_STATE_FLYING) ? m_flight_detector.GetTakeoffTimestamp() : m_flight_detector.GetLandingTimestamp();
+	message.flight_state.airtime = m_flight_detector.GetAirtime();
+	message.flight_state.distance = m_flight_detector.GetDistance();
+	if (TaskStatsQueueSend(TASK_INDEX_MSG_PROC, m_queue_handle, &message) != pdTRUE) {
+		MSG_PROC_LOGE("Send flight state message failed, state:%d.", message.flight_state.state);
+	}
+}
+
+/*
+	The barometer saves the battery on the ground and measures at its best from the first sign of a takeoff, through
+	the flight and the landing the detector is still confirming. It starts in the flight mode, the first sample on the
+	ground switches it.
+*/
+void BluethroatMsgProc::update_barometer_mode() {
+#if CONFIG_I2C_DEVICE_DPS3XX_LOW_POWER_ON_GROUND
+	bool flying = (m_flight_detector.GetState() == FLIGHT_STATE_FLYING) || m_flight_detector.IsPending();
+	if (flying != m_barometer_flying) {
+		m_barometer_flying = flying;
+		MSG_PROC_LOGI("Barometer to the %s mode.", flying ? "flight" : "ground");
+		(void)BarometerSetMode(flying ? DPS3XX_MODE_HIGH_RESOLUTION : DPS3XX_MODE_LOW_POWER);
+	}
+#endif
+}
+
 void message_loop_c_entry(void *p_param) {
 	BluethroatMsgProc *p_bluethroat_msg_proc = (BluethroatMsgProc *)p_param;
     p_bluethroat_msg_proc->message_loop();
@@ -1,8 +1,11 @@
 #include <stddef.h>
 #include <math.h>
+#include <sdkconfig.h>
 
 #include <esp_log.h>
 
+#include "utilities/baro_altitude.h"
+#include "bluethroat_config.h"
 #include "bluethroat_vario.h"
 
 #define BLUETHROAT_VARIO_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
@@ -31,9 +34,55 @@
 #define BLUETHROAT_VARIO_ASSERT(condition, format, ...)
 #endif
 
+#if CONFIG_VARIO_ENGINE_KALMAN
+#define BLUETHROAT_VARIO_DEFAULT_ENGINE                 VARIO_ENGINE_KALMAN
+#elif CONFIG_VARIO_ENGINE_INERTIAL
+#define BLUETHROAT_VARIO_DEFAULT_ENGINE                 VARIO_ENGINE_INERTIAL
+#else
+#define BLUETHROAT_VARIO_DEFAULT_ENGINE                 VARIO_ENGINE_TWO_POINT
+#endif
+
+#if CONFIG_VARIO_KALMAN_ACCELERATION
+#define BLUETHROAT_VARIO_KALMAN_ORDER                   KALMAN_VARIO_ORDER_ACCELERATION
+#else
+#define BLUETHROAT_VARIO_KALMAN_ORDER                   KALMAN_VARIO_ORDER_SPEED
+#endif
+
+/* The inertial engine falls back to the Kalman filter when the IMU has been quiet for longer */
+#define BLUETHROAT_VARIO_ACCELERATION_TIMEOUT_MS        (500)
+
+#if CONFIG_VARIO_TOTAL_ENERGY
+#define BLUETHROAT_VARIO_DEFAULT_TOTAL_ENERGY           true
+#else
+#define BLUETHROAT_VARIO_DEFAULT_TOTAL_ENERGY           false
+#endif
+
+/* The total energy compensation stops when the anemometer has been quiet for longer */
+#define BLUETHROAT_VARIO_AIRSPEED_TIMEOUT_MS            (1000)
+
+#define BLUETHROAT_VARIO_GAS_CONSTANT                   (287.05f)       /* J/(kg K), dry air */
+#define BLUETHROAT_VARIO_CELSIUS_TO_KELVIN              (273.15f)
+#define BLUETHROAT_VARIO_SEA_LEVEL_DENSITY              (1.225f)        /* kg/m^3, ISA */
+#define BLUETHROAT_VARIO_GRAVITY                        (9.80665f)
+#define BLUETHROAT_VARIO_KMH_TO_MPS                     (1.0f / 3.6f)
+
+static const int32_t s_default_polar_speeds_kmh[GLIDER_POLAR_POINTS] = {CONFIG_VARIO_POLAR_SPEED_1, CONFIG_VARIO_POLAR_SPEED_2, CONFIG_VARIO_POLAR_SPEED_3};
+static const int32_t s_default_polar_sinks_cms[GLIDER_POLAR_POINTS] = {CONFIG_VARIO_POLAR_SINK_1, CONFIG_VARIO_POLAR_SINK_2, CONFIG_VARIO_POLAR_SINK_3};
+
 static const char *TAG = "BLUETHROAT_VARIO";
 
-BluethraotVario::BluethraotVario() : m_latitude_degree(0), m_latitude_minute(0), m_latitude_second(0.0f), m_longitude_degree(0), m_longitude_minute(0), m_longitude_second(0.0f), m_altitude(0), m_last_temperature(0.0f), m_last_pressure(0.0f), m_last_timestamp(0) {
+const char *BluethraotVario::m_conf_namespace = "polar";
+const char *BluethraotVario::m_conf_key_speeds[GLIDER_POLAR_POINTS] = {"speed_1", "speed_2", "speed_3"};
+const char *BluethraotVario::m_conf_key_sinks[GLIDER_POLAR_POINTS] = {"sink_1", "sink_2", "sink_3"};
+
+BluethraotVario::BluethraotVario() : m_latitude_degree(0), m_latitude_minute(0), m_latitude_second(0.0f), m_longitude_degree(0), m_longitude_minute(0), m_longitude_second(0.0f), m_altitude(0),
+    m_engine(BLUETHROAT_VARIO_DEFAULT_ENGINE), m_kalman(BLUETHROAT_VARIO_KALMAN_ORDER, CONFIG_VARIO_KALMAN_PROCESS_NOISE / 100.0f, CONFIG_VARIO_KALMAN_MEASUREMENT_NOISE / 100.0f),
+    m_inertial(CONFIG_VARIO_INERTIAL_ACCELERATION_NOISE / 100.0f, CONFIG_VARIO_INERTIAL_BIAS_NOISE / 100.0f, CONFIG_VARIO_KALMAN_MEASUREMENT_NOISE / 100.0f),
+    m_vertical_acceleration(0.0f), m_acceleration_timestamp(0), m_inertial_timestamp(0), m_total_energy(BLUETHROAT_VARIO_DEFAULT_TOTAL_ENERGY),
+    m_energy(KALMAN_VARIO_ORDER_SPEED, CONFIG_VARIO_KALMAN_PROCESS_NOISE / 100.0f, CONFIG_VARIO_KALMAN_MEASUREMENT_NOISE / 100.0f), m_static_pressure(0.0f),
+    m_static_temperature(0.0f), m_true_airspeed(0.0f), m_indicated_airspeed(0.0f), m_energy_height(0.0f), m_anemometer_timestamp(0), m_ground_speed(0.0f),
+    m_netto_vertical_speed(0.0f), m_relative_vertical_speed(0.0f), m_qnh((float)CONFIG_VARIO_QNH), m_barometric_altitude(0.0f), m_last_temperature(0.0f), m_last_pressure(0.0f), m_last_altitude(0.0f), m_last_timestamp(0) {
+    set_polar(s_default_polar_speeds_kmh, s_default_polar_sinks_cms);
     g_pBluethraotVario = this;
 }
 
@@ -41,33 +90,301 @@ BluethraotVario::~BluethraotVario() {
     g_pBluethraotVario = NULL;
 }
 
-float BluethraotVario::CalculateVerticalSpeed(float temperature, float pressure, uint32_t timestamp) {
-    (void)temperature;
+/* Switching the engine starts it over from the next sample. */
+void BluethraotVario::SetEngine(VarioEngine_t engine) {
+    m_engine = engine;
+    m_kalman.Reset();
+    m_inertial.Reset();
+    m_energy.Reset();
+    m_anemometer_timestamp = 0;
+    m_last_pressure = 0.0f;
+}
+
+/*
+    The two point engine differentiates the filtered pressure, the FIR filter of the driver smooths it at the cost of
+    its delay. The Kalman filter does its own smoothing and is given the unfiltered pressure.
+    The inertial engine moves its state to the sample with the last vertical acceleration and corrects it with the
+    altitude. The Kalman filter runs along, it takes over as soon as the acceleration messages stop.
+    With the total energy compensation, the rate of the energy height is added: a pull up trades airspeed for
+    altitude and the sum doesn't change, only the air mass and the sink of the glider move it.
+*/
+float BluethraotVario::CalculateVerticalSpeed(float temperature, float pressure, float pressure_filtered, uint32_t timestamp) {
     float vertical_speed = 0.0f;
 
-    if (m_last_pressure != 0.0f) {
-        float elevation = 44330.0f * (1.0f - pow(pressure / m_last_pressure, 0.1903f));
+    // Standard altitudes from the table of baro_altitude.h, the QNH only shifts and scales them by a few per mille.
+    float altitude = PressureToAltitude((m_engine != VARIO_ENGINE_TWO_POINT) ? pressure : pressure_filtered);
+    if (m_engine != VARIO_ENGINE_TWO_POINT) {
+        float delta_time = (m_last_pressure != 0.0f) ? (float)(timestamp - m_last_timestamp) / 1000.0f : 0.0f;
+        vertical_speed = m_kalman.Update(altitude, delta_time);
+        if (m_engine == VARIO_ENGINE_INERTIAL) {
+            if (m_acceleration_timestamp != 0 && (int32_t)(timestamp - m_acceleration_timestamp) < BLUETHROAT_VARIO_ACCELERATION_TIMEOUT_MS) {
+                // A sample older than the last acceleration message corrects the state where it is.
+                bool initialized = m_inertial.IsInitialized();
+                if (!initialized) {
+                    m_inertial_timestamp = timestamp;
+                } else if ((int32_t)(timestamp - m_inertial_timestamp) > 0) {
+                    m_inertial.Propagate(m_vertical_acceleration, (float)(timestamp - m_inertial_timestamp) / 1000.0f);
+                    m_inertial_timestamp = timestamp;
+                }
+                float inertial_speed = m_inertial.Correct(altitude);
+                if (initialized) {
+                    vertical_speed = inertial_speed;
+                }
+            } else {
+                m_inertial.Reset();
+            }
+        }
+    } else if (m_last_pressure != 0.0f) {
         float delta_time = (float)(timestamp - m_last_timestamp) / 1000.0f;
-        vertical_speed = elevation / delta_time;
+        vertical_speed = (altitude - m_last_altitude) / delta_time;
+    }
+    m_barometric_altitude = PressureToAltitude(pressure, m_qnh);
+    m_static_pressure = pressure;
+    m_static_temperature = temperature;
+    if (m_total_energy && airspeed_valid(timestamp)) {
+        vertical_speed += m_energy.GetVerticalSpeed();
     }
+    update_netto(vertical_speed, timestamp);
 
-    BLUETHROAT_VARIO_LOGD("last_temp:%f, last_pres:%f, last_time:%ld, temp:%f, pres:%f, time:%ld, vertical_speed:%f",
-        m_last_temperature, m_last_pressure, m_last_timestamp, temperature, pressure, timestamp, vertical_speed);
+    BLUETHROAT_VARIO_LOGD("last_temp:%f, last_pres:%f, last_time:%ld, temp:%f, pres:%f, pres_filtered:%f, time:%ld, vertical_speed:%f",
+        m_last_temperature, m_last_pressure, m_last_timestamp, temperature, pressure, pressure_filtered, timestamp, vertical_speed);
 
     m_last_temperature = temperature;
-    m_last_pressure = pressure;
+    m_last_pressure = (m_engine != VARIO_ENGINE_TWO_POINT) ? pressure : pressure_filtered;
+    m_last_altitude = altitude;
     m_last_timestamp = timestamp;
 
     return vertical_speed;
 }
 
+/*
+    Moves the inertial state to the end of the burst the acceleration is the mean of. Returns true with the new vertical
+    speed when the inertial engine is running, the barometer sample is what starts it.
+*/
+bool BluethraotVario::UpdateVerticalAcceleration(float vertical_acceleration, uint32_t timestamp, float *p_vertical_speed) {
+    m_vertical_acceleration = vertical_acceleration;
+    m_acceleration_timestamp = timestamp;
+    if (m_engine != VARIO_ENGINE_INERTIAL || !m_inertial.IsInitialized()) {
+        return false;
+    }
+
+    if ((int32_t)(timestamp - m_inertial_timestamp) > 0) {
+        m_inertial.Propagate(vertical_acceleration, (float)(timestamp - m_inertial_timestamp) / 1000.0f);
+        m_inertial_timestamp = timestamp;
+    }
+    if (p_vertical_speed != NULL) {
+        *p_vertical_speed = m_inertial.GetVerticalSpeed();
+        if (m_total_energy && airspeed_valid(timestamp)) {
+            *p_vertical_speed += m_energy.GetVerticalSpeed();
+        }
+    }
+    return true;
+}
+
+/*
+    Airspeed from the dynamic pressure and the air density of the last barometer sample, rho = p / (R * T):
+    V = sqrt(2 * q / rho). The true airspeed shown is of the deep filtered pressures of the anemometer. The energy height
+    is of the unfiltered samples, it goes through a filter with the same lag as the altitude so their rates add up.
+    Returns the true airspeed, 0 before the first barometer sample.
+*/
+float BluethraotVario::CalculateAirspeed(float total_pressure, float static_pressure, float total_pressure_sample, uint32_t timestamp) {
+    if (m_static_pressure <= 0.0f) {
+        return 0.0f;
+    }
+
+    float density = air_density();
+    float dynamic_pressure = fmaxf(total_pressure - static_pressure, 0.0f);
+    m_true_airspeed = sqrtf(2.0f * dynamic_pressure / density);
+    m_indicated_airspeed = sqrtf(2.0f * dynamic_pressure / BLUETHROAT_VARIO_SEA_LEVEL_DENSITY);
+
+    // The square of the airspeed is linear in the dynamic pressure, its noise stays white.
+    float energy_height = fmaxf(total_pressure_sample - m_static_pressure, 0.0f) / (density * BLUETHROAT_VARIO_GRAVITY);
+    float delta_time = (m_anemometer_timestamp != 0) ? (float)(timestamp - m_anemometer_timestamp) / 1000.0f : 0.0f;
+    if (m_anemometer_timestamp == 0) {
+        m_energy.Reset();
+    }
+    m_energy.Update(energy_height, delta_time);
+    m_energy_height = energy_height;
+    m_anemometer_timestamp = timestamp;
+
+    BLUETHROAT_VARIO_LOGD("total:%f, static:%f, total_sample:%f, density:%f, tas:%f, ias:%f, energy_height:%f, energy_rate:%f",
+        total_pressure, static_pressure, total_pressure_sample, density, m_true_airspeed, m_indicated_airspeed, energy_height, m_energy.GetVerticalSpeed());
+
+    return m_true_airspeed;
+}
+
+bool BluethraotVario::airspeed_valid(uint32_t timestamp) const {
+    return m_anemometer_timestamp != 0 && (int32_t)(timestamp - m_anemometer_timestamp) < BLUETHROAT_VARIO_AIRSPEED_TIMEOUT_MS;
+}
+
+/* kg/m^3, of the last barometer sample, the ISA sea level density before the first one. */
+float BluethraotVario::air_density() const {
+    if (m_static_pressure <= 0.0f) {
+        return BLUETHROAT_VARIO_SEA_LEVEL_DENSITY;
+    }
+    return m_static_pressure / (BLUETHROAT_VARIO_GAS_CONSTANT * (m_static_temperature + BLUETHROAT_VARIO_CELSIUS_TO_KELVIN));
+}
+
+/* Square root of the density of the last barometer sample over the sea level density, the TAS is the IAS over it. */
+float BluethraotVario::GetDensityRatio() const {
+    return sqrtf(air_density() / BLUETHROAT_VARIO_SEA_LEVEL_DENSITY);
+}
+
+/* The polar of the configuration, the one of menuconfig for the points it doesn't have or when they don't fit. */
+esp_err_t BluethraotVario::LoadPolar() {
+    int32_t speeds_kmh[GLIDER_POLAR_POINTS];
+    int32_t sinks_cms[GLIDER_POLAR_POINTS];
+    for (int i = 0; i < GLIDER_POLAR_POINTS; i++) {
+        if (g_pBluethroatConfig == NULL || g_pBluethroatConfig->GetInteger(m_conf_namespace, m_conf_key_speeds[i], &(speeds_kmh[i])) != ESP_OK) {
+            speeds_kmh[i] = s_default_polar_speeds_kmh[i];
+        }
+        if (g_pBluethroatConfig == NULL || g_pBluethroatConfig->GetInteger(m_conf_namespace, m_conf_key_sinks[i], &(sinks_cms[i])) != ESP_OK) {
+            sinks_cms[i] = s_default_polar_sinks_cms[i];
+        }
+    }
+
+    esp_err_t result = set_polar(speeds_kmh, sinks_cms);
+    if (result != ESP_OK) {
+        BLUETHROAT_VARIO_LOGE("Invalid polar in configuration, use the default polar");
+        set_polar(s_default_polar_speeds_kmh, s_default_polar_sinks_cms);
+    }
+    return result;
+}
+
+/* Fits the polar and keeps the points in the configuration, a polar that doesn't fit is neither used nor kept. */
+esp_err_t BluethraotVario::SetPolar(const int32_t *p_speeds_kmh, const int32_t *p_sinks_cms) {
+    esp_err_t result = set_polar(p_speeds_kmh, p_sinks_cms);
+    if (result != ESP_OK) {
+        return result;
+    }
+    if (g_pBluethroatConfig == NULL) {
+        BLUETHROAT_VARIO_LOGE("Config instance not initialized, failed to keep the polar");
+        return ESP_FAIL;
+    }
+
+    for (int i = 0; i < GLIDER_POLAR_POINTS && result == ESP_OK; i++) {
+        if ((result = g_pBluethroatConfig->SetInteger(m_conf_namespace, m_conf_key_speeds[i], p_speeds_kmh[i])) == ESP_OK) {
+            result = g_pBluethroatConfig->SetInteger(m_conf_namespace, m_conf_key_sinks[i], p_sinks_cms[i]);
+        }
+    }
+    return result;
+}
+
+esp_err_t BluethraotVario::set_polar(const int32_t *p_speeds_kmh, const int32_t *p_sinks_cms) {
+    float speeds[GLIDER_POLAR_POINTS];
+    float sinks[GLIDER_POLAR_POINTS];
+    for (int i = 0; i < GLIDER_POLAR_POINTS; i++) {
+        speeds[i] = (float)p_speeds_kmh[i] * BLUETHROAT_VARIO_KMH_TO_MPS;
+        sinks[i] = (float)p_sinks_cms[i] / 100.0f;
+    }
+    return m_polar.SetPoints(speeds, sinks);
+}
+
+/*
+    The polar is of the indicated airspeed, in thinner air the wing flies faster for the same dynamic pressure and sinks
+    faster by the same factor sqrt(rho0 / rho). The airspeed is the one of the anemometer, the GNSS ground speed without
+    it, a wind makes that one wrong by the wind component along the track. Before either, the wing is taken to fly at
+    its minimum sink, netto is then as good as the relative climb.
+*/
+void BluethraotVario::update_netto(float vertical_speed, uint32_t timestamp) {
+    float density_ratio = GetDensityRatio();
+    float indicated_airspeed = m_polar.GetMinSinkSpeed();
+    if (airspeed_valid(timestamp)) {
+        indicated_airspeed = m_indicated_airspeed;
+    } else if (m_ground_speed > 0.0f) {
+        indicated_airspeed = m_ground_speed * density_ratio;
+    }
+
+    m_netto_vertical_speed = vertical_speed + m_polar.GetSink(indicated_airspeed) / density_ratio;
+    m_relative_vertical_speed = m_netto_vertical_speed - m_polar.GetMinSink() / density_ratio;
+}
+
 BluethraotVario *g_pBluethraotVario = new BluethraotVario();
 
-float CalculateVerticalSpeed(float temperature, float pressure, uint32_t timestamp) {
+float CalculateVerticalSpeed(float temperature, float pressure, float pressure_filtered, uint32_t timestamp) {
     if (g_pBluethraotVario) {
-        return g_pBluethraotVario->CalculateVerticalSpeed(temperature, pressure, timestamp);
+        return g_pBluethraotVario->CalculateVerticalSpeed(temperature, pressure, pressure_filtered, timestamp);
     } else {
         BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
         return 0.0f;
     }
-}
\ No newline at end of file
+}
+bool UpdateVerticalAcceleration(float vertical_acceleration, uint32_t timestamp, float *p_vertical_speed) {
+    if (g_pBluethraotVario) {
+        return g_pBluethraotVario->UpdateVerticalAcceleration(vertical_acceleration, timestamp, p_vertical_speed);
+    } else {
+        BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
+        return false;
+    }
+}
+float CalculateAirspeed(float total_pressure, float static_pressure, float total_pressure_sample, uint32_t timestamp) {
+    if (g_pBluethraotVario) {
+        return g_pBluethraotVario->CalculateAirspeed(total_pressure, static_pressure, total_pressure_sample, timestamp);
+    } else {
+        BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
+        return 0.0f;
+    }
+}
+float GetTrueAirspeed() {
+    if (g_pBluethraotVario) {
+        return g_pBluethraotVario->GetTrueAirspeed();
+    } else {
+        BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
+        return 0.0f;
+    }
+}
+esp_err_t LoadGliderPolar() {
+    if (g_pBluethraotVario) {
+        return g_pBluethraotVario->LoadPolar();
+    } else {
+        BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
+        return ESP_FAIL;
+    }
+}
+void SetGroundSpeed(float ground_speed) {
+    if (g_pBluethraotVario) {
+        g_pBluethraotVario->SetGroundSpeed(ground_speed);
+    } else {
+        BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
+    }
+}
+const GliderPolar *GetGliderPolar() {
+    if (g_pBluethraotVario) {
+        return g_pBluethraotVario->GetPolar();
+    } else {
+        BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
+        return NULL;
+    }
+}
+float GetDensityRatio() {
+    if (g_pBluethraotVario) {
+        return g_pBluethraotVario->GetDensityRatio();
+    } else {
+        BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
+        return 1.0f;
+    }
+}
+float GetNettoVerticalSpeed() {
+    if (g_pBluethraotVario) {
+        return g_pBluethraotVario->GetNettoVerticalSpeed();
+    } else {
+        BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
+        return 0.0f;
+    }
+}
+float GetRelativeVerticalSpeed() {
+    if (g_pBluethraotVario) {
+        return g_pBluethraotVario->GetRelativeVerticalSpeed();
+    } else {
+        BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
+        return 0.0f;
+    }
+}
+float GetBarometricAltitude() {
+    if (g_pBluethraotVario) {
+        return g_pBluethraotVario->GetBarometricAltitude();
+    } else {
+        BLUETHROAT_VARIO_LOGE("BluethraotVario instance is NULL");
+        return 0.0f;
+    }
+}
@@ -17,6 +17,9 @@
 #include <freertos/task.h>
 
 #include "drivers/axp192_pmu.h"
+#if CONFIG_FRAME_RECORDER_ENABLED
+#include "utilities/frame_recorder.h"
+#endif
 
 #define AXP192_PMU_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
 #define AXP192_PMU_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
@@ -48,6 +51,9 @@ static const char *TAG = "AXP192_PMU";
 
 Axp192Pmu::Axp192Pmu() : I2cDevice(){
 	m_p_object_name = TAG;
+#if CONFIG_FRAME_RECORDER_ENABLED
+	m_last_record_ticks = 0;
+#endif
 	AXP192_PMU_LOGI("Create %s device.", m_p_object_name);
 }
 
@@ -155,6 +161,15 @@ esp_err_t Axp192Pmu::fetch_data(uint8_t *data, uint8_t size) {
 	AXP192_PMU_LOGD("Read battery status successful, data are as follows:");
 	AXP192_PMU_BUFFER_LOGD(p_pmu_status, sizeof(Axp192PmuStatus_t));
 
+#if CONFIG_FRAME_RECORDER_ENABLED
+	// Battery status is polled every task interval but changes slowly, record it at the report rate only.
+	TickType_t now_ticks = xTaskGetTickCount();
+	if (now_ticks - m_last_record_ticks >= AXP192_PMU_STATUE_REPORT_INTERVAL) {
+		m_last_record_ticks = now_ticks;
+		(void)FrameRecorderRecord(FRAME_TYPE_AXP192_PMU_STATUS, (uint8_t)m_device_addr, p_pmu_status, sizeof(Axp192PmuStatus_t));
+	}
+#endif
+
     return ESP_OK;
 }
 
@@ -0,0 +1,297 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <sdkconfig.h>
+
+#include <esp_err.h>
+#include <esp_log.h>
+
+#include "utilities/i2c_device.h"
+#include "drivers/bmi270_imu.h"
+#if CONFIG_FRAME_RECORDER_ENABLED
+#include "utilities/frame_recorder.h"
+#endif
+
+#define BMI270_IMU_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define BMI270_IMU_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define BMI270_IMU_LOGI(format, ...) 				ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define BMI270_IMU_LOGD(format, ...) 				ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define BMI270_IMU_LOGV(format, ...) 				ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+#define BMI270_IMU_BUFFER_LOGE(buffer, buff_len) 	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer, buff_len, ESP_LOG_ERROR)
+#define BMI270_IMU_BUFFER_LOGW(buffer, buff_len) 	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer, buff_len, ESP_LOG_WARN)
+#define BMI270_IMU_BUFFER_LOGI(buffer, buff_len) 	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer, buff_len, ESP_LOG_INFO)
+#define BMI270_IMU_BUFFER_LOGD(buffer, buff_len) 	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer, buff_len, ESP_LOG_DEBUG)
+#define BMI270_IMU_BUFFER_LOGV(buffer, buff_len) 	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer, buff_len, ESP_LOG_VERBOSE)
+
+#ifdef _DEBUG
+#define BMI270_IMU_ASSERT(condition, format, ...)   \
+	do                                           \
+	{                                            \
+		if (!(condition))                        \
+		{                                        \
+			BMI270_IMU_LOGE(format, ##__VA_ARGS__); \
+			assert(0);                           \
+		}                                        \
+	} while (0)
+#else
+#define BMI270_IMU_ASSERT(condition, format, ...)
+#endif
+
+#define BMI270_ACC_SCALE            (BMI270_STANDARD_GRAVITY / BMI270_ACC_LSB_PER_G)            /* m/s^2 per LSB */
+#define BMI270_GYR_SCALE            ((float)M_PI / 180.0f / BMI270_GYR_LSB_PER_DPS)             /* rad/s per LSB */
+#define BMI270_FRAME_PERIOD         (1.0f / BMI270_OUTPUT_DATA_RATE_HZ)
+#define BMI270_GRAVITY_FRAMES       (BMI270_OUTPUT_DATA_RATE_HZ)                                /* one second */
+
+static const char *TAG = "BMI270_IMU";
+
+Bmi270Imu::Bmi270Imu() : I2cDevice(), m_attitude_time_constant((float)CONFIG_I2C_DEVICE_BMI270_ATTITUDE_TIME),
+    m_attitude_gate(CONFIG_I2C_DEVICE_BMI270_ATTITUDE_GATE / 100.0f), m_attitude_valid(false), m_gravity(BMI270_STANDARD_GRAVITY),
+    m_gravity_sum(0.0f), m_gravity_frames(0), m_overflows(0) {
+    this->m_p_object_name = TAG;
+    memset(m_up, 0, sizeof(m_up));
+    BMI270_IMU_LOGI("Create %s device", m_p_object_name);
+}
+
+Bmi270Imu::~Bmi270Imu() {
+    BMI270_IMU_LOGI("Destroy %s device", m_p_object_name);
+}
+
+esp_err_t Bmi270Imu::CheckDeviceId(I2cMaster *p_i2c_master, uint16_t device_addr) {
+    uint8_t chip_id;
+    if (p_i2c_master->ReadByte(device_addr, BMI270_REG_ADDR_CHIP_ID, &chip_id) == ESP_OK && chip_id == BMI270_REG_VALUE_CHIP_ID) {
+        BMI270_IMU_LOGI("BMI270 device found at 0x%2.2x", device_addr);
+        return ESP_OK;
+    } else {
+        BMI270_IMU_LOGE("BMI270 device not found at 0x%2.2x", device_addr);
+        return ESP_FAIL;
+    }
+}
+
+esp_err_t Bmi270Imu::init_device() {
+    if (this->write_byte(BMI270_REG_ADDR_CMD, BMI270_REG_VALUE_CMD_SOFT_RESET) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to reset %s device", m_p_object_name);
+        return ESP_FAIL;
+    }
+    vTaskDelay(pdMS_TO_TICKS(BMI270_RESET_READY_MS + portTICK_PERIOD_MS - 1));
+
+    // Advanced power save would stretch the register accesses, and isn't worth it with the gyroscope on.
+    if (this->write_byte(BMI270_REG_ADDR_PWR_CONF, BMI270_REG_VALUE_PWR_CONF_PERFORMANCE) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to disable %s advanced power save", m_p_object_name);
+        return ESP_FAIL;
+    }
+    vTaskDelay(pdMS_TO_TICKS(BMI270_POWER_SAVE_EXIT_MS + portTICK_PERIOD_MS - 1));
+
+    if (this->upload_config() != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    // 100Hz, filtered in performance mode, a 40Hz bandwidth is plenty for the motion of a glider.
+    Bmi270AccConfReg_t acc_conf = {0};
+    acc_conf.acc_odr = BMI270_REG_VALUE_ODR_100HZ;
+    acc_conf.acc_bwp = BMI270_REG_VALUE_ACC_BWP_NORMAL;
+    acc_conf.acc_filter_perf = 1;
+    if (this->write_byte(BMI270_REG_ADDR_ACC_CONF, acc_conf.byte) != ESP_OK || this->write_byte(BMI270_REG_ADDR_ACC_RANGE, BMI270_REG_VALUE_ACC_RANGE_4G) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to configure %s accelerometer", m_p_object_name);
+        return ESP_FAIL;
+    }
+
+    Bmi270GyrConfReg_t gyr_conf = {0};
+    gyr_conf.gyr_odr = BMI270_REG_VALUE_ODR_100HZ;
+    gyr_conf.gyr_bwp = BMI270_REG_VALUE_GYR_BWP_NORMAL;
+    gyr_conf.gyr_noise_perf = 1;
+    gyr_conf.gyr_filter_perf = 1;
+    if (this->write_byte(BMI270_REG_ADDR_GYR_CONF, gyr_conf.byte) != ESP_OK || this->write_byte(BMI270_REG_ADDR_GYR_RANGE, BMI270_REG_VALUE_GYR_RANGE_500DPS) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to configure %s gyroscope", m_p_object_name);
+        return ESP_FAIL;
+    }
+
+    // Stream mode, the oldest frames are overwritten when the task falls behind.
+    Bmi270FifoConfig0Reg_t fifo_config_0 = {0};
+    Bmi270FifoConfig1Reg_t fifo_config_1 = {0};
+    fifo_config_1.fifo_acc_en = 1;
+    fifo_config_1.fifo_gyr_en = 1;
+    if (this->write_byte(BMI270_REG_ADDR_FIFO_CONFIG_0, fifo_config_0.byte) != ESP_OK || this->write_byte(BMI270_REG_ADDR_FIFO_CONFIG_1, fifo_config_1.byte) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to configure %s FIFO", m_p_object_name);
+        return ESP_FAIL;
+    }
+
+    Bmi270PwrCtrlReg_t pwr_ctrl = {0};
+    pwr_ctrl.acc_en = 1;
+    pwr_ctrl.gyr_en = 1;
+    if (this->write_byte(BMI270_REG_ADDR_PWR_CTRL, pwr_ctrl.byte) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to enable %s accelerometer and gyroscope", m_p_object_name);
+        return ESP_FAIL;
+    }
+    vTaskDelay(pdMS_TO_TICKS(BMI270_POWER_UP_MS + portTICK_PERIOD_MS - 1));
+
+    // Frames of the start-up are dropped, the first burst starts from a settled sensor.
+    if (this->write_byte(BMI270_REG_ADDR_CMD, BMI270_REG_VALUE_CMD_FIFO_FLUSH) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to flush %s FIFO", m_p_object_name);
+        return ESP_FAIL;
+    }
+
+    m_attitude_valid = false;
+    m_gravity_sum = 0.0f;
+    m_gravity_frames = 0;
+    return ESP_OK;
+}
+
+/* The config file in chunks at their word offset, then the initialization is started and polled until it is done. */
+esp_err_t Bmi270Imu::upload_config() {
+    if (this->write_byte(BMI270_REG_ADDR_INIT_CTRL, BMI270_REG_VALUE_INIT_CTRL_LOAD) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to prepare %s config file upload", m_p_object_name);
+        return ESP_FAIL;
+    }
+
+    for (uint32_t offset = 0; offset < BMI270_CONFIG_FILE_SIZE; offset += BMI270_CONFIG_CHUNK_SIZE) {
+        uint8_t init_addr[2] = {(uint8_t)((offset / 2) & BMI270_INIT_ADDR_0_MASK), (uint8_t)((offset / 2) >> BMI270_INIT_ADDR_1_SHIFT)};
+        if (this->write_buffer(BMI270_REG_ADDR_INIT_ADDR_0, init_addr, sizeof(init_addr)) != ESP_OK
+            || this->write_buffer(BMI270_REG_ADDR_INIT_DATA, &(g_bmi270_config_file[offset]), BMI270_CONFIG_CHUNK_SIZE) != ESP_OK) {
+            BMI270_IMU_LOGE("Failed to upload %s config file at %lu", m_p_object_name, offset);
+            return ESP_FAIL;
+        }
+    }
+
+    if (this->write_byte(BMI270_REG_ADDR_INIT_CTRL, BMI270_REG_VALUE_INIT_CTRL_START) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to start %s initialization", m_p_object_name);
+        return ESP_FAIL;
+    }
+
+    uint8_t status = BMI270_REG_VALUE_STATUS_NOT_INIT;
+    for (uint32_t waited_ms = 0; waited_ms < BMI270_INIT_TIMEOUT_MS; waited_ms += BMI270_INIT_POLL_MS) {
+        vTaskDelay(pdMS_TO_TICKS(BMI270_INIT_POLL_MS));
+        if (this->read_byte(BMI270_REG_ADDR_INTERNAL_STATUS, &status) == ESP_OK && (status & BMI270_INTERNAL_STATUS_MESSAGE_MASK) == BMI270_REG_VALUE_STATUS_INIT_OK) {
+            BMI270_IMU_LOGI("%s initialized after %lu ms", m_p_object_name, waited_ms + BMI270_INIT_POLL_MS);
+            return ESP_OK;
+        }
+    }
+
+    BMI270_IMU_LOGE("%s not initialized by its config file, internal status 0x%2.2x", m_p_object_name, status);
+    return ESP_FAIL;
+}
+
+esp_err_t Bmi270Imu::deinit_device() {
+    Bmi270PwrCtrlReg_t pwr_ctrl = {0};
+    return this->write_byte(BMI270_REG_ADDR_PWR_CTRL, pwr_ctrl.byte);
+}
+
+/* One read of the fill level, one burst read of whole frames, at most a burst, the rest is left for the next loop. */
+esp_err_t Bmi270Imu::fetch_data(uint8_t *data, uint8_t size) {
+    BMI270_IMU_ASSERT(size >= sizeof(Bmi270FifoBurst_t), "Buffer size is not enough to contain %s FIFO burst structure.", m_p_object_name);
+
+    Bmi270FifoBurst_t *p_burst = (Bmi270FifoBurst_t *)data;
+    uint8_t fifo_length[2];
+    esp_err_t result;
+
+    p_burst->frames = 0;
+    if ((result = this->read_buffer(BMI270_REG_ADDR_FIFO_LENGTH_0, fifo_length, sizeof(fifo_length))) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to read %s FIFO length", m_p_object_name);
+        return result;
+    }
+
+    uint32_t frames = ((((uint32_t)fifo_length[1] << 8) | fifo_length[0]) & BMI270_FIFO_LENGTH_MASK) / sizeof(Bmi270FifoFrame_t);
+    if (frames > BMI270_FIFO_BURST_FRAMES) {
+        BMI270_IMU_LOGD("%s FIFO holds %lu frames, read %d", m_p_object_name, frames, BMI270_FIFO_BURST_FRAMES);
+        m_overflows++;
+        frames = BMI270_FIFO_BURST_FRAMES;
+    } else if (frames == 0) {
+        return ESP_OK;
+    }
+
+    if ((result = this->read_buffer(BMI270_REG_ADDR_FIFO_DATA, (uint8_t *)(p_burst->frame), frames * sizeof(Bmi270FifoFrame_t))) != ESP_OK) {
+        BMI270_IMU_LOGE("Failed to read %s FIFO data", m_p_object_name);
+        return result;
+    }
+    p_burst->frames = (uint8_t)frames;
+
+#if CONFIG_FRAME_RECORDER_ENABLED
+    (void)FrameRecorderRecord(FRAME_TYPE_BMI270_FIFO, (uint8_t)m_device_addr, (uint8_t *)(p_burst->frame), frames * sizeof(Bmi270FifoFrame_t));
+#endif
+    BMI270_IMU_LOGV("Device: %s, fetched %lu frames", m_p_object_name, frames);
+    return ESP_OK;
+}
+
+esp_err_t Bmi270Imu::process_data(uint8_t *in_data, uint8_t in_size, BluethroatMsg_t *p_message) {
+    const Bmi270FifoBurst_t *p_burst = (const Bmi270FifoBurst_t *)in_data;
+    float acceleration_sum[3] = {0.0f, 0.0f, 0.0f};
+    float vertical_sum = 0.0f;
+    uint32_t frames = (p_burst->frames < BMI270_FIFO_BURST_FRAMES) ? p_burst->frames : BMI270_FIFO_BURST_FRAMES;
+
+    for (uint32_t i = 0; i < frames; i++) {
+        const Bmi270FifoFrame_t *p_frame = &(p_burst->frame[i]);
+        float acceleration[3] = {p_frame->acc_x * BMI270_ACC_SCALE, p_frame->acc_y * BMI270_ACC_SCALE, p_frame->acc_z * BMI270_ACC_SCALE};
+        float rotation[3] = {p_frame->gyr_x * BMI270_GYR_SCALE, p_frame->gyr_y * BMI270_GYR_SCALE, p_frame->gyr_z * BMI270_GYR_SCALE};
+
+        vertical_sum += update_attitude(acceleration, rotation, BMI270_FRAME_PERIOD);
+        acceleration_sum[0] += acceleration[0];
+        acceleration_sum[1] += acceleration[1];
+        acceleration_sum[2] += acceleration[2];
+    }
+
+    if (p_message != NULL) {
+        // No message until the gravity is measured, the vertical acceleration would be off by the scale error.
+        if (frames == 0 || m_gravity_frames < BMI270_GRAVITY_FRAMES) {
+            p_message->type = BLUETHROAT_MSG_INVALID;
+            return ESP_OK;
+        }
+
+        float scale = 1.0f / frames;
+        p_message->type = BLUETHROAT_MSG_TYPE_ACCELERATION_DATA;
+        p_message->acceleration_data.x = acceleration_sum[0] * scale;
+        p_message->acceleration_data.y = acceleration_sum[1] * scale;
+        p_message->acceleration_data.z = acceleration_sum[2] * scale;
+        p_message->acceleration_data.vertical = vertical_sum * scale;
+        p_message->acceleration_data.timestamp = esp_log_timestamp();
+
+        BMI270_IMU_LOGV("Device: %s send message, frames: %lu, acceleration: %f %f %f, vertical: %f", m_p_object_name, frames, p_message->acceleration_data.x, p_message->acceleration_data.y, p_message->acceleration_data.z, p_message->acceleration_data.vertical);
+    }
+
+    return ESP_OK;
+}
+
+/*
+    The vertical is a fixed vector of the earth frame, in the sensor frame it turns against the rotation of the sensor:
+    du/dt = -w x u. Returns the vertical acceleration of the frame, 0 until the gravity is measured.
+*/
+float Bmi270Imu::update_attitude(const float *p_acceleration, const float *p_rotation, float delta_time) {
+    float norm = sqrtf(p_acceleration[0] * p_acceleration[0] + p_acceleration[1] * p_acceleration[1] + p_acceleration[2] * p_acceleration[2]);
+    if (norm < 0.1f * BMI270_STANDARD_GRAVITY) {
+        // Free fall or a broken frame, keep the attitude.
+        return 0.0f;
+    }
+
+    if (!m_attitude_valid) {
+        for (int i = 0; i < 3; i++) {
+            m_up[i] = p_acceleration[i] / norm;
+        }
+        m_attitude_valid = true;
+    } else {
+        float cross[3] = {
+            p_rotation[1] * m_up[2] - p_rotation[2] * m_up[1],
+            p_rotation[2] * m_up[0] - p_rotation[0] * m_up[2],
+            p_rotation[0] * m_up[1] - p_rotation[1] * m_up[0],
+        };
+        float gain = (fabsf(norm - m_gravity) < m_attitude_gate * m_gravity) ? delta_time / m_attitude_time_constant : 0.0f;
+        for (int i = 0; i < 3; i++) {
+            m_up[i] += -cross[i] * delta_time + gain * (p_acceleration[i] / norm - m_up[i]);
+        }
+        float up_norm = sqrtf(m_up[0] * m_up[0] + m_up[1] * m_up[1] + m_up[2] * m_up[2]);
+        for (int i = 0; i < 3; i++) {
+            m_up[i] /= up_norm;
+        }
+    }
+
+    float along = p_acceleration[0] * m_up[0] + p_acceleration[1] * m_up[1] + p_acceleration[2] * m_up[2];
+    if (m_gravity_frames < BMI270_GRAVITY_FRAMES) {
+        m_gravity_sum += along;
+        if (++m_gravity_frames == BMI270_GRAVITY_FRAMES) {
+            m_gravity = m_gravity_sum / BMI270_GRAVITY_FRAMES;
+            BMI270_IMU_LOGI("Device: %s, gravity %f m/s^2", m_p_object_name, m_gravity);
+        }
+        return 0.0f;
+    }
+
+    return along - m_gravity;
+}
@@ -1,4 +1,9 @@
+#include <stddef.h>
+
+#include <esp_timer.h>
+
 #include "drivers/dps3xx_anemometer.h"
+#include "drivers/dps3xx_sync.h"
 
 #define DPS3XX_ANEMO_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
 #define DPS3XX_ANEMO_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
@@ -28,12 +33,29 @@
 
 static const char *TAG = "DPS3XX_ANEMO";
 
-Dps3xxAnemometer::Dps3xxAnemometer(Dps3xxBarometer *p_barometer) : Dps3xxBarometer(), m_p_barometer(p_barometer) {
+static_assert(offsetof(AnemometerData_t, temperature) == offsetof(BarometerData_t, temperature) && offsetof(AnemometerData_t, timestamp) == offsetof(BarometerData_t, timestamp),
+    "anemometer data must share the temperature and the timestamp of the barometer data");
+
+Dps3xxAnemometer::Dps3xxAnemometer(Dps3xxBarometer *p_barometer, bool static_port) : Dps3xxBarometer(), m_p_barometer(p_barometer), m_static_port(static_port), m_unpaired(0), m_unsynced_bursts(0) {
     m_p_object_name = TAG;
-    DPS3XX_ANEMO_LOGI("Create %s device", m_p_object_name);
+    m_trace_latency = false;
+    m_p_static_filter = new FirFilter<uint32_t, uint32_t>(FILTER_DEPTH_DEEP, AIR_PRESSURE_DEFAULT_VALUE << (31 - AIR_PRESSURE_DEFAULT_VALUE_MSB - FILTER_DEPTH_DEEP));
+    if (this->get_sync() == NULL) {
+        DPS3XX_ANEMO_LOGW("No barometer sync, %s runs on its own wakes", m_p_object_name);
+    }
+    DPS3XX_ANEMO_LOGI("Create %s device, %s", m_p_object_name, m_static_port ? "static port" : "pitot");
 }
 
 Dps3xxAnemometer::~Dps3xxAnemometer() {
+    delete m_p_static_filter;
+}
+
+esp_err_t Dps3xxAnemometer::fetch_data(uint8_t *data, uint8_t size) {
+    // The mode of the barometer, the airspeed and the redundant static pair the samples of both at the same rate.
+    if (m_p_barometer != NULL) {
+        this->SetMode(m_p_barometer->GetRequestedMode());
+    }
+    return Dps3xxBarometer::fetch_data(data, size);
 }
 
 esp_err_t Dps3xxAnemometer::process_data(uint8_t *in_data, uint8_t in_size, BluethroatMsg_t *p_message) {
@@ -42,14 +64,38 @@ esp_err_t Dps3xxAnemometer::process_data(uint8_t *in_data, uint8_t in_size, Blue
         return ESP_FAIL;
     }
 
-    float32_t total_pressure = float32_t(POSITIVE, this->m_p_deep_filter->GetAverage(), -10);
-    float32_t static_pressure = float32_t(POSITIVE, this->m_p_barometer->m_p_deep_filter->GetAverage(), -10);
+    if (m_static_port) {
+        p_message->type = BLUETHROAT_MSG_TYPE_STATIC_PRESSURE_DATA;
+        return ESP_OK;
+    }
+
+    // The static pressure of the barometer sample taken with this one, the nearest counted as unpaired when none was.
+    Dps3xxSync *p_sync = this->get_sync();
+    float32_t static_sample;
+    int64_t skew_us;
+    if (p_sync != NULL && p_sync->GetPressure(m_sample_timestamp_us, &static_sample, &skew_us)) {
+        if ((skew_us < 0 ? -skew_us : skew_us) > (int64_t)(this->GetSamplePeriodUs() / 2)) {
+            m_unpaired++;
+            DPS3XX_ANEMO_LOGD("%s sample paired %lld us apart", m_p_object_name, (long long)skew_us);
+        }
+        this->m_p_static_filter->PutSample(static_sample.m >> ((AIR_PRESSURE_DEFAULT_VALUE_MSB + FILTER_DEPTH_DEEP - 31) - static_sample.e));
+    } else {
+        m_unpaired++;
+    }
+
+    // The deep filters hold the pressures with the exponent process_data() shifted them to.
+    float32_t total_pressure = float32_t(POSITIVE, this->m_p_deep_filter->GetAverage(), AIR_PRESSURE_DEFAULT_VALUE_MSB + FILTER_DEPTH_DEEP - 31);
+    float32_t static_pressure = float32_t(POSITIVE, this->m_p_static_filter->GetAverage(), AIR_PRESSURE_DEFAULT_VALUE_MSB + FILTER_DEPTH_DEEP - 31);
 
     DPS3XX_ANEMO_LOGD("%f %f %f %f", p_message->barometer_data.temperature, (float)total_pressure, (float)static_pressure, (float)(total_pressure - static_pressure));
 
+    float total_pressure_sample = p_message->barometer_data.pressure;
+
     p_message->type = BLUETHROAT_MSG_TYPE_ANEMOMETER_DATA;
-    // It is not necessary to copy the temperature from barometer data to anemometer data since they are in the same place in the union
+    // It is not necessary to copy the temperature and the timestamp from barometer data to anemometer data since they are in the same place in the union
     // p_message->anemometer_data.temperature = p_message->barometer_data.temperature;
+    // p_message->anemometer_data.timestamp = p_message->barometer_data.timestamp;
+    p_message->anemometer_data.total_pressure_sample = total_pressure_sample;
     p_message->anemometer_data.total_pressure = (float)total_pressure;
     p_message->anemometer_data.static_pressure = (float)static_pressure;
 
@@ -57,3 +103,44 @@ esp_err_t Dps3xxAnemometer::process_data(uint8_t *in_data, uint8_t in_size, Blue
 
     return ESP_OK;
 }
+
+/*
+    Starts on the phase of the barometer, a whole number of its periods after its start. A mode switch of the barometer
+    may follow the one of the anemometer by a few ticks, a start in another mode is waited for.
+*/
+void Dps3xxAnemometer::wait_start() {
+    Dps3xxSync *p_sync = this->get_sync();
+    if (p_sync == NULL) {
+        return;
+    }
+
+    int64_t start_us;
+    for (uint32_t ticks = 0; !p_sync->GetAlignedStart(esp_timer_get_time(), this->GetSamplePeriodUs(), &start_us); ticks++) {
+        if (ticks == DPS3XX_SYNC_START_TIMEOUT_TICKS) {
+            DPS3XX_ANEMO_LOGW("Barometer not started in the mode of %s, starting on its own phase", m_p_object_name);
+            return;
+        }
+        vTaskDelay(1);
+    }
+    (void)this->wait_until(start_us);
+    // The bursts the barometer ended so far hold no result of the new start.
+    (void)p_sync->WaitBurst(0);
+}
+
+/*
+    Reads the FIFO once the barometer processed its burst, the results of both end at the same time. Without the
+    barometer the FIFO is read a burst and a period after the last one, the results are in it by then.
+*/
+esp_err_t Dps3xxAnemometer::wait_burst() {
+    Dps3xxSync *p_sync = this->get_sync();
+    if (p_sync == NULL) {
+        return Dps3xxBarometer::wait_burst();
+    }
+
+    uint32_t timeout_ms = (this->GetSamplePeriodUs() * (DPS3XX_FIFO_BURST_SAMPLES + 1) + 999) / 1000;
+    if (!p_sync->WaitBurst(pdMS_TO_TICKS(timeout_ms) + 1)) {
+        m_unsynced_bursts++;
+        DPS3XX_ANEMO_LOGD("%s FIFO read without the barometer", m_p_object_name);
+    }
+    return ESP_OK;
+}
@@ -1,5 +1,6 @@
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <esp_err.h>
 #include <esp_log.h>
@@ -9,6 +10,12 @@
 #include "utilities/i2c_device.h"
 #include "utilities/low_pass_filter.h"
 #include "drivers/dps3xx_barometer.h"
+#if CONFIG_FRAME_RECORDER_ENABLED
+#include "utilities/frame_recorder.h"
+#endif
+#if CONFIG_LATENCY_TRACE_ENABLED
+#include "utilities/latency_trace.h"
+#endif
 
 #define DPS3XX_BARO_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
 #define DPS3XX_BARO_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
@@ -38,7 +45,31 @@
 
 static const char *TAG = "DPS3XX_BARO";
 
-Dps3xxBarometer::Dps3xxBarometer() : I2cDevice() {
+// Single measurement time and scale factor of every oversampling rate, indexed by the PM_PRC and TMP_PRC values.
+static const uint32_t s_measurement_times_ms[] = {
+    DPS3XX_MEASUREMENT_TIME_MS_PRC_1,  DPS3XX_MEASUREMENT_TIME_MS_PRC_2,  DPS3XX_MEASUREMENT_TIME_MS_PRC_4,  DPS3XX_MEASUREMENT_TIME_MS_PRC_8,
+    DPS3XX_MEASUREMENT_TIME_MS_PRC_16, DPS3XX_MEASUREMENT_TIME_MS_PRC_32, DPS3XX_MEASUREMENT_TIME_MS_PRC_64, DPS3XX_MEASUREMENT_TIME_MS_PRC_128,
+};
+static const int32_t s_scale_factors[] = {
+    DPS3XX_SCALE_FACTOR_PRC_1,  DPS3XX_SCALE_FACTOR_PRC_2,  DPS3XX_SCALE_FACTOR_PRC_4,  DPS3XX_SCALE_FACTOR_PRC_8,
+    DPS3XX_SCALE_FACTOR_PRC_16, DPS3XX_SCALE_FACTOR_PRC_32, DPS3XX_SCALE_FACTOR_PRC_64, DPS3XX_SCALE_FACTOR_PRC_128,
+};
+
+// Pressure rate and oversampling, and the most the temperature is oversampled, of every mode.
+typedef struct {
+    uint8_t pressure_rate;
+    uint8_t pressure_prc;
+    uint8_t temperature_max_prc;
+} Dps3xxModeConfig_t;
+
+static const Dps3xxModeConfig_t s_modes[DPS3XX_MODE_MAX] = {
+    [DPS3XX_MODE_LOW_POWER]         = {DPS3XX_REG_VALUE_PM_RATE_4, DPS3XX_REG_VALUE_PM_PRC_8,  DPS3XX_REG_VALUE_TMP_PRC_8},
+    [DPS3XX_MODE_HIGH_RESOLUTION]   = {DPS3XX_REG_VALUE_PM_RATE_8, DPS3XX_REG_VALUE_PM_PRC_64, DPS3XX_REG_VALUE_TMP_PRC_32},
+};
+
+Dps3xxBarometer::Dps3xxBarometer(Dps3xxSync *p_sync) : I2cDevice(), m_mode(DPS3XX_MODE_HIGH_RESOLUTION), m_requested_mode(DPS3XX_MODE_HIGH_RESOLUTION), m_trace_latency(true), m_trace_sequence(0), m_sample_count(0), m_sample_index(0),
+    m_has_temperature(false), m_sample_timestamp_us(0), m_sample_timestamp(0), m_has_timestamp(false), m_wake_timer(NULL), m_wake_semaphore(NULL), m_next_wake_us(0), m_p_sync(p_sync), m_start_us(0), m_overflows(0),
+    m_cached_raw_temperature(0), m_has_cached_temperature(false), m_temperature_updates(0) {
     this->m_p_object_name = TAG;
     DPS3XX_BARO_LOGI("Create %s device", m_p_object_name);
 }
@@ -47,6 +78,13 @@ Dps3xxBarometer::~Dps3xxBarometer() {
     DPS3XX_BARO_LOGI("Destroy %s device", m_p_object_name);
     delete m_p_shallow_filter;
     delete m_p_deep_filter;
+    if (m_wake_timer != NULL) {
+        (void)esp_timer_stop(m_wake_timer);
+        (void)esp_timer_delete(m_wake_timer);
+    }
+    if (m_wake_semaphore != NULL) {
+        vSemaphoreDelete(m_wake_semaphore);
+    }
 }
 
 esp_err_t Dps3xxBarometer::CheckDeviceId(I2cMaster *p_i2c_master, uint16_t device_addr) {
@@ -63,19 +101,34 @@ esp_err_t Dps3xxBarometer::CheckDeviceId(I2cMaster *p_i2c_master, uint16_t devic
 esp_err_t Dps3xxBarometer::init_device() {
     m_p_shallow_filter = new FirFilter<uint32_t, uint32_t>(FILTER_DEPTH_SHALLOW, AIR_PRESSURE_DEFAULT_VALUE << (31 - AIR_PRESSURE_DEFAULT_VALUE_MSB - FILTER_DEPTH_SHALLOW));
     m_p_deep_filter = new FirFilter<uint32_t, uint32_t>(FILTER_DEPTH_DEEP, AIR_PRESSURE_DEFAULT_VALUE << (31 - AIR_PRESSURE_DEFAULT_VALUE_MSB - FILTER_DEPTH_DEEP));
-    m_pressure_cfg = {
-        .mesurement_rate = DPS3XX_REG_VALUE_PM_RATE_4,
-        .oversampling_rate = DPS3XX_REG_VALUE_PM_PRC_64,
-        .mesurement_time = pdMS_TO_TICKS(DPS3XX_MEASUREMENT_TIME_MS_PRC_64 + portTICK_PERIOD_MS - 1),
-        .scale_factor = float32_t((int32_t)DPS3XX_SCALE_FACTOR_PRC_64),
-    };
-    m_temperature_cfg = {
-        .mesurement_rate = DPS3XX_REG_VALUE_PM_RATE_4,
-        .oversampling_rate = DPS3XX_REG_VALUE_TMP_PRC_32,
-        .mesurement_time = pdMS_TO_TICKS(DPS3XX_MEASUREMENT_TIME_MS_PRC_32 + portTICK_PERIOD_MS  - 1),
-        .scale_factor = float32_t((int32_t)DPS3XX_SCALE_FACTOR_PRC_32),
-    };
-    
+    // The mode requested before the task starts, the flight one by default.
+    m_mode = m_requested_mode;
+    this->select_mode(m_mode);
+    m_sample_count = 0;
+    m_sample_index = 0;
+    m_has_temperature = false;
+    m_has_timestamp = false;
+    m_has_cached_temperature = false;
+
+    // The burst wakes, a reset of the device keeps the timer of the first initialization.
+    if (m_wake_semaphore == NULL && (m_wake_semaphore = xSemaphoreCreateBinary()) == NULL) {
+        DPS3XX_BARO_LOGE("Failed to create %s wake semaphore", m_p_object_name);
+        return ESP_ERR_NO_MEM;
+    }
+    if (m_wake_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = &Dps3xxBarometer::wake_callback,
+            .arg = this,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = m_p_object_name,
+            .skip_unhandled_events = true,
+        };
+        if (esp_timer_create(&timer_args, &m_wake_timer) != ESP_OK) {
+            DPS3XX_BARO_LOGE("Failed to create %s wake timer", m_p_object_name);
+            return ESP_FAIL;
+        }
+    }
+
     Dps3xxResetReg_t reset = {0};
     reset.soft_reset = DPS3XX_REG_VALUE_SOFT_RESET;
     reset.fifo_flush = DPS3XX_REG_VALUE_FIFO_FLUSH;
@@ -99,45 +152,20 @@ esp_err_t Dps3xxBarometer::init_device() {
         return ESP_FAIL;
     }
 
-    // Set pressure measurement rate and oversampling rate
-    Dps3xxPrsCfgReg_t prs_cfg = {0};
-    prs_cfg.pm_rate = m_pressure_cfg.mesurement_rate;
-    prs_cfg.pm_prc = m_pressure_cfg.oversampling_rate;
-    if (this->write_byte(DPS3XX_REG_ADDR_PRS_CFG, prs_cfg.byte) != ESP_OK) {
-        DPS3XX_BARO_LOGE("Failed to set %s pressure measurement rate and oversampling rate", m_p_object_name);
-        return ESP_FAIL;
-    }
-
-    // Set temperature measurement rate and oversampling rate
-    Dps3xxTmpCfgReg_t tmp_cfg = {0};
-    if (this->read_byte(DPS3XX_REG_ADDR_COEF_SRC, &(tmp_cfg.byte)) != ESP_OK) {
-        DPS3XX_BARO_LOGE("Failed to read %s temperature coefficient source", m_p_object_name);
-        return ESP_FAIL;
-    }
-    tmp_cfg.tmp_rate = m_temperature_cfg.mesurement_rate;
-    tmp_cfg.tmp_prc = m_temperature_cfg.oversampling_rate;
-    if (this->write_byte(DPS3XX_REG_ADDR_TMP_CFG, tmp_cfg.byte) != ESP_OK) {
-        DPS3XX_BARO_LOGE("Failed to set %s temperature measurement rate and oversampling rate", m_p_object_name);
-        return ESP_FAIL;
-    }
-
-    // Set pressure and temperature shift enable
-    Dps3xxCfgReg_t cfg = {0};
-    cfg.p_shift_en = 1;
-    cfg.t_shift_en = 1;
-    if (this->write_byte(DPS3XX_REG_ADDR_CFG_REG, cfg.byte) != ESP_OK) {
-        DPS3XX_BARO_LOGE("Failed to set %s pressure and temperature shift enable", m_p_object_name);
+    // Set pressure and temperature measurement rate and oversampling rate, FIFO and shift enable
+    if (this->write_measure_config() != ESP_OK) {
         return ESP_FAIL;
     }
 
-    // Set pressure and temperature measurement mode to stop (idle mode, ready for single shot measurement)
+    // Set pressure and temperature measurement mode to continuous background measurement
+    this->wait_start();
     meas_cfg = {0};
+    meas_cfg.meas_ctrl = DPS3XX_REG_VALUE_MEAS_CTRL_BG_ALL;
     if (this->write_byte(DPS3XX_REG_ADDR_MEAS_CFG, meas_cfg.byte) != ESP_OK) {
-        DPS3XX_BARO_LOGE("Failed to set %s pressure and temperature measurement rate", m_p_object_name);
+        DPS3XX_BARO_LOGE("Failed to start %s background measurement", m_p_object_name);
         return ESP_FAIL;
     }
-
-    vTaskDelay(pdMS_TO_TICKS(portTICK_PERIOD_MS));
+    this->start_wakes();
 
     return ESP_OK;
 }
@@ -148,91 +176,96 @@ esp_err_t Dps3xxBarometer::deinit_device() {
 
 esp_err_t Dps3xxBarometer::fetch_data(uint8_t *data, uint8_t size) {
     DPS3XX_BARO_ASSERT(size >= sizeof(Dps3xxData_t), "Buffer size is not enough to contain %s pressure and temperature structure.", m_p_object_name);
-    
-    uint8_t meas_cfg;
-    esp_err_t result;
-    uint8_t retry;
 
-    if ((result = this->write_byte(DPS3XX_REG_ADDR_MEAS_CFG, DPS3XX_REG_VALUE_MEAS_CTRL_TMP)) != ESP_OK) {
-        DPS3XX_BARO_LOGE("Failed to write %s measurement configuration register", m_p_object_name);
-        return ESP_FAIL;
-    } else {
-        vTaskDelay(this->m_temperature_cfg.mesurement_time);
-    }
+    esp_err_t result;
 
-    for (retry=0; retry<5; retry++) {
-        if ((result = this->read_byte(DPS3XX_REG_ADDR_MEAS_CFG, &meas_cfg) != ESP_OK)) {
-            DPS3XX_BARO_LOGE("Failed to read %s measurement configuration register", m_p_object_name);
-            return ESP_FAIL;
-        } else if (meas_cfg & DPS3XX_REG_VALUE_TMP_RDY) {
-            break;
-        } else {
-            DPS3XX_BARO_LOGV("Waiting for %s temperature data ready, meas_cfg: 0x%2.2x", m_p_object_name, meas_cfg);
-            vTaskDelay(pdMS_TO_TICKS(portTICK_PERIOD_MS));
+    // A new mode applies once the samples of the last burst are processed, they are compensated for the old one.
+    if (m_sample_index >= m_sample_count && m_requested_mode != m_mode) {
+        if ((result = this->ApplyMode(m_requested_mode)) != ESP_OK) {
+            DPS3XX_BARO_LOGE("Failed to switch %s to mode %d", m_p_object_name, m_requested_mode);
+            return result;
         }
     }
 
-    if (retry == 5) {
-        DPS3XX_BARO_LOGE("Failed to get %s temperature data ready flag", m_p_object_name);
-        return ESP_FAIL;
-    }
-
-    if ((result = this->write_byte(DPS3XX_REG_ADDR_MEAS_CFG, DPS3XX_REG_VALUE_MEAS_CTRL_PRS)) != ESP_OK) {
-        DPS3XX_BARO_LOGE("Failed to write %s measurement configuration register", m_p_object_name);
-        return ESP_FAIL;
-    } else {
-        vTaskDelay(this->m_pressure_cfg.mesurement_time);
-    }
-
-    for (retry=0; retry<5; retry++) {
-        if ((result = this->read_byte(DPS3XX_REG_ADDR_MEAS_CFG, &meas_cfg) != ESP_OK)) {
-            DPS3XX_BARO_LOGE("Failed to read %s measurement configuration register", m_p_object_name);
-            return ESP_FAIL;
-        } else if (meas_cfg & DPS3XX_REG_VALUE_PRS_RDY) {
-            break;
-        } else {
-            DPS3XX_BARO_LOGV("Waiting for %s pressure data ready, meas_cfg: 0x%2.2x", m_p_object_name, meas_cfg);
-            vTaskDelay(pdMS_TO_TICKS(portTICK_PERIOD_MS));
+    // The samples of a burst are handed over one by one, the FIFO is only read once they are all processed.
+    for (uint8_t burst = 0; m_sample_index >= m_sample_count; burst++) {
+        if (burst == DPS3XX_FIFO_EMPTY_BURSTS) {
+            DPS3XX_BARO_LOGE("No %s pressure in %d FIFO bursts", m_p_object_name, DPS3XX_FIFO_EMPTY_BURSTS);
+            return ESP_ERR_TIMEOUT;
+        }
+        if ((result = this->wait_burst()) != ESP_OK) {
+            DPS3XX_BARO_LOGE("Failed to wait for %s FIFO burst", m_p_object_name);
+            return result;
+        }
+        if ((result = this->read_fifo()) != ESP_OK) {
+            DPS3XX_BARO_LOGE("Failed to read %s FIFO", m_p_object_name);
+            return result;
+        }
+        // The wakes keep the phase of the first result, a burst without a pressure waits another period. A task held up
+        // past the next wake too skips the wakes it missed.
+        int64_t burst_us = (int64_t)this->GetSamplePeriodUs() * DPS3XX_FIFO_BURST_SAMPLES;
+        m_next_wake_us += (m_sample_count > 0) ? burst_us : (int64_t)this->GetSamplePeriodUs();
+        int64_t now_us = esp_timer_get_time();
+        if (m_next_wake_us <= now_us) {
+            m_next_wake_us += ((now_us - m_next_wake_us) / burst_us + 1) * burst_us;
         }
     }
 
-    if (retry == 5) {
-        DPS3XX_BARO_LOGE("Failed to get %s pressure data ready flag", m_p_object_name);
-        return ESP_FAIL;
-    }
-
-    result = this->read_buffer(DPS3XX_REG_ADDR_PSR_B2, data, sizeof(Dps3xxData_t));
+    const Dps3xxSample_t *p_sample = &(m_samples[m_sample_index++]);
+    memcpy(data, p_sample->data.bytes, sizeof(Dps3xxData_t));
+    m_sample_timestamp_us = p_sample->timestamp_us;
+    m_sample_timestamp = (uint32_t)(p_sample->timestamp_us / 1000);
 
-    if (result == ESP_OK) {
-        DPS3XX_BARO_LOGD("Device: %s, raw_temperature: 0x%2.2x%2.2x%2.2x, raw_pressure: 0x%2.2x%2.2x%2.2x", m_p_object_name, data[2], data[1], data[0], data[5], data[4], data[3]);
-        return ESP_OK;
-    } else {
-        DPS3XX_BARO_LOGE("Failed to read %s pressure and temperature data", m_p_object_name);
-        return result;
+#if CONFIG_FRAME_RECORDER_ENABLED
+    (void)FrameRecorderRecordAt(FRAME_TYPE_DPS3XX_DATA, (uint8_t)m_device_addr, m_sample_timestamp, data, sizeof(Dps3xxData_t));
+#endif
+#if CONFIG_LATENCY_TRACE_ENABLED
+    if (m_trace_latency) {
+        m_trace_sequence = LatencyTraceBegin();
     }
+#endif
+    DPS3XX_BARO_LOGD("Device: %s, raw_pressure: 0x%2.2x%2.2x%2.2x, raw_temperature: 0x%2.2x%2.2x%2.2x", m_p_object_name, data[0], data[1], data[2], data[3], data[4], data[5]);
+    return ESP_OK;
 }
 
 esp_err_t Dps3xxBarometer::process_data(uint8_t *in_data, uint8_t in_size, BluethroatMsg_t *p_message) {
     Dps3xxData_t *regs = (Dps3xxData_t *)in_data;
 
-    uint32_t timestamp_ms = esp_log_timestamp();
+    uint32_t timestamp_ms = m_sample_timestamp;
 
     int32_t raw_temperature = (int32_t)(((uint32_t)regs->tmp_b2 << 24) | ((uint32_t)regs->tmp_b1 << 16) | ((uint32_t)regs->tmp_b0 << 8)) >> 8;
     int32_t raw_pressure    = (int32_t)(((uint32_t)regs->prs_b2 << 24) | ((uint32_t)regs->prs_b1 << 16) | ((uint32_t)regs->prs_b0 << 8)) >> 8;
 
     DPS3XX_BARO_LOGV("Device: %s, raw_temperature: 0x%8.8lx, raw_pressure: 0x%8.8lx", m_p_object_name, raw_temperature, raw_pressure);
 
-    float32_t temperature = m_coef_data.scaled_c0 + 
-                            m_coef_data.scaled_c1 * raw_temperature;
-    float32_t pressure    = m_coef_data.scaled_c00 + 
-                            m_coef_data.scaled_c10 * raw_pressure + 
+    // The temperature terms only change with a new temperature result, once every DPS3XX_TEMPERATURE_RATIO pressures.
+    if (!m_has_cached_temperature || raw_temperature != m_cached_raw_temperature) {
+        m_cached_temperature     = m_coef_data.scaled_c0 +
+                                   m_coef_data.scaled_c1 * raw_temperature;
+        m_cached_pressure_offset = m_coef_data.scaled_c00 +
+                                   m_coef_data.scaled_c01 * raw_temperature;
+        m_cached_pressure_gain   = m_coef_data.scaled_c10 +
+                                   m_coef_data.scaled_c11 * raw_temperature;
+        m_cached_raw_temperature = raw_temperature;
+        m_has_cached_temperature = true;
+        m_temperature_updates++;
+    }
+    float32_t temperature = m_cached_temperature;
+    float32_t pressure    = m_cached_pressure_offset +
+                            m_cached_pressure_gain * raw_pressure +
                             m_coef_data.scaled_c20 * raw_pressure * raw_pressure +
-                            m_coef_data.scaled_c30 * raw_pressure * raw_pressure * raw_pressure +
-                            m_coef_data.scaled_c01 * raw_temperature +
-                            m_coef_data.scaled_c11 * raw_pressure * raw_temperature;
+                            m_coef_data.scaled_c30 * raw_pressure * raw_pressure * raw_pressure;
 
     DPS3XX_BARO_LOGD("%s %ld %ld %f %f", m_p_object_name, raw_temperature, raw_pressure,(float)temperature, (float)pressure);
 
+    // The anemometer pairs its samples with these, it reads its FIFO once the burst is processed.
+    if (m_p_sync != NULL) {
+        m_p_sync->PutSample(m_sample_timestamp_us, pressure);
+        if (m_sample_index >= m_sample_count) {
+            m_p_sync->EndBurst();
+        }
+    }
+
     // Generally, the air pressure value  is 300(@30km) ~ 101325(@0km) Pa, it is a positive value.
     // Since 101325 is 0x18BCD only 17 bits, so the maximum value of the pressure.e is -15.
     // Shift the pressure.m to make exponent tobe ((-15) + FILTER_DEPTH_XXX), then put it into the filter.
@@ -254,6 +287,7 @@ esp_err_t Dps3xxBarometer::process_data(uint8_t *in_data, uint8_t in_size, Bluet
         // If don't left shift before construct a float32_t, additional shift operations and MSB detection will cause a lot of load.
         p_message->barometer_data.pressure_filterd = (float)float32_t(pressure.s, prs_shallow_average << FILTER_DEPTH_SHALLOW, pressure.e + shallow_offset - FILTER_DEPTH_SHALLOW);
         p_message->barometer_data.timestamp = timestamp_ms;
+        p_message->barometer_data.trace_sequence = m_trace_sequence;
 
         DPS3XX_BARO_LOGV("Device: %s send message, temperature: %f, pressure: %f, pressure_filterd: %f, timestamp: %lu", m_p_object_name, p_message->barometer_data.temperature, p_message->barometer_data.pressure, p_message->barometer_data.pressure_filterd, p_message->barometer_data.timestamp);
     }
@@ -267,6 +301,9 @@ esp_err_t Dps3xxBarometer::get_coefs() {
         DPS3XX_BARO_LOGE("Failed to read %s coefficient registers", m_p_object_name);
         return ESP_FAIL;
     }
+#if CONFIG_FRAME_RECORDER_ENABLED
+    (void)FrameRecorderRecord(FRAME_TYPE_DPS3XX_COEF, (uint8_t)m_device_addr, coef_regs.bytes, sizeof(Dps3xxCoefRegs_t));
+#endif
 
     int32_t c0, c1, c00, c10, c01, c11, c20, c21, c30;
     c0  = ((uint32_t)coef_regs.c0h  << 24) | ((uint32_t)coef_regs.c0l  << 20); c0  >>= 20;
@@ -281,15 +318,24 @@ esp_err_t Dps3xxBarometer::get_coefs() {
 
     DPS3XX_BARO_LOGI("Device: %s, c0: %ld, c1: %ld, c00: %ld, c10: %ld, c01: %ld, c11: %ld, c20: %ld, c21: %ld, c30: %ld", m_p_object_name, c0, c1, c00, c10, c01, c11, c20, c21, c30);
 
-    m_coef_data.scaled_c0  = float32_t(c0) / float32_t((int32_t)2);
-    m_coef_data.scaled_c1   = float32_t(c1) / m_temperature_cfg.scale_factor;
-    m_coef_data.scaled_c00  = float32_t(c00);
-    m_coef_data.scaled_c10  = float32_t(c10) / m_pressure_cfg.scale_factor;
-    m_coef_data.scaled_c01  = float32_t(c01) / m_temperature_cfg.scale_factor;
-    m_coef_data.scaled_c11  = float32_t(c11) / m_pressure_cfg.scale_factor / m_temperature_cfg.scale_factor;
-    m_coef_data.scaled_c20  = float32_t(c20) / m_pressure_cfg.scale_factor / m_pressure_cfg.scale_factor;  
-    m_coef_data.scaled_c21  = float32_t(c21) / m_pressure_cfg.scale_factor / m_pressure_cfg.scale_factor / m_temperature_cfg.scale_factor;
-    m_coef_data.scaled_c30  = float32_t(c30) / m_pressure_cfg.scale_factor / m_pressure_cfg.scale_factor / m_pressure_cfg.scale_factor;
+    m_coefs = {.c0 = c0, .c1 = c1, .c00 = c00, .c10 = c10, .c01 = c01, .c11 = c11, .c20 = c20, .c21 = c21, .c30 = c30};
+    this->scale_coefs();
+
+    return ESP_OK;
+}
+
+/* The coefficients read at reset scaled for the oversampling of the mode, the cached temperature terms follow. */
+void Dps3xxBarometer::scale_coefs() {
+    m_coef_data.scaled_c0  = float32_t(m_coefs.c0) / float32_t((int32_t)2);
+    m_coef_data.scaled_c1   = float32_t(m_coefs.c1) / m_temperature_cfg.scale_factor;
+    m_coef_data.scaled_c00  = float32_t(m_coefs.c00);
+    m_coef_data.scaled_c10  = float32_t(m_coefs.c10) / m_pressure_cfg.scale_factor;
+    m_coef_data.scaled_c01  = float32_t(m_coefs.c01) / m_temperature_cfg.scale_factor;
+    m_coef_data.scaled_c11  = float32_t(m_coefs.c11) / m_pressure_cfg.scale_factor / m_temperature_cfg.scale_factor;
+    m_coef_data.scaled_c20  = float32_t(m_coefs.c20) / m_pressure_cfg.scale_factor / m_pressure_cfg.scale_factor;
+    m_coef_data.scaled_c21  = float32_t(m_coefs.c21) / m_pressure_cfg.scale_factor / m_pressure_cfg.scale_factor / m_temperature_cfg.scale_factor;
+    m_coef_data.scaled_c30  = float32_t(m_coefs.c30) / m_pressure_cfg.scale_factor / m_pressure_cfg.scale_factor / m_pressure_cfg.scale_factor;
+    m_has_cached_temperature = false;
 
     DPS3XX_BARO_LOGI("Scaled c0(%e) =  s(%ld), m(0x%8.8lx), e(%ld)", (double)(float)m_coef_data.scaled_c0,  m_coef_data.scaled_c0.s,  m_coef_data.scaled_c0.m,  m_coef_data.scaled_c0.e);
     DPS3XX_BARO_LOGI("Scaled c1(%e) =  s(%ld), m(0x%8.8lx), e(%ld)", (double)(float)m_coef_data.scaled_c1,  m_coef_data.scaled_c1.s,  m_coef_data.scaled_c1.m,  m_coef_data.scaled_c1.e);
@@ -300,6 +346,243 @@ esp_err_t Dps3xxBarometer::get_coefs() {
     DPS3XX_BARO_LOGI("Scaled c20(%e) = s(%ld), m(0x%8.8lx), e(%ld)", (double)(float)m_coef_data.scaled_c20, m_coef_data.scaled_c20.s, m_coef_data.scaled_c20.m, m_coef_data.scaled_c20.e);
     DPS3XX_BARO_LOGI("Scaled c21(%e) = s(%ld), m(0x%8.8lx), e(%ld)", (double)(float)m_coef_data.scaled_c21, m_coef_data.scaled_c21.s, m_coef_data.scaled_c21.m, m_coef_data.scaled_c21.e);
     DPS3XX_BARO_LOGI("Scaled c30(%e) = s(%ld), m(0x%8.8lx), e(%ld)", (double)(float)m_coef_data.scaled_c30, m_coef_data.scaled_c30.s, m_coef_data.scaled_c30.m, m_coef_data.scaled_c30.e);
+}
+
+/*
+    Switches the rates and the oversampling without a reset. The background measurement stops, the results of the old
+    mode left in the FIFO are flushed, and it starts again in the new one. The cached temperature result is moved to
+    the scale of its new oversampling, the pressures before the first temperature of the new mode are compensated with
+    it.
+*/
+esp_err_t Dps3xxBarometer::ApplyMode(Dps3xxMode_t mode) {
+    esp_err_t result;
+
+    Dps3xxMeasCfgReg_t meas_cfg = {0};
+    meas_cfg.meas_ctrl = DPS3XX_REG_VALUE_MEAS_CTRL_STOP;
+    if ((result = this->write_byte(DPS3XX_REG_ADDR_MEAS_CFG, meas_cfg.byte)) != ESP_OK) {
+        DPS3XX_BARO_LOGE("Failed to stop %s background measurement", m_p_object_name);
+        return result;
+    }
+
+    // The new scales first, a switch which fails on the bus is tried again at the next burst from there.
+    uint8_t temperature_prc = m_temperature_cfg.oversampling_rate;
+    this->select_mode(mode);
+    this->scale_coefs();
+    if (m_has_temperature) {
+        int32_t raw_temperature = (int32_t)(((uint32_t)m_temperature[0] << 24) | ((uint32_t)m_temperature[1] << 16) | ((uint32_t)m_temperature[2] << 8)) >> 8;
+        raw_temperature = (int32_t)((int64_t)raw_temperature * s_scale_factors[m_temperature_cfg.oversampling_rate] / s_scale_factors[temperature_prc]);
+        m_temperature[0] = (uint8_t)(raw_temperature >> 16);
+        m_temperature[1] = (uint8_t)(raw_temperature >> 8);
+        m_temperature[2] = (uint8_t)(raw_temperature) & ~DPS3XX_FIFO_ENTRY_PRESSURE;
+    }
+    if ((result = this->write_measure_config()) != ESP_OK) {
+        return result;
+    }
+
+    Dps3xxResetReg_t reset = {0};
+    reset.fifo_flush = DPS3XX_REG_VALUE_FIFO_FLUSH;
+    if ((result = this->write_byte(DPS3XX_REG_ADDR_RESET, reset.byte)) != ESP_OK) {
+        DPS3XX_BARO_LOGE("Failed to flush %s FIFO", m_p_object_name);
+        return result;
+    }
+
+    m_sample_count = 0;
+    m_sample_index = 0;
+    m_has_timestamp = false;
+
+    this->wait_start();
+    meas_cfg.meas_ctrl = DPS3XX_REG_VALUE_MEAS_CTRL_BG_ALL;
+    if ((result = this->write_byte(DPS3XX_REG_ADDR_MEAS_CFG, meas_cfg.byte)) != ESP_OK) {
+        DPS3XX_BARO_LOGE("Failed to start %s background measurement", m_p_object_name);
+        return result;
+    }
+    this->start_wakes();
+    m_mode = mode;
+
+#if CONFIG_FRAME_RECORDER_ENABLED
+    uint8_t mode_byte = (uint8_t)mode;
+    (void)FrameRecorderRecord(FRAME_TYPE_DPS3XX_MODE, (uint8_t)m_device_addr, &mode_byte, sizeof(mode_byte));
+#endif
+    return ESP_OK;
+}
+
+/*
+    Drains the FIFO into the samples. Each entry is its own 3 bytes read at PSR_B2, which pops it, until the empty
+    marker or as many results as the FIFO holds are read.
+*/
+esp_err_t Dps3xxBarometer::read_fifo() {
+    uint8_t entry[DPS3XX_FIFO_ENTRY_SIZE];
+    uint32_t read_entries = 0;
+    bool empty = false;
+    int64_t begin_us = esp_timer_get_time();
+    esp_err_t result;
+
+    m_sample_count = 0;
+    m_sample_index = 0;
+    while (!empty && read_entries < DPS3XX_FIFO_ENTRIES) {
+        if ((result = this->read_buffer(DPS3XX_REG_ADDR_PSR_B2, entry, DPS3XX_FIFO_ENTRY_SIZE)) != ESP_OK) {
+            return result;
+        }
+        read_entries++;
+        if ((((uint32_t)entry[0] << 16) | ((uint32_t)entry[1] << 8) | entry[2]) == DPS3XX_FIFO_EMPTY) {
+            empty = true;
+        } else if ((entry[2] & DPS3XX_FIFO_ENTRY_PRESSURE) == 0) {
+            memcpy(m_temperature, entry, DPS3XX_FIFO_ENTRY_SIZE);
+            m_has_temperature = true;
+        } else if (m_has_temperature) {
+            // A pressure before the first temperature can't be compensated.
+            Dps3xxSample_t *p_sample = &(m_samples[m_sample_count++]);
+            memcpy(&(p_sample->data.prs_b2), entry, DPS3XX_FIFO_ENTRY_SIZE);
+            memcpy(&(p_sample->data.tmp_b2), m_temperature, DPS3XX_FIFO_ENTRY_SIZE);
+        }
+    }
+    if (!empty) {
+        m_overflows++;
+        DPS3XX_BARO_LOGW("%s FIFO full, results lost", m_p_object_name);
+    }
+    if (m_sample_count == 0) {
+        return ESP_OK;
+    }
+
+    // The last pressure ended within the period before the end of the drain, and the samples are a period apart. They
+    // follow the previous burst unless that puts the last one out of this period, after a loss or a drift of the sensor
+    // clock. The first burst is stamped at the start of the drain, which the reads of the entries don't delay.
+    int64_t now_us = esp_timer_get_time();
+    int64_t period_us = this->GetSamplePeriodUs();
+    int64_t last_us = m_has_timestamp ? m_sample_timestamp_us + m_sample_count * period_us : begin_us;
+    if (last_us > now_us) {
+        last_us = now_us;
+    } else if (now_us - last_us >= period_us) {
+        last_us = now_us - period_us + 1;
+    }
+    for (uint8_t i = 0; i < m_sample_count; i++) {
+        m_samples[i].timestamp_us = last_us - (m_sample_count - 1 - i) * period_us;
+    }
+    m_has_timestamp = true;
+
+    DPS3XX_BARO_LOGV("Device: %s, %u FIFO entries read, %u samples", m_p_object_name, (unsigned int)read_entries, (unsigned int)m_sample_count);
+    return ESP_OK;
+}
+
+/*
+    The background measurement just started, the first pressure ends after a temperature and a pressure measurement.
+    The measurement times are rounded up to the millisecond, the wake comes a little after the result.
+*/
+void Dps3xxBarometer::start_wakes() {
+    m_start_us = esp_timer_get_time();
+    m_next_wake_us = m_start_us + (int64_t)(m_temperature_cfg.mesurement_time + m_pressure_cfg.mesurement_time) * 1000 +
+                     (int64_t)this->GetSamplePeriodUs() * (DPS3XX_FIFO_BURST_SAMPLES - 1);
+    if (m_p_sync != NULL) {
+        m_p_sync->Restart(m_start_us, this->GetSamplePeriodUs());
+    }
+}
+
+/* The barometer starts its background measurement at once, the anemometer on its phase. */
+void Dps3xxBarometer::wait_start() {
+}
+
+esp_err_t Dps3xxBarometer::wait_burst() {
+    return this->wait_until(m_next_wake_us);
+}
+
+/* A task held up past the wake goes on at once. */
+esp_err_t Dps3xxBarometer::wait_until(int64_t wake_us) {
+    int64_t delay_us = wake_us - esp_timer_get_time();
+    if (delay_us <= 0) {
+        return ESP_OK;
+    }
+
+    // A wake of a timer stopped after a timeout may be left.
+    (void)xSemaphoreTake(m_wake_semaphore, 0);
+    esp_err_t result = esp_timer_start_once(m_wake_timer, (uint64_t)delay_us);
+    if (result != ESP_OK) {
+        DPS3XX_BARO_LOGE("Failed to start %s wake timer", m_p_object_name);
+        return result;
+    }
+    if (xSemaphoreTake(m_wake_semaphore, pdMS_TO_TICKS(delay_us / 1000) + DPS3XX_WAKE_TIMEOUT_TICKS) != pdTRUE) {
+        (void)esp_timer_stop(m_wake_timer);
+        DPS3XX_BARO_LOGW("%s wake timer late, going on anyway", m_p_object_name);
+    }
+    return ESP_OK;
+}
+
+void Dps3xxBarometer::wake_callback(void *arg) {
+    Dps3xxBarometer *p_barometer = (Dps3xxBarometer *)arg;
+    (void)xSemaphoreGive(p_barometer->m_wake_semaphore);
+}
+
+void Dps3xxBarometer::set_measure_config(Dps3xxMeasureConfig_t *p_cfg, uint8_t mesurement_rate, uint8_t oversampling_rate) {
+    p_cfg->mesurement_rate = mesurement_rate;
+    p_cfg->oversampling_rate = oversampling_rate;
+    p_cfg->mesurement_time = s_measurement_times_ms[oversampling_rate];
+    p_cfg->scale_factor = float32_t(s_scale_factors[oversampling_rate]);
+}
+
+/* A temperature every DPS3XX_TEMPERATURE_RATIO pressures, at least one a second, oversampled as much as fits. */
+void Dps3xxBarometer::select_mode(Dps3xxMode_t mode) {
+    const Dps3xxModeConfig_t *p_mode = &(s_modes[mode]);
+    set_measure_config(&m_pressure_cfg, p_mode->pressure_rate, p_mode->pressure_prc);
+    uint8_t temperature_rate = m_pressure_cfg.mesurement_rate;
+    while (temperature_rate > DPS3XX_REG_VALUE_TMP_RATE_1 && (1U << (m_pressure_cfg.mesurement_rate - temperature_rate + 1)) <= DPS3XX_TEMPERATURE_RATIO) {
+        temperature_rate--;
+    }
+    uint32_t pressure_time = m_pressure_cfg.mesurement_time << m_pressure_cfg.mesurement_rate;
+    uint8_t temperature_prc = p_mode->temperature_max_prc;
+    while (temperature_prc > DPS3XX_REG_VALUE_TMP_PRC_1 && pressure_time + (s_measurement_times_ms[temperature_prc] << temperature_rate) > 1000) {
+        temperature_prc--;
+    }
+    set_measure_config(&m_temperature_cfg, temperature_rate, temperature_prc);
+    if (pressure_time + (m_temperature_cfg.mesurement_time << m_temperature_cfg.mesurement_rate) > 1000) {
+        DPS3XX_BARO_LOGW("%s measurements take more than a second, the rates won't be kept", m_p_object_name);
+    }
+    DPS3XX_BARO_LOGI("%s mode %d, pressure %d/s oversampled %d times, temperature %d/s oversampled %d times", m_p_object_name, mode,
+        1 << m_pressure_cfg.mesurement_rate, 1 << m_pressure_cfg.oversampling_rate, 1 << m_temperature_cfg.mesurement_rate, 1 << m_temperature_cfg.oversampling_rate);
+}
+
+esp_err_t Dps3xxBarometer::write_measure_config() {
+    // Set pressure measurement rate and oversampling rate
+    Dps3xxPrsCfgReg_t prs_cfg = {0};
+    prs_cfg.pm_rate = m_pressure_cfg.mesurement_rate;
+    prs_cfg.pm_prc = m_pressure_cfg.oversampling_rate;
+    if (this->write_byte(DPS3XX_REG_ADDR_PRS_CFG, prs_cfg.byte) != ESP_OK) {
+        DPS3XX_BARO_LOGE("Failed to set %s pressure measurement rate and oversampling rate", m_p_object_name);
+        return ESP_FAIL;
+    }
+
+    // Set temperature measurement rate and oversampling rate
+    Dps3xxTmpCfgReg_t tmp_cfg = {0};
+    if (this->read_byte(DPS3XX_REG_ADDR_COEF_SRC, &(tmp_cfg.byte)) != ESP_OK) {
+        DPS3XX_BARO_LOGE("Failed to read %s temperature coefficient source", m_p_object_name);
+        return ESP_FAIL;
+    }
+    tmp_cfg.tmp_rate = m_temperature_cfg.mesurement_rate;
+    tmp_cfg.tmp_prc = m_temperature_cfg.oversampling_rate;
+    if (this->write_byte(DPS3XX_REG_ADDR_TMP_CFG, tmp_cfg.byte) != ESP_OK) {
+        DPS3XX_BARO_LOGE("Failed to set %s temperature measurement rate and oversampling rate", m_p_object_name);
+        return ESP_FAIL;
+    }
+
+    // Set FIFO enable, and pressure and temperature shift enable of the oversampling rates
+    Dps3xxCfgReg_t cfg = {0};
+    cfg.fifo_en = 1;
+    cfg.p_shift_en = (m_pressure_cfg.oversampling_rate >= DPS3XX_REG_VALUE_SHIFT_MIN_PRC) ? 1 : 0;
+    cfg.t_shift_en = (m_temperature_cfg.oversampling_rate >= DPS3XX_REG_VALUE_SHIFT_MIN_PRC) ? 1 : 0;
+    if (this->write_byte(DPS3XX_REG_ADDR_CFG_REG, cfg.byte) != ESP_OK) {
+        DPS3XX_BARO_LOGE("Failed to set %s FIFO and shift enable", m_p_object_name);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+Dps3xxBarometer *g_pDps3xxBarometer = NULL;
+
+/* A vario without a barometer has no mode to set, not an error worth logging at every takeoff. */
+esp_err_t BarometerSetMode(Dps3xxMode_t mode) {
+    if (g_pDps3xxBarometer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
+    g_pDps3xxBarometer->SetMode(mode);
     return ESP_OK;
 }
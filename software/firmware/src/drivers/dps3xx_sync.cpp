@@ -0,0 +1,101 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+#include <esp_log.h>
+
+#include "drivers/dps3xx_sync.h"
+
+#define DPS3XX_SYNC_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define DPS3XX_SYNC_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define DPS3XX_SYNC_LOGI(format, ...) 				ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define DPS3XX_SYNC_LOGD(format, ...) 				ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define DPS3XX_SYNC_LOGV(format, ...) 				ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "DPS3XX_SYNC";
+
+Dps3xxSync::Dps3xxSync() : m_burst_semaphore(NULL), m_started(false), m_start_us(0), m_period_us(0), m_sample_count(0), m_next_sample(0) {
+    portMUX_INITIALIZE(&m_spinlock);
+}
+
+Dps3xxSync::~Dps3xxSync() {
+    if (m_burst_semaphore != NULL) {
+        vSemaphoreDelete(m_burst_semaphore);
+    }
+}
+
+esp_err_t Dps3xxSync::Init() {
+    if (m_burst_semaphore == NULL && (m_burst_semaphore = xSemaphoreCreateBinary()) == NULL) {
+        DPS3XX_SYNC_LOGE("Failed to create burst semaphore");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/* The barometer started its background measurement, the static pressures before it are of another mode. */
+void Dps3xxSync::Restart(int64_t start_us, uint32_t period_us) {
+    taskENTER_CRITICAL(&m_spinlock);
+    m_started = true;
+    m_start_us = start_us;
+    m_period_us = period_us;
+    m_sample_count = 0;
+    m_next_sample = 0;
+    taskEXIT_CRITICAL(&m_spinlock);
+    DPS3XX_SYNC_LOGD("Barometer started at %lld us, a pressure every %u us", (long long)start_us, (unsigned int)period_us);
+}
+
+void Dps3xxSync::PutSample(int64_t timestamp_us, float32_t pressure) {
+    taskENTER_CRITICAL(&m_spinlock);
+    m_samples[m_next_sample].timestamp_us = timestamp_us;
+    m_samples[m_next_sample].pressure = pressure;
+    m_next_sample = (m_next_sample + 1) % DPS3XX_SYNC_HISTORY;
+    if (m_sample_count < DPS3XX_SYNC_HISTORY) {
+        m_sample_count++;
+    }
+    taskEXIT_CRITICAL(&m_spinlock);
+}
+
+void Dps3xxSync::EndBurst() {
+    (void)xSemaphoreGive(m_burst_semaphore);
+}
+
+/* The first start of a period of the barometer from now on, false before it started at that period. */
+bool Dps3xxSync::GetAlignedStart(int64_t now_us, uint32_t period_us, int64_t *p_start_us) {
+    taskENTER_CRITICAL(&m_spinlock);
+    bool started = m_started && m_period_us == period_us && period_us > 0;
+    int64_t start_us = m_start_us;
+    taskEXIT_CRITICAL(&m_spinlock);
+
+    if (!started) {
+        return false;
+    }
+    if (start_us < now_us) {
+        start_us += (now_us - start_us + period_us - 1) / period_us * (int64_t)period_us;
+    }
+    *p_start_us = start_us;
+    return true;
+}
+
+bool Dps3xxSync::WaitBurst(TickType_t ticks) {
+    return xSemaphoreTake(m_burst_semaphore, ticks) == pdTRUE;
+}
+
+/* The static pressure of the sample nearest to the timestamp, and how far from it. False while there is none. */
+bool Dps3xxSync::GetPressure(int64_t timestamp_us, float32_t *p_pressure, int64_t *p_skew_us) {
+    bool found = false;
+    int64_t best_skew_us = 0;
+
+    taskENTER_CRITICAL(&m_spinlock);
+    for (uint8_t i = 0; i < m_sample_count; i++) {
+        int64_t skew_us = m_samples[i].timestamp_us - timestamp_us;
+        if (!found || (skew_us < 0 ? -skew_us : skew_us) < (best_skew_us < 0 ? -best_skew_us : best_skew_us)) {
+            *p_pressure = m_samples[i].pressure;
+            best_skew_us = skew_us;
+            found = true;
+        }
+    }
+    taskEXIT_CRITICAL(&m_spinlock);
+
+    *p_skew_us = best_skew_us;
+    return found;
+}
@@ -149,7 +149,7 @@ esp_err_t Ft6x36uTouch::read_buffer(uint32_t reg_addr, uint8_t *buffer, uint16_t
 		message.button_data.act = BUTTON_ACT_LONG_PRESSED;
 		if (this->m_queue_handle != NULL) {
 			FT6X36U_TOUCH_LOGD("Send button message to message process task, button index: %d, button act: %d", message.button_data.index, message.button_data.act);
-			xQueueSend(m_queue_handle, &message, 0);
+			(void)send_message(&message);
 		} else {
 			// Queue handle is invalid, Add direct processing code here or do nothing
 		}
@@ -190,7 +190,7 @@ esp_err_t Ft6x36uTouch::read_buffer(uint32_t reg_addr, uint8_t *buffer, uint16_t
 		message.button_data.act = BUTTON_ACT_PRESSED;
 		if (this->m_queue_handle != NULL) {
 			FT6X36U_TOUCH_LOGD("Send button message to Bluethroat task, button index: %d, button act: %d", message.button_data.index, message.button_data.act);
-			xQueueSend(m_queue_handle, &message, 0);
+			(void)send_message(&message);
 		} else {
 			// Queue handle is invalid, Add direct processing code here
 		}
@@ -10,7 +10,11 @@
 #include "utilities/sme_float.h"
 #include "bluethroat_bluetooth.h"
 
+#include "utilities/task_stats.h"
 #include "drivers/neo_m9n_gnss.h"
+#if CONFIG_FRAME_RECORDER_ENABLED
+#include "utilities/frame_recorder.h"
+#endif
 
 #define NEO_M9N_GNSS_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
 #define NEO_M9N_GNSS_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
@@ -40,7 +44,8 @@
 
 static const char *TAG = "NEO_M9N_GNSS";
 
-NeoM9nGnss::NeoM9nGnss() : TaskObject(), m_uart_port(UART_NUM_MAX), m_uart_tx_pin(GPIO_NUM_NC), m_uart_rx_pin(GPIO_NUM_NC), m_uart_rts_pin(GPIO_NUM_NC), m_uart_cts_pin(GPIO_NUM_NC), m_uart_baudrate(0) {
+NeoM9nGnss::NeoM9nGnss() : TaskObject(), m_uart_port(UART_NUM_MAX), m_uart_tx_pin(GPIO_NUM_NC), m_uart_rx_pin(GPIO_NUM_NC), m_uart_rts_pin(GPIO_NUM_NC), m_uart_cts_pin(GPIO_NUM_NC), m_uart_baudrate(0),
+    m_wind_estimator(CONFIG_VARIO_WIND_WINDOW, CONFIG_VARIO_WIND_MIN_TURN) {
 	m_p_object_name = TAG;
     NEO_M9N_GNSS_LOGI("Create %s device.", m_p_object_name);
 }
@@ -103,10 +108,11 @@ void NeoM9nGnss::task_cpp_entry() {
     BluethroatMsg_t message;
     message.type = BLUETHROAT_MSG_TYPE_GNSS_STATUS;
     message.gnss_status = GNSS_STATUS_DISCONNECTED;
-    (void)xQueueSend(m_queue_handle, &message, 0);
+    (void)send_message(&message);
 
 	for ( ; ; ) {
         if (xQueueReceive(m_uart_queue, (void *)(&event), portMAX_DELAY)) {
+            TaskStatsLoopBegin(task_index());
 
             switch (event.type) {
             case UART_FIFO_OVF:
@@ -127,6 +133,9 @@ void NeoM9nGnss::task_cpp_entry() {
                     uart_read_bytes(m_uart_port, sentence, read_length, UART_RECEIVE_TIMEOUT);
 					sentence[read_length-2] = '\0';
 					NEO_M9N_GNSS_LOGD("Uart[%d] receive data: %s", m_uart_port, sentence);
+#if CONFIG_FRAME_RECORDER_ENABLED
+					(void)FrameRecorderRecord(FRAME_TYPE_NMEA_SENTENCE, (uint8_t)m_uart_port, sentence, (uint8_t)strlen(sentence));
+#endif
 
                     /* Send NMEA data to mobile device via bluetooth */
                     BluetoothSendGnssNmea(sentence);
@@ -137,6 +146,8 @@ void NeoM9nGnss::task_cpp_entry() {
             default:
                 break;
             }
+
+            TaskStatsLoopEnd(task_index());
         }
 	}
 }
@@ -168,6 +179,9 @@ void NeoM9nGnss::process_gnss_sentence(char *sentence) {
     float altitude;
     float undulation;
     float course;
+    int fix_hour;
+    int fix_minute;
+    float fix_second;
 
     /* Parse NMEA data: GNRMC, GNGGA, GNVTG */
     if (strncmp(sentence, "$GNGGA", strlen("$GNGGA")) == 0 || strncmp(sentence, "$GNRMC", strlen("$GNRMC")) == 0 || strncmp(sentence, "$GNVTG", strlen("$GNVTG")) == 0) {
@@ -200,7 +214,7 @@ void NeoM9nGnss::process_gnss_sentence(char *sentence) {
 
                 message.gnss_gga_data.altitude = float(float32_t(altitude) + float32_t(undulation));
 
-                (void)xQueueSend(m_queue_handle, &message, 0);
+                (void)send_message(&message);
 
                 NEO_M9N_GNSS_LOGD("Report GNSS GGA data, latitude:%d°%d'%f\" %c, longitude:%d°%d'%f\" %c, altitude:%f", 
                     message.gnss_gga_data.latitude_degree, message.gnss_gga_data.latitude_minute, message.gnss_gga_data.latitude_second, 
@@ -220,7 +234,7 @@ void NeoM9nGnss::process_gnss_sentence(char *sentence) {
                     message.type = BLUETHROAT_MSG_TYPE_GNSS_STATUS;
                     message.gnss_status = status;
 
-                    (void)xQueueSend(m_queue_handle, &message, 0);
+                    (void)send_message(&message);
 
                     NEO_M9N_GNSS_LOGD("Report GNSS status, status:%d", message.gnss_status);
                 }
@@ -238,7 +252,7 @@ void NeoM9nGnss::process_gnss_sentence(char *sentence) {
                     message.type = BLUETHROAT_MSG_TYPE_GNSS_STATUS;
                     message.gnss_status = status;
 
-                    (void)xQueueSend(m_queue_handle, &message, 0);
+                    (void)send_message(&message);
 
                     NEO_M9N_GNSS_LOGD("Report GNSS status, status:%d", message.gnss_status);
                 }
@@ -258,7 +272,7 @@ void NeoM9nGnss::process_gnss_sentence(char *sentence) {
                     message.gnss_zda_data.year = time.tm_year + 2000;
 
                     last_time_sync_counter = time_sync_counter;
-                    (void)xQueueSend(m_queue_handle, &message, 0);
+                    (void)send_message(&message);
 
                     NEO_M9N_GNSS_LOGD("Report GNSS RMC datetime: %04d-%02d-%02d %02d:%02d:%02d", 
                         message.gnss_zda_data.year, message.gnss_zda_data.month, message.gnss_zda_data.day, 
@@ -276,7 +290,8 @@ void NeoM9nGnss::process_gnss_sentence(char *sentence) {
                 sscanf(fields[5], "%d.%s", &longitude_integer, longitude_buffer) == 2 &&
                 sscanf(longitude_float, "%f", &longitude_second) == 1 &&
                 (fields[6][0] == 'E' || fields[6][0] == 'W') &&
-                sscanf(fields[8], "%f", &course) == 1) {
+                sscanf(fields[8], "%f", &course) == 1 &&
+                sscanf(fields[1], "%2d%2d%f", &fix_hour, &fix_minute, &fix_second) == 3) {
 
                 message.type = BLUETHROAT_MSG_TYPE_GNSS_RMC_DATA;
 
@@ -291,8 +306,9 @@ void NeoM9nGnss::process_gnss_sentence(char *sentence) {
                 message.gnss_rmc_data.langitude_direction = (fields[6][0] == 'E') ? GNSS_LONGITUDE_DIRECTION_EAST : GNSS_LONGITUDE_DIRECTION_WEST;
 
                 message.gnss_rmc_data.course = course;
+                message.gnss_rmc_data.time = (uint32_t)((fix_hour * 60 + fix_minute) * 60000) + (uint32_t)(fix_second * 1000.0F + 0.5F);
 
-                (void)xQueueSend(m_queue_handle, &message, 0);
+                (void)send_message(&message);
 
                 NEO_M9N_GNSS_LOGD("Report GNSS RMC coordinate, latitude:%d°%d'%f\" %c, longitude:%d°%d'%f\" %c, course:%f", 
                     message.gnss_rmc_data.latitude_degree, message.gnss_rmc_data.latitude_minute, message.gnss_rmc_data.latitude_second, 
@@ -310,10 +326,27 @@ void NeoM9nGnss::process_gnss_sentence(char *sentence) {
                 sscanf(fields[7], "%f", &(message.gnss_vtg_data.speed_kmh)) == 1) {
                 message.type = BLUETHROAT_MSG_TYPE_GNSS_VTG_DATA;
 
-                (void)xQueueSend(m_queue_handle, &message, 0);
+                (void)send_message(&message);
 
                 NEO_M9N_GNSS_LOGD("Report GNSS VTG data, course:%f, speed(knot):%f, speed(kmh):%f", 
                     message.gnss_vtg_data.course, message.gnss_vtg_data.speed_knot, message.gnss_vtg_data.speed_kmh);
+
+                /* The wind is reported on every fix once it has been fitted, its age tells a glide from a thermal */
+                (void)m_wind_estimator.AddVelocity(message.gnss_vtg_data.course, message.gnss_vtg_data.speed_kmh / 3.6F);
+                if (m_wind_estimator.IsValid()) {
+                    message.type = BLUETHROAT_MSG_TYPE_WIND_DATA;
+                    message.wind_data.speed = m_wind_estimator.GetWindSpeed();
+                    message.wind_data.direction = m_wind_estimator.GetWindDirection();
+                    message.wind_data.east = m_wind_estimator.GetWindEast();
+                    message.wind_data.north = m_wind_estimator.GetWindNorth();
+                    message.wind_data.airspeed = m_wind_estimator.GetAirspeed();
+                    message.wind_data.age = m_wind_estimator.GetAge();
+
+                    (void)send_message(&message);
+
+                    NEO_M9N_GNSS_LOGD("Report wind data, speed:%f, direction:%f, airspeed:%f, age:%u",
+                        message.wind_data.speed, message.wind_data.direction, message.wind_data.airspeed, (unsigned int)message.wind_data.age);
+                }
             } else {
                 NEO_M9N_GNSS_LOGD("Parse GNSS VTG data failed.");
             }
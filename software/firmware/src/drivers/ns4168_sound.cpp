@@ -4,8 +4,12 @@
 
 #include "drivers/axp192_pmu.h"
 #include "drivers/ns4168_sound.h"
+#include "utilities/task_stats.h"
 
 #include "bluethroat_config.h"
+#if CONFIG_LATENCY_TRACE_ENABLED
+#include "utilities/latency_trace.h"
+#endif
 
 #define NS4168_SOUND_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
 #define NS4168_SOUND_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
@@ -117,10 +121,14 @@ Ns4168Sound::Ns4168Sound(I2sMaster *i2s_master, uint32_t sample_rate, uint32_t s
 
     m_sound_enabled = false;
     m_last_beep_time_ticks = 0;
+    m_flying = false;
 
     m_vertical_accel_in_multiple = 0;
     m_vertical_speed_in_multiple = 0;
 
+    m_trace_sequence = 0;
+    m_playing_trace_sequence = 0;
+
     m_sound_mutex = xSemaphoreCreateMutex();
     NS4168_SOUND_ASSERT(m_sound_mutex != NULL, "Failed to create sound mutex");
 
@@ -264,6 +272,15 @@ void Ns4168Sound::set_power_off_timeout(int32_t timeout_ms) {
     NS4168_SOUND_LOGI("Set power off timeout: %ld ms", timeout_ms);
 }
 
+/* A glider quietly gliding or ridge soaring may not beep for longer than the power off timeout, it only runs on ground. */
+void Ns4168Sound::set_flying(bool flying) {
+    if (m_flying && !flying) {
+        m_last_beep_time_ticks = xTaskGetTickCount();
+    }
+    m_flying = flying;
+    NS4168_SOUND_LOGI("Set flying: %d", flying);
+}
+
 void Ns4168Sound::set_acceleration_params(int32_t tone_freq_hz, int32_t beep_period_ms) {
     NS4168_SOUND_LOGI("Set acceleration parameters: tone_freq: %ld Hz, beep_period: %ld ms", tone_freq_hz, beep_period_ms);
 
@@ -400,8 +417,6 @@ void Ns4168Sound::play_speed_lift_sound(int32_t vertical_speed) {
     static int32_t volume;
     static int8_t *waveform_table;
     static int32_t sample;
-    static size_t written;
-    static esp_err_t result;
 
     if (xSemaphoreTake(m_sound_mutex, portMAX_DELAY) == pdTRUE) {
         lift_params = m_speed_lift_params[vertical_speed];
@@ -430,10 +445,7 @@ void Ns4168Sound::play_speed_lift_sound(int32_t vertical_speed) {
             m_sound_buffer[buffer_offset++] = sample;
 
             if (buffer_offset >= NS4168_SOUND_BUFFER_SIZE || i >= (lift_params.beep_period_samples - 1)) {
-                result = m_p_i2s_master->Write(m_sound_buffer, buffer_offset, &written, portMAX_DELAY);
-                if (result != ESP_OK || written != buffer_offset) {
-                    NS4168_SOUND_LOGE("Failed to write sound buffer: %d, %d", result, written);
-                }
+                write_sound_buffer(buffer_offset);
                 buffer_offset = 0;
             }
         }
@@ -447,8 +459,6 @@ void Ns4168Sound::play_speed_sink_sound(int32_t vertical_speed) {
     static int32_t volume;
     static int8_t *waveform_table;
     static int32_t sample;
-    static size_t written;
-    static esp_err_t result;
 
     if (xSemaphoreTake(m_sound_mutex, portMAX_DELAY) == pdTRUE) {
         sink_params = m_speed_sink_params[-vertical_speed];
@@ -466,10 +476,7 @@ void Ns4168Sound::play_speed_sink_sound(int32_t vertical_speed) {
             m_sound_buffer[buffer_offset++] = sample;
 
             if (buffer_offset >= NS4168_SOUND_BUFFER_SIZE || i >= (sink_params.beep_period_samples - 1)) {
-                result = m_p_i2s_master->Write(m_sound_buffer, buffer_offset, &written, portMAX_DELAY);
-                if (result != ESP_OK || written != buffer_offset) {
-                    NS4168_SOUND_LOGE("Failed to write sound buffer: %d, %d", result, written);
-                }
+                write_sound_buffer(buffer_offset);
                 buffer_offset = 0;
             }
         }
@@ -477,17 +484,29 @@ void Ns4168Sound::play_speed_sink_sound(int32_t vertical_speed) {
 }
 
 void Ns4168Sound::play_silence_sound() {
-    static size_t written;
-    static esp_err_t result;
-
     for (uint32_t i = 0; i < NS4168_SOUND_BUFFER_SIZE; i++) {
         m_sound_buffer[i] = 0;
     }
 
-    result = m_p_i2s_master->Write(m_sound_buffer, NS4168_SOUND_BUFFER_SIZE, &written, portMAX_DELAY);
-    if (result != ESP_OK || written != NS4168_SOUND_BUFFER_SIZE) {
+    write_sound_buffer(NS4168_SOUND_BUFFER_SIZE);
+}
+
+void Ns4168Sound::write_sound_buffer(size_t size) {
+    static size_t written;
+    static esp_err_t result;
+
+    result = m_p_i2s_master->Write(m_sound_buffer, size, &written, portMAX_DELAY);
+    if (result != ESP_OK || written != size) {
         NS4168_SOUND_LOGE("Failed to write sound buffer: %d, %d", result, written);
     }
+
+#if CONFIG_LATENCY_TRACE_ENABLED
+    // The write returns once the buffer is queued for DMA, the time in the DMA descriptors is not included.
+    if (m_playing_trace_sequence != 0) {
+        LatencyTraceStamp(m_playing_trace_sequence, LATENCY_STAGE_I2S_WRITE);
+        m_playing_trace_sequence = 0;
+    }
+#endif
 }
 
 void Ns4168Sound::task_cpp_entry() {
@@ -498,47 +517,55 @@ void Ns4168Sound::task_cpp_entry() {
         m_vertical_speed = 10 - ((n / 5) % 21);
         NS4168_SOUND_LOGD("n: %ld, m_vertical_accel: %ld", n, m_vertical_speed);
 */
+        TaskStatsLoopBegin(task_index());
+        play_sound();
+        TaskStatsLoopEnd(task_index());
+    }
+}
 
-        if (m_vertical_speed_in_multiple >= m_speed_lift_latch_in_multiple) {
-            if (m_sound_enabled == false) {
-                PmuEnableSpeaker(true);
-                m_sound_enabled = true;
-                NS4168_SOUND_LOGI("Verticle speed over lift letch, enable speaker");
-            }
+void Ns4168Sound::play_sound() {
+    // Latch the trace sequence before the vertical speed, SoundSetVerticalSpeed stores them in the reverse order.
+    m_playing_trace_sequence = m_trace_sequence;
 
-            play_speed_lift_sound(m_vertical_speed_in_multiple / VERTICAL_SPEED_MULTIPLE);
-            m_last_sound_state = SOUND_SPEED_LIFT;
-            m_last_beep_time_ticks = xTaskGetTickCount();
-        } else if (m_vertical_speed_in_multiple <= m_speed_sink_latch_in_multiple) {
-            if (m_sound_enabled == false) {
-                PmuEnableSpeaker(true);
-                m_sound_enabled = true;
-                NS4168_SOUND_LOGI("Verticle speed under sink letch, enable speaker");
-            }
-            play_speed_sink_sound(m_vertical_speed_in_multiple / VERTICAL_SPEED_MULTIPLE);
-            m_last_sound_state = SOUND_SPEED_SINK;
-            m_last_beep_time_ticks = xTaskGetTickCount();
-        } else if (m_vertical_accel_in_multiple >= m_acceleration_latch_in_multiple) {
-            if (m_sound_enabled == false) {
-                PmuEnableSpeaker(true);
-                m_sound_enabled = true;
-                NS4168_SOUND_LOGI("Verticle accelaration over letch, enable speaker");
-            }
-            play_acceleration_sound(m_vertical_accel_in_multiple / VERTICAL_ACCELERATION_MULTIPLE);
-            m_last_sound_state = SOUND_ACCELERATION;
-            m_last_beep_time_ticks = xTaskGetTickCount();
+    if (m_vertical_speed_in_multiple >= m_speed_lift_latch_in_multiple) {
+        if (m_sound_enabled == false) {
+            PmuEnableSpeaker(true);
+            m_sound_enabled = true;
+            NS4168_SOUND_LOGI("Verticle speed over lift letch, enable speaker");
+        }
+
+        play_speed_lift_sound(m_vertical_speed_in_multiple / VERTICAL_SPEED_MULTIPLE);
+        m_last_sound_state = SOUND_SPEED_LIFT;
+        m_last_beep_time_ticks = xTaskGetTickCount();
+    } else if (m_vertical_speed_in_multiple <= m_speed_sink_latch_in_multiple) {
+        if (m_sound_enabled == false) {
+            PmuEnableSpeaker(true);
+            m_sound_enabled = true;
+            NS4168_SOUND_LOGI("Verticle speed under sink letch, enable speaker");
+        }
+        play_speed_sink_sound(m_vertical_speed_in_multiple / VERTICAL_SPEED_MULTIPLE);
+        m_last_sound_state = SOUND_SPEED_SINK;
+        m_last_beep_time_ticks = xTaskGetTickCount();
+    } else if (m_vertical_accel_in_multiple >= m_acceleration_latch_in_multiple) {
+        if (m_sound_enabled == false) {
+            PmuEnableSpeaker(true);
+            m_sound_enabled = true;
+            NS4168_SOUND_LOGI("Verticle accelaration over letch, enable speaker");
+        }
+        play_acceleration_sound(m_vertical_accel_in_multiple / VERTICAL_ACCELERATION_MULTIPLE);
+        m_last_sound_state = SOUND_ACCELERATION;
+        m_last_beep_time_ticks = xTaskGetTickCount();
+    } else {
+        if (m_sound_enabled == true && (xTaskGetTickCount() - m_last_beep_time_ticks) >= m_disable_sound_timeout_ticks) {
+            PmuEnableSpeaker(false);
+            m_sound_enabled = false;
+            NS4168_SOUND_LOGI("Disable sound timeout, disable speaker");
+        } else if (!m_flying && (xTaskGetTickCount() - m_last_beep_time_ticks) >= m_power_off_timeout_ticks) {
+            NS4168_SOUND_LOGI("Power off timeout, power off system");
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            PmuSystemPowerOff();
         } else {
-            if (m_sound_enabled == true && (xTaskGetTickCount() - m_last_beep_time_ticks) >= m_disable_sound_timeout_ticks) {
-                PmuEnableSpeaker(false);
-                m_sound_enabled = false;
-                NS4168_SOUND_LOGI("Disable sound timeout, disable speaker");
-            } else if ((xTaskGetTickCount() - m_last_beep_time_ticks) >= m_power_off_timeout_ticks) {
-                NS4168_SOUND_LOGI("Power off timeout, power off system");
-                vTaskDelay(pdMS_TO_TICKS(1000));
-                PmuSystemPowerOff();
-            } else {
-                play_silence_sound();
-            }
+            play_silence_sound();
         }
     }
 }
@@ -590,6 +617,14 @@ void SoundSetPowerOffTimeout(int32_t timeout_ms) {
     }
 }
 
+void SoundSetFlying(bool flying) {
+    if (g_pNs4168Sound != NULL) {
+        g_pNs4168Sound->set_flying(flying);
+    } else {
+        NS4168_SOUND_LOGE("Sound instance not initialized, failed to set flying");
+    }
+}
+
 void SoundSetAccelParams(int32_t tone_freq_hz, int32_t beep_period_ms) {
     NS4168_SOUND_ASSERT(tone_freq_hz >= MIN_TONE_FREQ_HZ && tone_freq_hz <= MAX_TONE_FREQ_HZ, "Invalid tone frequency: %dHz", tone_freq_hz);
     NS4168_SOUND_ASSERT(beep_period_ms >= MIN_BEEP_PERIOD_MS && beep_period_ms <= MAX_BEEP_PERIOD_MS, "Invalid beep period: %dms", beep_period_ms);
@@ -720,12 +755,16 @@ void SoundSetVerticalAccel(float vertical_accel) {
     }
 }
 
-void SoundSetVerticalSpeed(float vertical_speed) {
+void SoundSetVerticalSpeed(float vertical_speed, uint32_t trace_sequence) {
     if (g_pNs4168Sound != NULL) {
         int32_t n_vertical_speed = (int32_t)(vertical_speed * VERTICAL_SPEED_MULTIPLE);
         n_vertical_speed = n_vertical_speed > (VERTICAL_SPEED_MAX * VERTICAL_SPEED_MULTIPLE) ? (VERTICAL_SPEED_MAX * VERTICAL_SPEED_MULTIPLE) : n_vertical_speed;
         n_vertical_speed = n_vertical_speed < (VERTICAL_SPEED_MIN * VERTICAL_SPEED_MULTIPLE) ? (VERTICAL_SPEED_MIN * VERTICAL_SPEED_MULTIPLE) : n_vertical_speed;
         g_pNs4168Sound->m_vertical_speed_in_multiple = n_vertical_speed;
+#if CONFIG_LATENCY_TRACE_ENABLED
+        LatencyTraceStamp(trace_sequence, LATENCY_STAGE_SOUND_SET);
+        g_pNs4168Sound->m_trace_sequence = trace_sequence;
+#endif
         NS4168_SOUND_LOGV("Set vertical speed: %f, %ld", vertical_speed, n_vertical_speed);
     } else {
         NS4168_SOUND_LOGD("Sound instance not initialized, failed to set vertical speed");
@@ -0,0 +1,104 @@
+#include <stdint.h>
+
+#include "utilities/baro_altitude.h"
+
+/* Series for the compile time table, ln(x) = 2 * atanh((x - 1) / (x + 1)) converges for the whole table range. */
+static constexpr double const_ln(double x) {
+	double z = (x - 1.0) / (x + 1.0);
+	double z2 = z * z;
+	double term = z;
+	double sum = 0.0;
+	for (int k = 1; k < 200; k += 2) {
+		sum += term / k;
+		term *= z2;
+	}
+	return 2.0 * sum;
+}
+
+/* Taylor series of exp(x / 2^n), squared n times. */
+static constexpr double const_exp(double x) {
+	int halvings = 0;
+	while (x > 0.5 || x < -0.5) {
+		x /= 2.0;
+		halvings++;
+	}
+	double term = 1.0;
+	double sum = 1.0;
+	for (int k = 1; k < 30; k++) {
+		term *= x / k;
+		sum += term;
+	}
+	while (halvings-- > 0) {
+		sum *= sum;
+	}
+	return sum;
+}
+
+static constexpr int32_t const_altitude_q16(double pressure) {
+	double altitude = BARO_ALTITUDE_SCALE_M * (1.0 - const_exp(BARO_ALTITUDE_EXPONENT * const_ln(pressure / BARO_ALTITUDE_STANDARD_PRESSURE)));
+	return (int32_t)(altitude * 65536.0 + ((altitude >= 0.0) ? 0.5 : -0.5));
+}
+
+struct BaroAltitudeTable {
+	int32_t altitude_q16[BARO_ALTITUDE_TABLE_SIZE];
+
+	constexpr BaroAltitudeTable() : altitude_q16() {
+		for (int i = 0; i < BARO_ALTITUDE_TABLE_SIZE; i++) {
+			altitude_q16[i] = const_altitude_q16((double)(BARO_ALTITUDE_MIN_PRESSURE + (i << BARO_ALTITUDE_STEP_SHIFT)));
+		}
+	}
+};
+
+static constexpr BaroAltitudeTable s_table;
+
+static_assert(s_table.altitude_q16[(101376 - BARO_ALTITUDE_MIN_PRESSURE) >> BARO_ALTITUDE_STEP_SHIFT] < 0 &&
+	s_table.altitude_q16[(101120 - BARO_ALTITUDE_MIN_PRESSURE) >> BARO_ALTITUDE_STEP_SHIFT] > 0, "standard pressure is not at 0m");
+
+int32_t PressureToAltitudeQ16(int32_t pressure_q8) {
+	int32_t offset = pressure_q8 - (BARO_ALTITUDE_MIN_PRESSURE << 8);
+	if (offset <= 0) {
+		return s_table.altitude_q16[0];
+	} else if (offset >= ((BARO_ALTITUDE_MAX_PRESSURE - BARO_ALTITUDE_MIN_PRESSURE) << 8)) {
+		return s_table.altitude_q16[BARO_ALTITUDE_TABLE_SIZE - 1];
+	}
+
+	// 8 bits of the step and 8 bits of the Q24.8 fraction make the Q16 interpolation factor.
+	int32_t index = offset >> (BARO_ALTITUDE_STEP_SHIFT + 8);
+	int32_t fraction = offset & ((1 << (BARO_ALTITUDE_STEP_SHIFT + 8)) - 1);
+	int32_t low = s_table.altitude_q16[index];
+	int32_t high = s_table.altitude_q16[index + 1];
+	return low + (int32_t)(((int64_t)(high - low) * fraction) >> (BARO_ALTITUDE_STEP_SHIFT + 8));
+}
+
+float PressureToAltitude(float pressure) {
+	// Clamped before the conversion, which also turns a NaN into the lowest pressure.
+	if (!(pressure > (float)BARO_ALTITUDE_MIN_PRESSURE)) {
+		pressure = (float)BARO_ALTITUDE_MIN_PRESSURE;
+	} else if (pressure > (float)BARO_ALTITUDE_MAX_PRESSURE) {
+		pressure = (float)BARO_ALTITUDE_MAX_PRESSURE;
+	}
+	return (float)PressureToAltitudeQ16((int32_t)(pressure * 256.0f)) * (1.0f / 65536.0f);
+}
+
+/* The mantissa shifted to Q24.8, the result back from Q16.16, both exact. */
+float32_t PressureToAltitude(const float32_t &pressure) {
+	int32_t pressure_q8;
+	int32_t shift = pressure.e + 8;
+
+	if (pressure.s == NEGATIVE || pressure.m == 0 || shift < -31) {
+		pressure_q8 = 0;
+	} else if (shift >= 0) {
+		pressure_q8 = BARO_ALTITUDE_MAX_PRESSURE << 8;
+	} else {
+		pressure_q8 = (int32_t)(pressure.m >> (-shift));
+	}
+
+	int32_t altitude_q16 = PressureToAltitudeQ16(pressure_q8);
+	return float32_t((altitude_q16 < 0) ? NEGATIVE : POSITIVE, (uint32_t)((altitude_q16 < 0) ? -altitude_q16 : altitude_q16), -16);
+}
+
+float PressureToAltitude(float pressure, float qnh) {
+	float altitude = PressureToAltitude(pressure);
+	float qnh_altitude = PressureToAltitude(qnh);
+	return (float)BARO_ALTITUDE_SCALE_M * (altitude - qnh_altitude) / ((float)BARO_ALTITUDE_SCALE_M - qnh_altitude);
+}
@@ -0,0 +1,155 @@
+#include <math.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "utilities/climb_averager.h"
+
+#define CLIMB_AVERAGER_LOGE(format, ...) 			ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define CLIMB_AVERAGER_LOGW(format, ...) 			ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define CLIMB_AVERAGER_LOGI(format, ...) 			ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define CLIMB_AVERAGER_LOGD(format, ...) 			ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define CLIMB_AVERAGER_LOGV(format, ...) 			ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "CLIMB_AVERAGER";
+
+static int16_t clamp_int16(float value) {
+	return (int16_t)fmaxf(-32768.0f, fminf(32767.0f, roundf(value)));
+}
+
+ClimbAverager::ClimbAverager(uint32_t short_window, uint32_t long_window) {
+	init_window(&(m_windows[CLIMB_WINDOW_SHORT]), short_window);
+	init_window(&(m_windows[CLIMB_WINDOW_LONG]), long_window);
+	Reset();
+}
+
+void ClimbAverager::init_window(ClimbWindow_t *p_window, uint32_t duration) {
+	if (duration < CLIMB_AVERAGER_BUCKETS) {
+		CLIMB_AVERAGER_LOGW("Window of %u ms shorter than its buckets, %u ms instead", (unsigned int)duration, (unsigned int)CLIMB_AVERAGER_BUCKETS);
+		duration = CLIMB_AVERAGER_BUCKETS;
+	}
+	p_window->duration = duration;
+	p_window->bucket_duration = duration / CLIMB_AVERAGER_BUCKETS;
+}
+
+void ClimbAverager::Reset() {
+	for (uint32_t window = 0; window < CLIMB_WINDOW_MAX; window++) {
+		ClimbWindow_t *p_window = &(m_windows[window]);
+		memset(p_window->sums, 0, sizeof(p_window->sums));
+		memset(p_window->counts, 0, sizeof(p_window->counts));
+		p_window->index = 0;
+		p_window->bucket_start = 0;
+		p_window->turns = 0;
+		p_window->sum = 0.0f;
+		p_window->count = 0;
+	}
+	m_started = false;
+	m_vertical_speed = 0.0f;
+	m_altitude = 0.0f;
+	m_timestamp = 0;
+	m_report_timestamp = 0;
+	m_in_thermal = false;
+	m_thermal_sum = 0.0f;
+	m_thermal_count = 0;
+	m_thermal_start_altitude = 0.0f;
+	m_thermal_start_timestamp = 0;
+	m_thermal_gain = 0.0f;
+	m_thermal_duration = 0;
+}
+
+/* Every vertical speed of the vario, with the barometric altitude and the timestamp of its sample. Returns true once per report interval. */
+bool ClimbAverager::AddSample(float vertical_speed, float altitude, uint32_t timestamp) {
+	if (!m_started) {
+		m_started = true;
+		for (uint32_t window = 0; window < CLIMB_WINDOW_MAX; window++) {
+			m_windows[window].bucket_start = timestamp;
+		}
+		m_report_timestamp = timestamp;
+	}
+	m_vertical_speed = vertical_speed;
+	m_altitude = altitude;
+	m_timestamp = timestamp;
+
+	for (uint32_t window = 0; window < CLIMB_WINDOW_MAX; window++) {
+		add_to_window(&(m_windows[window]), vertical_speed, timestamp);
+	}
+
+	if (m_in_thermal) {
+		m_thermal_sum += vertical_speed;
+		m_thermal_count++;
+		m_thermal_gain = altitude - m_thermal_start_altitude;
+		m_thermal_duration = timestamp - m_thermal_start_timestamp;
+	}
+
+	uint32_t elapsed = timestamp - m_report_timestamp;
+	if ((int32_t)elapsed < CLIMB_AVERAGER_REPORT_INTERVAL) {
+		return false;
+	}
+	// After a gap the reports restart from this sample instead of catching up.
+	m_report_timestamp = (elapsed < 2 * CLIMB_AVERAGER_REPORT_INTERVAL) ? m_report_timestamp + CLIMB_AVERAGER_REPORT_INTERVAL : timestamp;
+	return true;
+}
+
+/* The thermal restarts from the last sample, its average and gain are kept after it until the next one. */
+void ClimbAverager::StartThermal() {
+	m_in_thermal = true;
+	m_thermal_sum = 0.0f;
+	m_thermal_count = 0;
+	m_thermal_start_altitude = m_altitude;
+	m_thermal_start_timestamp = m_timestamp;
+	m_thermal_gain = 0.0f;
+	m_thermal_duration = 0;
+	CLIMB_AVERAGER_LOGD("Thermal entered at %u ms, altitude %f m", (unsigned int)m_timestamp, m_altitude);
+}
+
+float ClimbAverager::GetAverage(ClimbWindowIndex_t window) const {
+	const ClimbWindow_t *p_window = &(m_windows[window]);
+	return (p_window->count > 0) ? p_window->sum / (float)p_window->count : m_vertical_speed;
+}
+
+float ClimbAverager::GetThermalAverage() const {
+	return (m_thermal_count > 0) ? m_thermal_sum / (float)m_thermal_count : 0.0f;
+}
+
+void ClimbAverager::GetRecord(ClimbRecord_t *p_record) const {
+	p_record->vertical_speed = clamp_int16(m_vertical_speed * 100.0f);
+	p_record->short_average = clamp_int16(GetAverage(CLIMB_WINDOW_SHORT) * 100.0f);
+	p_record->long_average = clamp_int16(GetAverage(CLIMB_WINDOW_LONG) * 100.0f);
+	p_record->thermal_average = clamp_int16(GetThermalAverage() * 100.0f);
+	p_record->thermal_gain = clamp_int16(m_thermal_gain);
+	p_record->thermal_duration = (uint16_t)fminf(65535.0f, (float)(m_thermal_duration / 1000));
+}
+
+/*
+	The buckets between the last sample and this one are emptied and their sums dropped, a gap longer than the window
+	empties them all. The sample then goes to the bucket of its time.
+*/
+void ClimbAverager::add_to_window(ClimbWindow_t *p_window, float vertical_speed, uint32_t timestamp) {
+	uint32_t elapsed = timestamp - p_window->bucket_start;
+	if ((int32_t)elapsed >= (int32_t)p_window->bucket_duration) {
+		uint32_t steps = elapsed / p_window->bucket_duration;
+		p_window->bucket_start += steps * p_window->bucket_duration;
+		if (steps > CLIMB_AVERAGER_BUCKETS) {
+			steps = CLIMB_AVERAGER_BUCKETS;
+		}
+		for (uint32_t step = 0; step < steps; step++) {
+			p_window->index = (p_window->index + 1) % CLIMB_AVERAGER_BUCKETS;
+			p_window->sum -= p_window->sums[p_window->index];
+			p_window->count -= p_window->counts[p_window->index];
+			p_window->sums[p_window->index] = 0.0f;
+			p_window->counts[p_window->index] = 0;
+		}
+		p_window->turns += steps;
+		if (p_window->turns >= CLIMB_AVERAGER_BUCKETS) {
+			p_window->turns = 0;
+			p_window->sum = 0.0f;
+			for (uint32_t bucket = 0; bucket < CLIMB_AVERAGER_BUCKETS; bucket++) {
+				p_window->sum += p_window->sums[bucket];
+			}
+		}
+	}
+
+	p_window->sums[p_window->index] += vertical_speed;
+	p_window->counts[p_window->index]++;
+	p_window->sum += vertical_speed;
+	p_window->count++;
+}
@@ -0,0 +1,132 @@
+#include <math.h>
+#include <esp_log.h>
+
+#include "utilities/flight_detector.h"
+
+#define FLIGHT_DETECTOR_LOGE(format, ...) 			ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define FLIGHT_DETECTOR_LOGW(format, ...) 			ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define FLIGHT_DETECTOR_LOGI(format, ...) 			ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define FLIGHT_DETECTOR_LOGD(format, ...) 			ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define FLIGHT_DETECTOR_LOGV(format, ...) 			ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+/* Vertical speeds, m/s, a climb or a sink beyond the first is flying, the vario of a landed glider is below the second */
+#define FLIGHT_DETECTOR_TAKEOFF_VERTICAL_SPEED		(1.5f)
+#define FLIGHT_DETECTOR_LANDING_VERTICAL_SPEED		(0.5f)
+/* Smoothed vertical acceleration of an instrument lying on the ground, m/s^2 */
+#define FLIGHT_DETECTOR_LANDING_ACTIVITY			(0.5f)
+#define FLIGHT_DETECTOR_ACTIVITY_ALPHA				(0.1f)
+/* The GNSS speed and the IMU are ignored when their last sample is older, ms, the IMU may stamp a burst a little ahead */
+#define FLIGHT_DETECTOR_MAX_AGE						(3000UL)
+
+static const char *TAG = "FLIGHT_DETECTOR";
+
+FlightDetector::FlightDetector(float takeoff_speed, uint32_t takeoff_time, float landing_speed, uint32_t landing_time) :
+	m_takeoff_speed(takeoff_speed), m_takeoff_time(takeoff_time), m_landing_speed(landing_speed), m_landing_time(landing_time) {
+	if (m_landing_speed >= m_takeoff_speed) {
+		FLIGHT_DETECTOR_LOGW("Landing speed %f m/s not below the takeoff speed %f m/s, half of it instead", m_landing_speed, m_takeoff_speed);
+		m_landing_speed = m_takeoff_speed * 0.5f;
+	}
+	Reset();
+}
+
+void FlightDetector::Reset() {
+	m_state = FLIGHT_STATE_GROUND;
+	m_now = 0;
+	m_vertical_speed = 0.0f;
+	m_ground_speed = 0.0f;
+	m_ground_speed_timestamp = 0;
+	m_has_ground_speed = false;
+	m_acceleration_activity = 0.0f;
+	m_acceleration_timestamp = 0;
+	m_has_acceleration = false;
+	m_pending = false;
+	m_pending_timestamp = 0;
+	m_pending_distance = 0.0f;
+	m_takeoff_timestamp = 0;
+	m_landing_timestamp = 0;
+	m_distance = 0.0f;
+}
+
+/* Every vertical speed of the vario, with the timestamp of its barometer sample. Returns true when the state changed. */
+bool FlightDetector::AddVerticalSpeed(float vertical_speed, uint32_t timestamp) {
+	m_now = timestamp;
+	m_vertical_speed = vertical_speed;
+
+	bool flying = (m_state == FLIGHT_STATE_FLYING);
+	if (!(flying ? is_still() : is_moving())) {
+		m_pending = false;
+		return false;
+	}
+	if (!m_pending) {
+		m_pending = true;
+		m_pending_timestamp = timestamp;
+		m_pending_distance = 0.0f;
+		return false;
+	}
+	if (timestamp - m_pending_timestamp < (flying ? m_landing_time : m_takeoff_time)) {
+		return false;
+	}
+
+	m_pending = false;
+	if (flying) {
+		m_state = FLIGHT_STATE_LANDED;
+		m_landing_timestamp = m_pending_timestamp;
+		FLIGHT_DETECTOR_LOGI("Landed at %u ms, airtime %u s, distance %.0f m", (unsigned int)m_landing_timestamp, (unsigned int)(GetAirtime() / 1000), m_distance);
+	} else {
+		// A new flight, the counters restart.
+		m_state = FLIGHT_STATE_FLYING;
+		m_takeoff_timestamp = m_pending_timestamp;
+		m_landing_timestamp = 0;
+		m_distance = m_pending_distance;
+		FLIGHT_DETECTOR_LOGI("Takeoff at %u ms", (unsigned int)m_takeoff_timestamp);
+	}
+	return true;
+}
+
+/* Ground speed of every GNSS fix, m/s, stamped with the last barometer sample. The distance is flown at it. */
+void FlightDetector::AddGroundSpeed(float ground_speed) {
+	uint32_t delta_time = m_now - m_ground_speed_timestamp;
+	if (m_has_ground_speed && delta_time <= FLIGHT_DETECTOR_MAX_AGE) {
+		float distance = ground_speed * (float)delta_time / 1000.0f;
+		if (m_state == FLIGHT_STATE_FLYING) {
+			m_distance += distance;
+		} else if (m_pending) {
+			m_pending_distance += distance;
+		}
+	}
+	m_ground_speed = ground_speed;
+	m_ground_speed_timestamp = m_now;
+	m_has_ground_speed = true;
+}
+
+/* Mean vertical acceleration of every IMU burst, gravity removed. */
+void FlightDetector::AddAcceleration(float vertical_acceleration, uint32_t timestamp) {
+	m_acceleration_activity += (fabsf(vertical_acceleration) - m_acceleration_activity) * FLIGHT_DETECTOR_ACTIVITY_ALPHA;
+	m_acceleration_timestamp = timestamp;
+	m_has_acceleration = true;
+}
+
+uint32_t FlightDetector::GetAirtime() const {
+	switch (m_state) {
+	case FLIGHT_STATE_FLYING:
+		return m_now - m_takeoff_timestamp;
+	case FLIGHT_STATE_LANDED:
+		return m_landing_timestamp - m_takeoff_timestamp;
+	default:
+		return 0;
+	}
+}
+
+bool FlightDetector::is_moving() const {
+	bool has_ground_speed = m_has_ground_speed && (int32_t)(m_now - m_ground_speed_timestamp) <= (int32_t)FLIGHT_DETECTOR_MAX_AGE;
+	return (has_ground_speed && m_ground_speed >= m_takeoff_speed) || fabsf(m_vertical_speed) >= FLIGHT_DETECTOR_TAKEOFF_VERTICAL_SPEED;
+}
+
+/* Without a recent GNSS fix or IMU burst, their part of the condition holds. */
+bool FlightDetector::is_still() const {
+	bool has_ground_speed = m_has_ground_speed && (int32_t)(m_now - m_ground_speed_timestamp) <= (int32_t)FLIGHT_DETECTOR_MAX_AGE;
+	bool has_acceleration = m_has_acceleration && (int32_t)(m_now - m_acceleration_timestamp) <= (int32_t)FLIGHT_DETECTOR_MAX_AGE;
+	return (!has_ground_speed || m_ground_speed < m_landing_speed) &&
+		   fabsf(m_vertical_speed) < FLIGHT_DETECTOR_LANDING_VERTICAL_SPEED &&
+		   (!has_acceleration || m_acceleration_activity < FLIGHT_DETECTOR_LANDING_ACTIVITY);
+}
@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "utilities/frame_recorder.h"
+#include "utilities/task_stats.h"
+
+#define FRAME_RECORDER_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define FRAME_RECORDER_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define FRAME_RECORDER_LOGI(format, ...) 				ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define FRAME_RECORDER_LOGD(format, ...) 				ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define FRAME_RECORDER_LOGV(format, ...) 				ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+#define FRAME_RECORDER_BUFFER_LOGE(buffer, buff_len) 	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer, buff_len, ESP_LOG_ERROR)
+#define FRAME_RECORDER_BUFFER_LOGW(buffer, buff_len) 	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer, buff_len, ESP_LOG_WARN)
+#define FRAME_RECORDER_BUFFER_LOGI(buffer, buff_len) 	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer, buff_len, ESP_LOG_INFO)
+#define FRAME_RECORDER_BUFFER_LOGD(buffer, buff_len) 	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer, buff_len, ESP_LOG_DEBUG)
+#define FRAME_RECORDER_BUFFER_LOGV(buffer, buff_len) 	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer, buff_len, ESP_LOG_VERBOSE)
+
+#ifdef _DEBUG
+#define FRAME_RECORDER_ASSERT(condition, format, ...)   \
+	do                                           \
+	{                                            \
+		if (!(condition))                        \
+		{                                        \
+			FRAME_RECORDER_LOGE(format, ##__VA_ARGS__); \
+			assert(0);                           \
+		}                                        \
+	} while (0)
+#else
+#define FRAME_RECORDER_ASSERT(condition, format, ...)
+#endif
+
+static const char *TAG = "FRAME_RECORDER";
+
+FrameRecorder::FrameRecorder(const char *p_path, uint32_t buffer_size, uint32_t max_file_size) : TaskObject(),
+	m_p_path(p_path), m_buffer_size(buffer_size), m_max_file_size(max_file_size), m_p_file(NULL), m_file_size(0),
+	m_active_buffer(0), m_dropped_frames(0), m_file_full(false), m_mutex(NULL), m_write_queue(NULL) {
+	m_p_object_name = TAG;
+	for (uint32_t i = 0; i < FRAME_RECORDER_BUFFER_COUNT; i++) {
+		m_p_buffers[i] = NULL;
+		m_buffer_lengths[i] = 0;
+		m_buffer_busy[i] = false;
+	}
+}
+
+FrameRecorder::~FrameRecorder() {
+	for (uint32_t i = 0; i < FRAME_RECORDER_BUFFER_COUNT; i++) {
+		free(m_p_buffers[i]);
+	}
+	if (m_write_queue != NULL) {
+		vQueueDelete(m_write_queue);
+	}
+	if (m_mutex != NULL) {
+		vSemaphoreDelete(m_mutex);
+	}
+}
+
+esp_err_t FrameRecorder::init_device() {
+	for (uint32_t i = 0; i < FRAME_RECORDER_BUFFER_COUNT; i++) {
+		if ((m_p_buffers[i] = (uint8_t *)malloc(m_buffer_size)) == NULL) {
+			FRAME_RECORDER_LOGE("Failed to allocate %lu bytes recording buffer", m_buffer_size);
+			return ESP_ERR_NO_MEM;
+		}
+	}
+
+	m_mutex = xSemaphoreCreateMutex();
+	m_write_queue = xQueueCreate(FRAME_RECORDER_BUFFER_COUNT, sizeof(uint32_t));
+	if (m_mutex == NULL || m_write_queue == NULL) {
+		FRAME_RECORDER_LOGE("Failed to create recorder mutex or queue");
+		return ESP_ERR_NO_MEM;
+	}
+
+	// Keep the recording of the previous boot, the file system has no room for more.
+	char previous_path[128];
+	snprintf(previous_path, sizeof(previous_path), "%s.1", m_p_path);
+	remove(previous_path);
+	rename(m_p_path, previous_path);
+
+	if ((m_p_file = fopen(m_p_path, "wb")) == NULL) {
+		FRAME_RECORDER_LOGE("Failed to create recording file %s", m_p_path);
+		return ESP_FAIL;
+	}
+
+	FrameFileHeader_t header = {.magic = FRAME_FILE_MAGIC, .version = FRAME_FILE_VERSION, .header_size = sizeof(FrameHeader_t)};
+	if (fwrite(&header, sizeof(header), 1, m_p_file) != 1) {
+		FRAME_RECORDER_LOGE("Failed to write recording file header");
+		fclose(m_p_file);
+		m_p_file = NULL;
+		return ESP_FAIL;
+	}
+	m_file_size = sizeof(header);
+
+	g_pFrameRecorder = this;
+	FRAME_RECORDER_LOGI("Recording frames to %s", m_p_path);
+
+	return ESP_OK;
+}
+
+esp_err_t FrameRecorder::deinit_device() {
+	g_pFrameRecorder = NULL;
+
+	esp_err_t result = this->Flush();
+	if (m_p_file != NULL) {
+		xSemaphoreTake(m_mutex, portMAX_DELAY);
+		fclose(m_p_file);
+		m_p_file = NULL;
+		xSemaphoreGive(m_mutex);
+	}
+
+	FRAME_RECORDER_LOGI("Recording stopped, %lu bytes recorded, %lu frames dropped", m_file_size, m_dropped_frames);
+	return result;
+}
+
+void FrameRecorder::task_cpp_entry() {
+	uint32_t index;
+	for ( ; ; ) {
+		if (xQueueReceive(m_write_queue, &index, FRAME_RECORDER_FLUSH_INTERVAL) == pdTRUE) {
+			TaskStatsLoopBegin(task_index());
+			write_buffer(index);
+		} else {
+			TaskStatsLoopBegin(task_index());
+			xSemaphoreTake(m_mutex, portMAX_DELAY);
+			(void)submit_active_buffer();
+			xSemaphoreGive(m_mutex);
+		}
+		TaskStatsLoopEnd(task_index());
+	}
+}
+
+esp_err_t FrameRecorder::Record(FrameType_t type, uint8_t source, uint32_t timestamp, const void *p_data, uint8_t size) {
+	FrameHeader_t header = {.type = (uint8_t)type, .source = source, .size = size, .timestamp = timestamp};
+	uint32_t frame_size = sizeof(FrameHeader_t) + size;
+	esp_err_t result = ESP_OK;
+
+	xSemaphoreTake(m_mutex, portMAX_DELAY);
+	if (m_file_full) {
+		result = ESP_ERR_NO_MEM;
+	} else if (m_file_size + frame_size > m_max_file_size) {
+		FRAME_RECORDER_LOGW("Recording file reaches %lu bytes, recording stopped", m_file_size);
+		m_file_full = true;
+		result = ESP_ERR_NO_MEM;
+	} else if (m_buffer_lengths[m_active_buffer] + frame_size > m_buffer_size && !submit_active_buffer()) {
+		m_dropped_frames++;
+		result = ESP_ERR_NO_MEM;
+	} else {
+		uint8_t *p_buffer = m_p_buffers[m_active_buffer] + m_buffer_lengths[m_active_buffer];
+		memcpy(p_buffer, &header, sizeof(FrameHeader_t));
+		memcpy(p_buffer + sizeof(FrameHeader_t), p_data, size);
+		m_buffer_lengths[m_active_buffer] += frame_size;
+		m_file_size += frame_size;
+	}
+	xSemaphoreGive(m_mutex);
+
+	return result;
+}
+
+esp_err_t FrameRecorder::Flush() {
+	xSemaphoreTake(m_mutex, portMAX_DELAY);
+	bool submitted = submit_active_buffer();
+	xSemaphoreGive(m_mutex);
+
+	TickType_t start_ticks = xTaskGetTickCount();
+	for ( ; ; ) {
+		bool busy = false;
+		xSemaphoreTake(m_mutex, portMAX_DELAY);
+		for (uint32_t i = 0; i < FRAME_RECORDER_BUFFER_COUNT; i++) {
+			busy = busy || m_buffer_busy[i];
+		}
+		xSemaphoreGive(m_mutex);
+
+		if (!busy) {
+			// The active buffer could not be submitted while both buffers were busy, try again now they are written.
+			if (!submitted) {
+				xSemaphoreTake(m_mutex, portMAX_DELAY);
+				submitted = submit_active_buffer();
+				xSemaphoreGive(m_mutex);
+			} else {
+				return ESP_OK;
+			}
+		} else if (xTaskGetTickCount() - start_ticks >= FRAME_RECORDER_FLUSH_TIMEOUT) {
+			FRAME_RECORDER_LOGE("Timeout waiting for recording buffers to be written");
+			return ESP_ERR_TIMEOUT;
+		} else {
+			vTaskDelay(1);
+		}
+	}
+}
+
+/* Hand the active buffer over to the recorder task and switch to the other one, called with the mutex taken. */
+bool FrameRecorder::submit_active_buffer() {
+	uint32_t next_buffer = (m_active_buffer + 1) % FRAME_RECORDER_BUFFER_COUNT;
+
+	if (m_buffer_lengths[m_active_buffer] == 0) {
+		return true;
+	} else if (m_buffer_busy[next_buffer]) {
+		return false;
+	}
+
+	m_buffer_busy[m_active_buffer] = true;
+	(void)xQueueSend(m_write_queue, &m_active_buffer, 0);
+	m_active_buffer = next_buffer;
+
+	return true;
+}
+
+void FrameRecorder::write_buffer(uint32_t index) {
+	// The buffer is busy, producers don't touch it, so it is written without holding the mutex.
+	if (m_p_file != NULL) {
+		if (fwrite(m_p_buffers[index], 1, m_buffer_lengths[index], m_p_file) != m_buffer_lengths[index] || fflush(m_p_file) != 0) {
+			FRAME_RECORDER_LOGE("Failed to write %lu bytes to recording file", m_buffer_lengths[index]);
+		} else {
+			FRAME_RECORDER_LOGD("Write %lu bytes to recording file", m_buffer_lengths[index]);
+		}
+	}
+
+	xSemaphoreTake(m_mutex, portMAX_DELAY);
+	m_buffer_lengths[index] = 0;
+	m_buffer_busy[index] = false;
+	xSemaphoreGive(m_mutex);
+}
+
+FrameRecorder *g_pFrameRecorder = NULL;
+
+esp_err_t FrameRecorderRecord(FrameType_t type, uint8_t source, const void *p_data, uint8_t size) {
+	return FrameRecorderRecordAt(type, source, esp_log_timestamp(), p_data, size);
+}
+
+/* For a sample taken before it is read, a result of a FIFO. */
+esp_err_t FrameRecorderRecordAt(FrameType_t type, uint8_t source, uint32_t timestamp, const void *p_data, uint8_t size) {
+	// Recording is optional, a missing recorder is not an error worth logging on every sensor sample.
+	if (g_pFrameRecorder == NULL) {
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	return g_pFrameRecorder->Record(type, source, timestamp, p_data, size);
+}
+
+esp_err_t FrameRecorderFlush() {
+	if (g_pFrameRecorder == NULL) {
+		FRAME_RECORDER_LOGE("Frame recorder is not initialized.");
+		return ESP_FAIL;
+	}
+
+	return g_pFrameRecorder->Flush();
+}
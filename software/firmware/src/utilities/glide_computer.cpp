@@ -0,0 +1,153 @@
+#include <float.h>
+#include <math.h>
+#include <esp_log.h>
+
+#include "utilities/glide_computer.h"
+
+#define GLIDE_COMPUTER_LOGE(format, ...) 			ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define GLIDE_COMPUTER_LOGW(format, ...) 			ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define GLIDE_COMPUTER_LOGI(format, ...) 			ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define GLIDE_COMPUTER_LOGD(format, ...) 			ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define GLIDE_COMPUTER_LOGV(format, ...) 			ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+#define GLIDE_COMPUTER_METERS_PER_SECOND_OF_ARC		(1852.0f / 60.0f)
+#define GLIDE_COMPUTER_MICRO_MINUTES_PER_MINUTE		(1000000LL)
+
+static const char *TAG = "GLIDE_COMPUTER";
+
+GlideComputer::GlideComputer(float maccready, float margin) : m_maccready(maccready), m_margin(margin) {
+	m_has_waypoint = false;
+	m_waypoint_latitude_minutes = 0;
+	m_waypoint_latitude_second = 0.0f;
+	m_waypoint_longitude_minutes = 0;
+	m_waypoint_longitude_second = 0.0f;
+	m_waypoint_altitude = 0.0f;
+	Reset();
+}
+
+/* The waypoint and the MacCready setting are kept, they are of the pilot, not of the flight. */
+void GlideComputer::Reset() {
+	m_wind_east = 0.0f;
+	m_wind_north = 0.0f;
+	m_netto_sum = 0.0f;
+	m_netto_count = 0;
+	m_netto = 0.0f;
+	m_has_netto = false;
+	m_valid = false;
+	m_course = 0.0f;
+	m_tailwind = 0.0f;
+	m_crosswind = 0.0f;
+	m_speed_to_fly = 0.0f;
+	m_final_glide_speed = 0.0f;
+	m_distance = 0.0f;
+	m_required_glide = GLIDE_COMPUTER_MAX_GLIDE;
+	m_glide = 0.0f;
+	m_arrival_altitude = -FLT_MAX;
+}
+
+/*
+	Micro degrees, north and east positive. They are split into whole minutes and the seconds of the last one like the
+	positions of the fixes, the difference of the two keeps the float precision of the seconds anywhere on earth.
+*/
+void GlideComputer::SetWaypoint(int32_t latitude, int32_t longitude, float altitude) {
+	int64_t latitude_micro_minutes = (int64_t)latitude * 60;
+	int64_t longitude_micro_minutes = (int64_t)longitude * 60;
+	int64_t latitude_minutes = latitude_micro_minutes / GLIDE_COMPUTER_MICRO_MINUTES_PER_MINUTE - ((latitude_micro_minutes % GLIDE_COMPUTER_MICRO_MINUTES_PER_MINUTE < 0) ? 1 : 0);
+	int64_t longitude_minutes = longitude_micro_minutes / GLIDE_COMPUTER_MICRO_MINUTES_PER_MINUTE - ((longitude_micro_minutes % GLIDE_COMPUTER_MICRO_MINUTES_PER_MINUTE < 0) ? 1 : 0);
+
+	m_waypoint_latitude_minutes = (int32_t)latitude_minutes;
+	m_waypoint_latitude_second = (float)(latitude_micro_minutes - latitude_minutes * GLIDE_COMPUTER_MICRO_MINUTES_PER_MINUTE) * 60.0f / (float)GLIDE_COMPUTER_MICRO_MINUTES_PER_MINUTE;
+	m_waypoint_longitude_minutes = (int32_t)longitude_minutes;
+	m_waypoint_longitude_second = (float)(longitude_micro_minutes - longitude_minutes * GLIDE_COMPUTER_MICRO_MINUTES_PER_MINUTE) * 60.0f / (float)GLIDE_COMPUTER_MICRO_MINUTES_PER_MINUTE;
+	m_waypoint_altitude = altitude;
+	m_has_waypoint = true;
+	GLIDE_COMPUTER_LOGI("Waypoint at %d' %f\", %d' %f\", %f m", (int)m_waypoint_latitude_minutes, m_waypoint_latitude_second, (int)m_waypoint_longitude_minutes, m_waypoint_longitude_second, m_waypoint_altitude);
+}
+
+void GlideComputer::SetWind(float east, float north) {
+	m_wind_east = east;
+	m_wind_north = north;
+}
+
+/* Every netto of the vario between two fixes. */
+void GlideComputer::AddNetto(float netto) {
+	m_netto_sum += netto;
+	m_netto_count++;
+}
+
+void GlideComputer::AddFix(const GnssRmcData_t *p_rmc, float altitude, const GliderPolar *p_polar, float density_ratio) {
+	if (m_netto_count > 0) {
+		float netto = m_netto_sum / (float)m_netto_count;
+		m_netto = m_has_netto ? m_netto + (netto - m_netto) * GLIDE_COMPUTER_NETTO_ALPHA : netto;
+		m_has_netto = true;
+	}
+	m_netto_sum = 0.0f;
+	m_netto_count = 0;
+
+	m_course = p_rmc->course;
+	m_distance = 0.0f;
+	if (m_has_waypoint) {
+		float east, north;
+		locate_waypoint(p_rmc, &east, &north);
+		m_distance = sqrtf(east * east + north * north);
+		if (m_distance > 0.0f) {
+			m_course = fmodf(atan2f(east, north) * 180.0f / (float)M_PI + 360.0f, 360.0f);
+		}
+	}
+	float course = m_course * (float)M_PI / 180.0f;
+	m_tailwind = m_wind_east * sinf(course) + m_wind_north * cosf(course);
+	m_crosswind = m_wind_east * cosf(course) - m_wind_north * sinf(course);
+
+	m_speed_to_fly = speed_to_fly(p_polar, density_ratio, m_netto);
+	m_final_glide_speed = speed_to_fly(p_polar, density_ratio, 0.0f);
+
+	// The crosswind is taken out of the airspeed to hold the course.
+	float sink = p_polar->GetSink(m_final_glide_speed * density_ratio) / density_ratio;
+	float ground_speed = m_tailwind + sqrtf(fmaxf(m_final_glide_speed * m_final_glide_speed - m_crosswind * m_crosswind, 0.0f));
+	if (ground_speed <= 0.0f) {
+		m_glide = 0.0f;
+	} else {
+		m_glide = (ground_speed < sink * GLIDE_COMPUTER_MAX_GLIDE) ? ground_speed / sink : GLIDE_COMPUTER_MAX_GLIDE;
+	}
+
+	if (m_has_waypoint) {
+		float height = altitude - m_waypoint_altitude - m_margin;
+		m_required_glide = (height > 0.0f && m_distance < height * GLIDE_COMPUTER_MAX_GLIDE) ? m_distance / height : GLIDE_COMPUTER_MAX_GLIDE;
+		m_arrival_altitude = (m_glide > 0.0f) ? height - m_distance / m_glide : -FLT_MAX;
+	}
+	m_valid = true;
+
+	GLIDE_COMPUTER_LOGD("course:%f, tailwind:%f, crosswind:%f, netto:%f, stf:%f, final glide speed:%f, glide:%f, distance:%f, required glide:%f, arrival:%f",
+		m_course, m_tailwind, m_crosswind, m_netto, m_speed_to_fly, m_final_glide_speed, m_glide, m_distance, m_required_glide, m_arrival_altitude);
+}
+
+/* m from the glider to the waypoint, at the scale of the latitude of the waypoint. */
+void GlideComputer::locate_waypoint(const GnssRmcData_t *p_rmc, float *p_east, float *p_north) const {
+	int32_t latitude_sign = (p_rmc->latitude_direction == GNSS_LATITUDE_DIRECTION_NORTH) ? 1 : -1;
+	int32_t longitude_sign = (p_rmc->langitude_direction == GNSS_LONGITUDE_DIRECTION_EAST) ? 1 : -1;
+	int32_t latitude_minutes = latitude_sign * (int32_t)(p_rmc->latitude_degree * 60 + p_rmc->latitude_minute);
+	int32_t longitude_minutes = longitude_sign * (int32_t)(p_rmc->langitude_degree * 60 + p_rmc->langitude_minute);
+
+	float north_seconds = (float)((m_waypoint_latitude_minutes - latitude_minutes) * 60) + m_waypoint_latitude_second - (float)latitude_sign * p_rmc->latitude_second;
+	float east_seconds = (float)((m_waypoint_longitude_minutes - longitude_minutes) * 60) + m_waypoint_longitude_second - (float)longitude_sign * p_rmc->langitude_second;
+	float meters_per_longitude_second = GLIDE_COMPUTER_METERS_PER_SECOND_OF_ARC * cosf((float)m_waypoint_latitude_minutes / 60.0f * (float)M_PI / 180.0f);
+	*p_north = north_seconds * GLIDE_COMPUTER_METERS_PER_SECOND_OF_ARC;
+	*p_east = east_seconds * meters_per_longitude_second;
+}
+
+/*
+	m/s, true airspeed. The tangent from the MacCready setting over the netto, moved back by the tailwind, is solved in
+	the indicated airspeed of the polar, never slower than the minimum sink.
+*/
+float GlideComputer::speed_to_fly(const GliderPolar *p_polar, float density_ratio, float netto) const {
+	float tailwind = m_tailwind * density_ratio;
+	float rate = (m_maccready - netto) * density_ratio;
+	float speed = p_polar->GetMinSinkSpeed();
+	if (p_polar->m_a > 0.0f) {
+		float discriminant = tailwind * tailwind + (p_polar->m_c + rate - p_polar->m_b * tailwind) / p_polar->m_a;
+		if (discriminant > 0.0f) {
+			speed = fmaxf(sqrtf(discriminant) - tailwind, speed);
+		}
+	}
+	return speed / density_ratio;
+}
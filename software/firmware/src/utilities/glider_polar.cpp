@@ -0,0 +1,67 @@
+#include <math.h>
+#include <esp_log.h>
+
+#include "utilities/glider_polar.h"
+
+#define GLIDER_POLAR_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define GLIDER_POLAR_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define GLIDER_POLAR_LOGI(format, ...) 				ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define GLIDER_POLAR_LOGD(format, ...) 				ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define GLIDER_POLAR_LOGV(format, ...) 				ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+/* Points closer than this make the fit ill conditioned, a few km/h apart at least */
+#define GLIDER_POLAR_MIN_SPEED_STEP					(0.5f)
+
+static const char *TAG = "GLIDER_POLAR";
+
+/* A flat polar of 1 m/s until the points are set, netto is then the vario plus 1 m/s. */
+GliderPolar::GliderPolar() : m_a(0.0f), m_b(0.0f), m_c(1.0f), m_min_sink_speed(0.0f), m_min_sink(1.0f) {
+}
+
+/*
+    Newton's divided differences of the three points, sorted by speed. The polar is kept unless the points are far
+    enough apart and bend upwards with a minimum sink above zero, a wing that sinks less when it flies faster everywhere
+    or that climbs in still air is a typing error.
+*/
+esp_err_t GliderPolar::SetPoints(const float *p_speeds, const float *p_sinks) {
+	float speeds[GLIDER_POLAR_POINTS];
+	float sinks[GLIDER_POLAR_POINTS];
+	for (int i = 0; i < GLIDER_POLAR_POINTS; i++) {
+		int j = i;
+		for (; j > 0 && speeds[j - 1] > p_speeds[i]; j--) {
+			speeds[j] = speeds[j - 1];
+			sinks[j] = sinks[j - 1];
+		}
+		speeds[j] = p_speeds[i];
+		sinks[j] = p_sinks[i];
+	}
+	if (speeds[1] - speeds[0] < GLIDER_POLAR_MIN_SPEED_STEP || speeds[2] - speeds[1] < GLIDER_POLAR_MIN_SPEED_STEP) {
+		GLIDER_POLAR_LOGE("Polar speeds %f, %f, %f m/s are too close", speeds[0], speeds[1], speeds[2]);
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	float slope_01 = (sinks[1] - sinks[0]) / (speeds[1] - speeds[0]);
+	float slope_12 = (sinks[2] - sinks[1]) / (speeds[2] - speeds[1]);
+	float a = (slope_12 - slope_01) / (speeds[2] - speeds[0]);
+	float b = slope_01 - a * (speeds[0] + speeds[1]);
+	float c = sinks[0] - (a * speeds[0] + b) * speeds[0];
+	if (a <= 0.0f) {
+		GLIDER_POLAR_LOGE("Polar of the sinks %f, %f, %f m/s has no minimum", sinks[0], sinks[1], sinks[2]);
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	float min_sink_speed = fmaxf(-b / (2.0f * a), 0.0f);
+	float min_sink = (a * min_sink_speed + b) * min_sink_speed + c;
+	if (min_sink <= 0.0f) {
+		GLIDER_POLAR_LOGE("Polar of the sinks %f, %f, %f m/s climbs at %f m/s", sinks[0], sinks[1], sinks[2], min_sink_speed);
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	m_a = a;
+	m_b = b;
+	m_c = c;
+	m_min_sink_speed = min_sink_speed;
+	m_min_sink = min_sink;
+	GLIDER_POLAR_LOGI("Polar sink = %f * v^2 + %f * v + %f, minimum sink %f m/s at %f m/s", m_a, m_b, m_c, m_min_sink, m_min_sink_speed);
+	return ESP_OK;
+}
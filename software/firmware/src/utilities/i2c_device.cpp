@@ -1,5 +1,6 @@
 #include <esp_log.h>
 #include "utilities/i2c_device.h"
+#include "utilities/task_stats.h"
 #include "bluethroat_msg_proc.h"
 
 #define I2C_DEVICE_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
@@ -60,10 +61,12 @@ void I2cDevice::task_cpp_entry() {
 	uint8_t raw_data[MAX_RAW_DATA_BUFFER_LENGTH];
 	BluethroatMsg_t  message;
 	for ( ; ; ) {
+		TaskStatsLoopBegin(this->task_index());
 		if (ESP_OK == this->fetch_data(raw_data, sizeof(raw_data))) {
+			TaskStatsLoopFetched(this->task_index());
 			if(ESP_OK == this->process_data(raw_data, MAX_RAW_DATA_BUFFER_LENGTH, &message)) {
 				if (this->m_queue_handle != NULL && message.type != BLUETHROAT_MSG_INVALID) {
-					(void)xQueueSend(this->m_queue_handle, &message, 0);
+					(void)this->send_message(&message);
 				} else {
 					; // not valid queue handle provided, needn't send message
 				}
@@ -73,6 +76,7 @@ void I2cDevice::task_cpp_entry() {
 		} else {
 			I2C_DEVICE_LOGE("Task %s fetch data failed.", this->m_p_task_param->task_name);
 		}
+		TaskStatsLoopEnd(this->task_index());
 
 		if (this->m_p_task_param->task_interval > 0) {
 			vTaskDelay(this->m_p_task_param->task_interval);
@@ -0,0 +1,111 @@
+#include <string.h>
+#include <esp_log.h>
+
+#include "utilities/inertial_vario.h"
+
+#define INERTIAL_VARIO_LOGE(format, ...) 			ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define INERTIAL_VARIO_LOGW(format, ...) 			ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define INERTIAL_VARIO_LOGI(format, ...) 			ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define INERTIAL_VARIO_LOGD(format, ...) 			ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define INERTIAL_VARIO_LOGV(format, ...) 			ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+/* Uncertainty of the vertical speed and the acceleration bias before the first sample */
+#define INERTIAL_VARIO_INITIAL_SPEED_VARIANCE		(25.0f)
+#define INERTIAL_VARIO_INITIAL_BIAS_VARIANCE		(0.25f)
+
+static const char *TAG = "INERTIAL_VARIO";
+
+InertialVario::InertialVario(float acceleration_noise, float bias_noise, float measurement_noise) :
+	m_acceleration_noise(acceleration_noise), m_bias_noise(bias_noise), m_measurement_noise(measurement_noise), m_initialized(false) {
+	memset(m_state, 0, sizeof(m_state));
+	memset(m_covariance, 0, sizeof(m_covariance));
+}
+
+void InertialVario::SetNoise(float acceleration_noise, float bias_noise, float measurement_noise) {
+	m_acceleration_noise = acceleration_noise;
+	m_bias_noise = bias_noise;
+	m_measurement_noise = measurement_noise;
+}
+
+void InertialVario::Reset() {
+	m_initialized = false;
+}
+
+/*
+	x = F * x + u * (a - b), P = F * P * F' + Q, with the input gain u = [dt^2/2 dt 0]:
+	F = [1 dt -dt^2/2; 0 1 -dt; 0 0 1], Q = u * u' * acceleration_noise^2 + diag(0, 0, bias_noise^2 * dt).
+	Returns the vertical speed, nothing is moved before the first altitude.
+*/
+float InertialVario::Propagate(float acceleration, float delta_time) {
+	if (!m_initialized || delta_time <= 0.0f) {
+		return m_state[1];
+	}
+
+	float half_square = 0.5f * delta_time * delta_time;
+	float transition[INERTIAL_VARIO_ORDER][INERTIAL_VARIO_ORDER] = {
+		{1.0f, delta_time, -half_square},
+		{0.0f, 1.0f, -delta_time},
+		{0.0f, 0.0f, 1.0f},
+	};
+	float gain[INERTIAL_VARIO_ORDER] = {half_square, delta_time, 0.0f};
+	float corrected = acceleration - m_state[2];
+
+	m_state[0] += m_state[1] * delta_time + corrected * half_square;
+	m_state[1] += corrected * delta_time;
+
+	// F is upper triangular, the products skip its zeros.
+	float product[INERTIAL_VARIO_ORDER][INERTIAL_VARIO_ORDER] = {{0.0f}};
+	for (int i = 0; i < INERTIAL_VARIO_ORDER; i++) {
+		for (int j = 0; j < INERTIAL_VARIO_ORDER; j++) {
+			for (int k = i; k < INERTIAL_VARIO_ORDER; k++) {
+				product[i][j] += transition[i][k] * m_covariance[k][j];
+			}
+		}
+	}
+	float acceleration_variance = m_acceleration_noise * m_acceleration_noise;
+	for (int i = 0; i < INERTIAL_VARIO_ORDER; i++) {
+		for (int j = 0; j < INERTIAL_VARIO_ORDER; j++) {
+			float sum = gain[i] * gain[j] * acceleration_variance;
+			for (int k = j; k < INERTIAL_VARIO_ORDER; k++) {
+				sum += product[i][k] * transition[j][k];
+			}
+			m_covariance[i][j] = sum;
+		}
+	}
+	m_covariance[2][2] += m_bias_noise * m_bias_noise * delta_time;
+
+	return m_state[1];
+}
+
+/* The altitude is the first state, H = [1 0 0], as in KalmanVario::correct(). Returns the vertical speed. */
+float InertialVario::Correct(float altitude) {
+	if (!m_initialized) {
+		memset(m_state, 0, sizeof(m_state));
+		memset(m_covariance, 0, sizeof(m_covariance));
+		m_state[0] = altitude;
+		m_covariance[0][0] = m_measurement_noise * m_measurement_noise;
+		m_covariance[1][1] = INERTIAL_VARIO_INITIAL_SPEED_VARIANCE;
+		m_covariance[2][2] = INERTIAL_VARIO_INITIAL_BIAS_VARIANCE;
+		m_initialized = true;
+		return 0.0f;
+	}
+
+	float innovation = altitude - m_state[0];
+	float innovation_variance = m_covariance[0][0] + m_measurement_noise * m_measurement_noise;
+	float gain[INERTIAL_VARIO_ORDER];
+	float first_row[INERTIAL_VARIO_ORDER];
+
+	for (int i = 0; i < INERTIAL_VARIO_ORDER; i++) {
+		gain[i] = m_covariance[i][0] / innovation_variance;
+		first_row[i] = m_covariance[0][i];
+	}
+	for (int i = 0; i < INERTIAL_VARIO_ORDER; i++) {
+		m_state[i] += gain[i] * innovation;
+		for (int j = 0; j < INERTIAL_VARIO_ORDER; j++) {
+			m_covariance[i][j] -= gain[i] * first_row[j];
+		}
+	}
+
+	INERTIAL_VARIO_LOGV("altitude:%f, state:%f %f %f", altitude, m_state[0], m_state[1], m_state[2]);
+	return m_state[1];
+}
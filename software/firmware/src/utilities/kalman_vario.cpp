@@ -0,0 +1,119 @@
+#include <string.h>
+#include <esp_log.h>
+
+#include "utilities/kalman_vario.h"
+
+#define KALMAN_VARIO_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define KALMAN_VARIO_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define KALMAN_VARIO_LOGI(format, ...) 				ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define KALMAN_VARIO_LOGD(format, ...) 				ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define KALMAN_VARIO_LOGV(format, ...) 				ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+/* Uncertainty of the vertical speed and acceleration before the first samples, a glider launching or still in a thermal */
+#define KALMAN_VARIO_INITIAL_SPEED_VARIANCE			(25.0f)
+#define KALMAN_VARIO_INITIAL_ACCELERATION_VARIANCE	(4.0f)
+
+static const char *TAG = "KALMAN_VARIO";
+
+KalmanVario::KalmanVario(KalmanVarioOrder_t order, float process_noise, float measurement_noise) : m_order(order),
+	m_process_noise(process_noise), m_measurement_noise(measurement_noise), m_initialized(false) {
+	memset(m_state, 0, sizeof(m_state));
+	memset(m_covariance, 0, sizeof(m_covariance));
+}
+
+void KalmanVario::SetNoise(float process_noise, float measurement_noise) {
+	m_process_noise = process_noise;
+	m_measurement_noise = measurement_noise;
+}
+
+void KalmanVario::Reset() {
+	m_initialized = false;
+}
+
+/* Returns the vertical speed after the sample, 0 for the first sample after a reset. */
+float KalmanVario::Update(float altitude, float delta_time) {
+	if (!m_initialized) {
+		memset(m_state, 0, sizeof(m_state));
+		memset(m_covariance, 0, sizeof(m_covariance));
+		m_state[0] = altitude;
+		m_covariance[0][0] = m_measurement_noise * m_measurement_noise;
+		m_covariance[1][1] = KALMAN_VARIO_INITIAL_SPEED_VARIANCE;
+		m_covariance[2][2] = KALMAN_VARIO_INITIAL_ACCELERATION_VARIANCE;
+		m_initialized = true;
+		return 0.0f;
+	}
+
+	// Two samples with the same timestamp are two measurements of the same state.
+	if (delta_time > 0.0f) {
+		predict(delta_time);
+	}
+	correct(altitude);
+
+	KALMAN_VARIO_LOGV("altitude:%f, delta_time:%f, state:%f %f %f", altitude, delta_time, m_state[0], m_state[1], m_state[2]);
+	return m_state[1];
+}
+
+/* x = F * x, P = F * P * F' + Q, with Q = g * g' * process_noise^2 for the noise gain g of the model. */
+void KalmanVario::predict(float delta_time) {
+	float half_square = 0.5f * delta_time * delta_time;
+	float transition[KALMAN_VARIO_MAX_ORDER][KALMAN_VARIO_MAX_ORDER] = {
+		{1.0f, delta_time, half_square},
+		{0.0f, 1.0f, delta_time},
+		{0.0f, 0.0f, 1.0f},
+	};
+	float gain[KALMAN_VARIO_MAX_ORDER] = {half_square, delta_time, 0.0f};
+	if (m_order == KALMAN_VARIO_ORDER_ACCELERATION) {
+		gain[0] = half_square * delta_time / 3.0f;
+		gain[1] = half_square;
+		gain[2] = delta_time;
+	}
+	int order = (int)m_order;
+
+	float state[KALMAN_VARIO_MAX_ORDER] = {0.0f};
+	for (int i = 0; i < order; i++) {
+		for (int j = i; j < order; j++) {
+			state[i] += transition[i][j] * m_state[j];
+		}
+	}
+	memcpy(m_state, state, sizeof(state));
+
+	// F is upper triangular, the products skip its zeros.
+	float product[KALMAN_VARIO_MAX_ORDER][KALMAN_VARIO_MAX_ORDER] = {{0.0f}};
+	for (int i = 0; i < order; i++) {
+		for (int j = 0; j < order; j++) {
+			for (int k = i; k < order; k++) {
+				product[i][j] += transition[i][k] * m_covariance[k][j];
+			}
+		}
+	}
+	float process_variance = m_process_noise * m_process_noise;
+	for (int i = 0; i < order; i++) {
+		for (int j = 0; j < order; j++) {
+			float sum = gain[i] * gain[j] * process_variance;
+			for (int k = j; k < order; k++) {
+				sum += product[i][k] * transition[j][k];
+			}
+			m_covariance[i][j] = sum;
+		}
+	}
+}
+
+/* The altitude is the first state, H = [1 0 0]: K = P(:,0) / (P(0,0) + R), x += K * y, P -= K * P(0,:). */
+void KalmanVario::correct(float altitude) {
+	int order = (int)m_order;
+	float innovation = altitude - m_state[0];
+	float innovation_variance = m_covariance[0][0] + m_measurement_noise * m_measurement_noise;
+	float gain[KALMAN_VARIO_MAX_ORDER];
+	float first_row[KALMAN_VARIO_MAX_ORDER];
+
+	for (int i = 0; i < order; i++) {
+		gain[i] = m_covariance[i][0] / innovation_variance;
+		first_row[i] = m_covariance[0][i];
+	}
+	for (int i = 0; i < order; i++) {
+		m_state[i] += gain[i] * innovation;
+		for (int j = 0; j < order; j++) {
+			m_covariance[i][j] -= gain[i] * first_row[j];
+		}
+	}
+}
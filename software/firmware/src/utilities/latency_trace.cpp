@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+#include "bluethroat_bluetooth.h"
+#include "bluethroat_message.h"
+#include "utilities/task_stats.h"
+#include "utilities/latency_trace.h"
+
+#define LATENCY_TRACE_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define LATENCY_TRACE_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define LATENCY_TRACE_LOGI(format, ...) 				ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define LATENCY_TRACE_LOGD(format, ...) 				ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define LATENCY_TRACE_LOGV(format, ...) 				ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "LATENCY_TRACE";
+
+static const char *s_stage_names[LATENCY_STAGE_MAX] = {"FETCH", "DEQUEUE", "VARIO", "SOUND", "I2S"};
+static const uint32_t s_histogram_edges_ms[LATENCY_HISTOGRAM_BINS] = LATENCY_HISTOGRAM_EDGES_MS;
+
+static void report_timer_callback(TimerHandle_t timer) {
+	LatencyTrace *p_latency_trace = (LatencyTrace *)pvTimerGetTimerID(timer);
+	p_latency_trace->RequestReport();
+}
+
+LatencyTrace::LatencyTrace(TickType_t report_interval_ticks) : m_report_interval_ticks(report_interval_ticks),
+	m_next_sequence(LATENCY_TRACE_NO_SEQUENCE + 1), m_superseded_samples(0), m_report_timer(NULL), m_queue_handle(NULL) {
+	memset(m_records, 0, sizeof(m_records));
+	memset(m_histograms, 0, sizeof(m_histograms));
+	portMUX_INITIALIZE(&m_spinlock);
+}
+
+LatencyTrace::~LatencyTrace() {
+	g_pLatencyTrace = NULL;
+	if (m_report_timer != NULL) {
+		xTimerDelete(m_report_timer, portMAX_DELAY);
+	}
+}
+
+esp_err_t LatencyTrace::Init() {
+	if (m_report_interval_ticks > 0) {
+		m_report_timer = xTimerCreate(TAG, m_report_interval_ticks, pdTRUE, this, report_timer_callback);
+		if (m_report_timer == NULL || xTimerStart(m_report_timer, 0) != pdPASS) {
+			LATENCY_TRACE_LOGE("Failed to start latency report timer");
+			return ESP_FAIL;
+		}
+	}
+
+	g_pLatencyTrace = this;
+	return ESP_OK;
+}
+
+uint32_t LatencyTrace::Begin() {
+	int64_t now_us = esp_timer_get_time();
+
+	taskENTER_CRITICAL(&m_spinlock);
+	uint32_t sequence = m_next_sequence++;
+	if (m_next_sequence == LATENCY_TRACE_NO_SEQUENCE) {
+		m_next_sequence++;
+	}
+
+	LatencyRecord_t *p_record = &(m_records[sequence % LATENCY_TRACE_RING_SIZE]);
+	if (p_record->sequence != LATENCY_TRACE_NO_SEQUENCE && !p_record->completed) {
+		m_superseded_samples++;
+	}
+	memset(p_record, 0, sizeof(LatencyRecord_t));
+	p_record->sequence = sequence;
+	p_record->stamps_us[LATENCY_STAGE_FETCH] = now_us;
+	taskEXIT_CRITICAL(&m_spinlock);
+
+	return sequence;
+}
+
+void LatencyTrace::Stamp(uint32_t sequence, LatencyStage_t stage) {
+	if (sequence == LATENCY_TRACE_NO_SEQUENCE) {
+		return;
+	}
+
+	int64_t now_us = esp_timer_get_time();
+
+	taskENTER_CRITICAL(&m_spinlock);
+	LatencyRecord_t *p_record = &(m_records[sequence % LATENCY_TRACE_RING_SIZE]);
+	// A record overwritten by a newer sample is silently ignored, only the first stamp of a stage counts.
+	if (p_record->sequence == sequence && !p_record->completed && p_record->stamps_us[stage] == 0) {
+		p_record->stamps_us[stage] = now_us;
+		if (stage == LATENCY_STAGE_I2S_WRITE) {
+			complete_record(p_record);
+		}
+	}
+	taskEXIT_CRITICAL(&m_spinlock);
+}
+
+/* Add the latencies of a completed record to the histograms, called with the spinlock taken. */
+void LatencyTrace::complete_record(LatencyRecord_t *p_record) {
+	for (int stage = LATENCY_STAGE_FETCH + 1; stage < LATENCY_STAGE_MAX; stage++) {
+		if (p_record->stamps_us[stage] == 0) {
+			continue;
+		}
+
+		uint32_t latency_us = (uint32_t)(p_record->stamps_us[stage] - p_record->stamps_us[LATENCY_STAGE_FETCH]);
+		LatencyHistogram_t *p_histogram = &(m_histograms[stage]);
+		p_histogram->count++;
+		p_histogram->total_us += latency_us;
+		p_histogram->max_us = (latency_us > p_histogram->max_us) ? latency_us : p_histogram->max_us;
+
+		int bin = 0;
+		while (bin < LATENCY_HISTOGRAM_BINS - 1 && latency_us / 1000 >= s_histogram_edges_ms[bin]) {
+			bin++;
+		}
+		p_histogram->bins[bin]++;
+	}
+	p_record->completed = true;
+}
+
+void LatencyTrace::GetHistograms(LatencyHistogram_t *p_histograms, uint32_t *p_superseded_samples) {
+	taskENTER_CRITICAL(&m_spinlock);
+	memcpy(p_histograms, m_histograms, sizeof(m_histograms));
+	*p_superseded_samples = m_superseded_samples;
+	taskEXIT_CRITICAL(&m_spinlock);
+}
+
+/* Called by the report timer, a full queue skips the report and counts as a dropped message. */
+void LatencyTrace::RequestReport() {
+	if (m_queue_handle == NULL) {
+		return;
+	}
+
+	BluethroatMsg_t message;
+	message.type = BLUETHROAT_MSG_TYPE_REPORT_REQUEST;
+	message.report_request.report = REPORT_LATENCY_TRACE;
+	(void)TaskStatsQueueSend(TASK_STATS_INDEX_OTHER, m_queue_handle, &message);
+}
+
+/*
+	Log the histograms and send them over the Nordic UART service of BLE, next to the GNSS sentences, one proprietary
+	NMEA sentence per stage: $PBTLAT,stage,count,mean_ms,max_ms,bin0,...,bin10*checksum
+*/
+void LatencyTrace::Report() {
+	LatencyHistogram_t histograms[LATENCY_STAGE_MAX];
+	uint32_t superseded_samples;
+	GetHistograms(histograms, &superseded_samples);
+
+	LATENCY_TRACE_LOGI("Latency from barometer fetch, %lu samples superseded before being played", (unsigned long)superseded_samples);
+	LATENCY_TRACE_LOGI("%-8s %8s %9s %9s  bins <1 <2 <5 <10 <20 <50 <100 <200 <500 <1000 >=1000 ms", "stage", "count", "mean ms", "max ms");
+
+	for (int stage = LATENCY_STAGE_FETCH + 1; stage < LATENCY_STAGE_MAX; stage++) {
+		const LatencyHistogram_t *p_histogram = &(histograms[stage]);
+		double mean_ms = (p_histogram->count > 0) ? (double)p_histogram->total_us / p_histogram->count / 1000.0 : 0.0;
+		double max_ms = p_histogram->max_us / 1000.0;
+
+		char bins[LATENCY_HISTOGRAM_BINS * 11 + 1];
+		int length = 0;
+		for (int bin = 0; bin < LATENCY_HISTOGRAM_BINS; bin++) {
+			length += snprintf(bins + length, sizeof(bins) - length, ",%lu", (unsigned long)p_histogram->bins[bin]);
+		}
+		LATENCY_TRACE_LOGI("%-8s %8lu %9.1f %9.1f  %s", s_stage_names[stage], (unsigned long)p_histogram->count, mean_ms, max_ms, bins + 1);
+
+		char sentence[160];
+		length = snprintf(sentence, sizeof(sentence), "$PBTLAT,%s,%lu,%.1f,%.1f%s", s_stage_names[stage], (unsigned long)p_histogram->count, mean_ms, max_ms, bins);
+		uint8_t checksum = 0;
+		for (int i = 1; i < length; i++) {
+			checksum ^= (uint8_t)sentence[i];
+		}
+		snprintf(sentence + length, sizeof(sentence) - length, "*%02X\r\n", checksum);
+		BluetoothSendGnssNmea(sentence);
+	}
+}
+
+LatencyTrace *g_pLatencyTrace = NULL;
+
+uint32_t LatencyTraceBegin() {
+	// Tracing is optional, every sample would log otherwise.
+	if (g_pLatencyTrace == NULL) {
+		return LATENCY_TRACE_NO_SEQUENCE;
+	}
+
+	return g_pLatencyTrace->Begin();
+}
+
+void LatencyTraceStamp(uint32_t sequence, LatencyStage_t stage) {
+	if (g_pLatencyTrace != NULL) {
+		g_pLatencyTrace->Stamp(sequence, stage);
+	}
+}
+
+void LatencyTraceReport() {
+	if (g_pLatencyTrace != NULL) {
+		g_pLatencyTrace->Report();
+	} else {
+		LATENCY_TRACE_LOGE("Latency trace is not initialized.");
+	}
+}
@@ -0,0 +1,111 @@
+#include <math.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "utilities/redundant_static.h"
+
+#define REDUNDANT_STATIC_LOGE(format, ...) 			ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define REDUNDANT_STATIC_LOGW(format, ...) 			ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define REDUNDANT_STATIC_LOGI(format, ...) 			ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define REDUNDANT_STATIC_LOGD(format, ...) 			ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define REDUNDANT_STATIC_LOGV(format, ...) 			ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "REDUNDANT_STATIC";
+
+RedundantStatic::RedundantStatic(RedundantStaticMode_t mode, uint32_t max_age, float max_difference) :
+	m_mode(mode), m_max_age(max_age), m_max_difference(max_difference) {
+	Reset();
+}
+
+void RedundantStatic::Reset() {
+	memset(m_ports, 0, sizeof(m_ports));
+	m_offset = 0.0f;
+	m_has_offset = false;
+	m_disagree_count = 0;
+	m_disagree = false;
+	m_fused_count = 0;
+}
+
+/*
+	Every sample of either port. Returns true when the sample drives the vario, it is then rewritten to the pressure of
+	the first port, the mean of both in the average mode.
+*/
+bool RedundantStatic::AddSample(StaticPortIndex_t port, BarometerData_t *p_data) {
+	StaticPortIndex_t other = (port == STATIC_PORT_PRIMARY) ? STATIC_PORT_SECONDARY : STATIC_PORT_PRIMARY;
+
+	check_health(port, p_data);
+	if (m_ports[port].failed) {
+		return false;
+	}
+
+	bool other_usable = is_usable(other, p_data->timestamp);
+	if (other_usable) {
+		compare_ports();
+	}
+	// The second port is a standby while the first one works.
+	if (port == STATIC_PORT_SECONDARY && other_usable) {
+		return false;
+	}
+
+	if (m_mode == REDUNDANT_STATIC_AVERAGE && other_usable && !m_disagree) {
+		const BarometerData_t *p_other = &(m_ports[other].sample);
+		p_data->pressure = 0.5f * (p_data->pressure + p_other->pressure - m_offset);
+		p_data->pressure_filterd = 0.5f * (p_data->pressure_filterd + p_other->pressure_filterd - m_offset);
+		m_fused_count++;
+	} else if (port == STATIC_PORT_SECONDARY) {
+		p_data->pressure -= m_offset;
+		p_data->pressure_filterd -= m_offset;
+	}
+	return true;
+}
+
+void RedundantStatic::check_health(StaticPortIndex_t port, const BarometerData_t *p_data) {
+	StaticPort_t *p_port = &(m_ports[port]);
+
+	p_port->repeat_count = (p_port->has_sample && p_data->pressure == p_port->sample.pressure) ? p_port->repeat_count + 1 : 0;
+	bool failed = p_data->pressure < REDUNDANT_STATIC_MIN_PRESSURE || p_data->pressure > REDUNDANT_STATIC_MAX_PRESSURE ||
+				  p_port->repeat_count >= REDUNDANT_STATIC_STUCK_SAMPLES;
+	if (failed != p_port->failed) {
+		p_port->failed = failed;
+		if (failed) {
+			p_port->failed_timestamp = p_data->timestamp;
+			REDUNDANT_STATIC_LOGW("Static port %d failed at %u ms, pressure %f Pa, %u samples repeated", port, (unsigned int)p_data->timestamp, p_data->pressure, (unsigned int)p_port->repeat_count);
+		} else {
+			REDUNDANT_STATIC_LOGI("Static port %d recovered at %u ms", port, (unsigned int)p_data->timestamp);
+		}
+	}
+	p_port->sample = *p_data;
+	p_port->has_sample = true;
+}
+
+bool RedundantStatic::is_usable(StaticPortIndex_t port, uint32_t timestamp) const {
+	const StaticPort_t *p_port = &(m_ports[port]);
+	return p_port->has_sample && !p_port->failed && (int32_t)(timestamp - p_port->sample.timestamp) <= (int32_t)m_max_age;
+}
+
+/* The offset only follows the ports while they agree, so a port that steps away stays apart. */
+void RedundantStatic::compare_ports() {
+	float difference = m_ports[STATIC_PORT_SECONDARY].sample.pressure - m_ports[STATIC_PORT_PRIMARY].sample.pressure;
+	if (!m_has_offset) {
+		m_offset = difference;
+		m_has_offset = true;
+		REDUNDANT_STATIC_LOGI("Second static port %f Pa off the first one", m_offset);
+		return;
+	}
+
+	bool disagree = fabsf(difference - m_offset) > m_max_difference;
+	if (disagree == m_disagree) {
+		m_disagree_count = 0;
+	} else if (++m_disagree_count >= REDUNDANT_STATIC_DISAGREE_SAMPLES) {
+		m_disagree = disagree;
+		m_disagree_count = 0;
+		if (disagree) {
+			REDUNDANT_STATIC_LOGW("Static ports disagree, %f Pa apart against an offset of %f Pa, following the first one", difference, m_offset);
+		} else {
+			REDUNDANT_STATIC_LOGI("Static ports agree again");
+		}
+	}
+	if (!disagree) {
+		m_offset += (difference - m_offset) * REDUNDANT_STATIC_OFFSET_ALPHA;
+	}
+}
@@ -0,0 +1,345 @@
+#include <math.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_cpu.h>
+
+#include "utilities/baro_altitude.h"
+#include "utilities/sme_float.h"
+#include "utilities/sme_float_bench.h"
+#include "drivers/dps3xx_barometer.h"
+
+#define SME_FLOAT_BENCH_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define SME_FLOAT_BENCH_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define SME_FLOAT_BENCH_LOGI(format, ...) 				ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define SME_FLOAT_BENCH_LOGD(format, ...) 				ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define SME_FLOAT_BENCH_LOGV(format, ...) 				ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "SME_FLOAT_BENCH";
+
+#define N 												SME_FLOAT_BENCH_SAMPLES
+#define Q16(value)										((int32_t)lround((value) * 65536.0))
+
+/* Coefficients of a DPS310 sample, c0, c1, c00, c10, c01, c11, c20, c21, c30 */
+static const int32_t s_coefs[9] = {222, -295, 82580, -55343, -3496, 1545, -11412, 216, -1756};
+
+/* Operands, the same values in each representation */
+static float32_t s_a_sme[N], s_b_sme[N];
+static float s_a_float[N], s_b_float[N];
+static int32_t s_a_fixed[N], s_b_fixed[N];
+static int32_t s_int[N];
+static int32_t s_raw_temperature[N], s_raw_pressure[N];
+static int32_t s_minutes_digits[N];								/* fraction of minute in 1e-5, as the 5 decimals of NMEA */
+static float s_minutes_float[N];
+static float32_t s_pressure_sme[N];
+static float s_pressure_float[N];
+static int32_t s_pressure_fixed[N];								/* Q24.8 */
+
+/* Results, each case writes the array of its implementation, conversions to float write s_out_float */
+static float32_t s_out_sme[N];
+static float s_out_float[N];
+static int32_t s_out_fixed[N];
+
+/* Scaled coefficients, prepared as in Dps3xxBarometer::get_coefs */
+static struct {
+	float32_t c0, c1, c00, c10, c01, c11, c20, c21, c30;
+} s_coef_sme;
+static struct {
+	float c0, c1, c00, c10, c01, c11, c20, c21, c30;
+} s_coef_float;
+static struct {
+	int64_t inv_kt, inv_kp;										/* 2^56 / scale factor */
+} s_coef_fixed;
+
+typedef enum {
+	BENCH_OP_COPY = 0,
+	BENCH_OP_ADD, BENCH_OP_SUB, BENCH_OP_MUL, BENCH_OP_DIV, BENCH_OP_NEG,
+	BENCH_OP_ADD_INT, BENCH_OP_SUB_INT, BENCH_OP_MUL_INT, BENCH_OP_DIV_INT,
+	BENCH_OP_FROM_INT, BENCH_OP_FROM_FLOAT, BENCH_OP_TO_FLOAT,
+	BENCH_OP_TEMPERATURE, BENCH_OP_PRESSURE, BENCH_OP_NMEA_SECONDS, BENCH_OP_ALTITUDE,
+} BenchOp_t;
+
+typedef struct {
+	const char *name;
+	BenchOp_t op;
+	void (*run[SME_FLOAT_BENCH_IMPL_MAX])(void);
+	uint8_t fixed_fraction_bits;									/* of s_out_fixed */
+	bool float_output;												/* all implementations write s_out_float */
+	double tolerance[SME_FLOAT_BENCH_IMPL_MAX];						/* of |result - reference| / max(1, |reference|) */
+} BenchCase_t;
+
+#define BENCH_LOOP(function, statement) \
+	static void function(void) { for (int i = 0; i < N; i++) { statement; } }
+
+BENCH_LOOP(sme_copy,			s_out_sme[i] = s_a_sme[i])
+BENCH_LOOP(float_copy,			s_out_float[i] = s_a_float[i])
+BENCH_LOOP(fixed_copy,			s_out_fixed[i] = s_a_fixed[i])
+
+BENCH_LOOP(sme_add,				s_out_sme[i] = s_a_sme[i] + s_b_sme[i])
+BENCH_LOOP(sme_add_assign,		s_out_sme[i] = s_a_sme[i]; s_out_sme[i] += s_b_sme[i])
+BENCH_LOOP(float_add,			s_out_float[i] = s_a_float[i] + s_b_float[i])
+BENCH_LOOP(fixed_add,			s_out_fixed[i] = s_a_fixed[i] + s_b_fixed[i])
+
+BENCH_LOOP(sme_sub,				s_out_sme[i] = s_a_sme[i] - s_b_sme[i])
+BENCH_LOOP(sme_sub_assign,		s_out_sme[i] = s_a_sme[i]; s_out_sme[i] -= s_b_sme[i])
+BENCH_LOOP(float_sub,			s_out_float[i] = s_a_float[i] - s_b_float[i])
+BENCH_LOOP(fixed_sub,			s_out_fixed[i] = s_a_fixed[i] - s_b_fixed[i])
+
+BENCH_LOOP(sme_mul,				s_out_sme[i] = s_a_sme[i] * s_b_sme[i])
+BENCH_LOOP(sme_mul_assign,		s_out_sme[i] = s_a_sme[i]; s_out_sme[i] *= s_b_sme[i])
+BENCH_LOOP(float_mul,			s_out_float[i] = s_a_float[i] * s_b_float[i])
+BENCH_LOOP(fixed_mul,			s_out_fixed[i] = (int32_t)(((int64_t)s_a_fixed[i] * s_b_fixed[i]) >> 16))
+
+BENCH_LOOP(sme_div,				s_out_sme[i] = s_a_sme[i] / s_b_sme[i])
+BENCH_LOOP(sme_div_assign,		s_out_sme[i] = s_a_sme[i]; s_out_sme[i] /= s_b_sme[i])
+BENCH_LOOP(float_div,			s_out_float[i] = s_a_float[i] / s_b_float[i])
+BENCH_LOOP(fixed_div,			s_out_fixed[i] = (int32_t)(((int64_t)s_a_fixed[i] << 16) / s_b_fixed[i]))
+
+BENCH_LOOP(sme_neg,				s_out_sme[i] = -s_a_sme[i])
+BENCH_LOOP(float_neg,			s_out_float[i] = -s_a_float[i])
+BENCH_LOOP(fixed_neg,			s_out_fixed[i] = -s_a_fixed[i])
+
+BENCH_LOOP(sme_add_int,			s_out_sme[i] = s_a_sme[i] + s_int[i])
+BENCH_LOOP(sme_add_assign_int,	s_out_sme[i] = s_a_sme[i]; s_out_sme[i] += s_int[i])
+BENCH_LOOP(float_add_int,		s_out_float[i] = s_a_float[i] + (float)s_int[i])
+BENCH_LOOP(fixed_add_int,		s_out_fixed[i] = s_a_fixed[i] + (s_int[i] << 16))
+
+BENCH_LOOP(sme_sub_int,			s_out_sme[i] = s_a_sme[i] - s_int[i])
+BENCH_LOOP(sme_sub_assign_int,	s_out_sme[i] = s_a_sme[i]; s_out_sme[i] -= s_int[i])
+BENCH_LOOP(float_sub_int,		s_out_float[i] = s_a_float[i] - (float)s_int[i])
+BENCH_LOOP(fixed_sub_int,		s_out_fixed[i] = s_a_fixed[i] - (s_int[i] << 16))
+
+BENCH_LOOP(sme_mul_int,			s_out_sme[i] = s_a_sme[i] * s_int[i])
+BENCH_LOOP(sme_mul_assign_int,	s_out_sme[i] = s_a_sme[i]; s_out_sme[i] *= s_int[i])
+BENCH_LOOP(float_mul_int,		s_out_float[i] = s_a_float[i] * (float)s_int[i])
+BENCH_LOOP(fixed_mul_int,		s_out_fixed[i] = s_a_fixed[i] * s_int[i])
+
+BENCH_LOOP(sme_div_int,			s_out_sme[i] = s_a_sme[i] / s_int[i])
+BENCH_LOOP(sme_div_assign_int,	s_out_sme[i] = s_a_sme[i]; s_out_sme[i] /= s_int[i])
+BENCH_LOOP(float_div_int,		s_out_float[i] = s_a_float[i] / (float)s_int[i])
+BENCH_LOOP(fixed_div_int,		s_out_fixed[i] = s_a_fixed[i] / s_int[i])
+
+BENCH_LOOP(sme_from_int,		s_out_sme[i] = float32_t(s_int[i]))
+BENCH_LOOP(float_from_int,		s_out_float[i] = (float)s_int[i])
+BENCH_LOOP(fixed_from_int,		s_out_fixed[i] = s_int[i] << 16)
+
+BENCH_LOOP(sme_from_float,		s_out_sme[i] = float32_t(s_a_float[i]))
+BENCH_LOOP(fixed_from_float,	s_out_fixed[i] = (int32_t)(s_a_float[i] * 65536.0F))
+
+BENCH_LOOP(sme_to_float,		s_out_float[i] = (float)s_a_sme[i])
+BENCH_LOOP(fixed_to_float,		s_out_float[i] = (float)s_a_fixed[i] * (1.0F / 65536.0F))
+
+/* The expressions of Dps3xxBarometer::process_data */
+BENCH_LOOP(sme_temperature,		s_out_sme[i] = s_coef_sme.c0 + s_coef_sme.c1 * s_raw_temperature[i])
+BENCH_LOOP(sme_pressure,		s_out_sme[i] = s_coef_sme.c00 +
+									s_coef_sme.c10 * s_raw_pressure[i] +
+									s_coef_sme.c20 * s_raw_pressure[i] * s_raw_pressure[i] +
+									s_coef_sme.c30 * s_raw_pressure[i] * s_raw_pressure[i] * s_raw_pressure[i] +
+									s_coef_sme.c01 * s_raw_temperature[i] +
+									s_coef_sme.c11 * s_raw_pressure[i] * s_raw_temperature[i])
+BENCH_LOOP(float_temperature,	s_out_float[i] = s_coef_float.c0 + s_coef_float.c1 * (float)s_raw_temperature[i])
+BENCH_LOOP(float_pressure,		float p = (float)s_raw_pressure[i]; float t = (float)s_raw_temperature[i];
+								s_out_float[i] = s_coef_float.c00 + p * (s_coef_float.c10 + p * (s_coef_float.c20 + p * s_coef_float.c30)) +
+									t * s_coef_float.c01 + t * p * s_coef_float.c11)
+
+/*
+	Scaled raw values in Q8.24 by a multiplication with the reciprocal of the scale factor, the polynomial by Horner's
+	method in Q16 with 64-bit intermediates, the compensated pressure in Q24.8.
+	Like process_data, all the implementations leave out the c21 term of the datasheet formula, so they compute the same
+	function.
+*/
+BENCH_LOOP(fixed_temperature,	int64_t t = ((int64_t)s_raw_temperature[i] * s_coef_fixed.inv_kt) >> 32;
+								s_out_fixed[i] = (int32_t)(((int64_t)s_coefs[0] << 15) + (((int64_t)s_coefs[1] * t) >> 8)))
+BENCH_LOOP(fixed_pressure,		int64_t p = ((int64_t)s_raw_pressure[i] * s_coef_fixed.inv_kp) >> 32;
+								int64_t t = ((int64_t)s_raw_temperature[i] * s_coef_fixed.inv_kt) >> 32;
+								int64_t acc = ((int64_t)s_coefs[6] << 16) + (((int64_t)s_coefs[8] * p) >> 8);
+								acc = ((int64_t)s_coefs[3] << 16) + ((acc * p) >> 24);
+								int64_t pressure = ((int64_t)s_coefs[2] << 16) + ((acc * p) >> 24) + (((int64_t)s_coefs[4] * t) >> 8);
+								pressure += ((((int64_t)s_coefs[5] * p) >> 8) * t) >> 24;
+								s_out_fixed[i] = (int32_t)(pressure >> 8))
+
+/* The conversion of NeoM9nGnss::process_gnss_sentence, fraction of minute to seconds */
+BENCH_LOOP(sme_nmea_seconds,	s_out_sme[i] = float32_t(s_minutes_float[i]) * float32_t(60.0F))
+BENCH_LOOP(float_nmea_seconds,	s_out_float[i] = s_minutes_float[i] * 60.0F)
+BENCH_LOOP(fixed_nmea_seconds,	s_out_fixed[i] = (int32_t)(((int64_t)s_minutes_digits[i] * (60 << 16)) / 100000))
+
+/* Pressure to altitude, by the table of baro_altitude.h and by libm as BluethraotVario did before it */
+#define LIBM_ALTITUDE(pressure)			(44330.77F * (1.0F - powf((pressure) / BARO_ALTITUDE_STANDARD_PRESSURE, 0.190263F)))
+BENCH_LOOP(sme_altitude_table,		s_out_sme[i] = PressureToAltitude(s_pressure_sme[i]))
+BENCH_LOOP(float_altitude_table,	s_out_float[i] = PressureToAltitude(s_pressure_float[i]))
+BENCH_LOOP(fixed_altitude_table,	s_out_fixed[i] = PressureToAltitudeQ16(s_pressure_fixed[i]))
+BENCH_LOOP(sme_altitude_libm,		s_out_sme[i] = float32_t(LIBM_ALTITUDE((float)s_pressure_sme[i])))
+BENCH_LOOP(float_altitude_libm,		s_out_float[i] = LIBM_ALTITUDE(s_pressure_float[i]))
+BENCH_LOOP(fixed_altitude_libm,		s_out_fixed[i] = Q16(LIBM_ALTITUDE((float)s_pressure_fixed[i] * (1.0F / 256.0F))))
+
+#define OPERATOR_TOLERANCE		{1e-6, 1e-6, 1e-4}
+
+static const BenchCase_t s_cases[] = {
+	{"load/store",			BENCH_OP_COPY,			{sme_copy, float_copy, fixed_copy}, 16, false, OPERATOR_TOLERANCE},
+	{"a + b",				BENCH_OP_ADD,			{sme_add, float_add, fixed_add}, 16, false, OPERATOR_TOLERANCE},
+	{"a += b",				BENCH_OP_ADD,			{sme_add_assign, float_add, fixed_add}, 16, false, OPERATOR_TOLERANCE},
+	{"a - b",				BENCH_OP_SUB,			{sme_sub, float_sub, fixed_sub}, 16, false, OPERATOR_TOLERANCE},
+	{"a -= b",				BENCH_OP_SUB,			{sme_sub_assign, float_sub, fixed_sub}, 16, false, OPERATOR_TOLERANCE},
+	{"a * b",				BENCH_OP_MUL,			{sme_mul, float_mul, fixed_mul}, 16, false, OPERATOR_TOLERANCE},
+	{"a *= b",				BENCH_OP_MUL,			{sme_mul_assign, float_mul, fixed_mul}, 16, false, OPERATOR_TOLERANCE},
+	{"a / b",				BENCH_OP_DIV,			{sme_div, float_div, fixed_div}, 16, false, OPERATOR_TOLERANCE},
+	{"a /= b",				BENCH_OP_DIV,			{sme_div_assign, float_div, fixed_div}, 16, false, OPERATOR_TOLERANCE},
+	{"-a",					BENCH_OP_NEG,			{sme_neg, float_neg, fixed_neg}, 16, false, OPERATOR_TOLERANCE},
+	{"a + int32",			BENCH_OP_ADD_INT,		{sme_add_int, float_add_int, fixed_add_int}, 16, false, OPERATOR_TOLERANCE},
+	{"a += int32",			BENCH_OP_ADD_INT,		{sme_add_assign_int, float_add_int, fixed_add_int}, 16, false, OPERATOR_TOLERANCE},
+	{"a - int32",			BENCH_OP_SUB_INT,		{sme_sub_int, float_sub_int, fixed_sub_int}, 16, false, OPERATOR_TOLERANCE},
+	{"a -= int32",			BENCH_OP_SUB_INT,		{sme_sub_assign_int, float_sub_int, fixed_sub_int}, 16, false, OPERATOR_TOLERANCE},
+	{"a * int32",			BENCH_OP_MUL_INT,		{sme_mul_int, float_mul_int, fixed_mul_int}, 16, false, OPERATOR_TOLERANCE},
+	{"a *= int32",			BENCH_OP_MUL_INT,		{sme_mul_assign_int, float_mul_int, fixed_mul_int}, 16, false, OPERATOR_TOLERANCE},
+	{"a / int32",			BENCH_OP_DIV_INT,		{sme_div_int, float_div_int, fixed_div_int}, 16, false, OPERATOR_TOLERANCE},
+	{"a /= int32",			BENCH_OP_DIV_INT,		{sme_div_assign_int, float_div_int, fixed_div_int}, 16, false, OPERATOR_TOLERANCE},
+	{"int32 to x",			BENCH_OP_FROM_INT,		{sme_from_int, float_from_int, fixed_from_int}, 16, false, OPERATOR_TOLERANCE},
+	{"float to x",			BENCH_OP_FROM_FLOAT,	{sme_from_float, float_copy, fixed_from_float}, 16, false, OPERATOR_TOLERANCE},
+	{"x to float",			BENCH_OP_TO_FLOAT,		{sme_to_float, float_copy, fixed_to_float}, 16, true, OPERATOR_TOLERANCE},
+	// 1e-4 of 25C, 1e-5 of 100000Pa is 1Pa, about 8cm
+	{"dps3xx temperature",	BENCH_OP_TEMPERATURE,	{sme_temperature, float_temperature, fixed_temperature}, 16, false, {1e-4, 1e-4, 1e-4}},
+	{"dps3xx pressure",		BENCH_OP_PRESSURE,		{sme_pressure, float_pressure, fixed_pressure}, 8, false, {1e-5, 1e-5, 1e-5}},
+	{"nmea seconds",		BENCH_OP_NMEA_SECONDS,	{sme_nmea_seconds, float_nmea_seconds, fixed_nmea_seconds}, 16, false, {1e-5, 1e-5, 1e-4}},
+	// BARO_ALTITUDE_MAX_ERROR_M of the lowest altitude of the operands, about 110m
+	{"altitude table",		BENCH_OP_ALTITUDE,		{sme_altitude_table, float_altitude_table, fixed_altitude_table}, 16, false, {1e-3, 1e-3, 1e-3}},
+	{"altitude libm",		BENCH_OP_ALTITUDE,		{sme_altitude_libm, float_altitude_libm, fixed_altitude_libm}, 16, false, {1e-4, 1e-4, 1e-4}},
+};
+
+static uint32_t s_random_state = 0x12345678;
+
+static double random_uniform(double low, double high) {
+	s_random_state = s_random_state * 1664525 + 1013904223;
+	return low + (high - low) * (s_random_state >> 8) / (double)(1 << 24);
+}
+
+static void prepare_operands() {
+	for (int i = 0; i < N; i++) {
+		// Magnitudes between 1 and 128 keep products and quotients in the Q16.16 range.
+		s_a_float[i] = (float)(random_uniform(1.0, 128.0) * ((i & 1) ? -1 : 1));
+		s_b_float[i] = (float)(random_uniform(1.0, 128.0) * ((i & 2) ? -1 : 1));
+		s_a_sme[i] = float32_t(s_a_float[i]);
+		s_b_sme[i] = float32_t(s_b_float[i]);
+		s_a_fixed[i] = Q16(s_a_float[i]);
+		s_b_fixed[i] = Q16(s_b_float[i]);
+		s_int[i] = (int32_t)random_uniform(1.0, 100.0) * ((i & 4) ? -1 : 1);
+
+		// Raw values of about -20~60C and 25000~105000Pa with the sample coefficients.
+		s_raw_temperature[i] = (int32_t)random_uniform(90000.0, 230000.0);
+		s_raw_pressure[i] = (int32_t)random_uniform(-450000.0, 900000.0);
+
+		s_minutes_digits[i] = (int32_t)random_uniform(0.0, 100000.0);
+		s_minutes_float[i] = (float)s_minutes_digits[i] / 100000.0F;
+
+		// About 9100m to 110m, away from 0m where the relative error of any altitude blows up.
+		s_pressure_float[i] = (float)random_uniform(30000.0, 100000.0);
+		s_pressure_sme[i] = float32_t(s_pressure_float[i]);
+		s_pressure_fixed[i] = (int32_t)lroundf(s_pressure_float[i] * 256.0F);
+	}
+
+	float32_t kt((int32_t)DPS3XX_SCALE_FACTOR_PRC_32), kp((int32_t)DPS3XX_SCALE_FACTOR_PRC_64);
+	s_coef_sme.c0  = float32_t(s_coefs[0]) / float32_t((int32_t)2);
+	s_coef_sme.c1  = float32_t(s_coefs[1]) / kt;
+	s_coef_sme.c00 = float32_t(s_coefs[2]);
+	s_coef_sme.c10 = float32_t(s_coefs[3]) / kp;
+	s_coef_sme.c01 = float32_t(s_coefs[4]) / kt;
+	s_coef_sme.c11 = float32_t(s_coefs[5]) / kp / kt;
+	s_coef_sme.c20 = float32_t(s_coefs[6]) / kp / kp;
+	s_coef_sme.c21 = float32_t(s_coefs[7]) / kp / kp / kt;
+	s_coef_sme.c30 = float32_t(s_coefs[8]) / kp / kp / kp;
+
+	float ktf = (float)DPS3XX_SCALE_FACTOR_PRC_32, kpf = (float)DPS3XX_SCALE_FACTOR_PRC_64;
+	s_coef_float.c0  = s_coefs[0] / 2.0F;
+	s_coef_float.c1  = s_coefs[1] / ktf;
+	s_coef_float.c00 = (float)s_coefs[2];
+	s_coef_float.c10 = s_coefs[3] / kpf;
+	s_coef_float.c01 = s_coefs[4] / ktf;
+	s_coef_float.c11 = s_coefs[5] / kpf / ktf;
+	s_coef_float.c20 = s_coefs[6] / kpf / kpf;
+	s_coef_float.c21 = s_coefs[7] / kpf / kpf / ktf;
+	s_coef_float.c30 = s_coefs[8] / kpf / kpf / kpf;
+
+	s_coef_fixed.inv_kt = (int64_t)((1ULL << 56) / DPS3XX_SCALE_FACTOR_PRC_32);
+	s_coef_fixed.inv_kp = (int64_t)((1ULL << 56) / DPS3XX_SCALE_FACTOR_PRC_64);
+}
+
+static double reference(BenchOp_t op, int i) {
+	double a = s_a_float[i], b = s_b_float[i], n = s_int[i];
+	double t = s_raw_temperature[i] / (double)DPS3XX_SCALE_FACTOR_PRC_32;
+	double p = s_raw_pressure[i] / (double)DPS3XX_SCALE_FACTOR_PRC_64;
+
+	switch (op) {
+	case BENCH_OP_COPY:				return a;
+	case BENCH_OP_ADD:				return a + b;
+	case BENCH_OP_SUB:				return a - b;
+	case BENCH_OP_MUL:				return a * b;
+	case BENCH_OP_DIV:				return a / b;
+	case BENCH_OP_NEG:				return -a;
+	case BENCH_OP_ADD_INT:			return a + n;
+	case BENCH_OP_SUB_INT:			return a - n;
+	case BENCH_OP_MUL_INT:			return a * n;
+	case BENCH_OP_DIV_INT:			return a / n;
+	case BENCH_OP_FROM_INT:			return n;
+	case BENCH_OP_FROM_FLOAT:		return a;
+	case BENCH_OP_TO_FLOAT:			return a;
+	case BENCH_OP_TEMPERATURE:		return s_coefs[0] / 2.0 + s_coefs[1] * t;
+	case BENCH_OP_PRESSURE:			return s_coefs[2] + p * (s_coefs[3] + p * (s_coefs[6] + p * s_coefs[8])) + t * s_coefs[4] + t * p * s_coefs[5];
+	case BENCH_OP_NMEA_SECONDS:		return s_minutes_digits[i] * 60.0 / 100000.0;
+	case BENCH_OP_ALTITUDE:			return BARO_ALTITUDE_SCALE_M * (1.0 - pow(s_pressure_float[i] / (double)BARO_ALTITUDE_STANDARD_PRESSURE, BARO_ALTITUDE_EXPONENT));
+	default:						return 0;
+	}
+}
+
+static double result(const BenchCase_t *p_case, SmeFloatBenchImpl_t impl, int i) {
+	if (p_case->float_output) {
+		return s_out_float[i];
+	}
+
+	switch (impl) {
+	case SME_FLOAT_BENCH_IMPL_FLOAT32_T:	return (float)s_out_sme[i];
+	case SME_FLOAT_BENCH_IMPL_FLOAT:		return s_out_float[i];
+	default:								return ldexp((double)s_out_fixed[i], -p_case->fixed_fraction_bits);
+	}
+}
+
+esp_err_t SmeFloatBenchmark(uint32_t rounds) {
+	esp_err_t status = ESP_OK;
+
+	prepare_operands();
+
+	SME_FLOAT_BENCH_LOGI("%lu rounds of %d operations, cycles per operation (max relative error)", (unsigned long)rounds, N);
+	SME_FLOAT_BENCH_LOGI("%-20s %22s %22s %22s", "case", "float32_t", "float", "Q-format");
+
+	for (size_t c = 0; c < sizeof(s_cases) / sizeof(s_cases[0]); c++) {
+		const BenchCase_t *p_case = &(s_cases[c]);
+		double cycles[SME_FLOAT_BENCH_IMPL_MAX];
+		double errors[SME_FLOAT_BENCH_IMPL_MAX];
+
+		for (int impl = 0; impl < SME_FLOAT_BENCH_IMPL_MAX; impl++) {
+			// A first run to fill the caches, then the timed rounds.
+			p_case->run[impl]();
+			esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+			for (uint32_t round = 0; round < rounds; round++) {
+				p_case->run[impl]();
+			}
+			esp_cpu_cycle_count_t elapsed = esp_cpu_get_cycle_count() - start;
+			cycles[impl] = (double)elapsed / ((double)rounds * N);
+
+			errors[impl] = 0;
+			for (int i = 0; i < N; i++) {
+				double expected = reference(p_case->op, i);
+				double error = fabs(result(p_case, (SmeFloatBenchImpl_t)impl, i) - expected) / fmax(1.0, fabs(expected));
+				errors[impl] = fmax(errors[impl], error);
+			}
+			if (errors[impl] > p_case->tolerance[impl]) {
+				SME_FLOAT_BENCH_LOGE("%s of implementation %d is out of tolerance, relative error %.3e", p_case->name, impl, errors[impl]);
+				status = ESP_FAIL;
+			}
+		}
+
+		SME_FLOAT_BENCH_LOGI("%-20s %10.1f (%9.2e) %10.1f (%9.2e) %10.1f (%9.2e)", p_case->name,
+			cycles[SME_FLOAT_BENCH_IMPL_FLOAT32_T], errors[SME_FLOAT_BENCH_IMPL_FLOAT32_T],
+			cycles[SME_FLOAT_BENCH_IMPL_FLOAT], errors[SME_FLOAT_BENCH_IMPL_FLOAT],
+			cycles[SME_FLOAT_BENCH_IMPL_FIXED], errors[SME_FLOAT_BENCH_IMPL_FIXED]);
+	}
+
+	return status;
+}
@@ -1,5 +1,7 @@
 #include <esp_log.h>
 #include "utilities/task_object.h"
+#include "utilities/task_stats.h"
+#include "bluethroat_global.h"
 #include "bluethroat_msg_proc.h"
 
 #define TASK_OBJ_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
@@ -85,6 +87,16 @@ esp_err_t TaskObject::delete_task() {
 	return ESP_OK;
 }
 
+/* Index of the task in g_TaskParam, TASK_STATS_INDEX_OTHER for an object without its own task. */
+uint32_t TaskObject::task_index() const {
+	return (m_p_task_param != NULL) ? (uint32_t)(m_p_task_param - g_TaskParam) : TASK_STATS_INDEX_OTHER;
+}
+
+/* Send a message to the message processor without waiting, a full queue is counted in the task statistics. */
+BaseType_t TaskObject::send_message(const BluethroatMsg_t *p_message) {
+	return TaskStatsQueueSend(task_index(), m_queue_handle, p_message);
+}
+
 void task_c_entry(void *p_param) {
 	TaskObject *p_object = (TaskObject *)p_param;
 	p_object->task_cpp_entry();
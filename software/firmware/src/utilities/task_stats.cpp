@@ -0,0 +1,197 @@
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+#include "bluethroat_global.h"
+#include "bluethroat_gui.h"
+#include "bluethroat_message.h"
+#include "utilities/task_stats.h"
+
+#define TASK_STATS_LOGE(format, ...) 				ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define TASK_STATS_LOGW(format, ...) 				ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define TASK_STATS_LOGI(format, ...) 				ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define TASK_STATS_LOGD(format, ...) 				ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define TASK_STATS_LOGV(format, ...) 				ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+static const char *TAG = "TASK_STATS";
+
+static void report_timer_callback(TimerHandle_t timer) {
+	TaskStats *p_task_stats = (TaskStats *)pvTimerGetTimerID(timer);
+	p_task_stats->RequestReport();
+}
+
+TaskStats::TaskStats(TickType_t report_interval_ticks) : m_report_interval_ticks(report_interval_ticks), m_report_timer(NULL), m_queue_handle(NULL) {
+	memset(m_stats, 0, sizeof(m_stats));
+	memset(m_task_handles, 0, sizeof(m_task_handles));
+	memset(m_loop_begin_us, 0, sizeof(m_loop_begin_us));
+	memset(m_loop_work_us, 0, sizeof(m_loop_work_us));
+	memset(m_last_loop_end_us, 0, sizeof(m_last_loop_end_us));
+	portMUX_INITIALIZE(&m_spinlock);
+}
+
+TaskStats::~TaskStats() {
+	g_pTaskStats = NULL;
+	if (m_report_timer != NULL) {
+		xTimerDelete(m_report_timer, portMAX_DELAY);
+	}
+}
+
+esp_err_t TaskStats::Init() {
+	if (m_report_interval_ticks > 0) {
+		m_report_timer = xTimerCreate(TAG, m_report_interval_ticks, pdTRUE, this, report_timer_callback);
+		if (m_report_timer == NULL || xTimerStart(m_report_timer, 0) != pdPASS) {
+			TASK_STATS_LOGE("Failed to start task statistics report timer");
+			return ESP_FAIL;
+		}
+	}
+
+	g_pTaskStats = this;
+	return ESP_OK;
+}
+
+void TaskStats::LoopBegin(uint32_t index) {
+	int64_t now_us = esp_timer_get_time();
+	uint32_t interval_us = (index < TASK_INDEX_MAX) ? g_TaskParam[index].task_interval * portTICK_PERIOD_MS * 1000 : 0;
+
+	taskENTER_CRITICAL(&m_spinlock);
+	if (m_task_handles[index] == NULL) {
+		m_task_handles[index] = xTaskGetCurrentTaskHandle();
+	}
+
+	// The first loop has no previous one, the jitter starts with the second.
+	if (m_last_loop_end_us[index] != 0) {
+		int64_t expected_us = m_last_loop_end_us[index] + interval_us;
+		uint32_t jitter_us = (now_us > expected_us) ? (uint32_t)(now_us - expected_us) : 0;
+		m_stats[index].jitter_total_us += jitter_us;
+		m_stats[index].jitter_max_us = (jitter_us > m_stats[index].jitter_max_us) ? jitter_us : m_stats[index].jitter_max_us;
+	}
+	m_loop_begin_us[index] = now_us;
+	m_loop_work_us[index] = now_us;
+	taskEXIT_CRITICAL(&m_spinlock);
+}
+
+void TaskStats::LoopFetched(uint32_t index) {
+	int64_t now_us = esp_timer_get_time();
+
+	taskENTER_CRITICAL(&m_spinlock);
+	m_loop_work_us[index] = now_us;
+	taskEXIT_CRITICAL(&m_spinlock);
+}
+
+void TaskStats::LoopEnd(uint32_t index) {
+	int64_t now_us = esp_timer_get_time();
+
+	taskENTER_CRITICAL(&m_spinlock);
+	if (m_loop_begin_us[index] != 0) {
+		uint32_t duration_us = (uint32_t)(now_us - m_loop_work_us[index]);
+		m_stats[index].loops++;
+		m_stats[index].duration_total_us += duration_us;
+		m_stats[index].duration_max_us = (duration_us > m_stats[index].duration_max_us) ? duration_us : m_stats[index].duration_max_us;
+		m_last_loop_end_us[index] = now_us;
+	}
+	taskEXIT_CRITICAL(&m_spinlock);
+}
+
+void TaskStats::QueueSendFailed(uint32_t index) {
+	taskENTER_CRITICAL(&m_spinlock);
+	m_stats[index].dropped_messages++;
+	taskEXIT_CRITICAL(&m_spinlock);
+}
+
+void TaskStats::Get(uint32_t index, TaskStats_t *p_stats) {
+	taskENTER_CRITICAL(&m_spinlock);
+	*p_stats = m_stats[index];
+	TaskHandle_t task_handle = m_task_handles[index];
+	taskEXIT_CRITICAL(&m_spinlock);
+
+	// The stack is scanned for the fill pattern, outside the critical section.
+	p_stats->stack_high_water = (task_handle != NULL) ? uxTaskGetStackHighWaterMark(task_handle) : 0;
+}
+
+/* Called by the report timer, a full queue skips the report and counts as a dropped message. */
+void TaskStats::RequestReport() {
+	if (m_queue_handle == NULL) {
+		return;
+	}
+
+	BluethroatMsg_t message;
+	message.type = BLUETHROAT_MSG_TYPE_REPORT_REQUEST;
+	message.report_request.report = REPORT_TASK_STATS;
+	(void)TaskStatsQueueSend(TASK_STATS_INDEX_OTHER, m_queue_handle, &message);
+}
+
+/* Refresh the debug tab of the GUI, the log shows the same table at debug level. */
+void TaskStats::Report() {
+	TaskStats_t stats[TASK_STATS_SLOTS];
+	for (uint32_t index = 0; index < TASK_STATS_SLOTS; index++) {
+		Get(index, &(stats[index]));
+		TASK_STATS_LOGD("%-16s loops: %lu, duration mean/max: %lu/%lu us, jitter mean/max: %lu/%lu us, stack free: %lu bytes, dropped: %lu",
+			TaskStatsName(index), (unsigned long)stats[index].loops,
+			(unsigned long)(stats[index].loops > 0 ? stats[index].duration_total_us / stats[index].loops : 0), (unsigned long)stats[index].duration_max_us,
+			(unsigned long)(stats[index].loops > 1 ? stats[index].jitter_total_us / (stats[index].loops - 1) : 0), (unsigned long)stats[index].jitter_max_us,
+			(unsigned long)stats[index].stack_high_water, (unsigned long)stats[index].dropped_messages);
+	}
+
+	GuiSetTaskStats(stats, TASK_STATS_SLOTS);
+}
+
+TaskStats *g_pTaskStats = NULL;
+
+const char *TaskStatsName(uint32_t index) {
+	return (index < TASK_INDEX_MAX) ? g_TaskParam[index].task_name : "OTHER";
+}
+
+void TaskStatsLoopBegin(uint32_t index) {
+	if (g_pTaskStats != NULL && index < TASK_STATS_SLOTS) {
+		g_pTaskStats->LoopBegin(index);
+	}
+}
+
+void TaskStatsLoopFetched(uint32_t index) {
+	if (g_pTaskStats != NULL && index < TASK_STATS_SLOTS) {
+		g_pTaskStats->LoopFetched(index);
+	}
+}
+
+void TaskStatsLoopEnd(uint32_t index) {
+	if (g_pTaskStats != NULL && index < TASK_STATS_SLOTS) {
+		g_pTaskStats->LoopEnd(index);
+	}
+}
+
+BaseType_t TaskStatsQueueSend(uint32_t index, QueueHandle_t queue_handle, const void *p_item) {
+	BaseType_t result = xQueueSend(queue_handle, p_item, 0);
+	if (result != pdTRUE && g_pTaskStats != NULL && index < TASK_STATS_SLOTS) {
+		g_pTaskStats->QueueSendFailed(index);
+	}
+
+	return result;
+}
+
+esp_err_t TaskStatsGet(uint32_t index, TaskStats_t *p_stats) {
+	if (g_pTaskStats == NULL || index >= TASK_STATS_SLOTS) {
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	g_pTaskStats->Get(index, p_stats);
+	return ESP_OK;
+}
+
+esp_err_t TaskStatsGetRecord(uint32_t index, TaskStatsRecord_t *p_record) {
+	TaskStats_t stats;
+	esp_err_t result = TaskStatsGet(index, &stats);
+	if (result != ESP_OK) {
+		return result;
+	}
+
+	p_record->index = (uint8_t)index;
+	p_record->loops = stats.loops;
+	p_record->duration_mean_us = (stats.loops > 0) ? (uint32_t)(stats.duration_total_us / stats.loops) : 0;
+	p_record->duration_max_us = stats.duration_max_us;
+	p_record->jitter_mean_us = (stats.loops > 1) ? (uint32_t)(stats.jitter_total_us / (stats.loops - 1)) : 0;
+	p_record->jitter_max_us = stats.jitter_max_us;
+	p_record->stack_high_water = stats.stack_high_water;
+	p_record->dropped_messages = stats.dropped_messages;
+	return ESP_OK;
+}
@@ -0,0 +1,173 @@
+#include <math.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "utilities/temperature_drift.h"
+
+#define TEMPERATURE_DRIFT_LOGE(format, ...) 			ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define TEMPERATURE_DRIFT_LOGW(format, ...) 			ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define TEMPERATURE_DRIFT_LOGI(format, ...) 			ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define TEMPERATURE_DRIFT_LOGD(format, ...) 			ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define TEMPERATURE_DRIFT_LOGV(format, ...) 			ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+#define TEMPERATURE_DRIFT_GAS_CONSTANT				(287.05f)       /* J/(kg K), dry air */
+#define TEMPERATURE_DRIFT_CELSIUS_TO_KELVIN			(273.15f)
+#define TEMPERATURE_DRIFT_GRAVITY					(9.80665f)
+
+static const char *TAG = "TEMPERATURE_DRIFT";
+
+TemperatureDrift::TemperatureDrift(float min_span, bool gnss_correction) : m_min_span(min_span), m_gnss_correction(gnss_correction) {
+	Reset();
+}
+
+void TemperatureDrift::Reset() {
+	m_has_sample = false;
+	m_reference_temperature = 0.0f;
+	m_reference_pressure = 0.0f;
+	m_temperature = 0.0f;
+	m_pressure = 0.0f;
+	m_coefficient = 0.0f;
+	m_variance = TEMPERATURE_DRIFT_INITIAL_VARIANCE;
+	m_learned = false;
+	m_correction = 0.0f;
+	m_ground_count = 0;
+	m_ground_temperature = 0.0f;
+	m_ground_pressure = 0.0f;
+	m_ground_temperature_square = 0.0f;
+	m_ground_temperature_pressure = 0.0f;
+	m_ground_pressure_square = 0.0f;
+	m_min_temperature = 0.0f;
+	m_max_temperature = 0.0f;
+	m_has_fix = false;
+	m_reference_altitude = 0.0f;
+	memset(m_state, 0, sizeof(m_state));
+	memset(m_covariance, 0, sizeof(m_covariance));
+	m_gnss_count = 0;
+}
+
+/* Every barometer sample before the vario, its pressures are rewritten to the corrected ones. */
+void TemperatureDrift::AddSample(BarometerData_t *p_data, bool on_ground) {
+	if (!m_has_sample) {
+		m_has_sample = true;
+		m_reference_temperature = p_data->temperature;
+		m_reference_pressure = p_data->pressure;
+		m_min_temperature = p_data->temperature;
+		m_max_temperature = p_data->temperature;
+	}
+	m_temperature = p_data->temperature;
+	m_pressure = p_data->pressure;
+	if (on_ground) {
+		learn_on_ground(p_data->temperature, p_data->pressure);
+	}
+
+	float correction = m_learned ? m_coefficient * (m_temperature - m_reference_temperature) : 0.0f;
+	m_correction += fmaxf(-TEMPERATURE_DRIFT_MAX_STEP, fminf(TEMPERATURE_DRIFT_MAX_STEP, correction - m_correction));
+	p_data->pressure -= m_correction;
+	p_data->pressure_filterd -= m_correction;
+}
+
+/*
+	Every GNSS altitude in flight, with the barometric altitude of the last corrected sample. The pressure error of the
+	uncorrected sample is the one of the altitudes, in Pa at the density of the sample, plus the correction applied.
+	The filter starts on the first fix from k and its variance, learned on the ground or not, and the offset of it.
+*/
+void TemperatureDrift::AddGnssAltitude(float gnss_altitude, float barometric_altitude) {
+	if (!m_gnss_correction || !m_has_sample) {
+		return;
+	}
+
+	float pressure_per_meter = m_pressure * TEMPERATURE_DRIFT_GRAVITY / (TEMPERATURE_DRIFT_GAS_CONSTANT * (m_temperature + TEMPERATURE_DRIFT_CELSIUS_TO_KELVIN));
+	float error = (gnss_altitude - barometric_altitude) * pressure_per_meter + m_correction;
+	float error_variance = TEMPERATURE_DRIFT_GNSS_NOISE * TEMPERATURE_DRIFT_GNSS_NOISE * pressure_per_meter * pressure_per_meter;
+	if (!m_has_fix) {
+		m_has_fix = true;
+		m_reference_altitude = gnss_altitude;
+		memset(m_covariance, 0, sizeof(m_covariance));
+		m_state[0] = m_coefficient;
+		m_state[1] = 0.0f;
+		m_state[2] = error - m_coefficient * (m_temperature - m_reference_temperature);
+		m_covariance[0][0] = m_variance;
+		m_covariance[1][1] = TEMPERATURE_DRIFT_SLOPE_VARIANCE;
+		m_covariance[2][2] = error_variance + m_variance * (m_temperature - m_reference_temperature) * (m_temperature - m_reference_temperature);
+		m_covariance[0][2] = m_covariance[2][0] = -m_variance * (m_temperature - m_reference_temperature);
+		return;
+	}
+
+	float measurement[TEMPERATURE_DRIFT_ORDER] = {m_temperature - m_reference_temperature, (gnss_altitude - m_reference_altitude) / 1000.0f, 1.0f};
+	correct_flight(measurement, error, error_variance);
+}
+
+/* Running means and sums of squares around them, the float sums stay exact over hours of samples. */
+void TemperatureDrift::learn_on_ground(float temperature, float pressure) {
+	float x = temperature - m_reference_temperature;
+	float y = pressure - m_reference_pressure;
+
+	m_ground_count++;
+	float delta_x = x - m_ground_temperature;
+	float delta_y = y - m_ground_pressure;
+	m_ground_temperature += delta_x / (float)m_ground_count;
+	m_ground_pressure += delta_y / (float)m_ground_count;
+	m_ground_temperature_square += delta_x * (x - m_ground_temperature);
+	m_ground_temperature_pressure += delta_x * (y - m_ground_pressure);
+	m_ground_pressure_square += delta_y * (y - m_ground_pressure);
+	m_min_temperature = fminf(m_min_temperature, temperature);
+	m_max_temperature = fmaxf(m_max_temperature, temperature);
+
+	if (m_max_temperature - m_min_temperature < m_min_span || m_ground_temperature_square <= 0.0f || m_ground_count <= 2) {
+		return;
+	}
+	// The variance of the slope is the one of the residuals over the spread of the temperature.
+	float coefficient = m_ground_temperature_pressure / m_ground_temperature_square;
+	float residual = (m_ground_pressure_square - coefficient * m_ground_temperature_pressure) / (float)(m_ground_count - 2);
+	set_coefficient(coefficient);
+	m_variance = fmaxf(residual, TEMPERATURE_DRIFT_MIN_RESIDUAL) / m_ground_temperature_square;
+	if (!m_learned) {
+		m_learned = true;
+		TEMPERATURE_DRIFT_LOGI("Drift of %f Pa/C learned on the ground over %f C, %u samples", m_coefficient, m_max_temperature - m_min_temperature, (unsigned int)m_ground_count);
+	}
+}
+
+/*
+	The error is the measurement of the state against the temperature, the altitude in km and 1. Without a process model
+	the state only takes the process noise between the fixes.
+*/
+void TemperatureDrift::correct_flight(const float *p_measurement, float error, float error_variance) {
+	m_covariance[0][0] += TEMPERATURE_DRIFT_COEFFICIENT_NOISE;
+	m_covariance[1][1] += TEMPERATURE_DRIFT_SLOPE_NOISE;
+	m_covariance[2][2] += TEMPERATURE_DRIFT_OFFSET_NOISE;
+
+	// P * H^T, the innovation and its variance
+	float covariance_measurement[TEMPERATURE_DRIFT_ORDER];
+	float innovation = error;
+	float innovation_variance = error_variance;
+	for (int i = 0; i < TEMPERATURE_DRIFT_ORDER; i++) {
+		covariance_measurement[i] = 0.0f;
+		for (int j = 0; j < TEMPERATURE_DRIFT_ORDER; j++) {
+			covariance_measurement[i] += m_covariance[i][j] * p_measurement[j];
+		}
+		innovation -= p_measurement[i] * m_state[i];
+		innovation_variance += p_measurement[i] * covariance_measurement[i];
+	}
+
+	// P is symmetric, P * H^T is also H * P.
+	for (int i = 0; i < TEMPERATURE_DRIFT_ORDER; i++) {
+		float gain = covariance_measurement[i] / innovation_variance;
+		m_state[i] += gain * innovation;
+		for (int j = 0; j < TEMPERATURE_DRIFT_ORDER; j++) {
+			m_covariance[i][j] -= gain * covariance_measurement[j];
+		}
+	}
+
+	set_coefficient(m_state[0]);
+	m_state[0] = m_coefficient;
+	m_variance = m_covariance[0][0];
+	if (!m_learned && m_variance < TEMPERATURE_DRIFT_INITIAL_VARIANCE / 100.0f) {
+		m_learned = true;
+		TEMPERATURE_DRIFT_LOGI("Drift of %f Pa/C learned in flight", m_coefficient);
+	}
+	m_gnss_count++;
+}
+
+void TemperatureDrift::set_coefficient(float coefficient) {
+	m_coefficient = fmaxf(-TEMPERATURE_DRIFT_MAX_COEFFICIENT, fminf(TEMPERATURE_DRIFT_MAX_COEFFICIENT, coefficient));
+}
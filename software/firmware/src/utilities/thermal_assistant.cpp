@@ -0,0 +1,241 @@
+#include <math.h>
+#include <esp_log.h>
+
+#include "utilities/thermal_assistant.h"
+
+#define THERMAL_ASSISTANT_LOGE(format, ...) 		ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define THERMAL_ASSISTANT_LOGW(format, ...) 		ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define THERMAL_ASSISTANT_LOGI(format, ...) 		ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define THERMAL_ASSISTANT_LOGD(format, ...) 		ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define THERMAL_ASSISTANT_LOGV(format, ...) 		ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+#define THERMAL_ASSISTANT_METERS_PER_SECOND_OF_ARC	(1852.0f / 60.0f)
+#define THERMAL_ASSISTANT_MS_PER_DAY				(86400000UL)
+/* Turn rates of the track that start and end the circles, degrees/s, a 360 in a minute is 6 degrees/s */
+#define THERMAL_ASSISTANT_ENTER_TURN_RATE			(6.0f)
+#define THERMAL_ASSISTANT_LEAVE_TURN_RATE			(3.0f)
+/* Smoothing of the turn rate per fix */
+#define THERMAL_ASSISTANT_TURN_RATE_ALPHA			(0.3f)
+/* A longer gap between fixes restarts the turn rate */
+#define THERMAL_ASSISTANT_MAX_FIX_GAP				(5000UL)
+/* Samples of the thermal before the core is located, about half a circle */
+#define THERMAL_ASSISTANT_MIN_SAMPLES				(8)
+
+static const char *TAG = "THERMAL_ASSISTANT";
+
+ThermalAssistant::ThermalAssistant() {
+	Reset();
+}
+
+void ThermalAssistant::Reset() {
+	m_index = 0;
+	m_count = 0;
+	m_has_origin = false;
+	m_origin_latitude_minutes = 0;
+	m_origin_longitude_minutes = 0;
+	m_meters_per_longitude_second = THERMAL_ASSISTANT_METERS_PER_SECOND_OF_ARC;
+	m_east = 0.0f;
+	m_north = 0.0f;
+	m_climb_sum = 0.0f;
+	m_climb_count = 0;
+	m_last_climb = 0.0f;
+	m_last_track = 0.0f;
+	m_last_timestamp = 0;
+	m_turn_rate = 0.0f;
+	m_circling = false;
+	m_thermal_samples = 0;
+	m_thermal_start_altitude = 0.0f;
+	m_thermal_start_timestamp = 0;
+	m_wind_east = 0.0f;
+	m_wind_north = 0.0f;
+	m_core_valid = false;
+	m_core_east = 0.0f;
+	m_core_north = 0.0f;
+	m_thermal_climb = 0.0f;
+}
+
+void ThermalAssistant::SetWind(float east, float north) {
+	m_wind_east = east;
+	m_wind_north = north;
+}
+
+/* Every vertical speed of the vario, averaged until the next fix. */
+void ThermalAssistant::AddClimb(float climb) {
+	m_climb_sum += climb;
+	m_climb_count++;
+}
+
+/* Returns true when the core of the thermal is located on this fix. */
+bool ThermalAssistant::AddFix(const GnssRmcData_t *p_rmc, float altitude) {
+	float east, north;
+	locate(p_rmc, &east, &north);
+
+	uint32_t delta_time = 0;
+	if (m_count > 0) {
+		delta_time = (p_rmc->time + THERMAL_ASSISTANT_MS_PER_DAY - m_last_timestamp) % THERMAL_ASSISTANT_MS_PER_DAY;
+	}
+	update_circling(p_rmc->course, delta_time);
+
+	float climb = (m_climb_count > 0) ? m_climb_sum / (float)m_climb_count : m_last_climb;
+	m_climb_sum = 0.0f;
+	m_climb_count = 0;
+	m_last_climb = climb;
+
+	// The climb was averaged on the way from the previous fix.
+	ThermalSample_t *p_sample = &(m_samples[m_index]);
+	bool connected = (m_count > 0 && delta_time <= THERMAL_ASSISTANT_MAX_FIX_GAP);
+	p_sample->east = connected ? 0.5f * (east + m_east) : east;
+	p_sample->north = connected ? 0.5f * (north + m_north) : north;
+	p_sample->altitude = altitude;
+	p_sample->climb = climb;
+	p_sample->timestamp = p_rmc->time;
+	m_index = (m_index + 1) % THERMAL_ASSISTANT_HISTORY;
+	if (m_count < THERMAL_ASSISTANT_HISTORY) {
+		m_count++;
+	}
+	m_east = east;
+	m_north = north;
+	m_last_timestamp = p_rmc->time;
+
+	if (m_circling) {
+		if (m_thermal_samples == 0) {
+			m_thermal_start_altitude = altitude;
+			m_thermal_start_timestamp = p_rmc->time;
+		}
+		if (m_thermal_samples < m_count) {
+			m_thermal_samples++;
+		}
+		locate_core();
+	} else {
+		m_thermal_samples = 0;
+		m_core_valid = false;
+	}
+
+	return m_core_valid;
+}
+
+/* Sample of the ring, age 0 is the last one. */
+const ThermalSample_t *ThermalAssistant::GetSample(uint32_t age) const {
+	if (age >= m_count) {
+		return NULL;
+	}
+	return &(m_samples[(m_index + THERMAL_ASSISTANT_HISTORY - 1 - age) % THERMAL_ASSISTANT_HISTORY]);
+}
+
+/* Position of a sample moved with the air mass to the time of the last fix, the air it climbed in is there now. */
+void ThermalAssistant::GetDriftedPosition(uint32_t age, float *p_east, float *p_north) const {
+	const ThermalSample_t *p_sample = GetSample(age);
+	if (p_sample == NULL) {
+		*p_east = m_east;
+		*p_north = m_north;
+		return;
+	}
+	float drift_time = (float)((m_last_timestamp + THERMAL_ASSISTANT_MS_PER_DAY - p_sample->timestamp) % THERMAL_ASSISTANT_MS_PER_DAY) / 1000.0f;
+	*p_east = p_sample->east + m_wind_east * drift_time;
+	*p_north = p_sample->north + m_wind_north * drift_time;
+}
+
+float ThermalAssistant::GetCoreEast() const {
+	return m_core_east - m_east;
+}
+
+float ThermalAssistant::GetCoreNorth() const {
+	return m_core_north - m_north;
+}
+
+float ThermalAssistant::GetThermalGain() const {
+	const ThermalSample_t *p_sample = GetSample(0);
+	return (m_circling && p_sample != NULL) ? p_sample->altitude - m_thermal_start_altitude : 0.0f;
+}
+
+uint32_t ThermalAssistant::GetThermalDuration() const {
+	return m_circling ? (m_last_timestamp + THERMAL_ASSISTANT_MS_PER_DAY - m_thermal_start_timestamp) % THERMAL_ASSISTANT_MS_PER_DAY : 0;
+}
+
+/*
+    Local east and north of the fix, from the whole minutes of the first fix. The minutes are subtracted as integers
+    and only the seconds are float, a float of the degrees would round to a meter.
+*/
+void ThermalAssistant::locate(const GnssRmcData_t *p_rmc, float *p_east, float *p_north) {
+	int32_t latitude_sign = (p_rmc->latitude_direction == GNSS_LATITUDE_DIRECTION_NORTH) ? 1 : -1;
+	int32_t longitude_sign = (p_rmc->langitude_direction == GNSS_LONGITUDE_DIRECTION_EAST) ? 1 : -1;
+	int32_t latitude_minutes = latitude_sign * (int32_t)(p_rmc->latitude_degree * 60 + p_rmc->latitude_minute);
+	int32_t longitude_minutes = longitude_sign * (int32_t)(p_rmc->langitude_degree * 60 + p_rmc->langitude_minute);
+
+	if (!m_has_origin) {
+		m_has_origin = true;
+		m_origin_latitude_minutes = latitude_minutes;
+		m_origin_longitude_minutes = longitude_minutes;
+		m_meters_per_longitude_second = THERMAL_ASSISTANT_METERS_PER_SECOND_OF_ARC * cosf((float)latitude_minutes / 60.0f * (float)M_PI / 180.0f);
+		THERMAL_ASSISTANT_LOGI("Origin at %d' %d'", (int)latitude_minutes, (int)longitude_minutes);
+	}
+
+	float north_seconds = (float)((latitude_minutes - m_origin_latitude_minutes) * 60) + (float)latitude_sign * p_rmc->latitude_second;
+	float east_seconds = (float)((longitude_minutes - m_origin_longitude_minutes) * 60) + (float)longitude_sign * p_rmc->langitude_second;
+	*p_north = north_seconds * THERMAL_ASSISTANT_METERS_PER_SECOND_OF_ARC;
+	*p_east = east_seconds * m_meters_per_longitude_second;
+}
+
+void ThermalAssistant::update_circling(float track, uint32_t delta_time) {
+	if (m_count == 0 || delta_time == 0 || delta_time > THERMAL_ASSISTANT_MAX_FIX_GAP) {
+		m_turn_rate = 0.0f;
+	} else {
+		float turn = fmodf(track - m_last_track + 540.0f, 360.0f) - 180.0f;
+		m_turn_rate += (turn * 1000.0f / (float)delta_time - m_turn_rate) * THERMAL_ASSISTANT_TURN_RATE_ALPHA;
+	}
+	m_last_track = track;
+
+	if (!m_circling && fabsf(m_turn_rate) >= THERMAL_ASSISTANT_ENTER_TURN_RATE) {
+		m_circling = true;
+		THERMAL_ASSISTANT_LOGD("Start circling, turn rate %f degrees/s", m_turn_rate);
+	} else if (m_circling && fabsf(m_turn_rate) < THERMAL_ASSISTANT_LEAVE_TURN_RATE) {
+		m_circling = false;
+		THERMAL_ASSISTANT_LOGD("Stop circling, turn rate %f degrees/s", m_turn_rate);
+	}
+}
+
+/*
+    Centroid of the drifted positions of the thermal, weighted by the climb above the weakest one, so a circle of even
+    lift points at its center and a circle with a strong side leans to it. Circles in sink have no core.
+*/
+void ThermalAssistant::locate_core() {
+	uint32_t samples = m_thermal_samples;
+	if (samples < THERMAL_ASSISTANT_MIN_SAMPLES) {
+		m_core_valid = false;
+		return;
+	}
+
+	float min_climb = GetSample(0)->climb;
+	float climb_sum = 0.0f;
+	for (uint32_t age = 0; age < samples; age++) {
+		float climb = GetSample(age)->climb;
+		min_climb = fminf(min_climb, climb);
+		climb_sum += climb;
+	}
+	m_thermal_climb = climb_sum / (float)samples;
+	if (m_thermal_climb <= 0.0f) {
+		m_core_valid = false;
+		return;
+	}
+
+	float weight_sum = 0.0f;
+	float east_sum = 0.0f;
+	float north_sum = 0.0f;
+	for (uint32_t age = 0; age < samples; age++) {
+		float east, north;
+		GetDriftedPosition(age, &east, &north);
+		float weight = GetSample(age)->climb - min_climb;
+		weight_sum += weight;
+		east_sum += weight * east;
+		north_sum += weight * north;
+	}
+	if (weight_sum <= 0.0f) {
+		m_core_valid = false;
+		return;
+	}
+
+	m_core_valid = true;
+	m_core_east = east_sum / weight_sum;
+	m_core_north = north_sum / weight_sum;
+	THERMAL_ASSISTANT_LOGD("Core %f m east, %f m north of the glider, thermal climb %f m/s", GetCoreEast(), GetCoreNorth(), m_thermal_climb);
+}
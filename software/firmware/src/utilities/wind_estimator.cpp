@@ -0,0 +1,168 @@
+#include <math.h>
+#include <esp_log.h>
+
+#include "utilities/wind_estimator.h"
+
+#define WIND_ESTIMATOR_LOGE(format, ...) 			ESP_LOGE(TAG, format, ##__VA_ARGS__)
+#define WIND_ESTIMATOR_LOGW(format, ...) 			ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#define WIND_ESTIMATOR_LOGI(format, ...) 			ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#define WIND_ESTIMATOR_LOGD(format, ...) 			ESP_LOGD(TAG, format, ##__VA_ARGS__)
+#define WIND_ESTIMATOR_LOGV(format, ...) 			ESP_LOGV(TAG, format, ##__VA_ARGS__)
+
+/* Below this ground speed the track of a fix is noise */
+#define WIND_ESTIMATOR_MIN_SPEED					(2.0f)
+/* Airspeeds a paraglider or a hang glider can circle at */
+#define WIND_ESTIMATOR_MIN_AIRSPEED					(3.0f)
+#define WIND_ESTIMATOR_MAX_AIRSPEED					(40.0f)
+/* rms distance of the fixes to the fitted circle, m/s, the algebraic residual over twice the airspeed */
+#define WIND_ESTIMATOR_MAX_RESIDUAL					(1.0f)
+/* Determinant of the covariance of the fixes, (m/s)^4, a full circle of 5 m/s is about 150 */
+#define WIND_ESTIMATOR_MIN_DETERMINANT				(1.0f)
+
+static const char *TAG = "WIND_ESTIMATOR";
+
+WindEstimator::WindEstimator(uint32_t window, float min_turn) : m_window(window), m_min_turn(min_turn) {
+	if (m_window < 3 || m_window > WIND_ESTIMATOR_MAX_WINDOW) {
+		WIND_ESTIMATOR_LOGW("Window of %u fixes out of range, %u fixes instead", (unsigned int)m_window, (unsigned int)WIND_ESTIMATOR_MAX_WINDOW);
+		m_window = WIND_ESTIMATOR_MAX_WINDOW;
+	}
+	Reset();
+}
+
+void WindEstimator::Reset() {
+	m_index = 0;
+	m_count = 0;
+	m_last_track = 0.0f;
+	m_turn_sum = 0.0f;
+	recalculate();
+	m_valid = false;
+	m_wind_east = 0.0f;
+	m_wind_north = 0.0f;
+	m_airspeed = 0.0f;
+	m_age = 0;
+}
+
+/* Track in degrees clockwise from north and ground speed in m/s of a fix. Returns true when the circle was fitted on it. */
+bool WindEstimator::AddVelocity(float track, float speed) {
+	if (speed < WIND_ESTIMATOR_MIN_SPEED) {
+		return false;
+	}
+
+	float track_rad = track * (float)M_PI / 180.0f;
+	float x = speed * sinf(track_rad);
+	float y = speed * cosf(track_rad);
+	float turn = 0.0f;
+	if (m_count > 0) {
+		turn = fmodf(track - m_last_track + 540.0f, 360.0f) - 180.0f;
+	}
+	m_last_track = track;
+
+	if (m_count == m_window) {
+		accumulate(m_east[m_index], m_north[m_index], -1.0f);
+		m_turn_sum -= m_turn[m_index];
+	} else {
+		m_count++;
+	}
+	m_east[m_index] = x;
+	m_north[m_index] = y;
+	m_turn[m_index] = turn;
+	accumulate(x, y, 1.0f);
+	m_turn_sum += turn;
+
+	// Once per window the sums are summed again, so the rounding of the removals doesn't pile up.
+	m_index++;
+	if (m_index == m_window) {
+		m_index = 0;
+		recalculate();
+	}
+
+	m_age++;
+	if (fabsf(m_turn_sum) >= m_min_turn && fit()) {
+		m_age = 0;
+		return true;
+	}
+	return false;
+}
+
+float WindEstimator::GetWindSpeed() const {
+	return sqrtf(m_wind_east * m_wind_east + m_wind_north * m_wind_north);
+}
+
+/* Degrees clockwise from north the wind blows from, the way it is reported. */
+float WindEstimator::GetWindDirection() const {
+	float direction = atan2f(-m_wind_east, -m_wind_north) * 180.0f / (float)M_PI;
+	return (direction < 0.0f) ? direction + 360.0f : direction;
+}
+
+void WindEstimator::accumulate(float x, float y, float sign) {
+	float z = x * x + y * y;
+	m_sum_x += sign * x;
+	m_sum_y += sign * y;
+	m_sum_xx += sign * x * x;
+	m_sum_yy += sign * y * y;
+	m_sum_xy += sign * x * y;
+	m_sum_z += sign * z;
+	m_sum_xz += sign * x * z;
+	m_sum_yz += sign * y * z;
+	m_sum_zz += sign * z * z;
+}
+
+void WindEstimator::recalculate() {
+	m_sum_x = m_sum_y = m_sum_xx = m_sum_yy = m_sum_xy = m_sum_z = m_sum_xz = m_sum_yz = m_sum_zz = 0.0f;
+	for (uint32_t i = 0; i < m_count; i++) {
+		accumulate(m_east[i], m_north[i], 1.0f);
+	}
+}
+
+/*
+    x^2 + y^2 + D x + E y + F = 0 in the least squares sense. F is eliminated with the means, which leaves a 2x2 system
+    of the covariances of the fixes, better conditioned in float than the raw sums with a wind of a few m/s.
+    The algebraic error of a fix, z + D x + E y + F, is r^2 - R^2 for a fix at r from the center, about 2 R times its
+    distance to the circle. At the solution its mean square is czz + D cxz + E cyz, from the sums without a pass over
+    the fixes.
+*/
+bool WindEstimator::fit() {
+	float n = (float)m_count;
+	float mean_x = m_sum_x / n;
+	float mean_y = m_sum_y / n;
+	float mean_z = m_sum_z / n;
+	float cxx = m_sum_xx / n - mean_x * mean_x;
+	float cyy = m_sum_yy / n - mean_y * mean_y;
+	float cxy = m_sum_xy / n - mean_x * mean_y;
+	float cxz = m_sum_xz / n - mean_x * mean_z;
+	float cyz = m_sum_yz / n - mean_y * mean_z;
+	float czz = m_sum_zz / n - mean_z * mean_z;
+
+	float determinant = cxx * cyy - cxy * cxy;
+	if (determinant < WIND_ESTIMATOR_MIN_DETERMINANT) {
+		return false;
+	}
+	float d = (cxy * cyz - cyy * cxz) / determinant;
+	float e = (cxy * cxz - cxx * cyz) / determinant;
+	float f = -mean_z - d * mean_x - e * mean_y;
+	float center_x = -0.5f * d;
+	float center_y = -0.5f * e;
+	float radius_square = center_x * center_x + center_y * center_y - f;
+	if (radius_square < WIND_ESTIMATOR_MIN_AIRSPEED * WIND_ESTIMATOR_MIN_AIRSPEED || radius_square > WIND_ESTIMATOR_MAX_AIRSPEED * WIND_ESTIMATOR_MAX_AIRSPEED) {
+		WIND_ESTIMATOR_LOGD("Fitted airspeed %f m/s out of range", sqrtf(fmaxf(radius_square, 0.0f)));
+		return false;
+	}
+	float radius = sqrtf(radius_square);
+	if (center_x * center_x + center_y * center_y >= radius_square) {
+		WIND_ESTIMATOR_LOGD("Fitted wind %f m/s above the airspeed %f m/s", sqrtf(center_x * center_x + center_y * center_y), radius);
+		return false;
+	}
+
+	float residual = sqrtf(fmaxf(czz + d * cxz + e * cyz, 0.0f)) / (2.0f * radius);
+	if (residual > WIND_ESTIMATOR_MAX_RESIDUAL) {
+		WIND_ESTIMATOR_LOGD("Fixes %f m/s off the circle", residual);
+		return false;
+	}
+
+	m_valid = true;
+	m_wind_east = center_x;
+	m_wind_north = center_y;
+	m_airspeed = radius;
+	WIND_ESTIMATOR_LOGD("Wind %f m/s from %f, airspeed %f m/s, residual %f m/s", GetWindSpeed(), GetWindDirection(), radius, residual);
+	return true;
+}